@@ -29,6 +29,11 @@ uniform mat4 ProjectionMatrix;
 uniform mat4 ModelViewProjectionMatrix;
 uniform mat2 TextureMatrix;
 
+// Compact meshes store octahedral encoded normals in the first two
+// components of the normal attribute, see Mesh3d::COMPACT_VERTICES
+
+uniform bool OctahedralNormals;
+
 // GLSL 1.30 (OpenGL 3.0) deprecates vertex shader attribute variables. They
 // have been replaced with user-defined generic shader input variables. The
 // application code uses the new glVertexAttribPointer() function to map vertex
@@ -79,12 +84,25 @@ out vec4 Diffuse;
 out vec4 Specular;
 out float Shininess;
 
+// decodes an octahedral encoded normal
+
+vec3 DecodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
 // main vertex shader
 
 void main()
 {
 
-	Normal = normalize(NormalMatrix * VertexNormal);							
+	vec3 ObjectNormal = OctahedralNormals ? DecodeOctahedral(VertexNormal.xy) : VertexNormal;
+
+	Normal = normalize(NormalMatrix * ObjectNormal);							
 	Eye = vec3 (ModelViewMatrix * VertexPosition );
 	Ldir=DirectionalLight.cameraspacedirection.xyz;
 
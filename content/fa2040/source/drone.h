@@ -30,6 +30,8 @@ namespace fa2040
 			glm::vec3				CurOrigin;	
 			
 			vml::geo2d::PathFinder* PathFinder;
+			vml::geo2d::PathScheduler* PathScheduler;		// if attached, routes can be requested asynchronously
+			int						RouteRequestId;			// id of the pending route request, -1 if none
 			int						NavMeshCellId;			// id of cell in the navmesh the navmesh is segmented into 'islands'
 															// this value indicates in which of these islands the 
 															// cleocopter belongs to see pathfinder for more info
@@ -174,6 +176,18 @@ namespace fa2040
 
 				return false;
 			}
+
+			// ----------------------------------------------------------
+			// drops the pending route request, if any, its callback
+			// captures the drone so it must not be delivered anymore
+
+			void CancelRoute()
+			{
+				if (PathScheduler && RouteRequestId != -1)
+					PathScheduler->Cancel(RouteRequestId);
+
+				RouteRequestId = -1;
+			}
 			
 		public:
 			
@@ -218,9 +232,79 @@ namespace fa2040
 			JPH::Hit WallHit;
 			bool CastRay;
 
+			// ----------------------------------------------------------
+			// asynchronous version of SetRoute, the path is requested to
+			// the path scheduler and copied when it's delivered, meanwhile
+			// the drone keeps its current path, a new request replaces the
+			// pending one, once the path is copied the drone switches to 
+			// nextstate, if no path is found the drone is left untouched
+
+			bool SetRoute(const glm::vec3& origin, const glm::ivec2& a, const glm::ivec2& b, unsigned int nextstate)
+			{
+				if (!PathFinder)
+					vml::os::Message::Error("Drone : ", "PathFinder is nnull");
+				if (!PathScheduler)
+					vml::os::Message::Error("Drone : ", "PathScheduler is nnull");
+
+				if (!PathFinder || !PathScheduler)
+					return false;
+
+				// drop previous request, if any
+
+				CancelRoute();
+
+				// the pathfinder stores paths from target to source, so endpoints
+				// are swapped as in the synchronous SetRoute, it could happen that 
+				// the drone is in a non valid cell, if this happens then we need 
+				// to find the nearest valid cell or the path will be null
+
+				glm::ivec2 ia = b;
+				glm::ivec2 ib = a;
+
+				if (PathFinder->GetCellIdFromIndices(b.x, b.y) == -1) ia = PathFinder->FindNearestCellToAnotherCell(b.x, b.y, NavMeshCellId);
+				if (PathFinder->GetCellIdFromIndices(a.x, a.y) == -1) ib = PathFinder->FindNearestCellToAnotherCell(a.x, a.y, NavMeshCellId);
+
+				// the callback is called by the scheduler on the thread updating the level
+
+				RouteRequestId = PathScheduler->Submit(origin, ia, ib, [this, nextstate](const vml::geo2d::PathScheduler::PathResult& result)
+				{
+					RouteRequestId = -1;
+
+					if (!result.Found)
+						return;
+
+					PathIndex	  = 0;
+					PathCount	  = (int)result.Points.size();
+					PathLenght	  = result.Length;
+					InvPathLenght = 1.0f / PathLenght;
+					T			  = 0.0f;
+					CurPath		  = 0.0f;
+					CruiseSpeed   = 0.0f;
+
+					// copy path, the result is released after delivery
+
+					for (size_t i = 0; i < result.Points.size(); ++i)
+						Path[i] = result.Points[i];
+
+					for (size_t i = 0; i < result.Directions.size(); ++i)
+					{
+						PathDir[i]				= result.Directions[i];
+						PathInvSegmentLength[i] = result.InvSegmentLength[i];
+						PathSegmentLength[i]	= result.SegmentLength[i];
+					}
+
+					Position = Path[0];
+					GetRootModel()->SetPosition(Position);
+					State = nextstate;
+				});
+
+				return true;
+			}
+			
 			// ----------------------------------------------------------
 			// this is used when the drone needs a fixed patrolling route
 			// if you need to change the route in realtime use changerout
+			// if a path scheduler is attached, the route is set on delivery
 
 			bool SetInitialRoute(const glm::vec3& origin, const glm::ivec2& a, const glm::ivec2& b)
 			{
@@ -236,6 +320,8 @@ namespace fa2040
 				if (PathFinder)
 				{
 					PathFinderStartingCellId = PathFinder->GetCellIdFromIndices(StartPathA.x, StartPathA.y);
+					if (PathScheduler)
+						return SetRoute(StartOrigin, StartPathA, StartPathB, NEUTRAL);
 					return SetRoute(StartOrigin, StartPathA, StartPathB);
 				}
 				return false;
@@ -280,7 +366,7 @@ namespace fa2040
 			// ----------------------------------------------------------
 			//
 
-			void StartCourse()			 { State = START_PATH; }
+			void StartCourse()			 { CancelRoute(); State = START_PATH; }
 			void StopChase()			 { State = STOP_CHASE; }
 			void ChasePlayer()			 { State = CHASE_PLAYER; }
 			void SetAvoidPlayerToTrue()  { AvoidPlayer = 1; }
@@ -300,6 +386,7 @@ namespace fa2040
 			int			 GetPriority()	    const { return Priority; }
 			int			 GetNavMeshCellId() const { return NavMeshCellId; }
 			bool		 IsAvoiding()		const { return AvoidState==AVOID_STATE_1; }
+			bool		 IsRoutePending()	const { return RouteRequestId != -1; }
 
 			// ----------------------------------------------------------
 			//
@@ -398,17 +485,16 @@ namespace fa2040
 					
 					//	std::cout << "Controller for object :" << GetScreenName() << std::endl;
 
-					SetRoute(CurOrigin, CurPathA, CurPathB);
+					// the drone waits here until the path is delivered, then
+					// switches to the forward patrol state
 
-					// start path state
+					if (!IsRoutePending())
+					{
+						SetRoute(CurOrigin, CurPathA, CurPathB, START_FORWARD_PATROL);
 
-					State		    = START_FORWARD_PATROL;
-					StopState	    = STOP_STATE_0;
-					T			    = 0.0f;						// T is initialize in the SetRoute function
-					CurPath		    = 0.0f;						// CurPath is initialize in the SetRoute function
-					CruiseSpeed     = 0.0f;
-					PrevCruiseSpeed = 0.0f;
-					PathIndex       = 0;
+						StopState	    = STOP_STATE_0;
+						PrevCruiseSpeed = 0.0f;					// T, CurPath, CruiseSpeed and PathIndex are initialized on delivery
+					}
 
 //					std::cout << "path started" << std::endl;
 				}
@@ -537,11 +623,10 @@ namespace fa2040
 					// its possible that the path is null 
 					// this never happens , but its a possibility
 					// in that case the drone will not move
+					// the drone goes back to route once the path is delivered
 
-					if (SetRoute(GetRootModel()->GetPosition(), GetNavMeshCell(), StartPathA))
-					{
-						State = GO_BACK_TO_ROUTE;
-					}
+					if (!IsRoutePending())
+						SetRoute(GetRootModel()->GetPosition(), GetNavMeshCell(), StartPathA, GO_BACK_TO_ROUTE);
 					
 				}
 
@@ -631,6 +716,31 @@ namespace fa2040
 				}
 			}
 			
+			// ----------------------------------------------------------
+			// attach path scheduler to drone, routes can then be computed
+			// off the main thread, see asynchronous SetRoute
+
+			void AttachPathScheduler(vml::geo2d::PathScheduler* pathscheduler)
+			{
+				if (!pathscheduler)
+					vml::os::Message::Error("Drone :", "Null PathScheduler");
+
+				PathScheduler = pathscheduler;
+			}
+
+			// ----------------------------------------------------------
+			// attach level navigation to drone, pathfinder and the path
+			// scheduler the level delivers paths with each frame
+
+			void AttachLevel(vml::scenes::Level* level, const glm::vec3& pos)
+			{
+				if (!level)
+					vml::os::Message::Error("Drone :", "Null Level");
+
+				AttachPathFinder(level->GetPathFinder(), pos);
+				AttachPathScheduler(level->GetPathScheduler());
+			}
+
 			// ----------------------------------------------------------
 			//
 
@@ -781,6 +891,8 @@ namespace fa2040
 			{
 				//	Player					 =  nullptr;
 				PathFinder				 =  nullptr;
+				PathScheduler			 =  nullptr;
+				RouteRequestId			 = -1;
 				Path					 =  nullptr;
 				PathInvSegmentLength	 =  nullptr;
 				PathSegmentLength		 =  nullptr;
@@ -919,6 +1031,10 @@ namespace fa2040
 
 			~Drone()
 			{
+				// a pending route would be delivered to a deleted drone
+
+				CancelRoute();
+
 				vml::os::SafeDeleteArray(Path);
 				vml::os::SafeDeleteArray(PathDir);
 				vml::os::SafeDeleteArray(PathInvSegmentLength);
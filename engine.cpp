@@ -49,6 +49,16 @@ namespace vml
 	}
 }
 
+// engine wide thread pool singleton
+
+namespace vml
+{
+	namespace os
+	{
+		vml::os::ThreadPool* vml::os::ThreadPool::Singleton = nullptr;
+	}
+}
+
 // global stores
 
 namespace vml
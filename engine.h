@@ -45,6 +45,7 @@
 #include <vml4.0/os/errormsg.h>		// error/warning/trace messaging , platform dependent
 #include <vml4.0/os/cpuinfo2.h>		// system info detection class ,platform dependent
 #include <vml4.0/os/timer.h>		// timer class ,platform dependent
+#include <vml4.0/os/mappedfile.h>	// memory mapped files ,platform dependent
 #endif	
 
 ////////////////////////////////////////////////////////////////////////////////////
@@ -54,12 +55,15 @@
 #include <vml4.0/utils/bitarray16.h>
 #include <vml4.0/utils/bitarray32.h>
 #include <vml4.0/utils/uniqueid.h>
+#include <vml4.0/utils/hash.h>
 
 ////////////////////////////////////////////////////////////////////////////////////
 // os
 
 #include <vml4.0/os/internalflags.h>
 #include <vml4.0/os/preferencesflags.h>
+#include <vml4.0/os/threadpool.h>
+#include <vml4.0/os/archive.h>
 
 ////////////////////////////////////////////////////////////////////////////////////
 // string utils
@@ -127,6 +131,7 @@ namespace vml
 
 #include <vml4.0/mesh/model.h>
 #include <vml4.0/mesh/object.h>
+#include <vml4.0/octree/dynamicbvh.h>
 #include <vml4.0/mesh/objectmanager2.h>
 
 ////////////////////////////////////////////////////////////////////////////////////
@@ -3,6 +3,7 @@
 //////////////////////////////////////////////////////////////////////////////////////////////
 
 #include <vml4.0/math/2d/pathfinder.h>
+#include <vml4.0/math/2d/pathscheduler.h>
 
 namespace vml
 {
@@ -24,9 +25,14 @@ namespace vml
 				std::string			       ColMeshFileName;
 				std::string			       NavMeshFileName;
 				std::string			       NavMaskFileName;
+				std::string			       OctCacheFileName;
+				std::string			       ColCacheFileName;
+				std::string			       NavHierarchyFileName;
+				std::string			       ArchiveFileName;
 				uint32_t				   InternalFlags;
 				vml::octree::OctTree*      OctTree;
 				vml::geo2d::PathFinder*    PathFinder;
+				vml::geo2d::PathScheduler* PathScheduler;
 				vml::meshes::Mesh3d*       MapMesh;
 				vml::meshes::Mesh3d*       CollisionMesh;
 				vml::meshes::Mesh3d*       NavMesh;
@@ -40,8 +46,14 @@ namespace vml
 					vml::os::SafeDelete(CollisionMesh);
 					vml::os::SafeDelete(NavMesh);
 					vml::os::SafeDelete(OctTree);
+					vml::os::SafeDelete(PathScheduler);
 					vml::os::SafeDelete(PathFinder);
 
+					// unmount level archive
+
+					if (!ArchiveFileName.empty())
+						vml::os::Archive::Unmount(ArchiveFileName);
+
 					// sets data members to initial values
 
 					LevelName		= "";
@@ -49,6 +61,10 @@ namespace vml
 					MapMeshFileName = "";
 					ColMeshFileName = "";
 					NavMeshFileName = "";
+					OctCacheFileName = "";
+					ColCacheFileName = "";
+					NavHierarchyFileName = "";
+					ArchiveFileName = "";
 					InternalFlags	=  0;
 
 				}
@@ -76,53 +92,94 @@ namespace vml
 					ColMeshFileName = MainPath + "\\" + LevelName + "_col.3df";
 					NavMeshFileName = MainPath + "\\" + LevelName + "_nav.3df";
 					NavMaskFileName = MainPath + "\\" + LevelName + "_nav_mask.nvm";
+					OctCacheFileName = MainPath + "\\" + LevelName + ".oct";
+					ColCacheFileName = MainPath + "\\" + LevelName + "_col.jsh";
+					NavHierarchyFileName = MainPath + "\\" + LevelName + "_nav_mask.hpa";
 
 					vml::utils::Logger::GetInstance()->Info("Level : Loading Level : " + MainPath);
+
+					// if the level is packed, mount its archive over the level
+					// directory, level files are then read from the archive,
+					// caches rebuilt at runtime are still saved to disk, and
+					// take precedence over the packed ones while newer
+
+					if (std::filesystem::exists(MainPath + ".vpk") && vml::os::Archive::Mount(MainPath + ".vpk", MainPath))
+					{
+						ArchiveFileName = MainPath + ".vpk";
+						vml::utils::Logger::GetInstance()->Info("Level : Mounted Archive : " + ArchiveFileName);
+					}
 					vml::utils::Logger::GetInstance()->Info("Level : MapMesh : "	   + MapMeshFileName);
 					vml::utils::Logger::GetInstance()->Info("Level : CollisionMesh : " + ColMeshFileName);
 					vml::utils::Logger::GetInstance()->Info("Level : NavMesh : "	   + NavMeshFileName);
 
 					// allocate meshes
 
-					MapMesh = new vml::meshes::Mesh3d(MapMeshFileName, { vml::meshes::Mesh3d::RETAIN_DATA });
+					MapMesh = new vml::meshes::Mesh3d(MapMeshFileName, { vml::meshes::Mesh3d::RETAIN_DATA, vml::meshes::Mesh3d::COMPACT_VERTICES });
 					
 					// Collison mesh and navmesh are not mandatory
 					
 					// load collision mesh
 
-					if (std::filesystem::exists(ColMeshFileName)) 
+					if (vml::os::FileView::Exists(ColMeshFileName)) 
 					{
 						vml::utils::Logger::GetInstance()->Info("Level : Loading Collison Mesh : " + ColMeshFileName);
-						CollisionMesh = new vml::meshes::Mesh3d(ColMeshFileName, { vml::meshes::Mesh3d::RETAIN_DATA });
+						CollisionMesh = new vml::meshes::Mesh3d(ColMeshFileName, { vml::meshes::Mesh3d::RETAIN_DATA, vml::meshes::Mesh3d::COMPACT_VERTICES });
 					}
 
 					// load nav mesh, if nav mesh exists , create pathfinder
 
-					if (std::filesystem::exists(NavMeshFileName)) 
+					if (vml::os::FileView::Exists(NavMeshFileName)) 
 					{
 						vml::utils::Logger::GetInstance()->Info("Level : Loading Nav Mesh : " + NavMeshFileName);
-						NavMesh = new vml::meshes::Mesh3d(NavMeshFileName, {});
+						NavMesh = new vml::meshes::Mesh3d(NavMeshFileName, { vml::meshes::Mesh3d::DO_NOT_RETAIN_DATA, vml::meshes::Mesh3d::COMPACT_VERTICES });
 						// log out mesh loading
 						vml::utils::Logger::GetInstance()->Info("Level : Loading MapMesh : " + MapMeshFileName);
 						// load bitmap mask for pathfinding 
 						PathFinder = new vml::geo2d::PathFinder(NavMaskFileName);
+						// load pathfinder cluster graph, if it's missing or
+						// doesn't match the mask, build it and save it
+						if (PathFinder->LoadHierarchy(NavHierarchyFileName))
+						{
+							vml::utils::Logger::GetInstance()->Info("Level : Nav Hierarchy Cached Load : " + NavHierarchyFileName);
+						}
+						else
+						{
+							PathFinder->BuildHierarchy();
+							PathFinder->SaveHierarchy(NavHierarchyFileName);
+							vml::utils::Logger::GetInstance()->Info("Level : Nav Hierarchy Build : " + std::to_string(PathFinder->GetHierarchyBuildTime()) + " ms");
+						}
+						// agents route through the scheduler, searches run on the engine pool
+						PathScheduler = new vml::geo2d::PathScheduler(PathFinder, vml::os::ThreadPool::GetInstance());
 					}
 					
-					// compile level
-
-					vml::utils::Logger::GetInstance()->Info("Level : Octree Compiling : " + LevelName);
-					
 					// create octree
 
 					OctTree = new vml::octree::OctTree;
 					
-					// compile map
+					// load compiled map from cache, if cache is missing or
+					// doesn't match the map mesh, compile map and save the cache
 
-					OctTree->Go(MapMesh);
+					vml::os::Timer timer;
+					timer.Init();
 
-					// log out
-					
-					vml::utils::Logger::GetInstance()->Info("Level : Octree Compiling : " + LevelName +" : Done");
+					if (OctTree->LoadCache(OctCacheFileName, MapMesh, vml::octree::OctTree::FLAT_LAYOUT | vml::octree::OctTree::RAY_QUERIES))
+					{
+						float loadtime = timer.GetElapsedTime() * 1000.0f;
+
+						vml::utils::Logger::GetInstance()->Info("Level : Octree Cached Load : " + std::to_string(loadtime) + " ms, Cold Build : " + std::to_string(OctTree->GetBuildTime()) + " ms");
+					}
+					else
+					{
+						vml::utils::Logger::GetInstance()->Info("Level : Octree Compiling : " + LevelName);
+
+						OctTree->Go(MapMesh, vml::octree::OctTree::FLAT_LAYOUT | vml::octree::OctTree::PARALLEL_BUILD | vml::octree::OctTree::CACHE_LEAF_DATA | vml::octree::OctTree::RAY_QUERIES);
+
+						OctTree->SaveCache(OctCacheFileName);
+
+						float buildtime = timer.GetElapsedTime() * 1000.0f;
+
+						vml::utils::Logger::GetInstance()->Info("Level : Octree Compiling : " + LevelName + " : Done, Cold Build : " + std::to_string(buildtime) + " ms");
+					}
 
 					// we can release map mesh data since we don't use it anymore once the octree is computed
 
@@ -140,6 +197,16 @@ namespace vml
 				}
 
 				
+				// -------------------------------------------------------------------
+				// called once per frame, delivers computed paths to agents,
+				// budget is the time in milliseconds time sliced searches can use
+
+				void UpdatePaths(float budget)
+				{
+					if (PathScheduler)
+						PathScheduler->Update(budget);
+				}
+
 				// -------------------------------------------------------------------
 				// getters
 
@@ -148,10 +215,12 @@ namespace vml
 				vml::meshes::Mesh3d       *GetCollisionMesh()     const { return CollisionMesh; }
 				vml::meshes::Mesh3d       *GetNavMesh()           const { return NavMesh; }
 				vml::geo2d::PathFinder    *GetPathFinder()	      const { return PathFinder; }
+				vml::geo2d::PathScheduler *GetPathScheduler()     const { return PathScheduler; }
 				const std::string         &GetLevelName()	      const { return LevelName; }
 				const std::string         &GetMapMeshFileName()	  const { return MapMeshFileName; }
 				const std::string         &GetColMeshFileName()	  const { return ColMeshFileName; }
 				const std::string         &GetNavMeshFileName()	  const { return NavMeshFileName; }
+				const std::string         &GetColCacheFileName()  const { return ColCacheFileName; }
 
 				// -------------------------------------------------------------------
 				//
@@ -172,6 +241,7 @@ namespace vml
 					NavMesh		   = nullptr;
 					OctTree        = nullptr;
 					PathFinder	   = nullptr;
+					PathScheduler  = nullptr;
 					vml::utils::Logger::GetInstance()->Info("Level : Initting Level");
 				}
 
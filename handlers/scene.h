@@ -181,6 +181,10 @@ namespace vml
 				{
 					if (!vml::utils::bits32::Get(InternalFlags, vml::utils::InternalFlags::INITTED))
 						vml::os::Message::Error("Scene : ","Scene is not initted");
+
+					// deliver paths computed for agents before their controllers run
+
+					Level->UpdatePaths(0.5f);
 			
 					// transfomr pipeline
 
@@ -59,6 +59,134 @@ namespace vml
                         }
                 };
 
+                // ----------------------------------------------------------
+                // abstract graph edge, inter cluster steps and cached
+                // intra cluster distances share the same layout
+
+                struct HierarchyEdge
+                {
+                    int32_t Target;                        // target abstract node
+                    int32_t Cost;                          // octile cost
+                };
+
+                // ----------------------------------------------------------
+                // sidecar file header, followed by nodes, cluster
+                // ranges, edge ranges and edges arrays
+
+                struct HierarchyHeader
+                {
+                    char     Magic[4];                     // 'VHPA'
+                    uint32_t Version;                      // file format version
+                    uint64_t SourceHash;                   // hash of the nav mask and cluster size
+                    int32_t  Width;                        // nav mask width
+                    int32_t  Height;                       // nav mask height
+                    int32_t  ClusterSize;                  // cluster size in cells
+                    int32_t  NodesCount;                   // abstract nodes count
+                    int32_t  EdgesCount;                   // abstract edges count
+                    float    BuildTime;                    // build time in milliseconds
+                };
+
+                // ----------------------------------------------------------
+                // bounded search scratch, indexed by cluster local cells
+
+                struct ClusterScratch
+                {
+                    std::vector<int>                 Distance;
+                    std::vector<int>                 Parent;
+                    std::vector<std::pair<int, int>> Heap;
+                };
+
+                static const uint32_t HIERARCHY_VERSION   = 1;
+                static const int      MAX_ENTRANCE_WIDTH  = 6;
+
+		public:
+
+                // ----------------------------------------------------------
+                // per query search state, a pathfinder is read only while
+                // searching, so queries running on different contexts can
+                // share the same pathfinder from different threads
+
+                class SearchContext
+                {
+                    friend class PathFinder;
+
+                    private:
+
+                        std::vector<int>          Distance;                   // Distance matrix used for pathfinding
+                        std::vector<Node>         Parent;                     // Parent matrix used for reconstructing path
+                        std::vector<unsigned int> Visited;                    // Search generation a cell was last reached in, Distance and Parent are valid only if it matches Generation
+                        unsigned int              Generation;                 // Current search generation
+                        std::vector<Node>         OpenList;                   // Open list binary heap, reused across searches
+                        std::vector<glm::ivec2>   Path;                       // Path cells from target to source
+                        int                       PathCount;
+                        std::vector<glm::vec3>    PAvgrIn;
+                        std::vector<glm::vec3>    PAvgrOut;
+                        std::vector<glm::vec3>    PAvgrDir;
+                        std::vector<float>        PAvgrInvSegmentLength;
+                        std::vector<float>        PAvgrSegmentLength;
+                        int                       PAvgrOutPathCount;
+                        float                     PathLength;
+                        std::vector<int>          HierarchyDistance;          // Abstract search distances, two extra entries for source and target
+                        std::vector<int>          HierarchyParent;            // Abstract search parents
+                        std::vector<std::pair<int, int>> HierarchyOpenList;   // Abstract search open list
+                        std::vector<int>          HierarchyPath;              // Abstract path nodes from source to target
+                        std::vector<int>          HierarchyCells;             // Refined path cells from source to target
+                        ClusterScratch            SourceScratch;              // Source to entrances distances
+                        ClusterScratch            TargetScratch;              // Target to entrances distances
+                        ClusterScratch            RefineScratch;              // Intra cluster segment refinement
+
+                    public:
+
+                        // ----------------------------------------------------------
+                        // allocates maps for a nav mask with the given cells count,
+                        // the smoothed path has one more point than the cells path
+
+                        void Resize(int size)
+                        {
+                            Distance.assign(size, INT_MAX);
+                            Parent.assign(size, Node(-1, -1));
+                            Visited.assign(size, 0);
+                            Path.assign(size, glm::ivec2(0, 0));
+                            PAvgrIn.resize(size);
+                            PAvgrOut.resize(size + 1);
+                            PAvgrDir.resize(size + 1);
+                            PAvgrInvSegmentLength.resize(size + 1);
+                            PAvgrSegmentLength.resize(size + 1);
+                            OpenList.reserve(size < 65536 ? size : 65536);
+                            Generation        = 0;
+                            PathCount         = 0;
+                            PAvgrOutPathCount = 0;
+                            PathLength        = 0.0f;
+                        }
+
+                        // ----------------------------------------------------------
+                        // getters
+
+                        int   GetPathCount()                    const { return PAvgrOutPathCount; }
+                        int   GetCellsCount()                   const { return PathCount; }
+                        float GetPathLength()                   const { return PathLength; }
+                        const glm::vec3* GetPAvgrOut()          const { return PAvgrOut.data(); }
+                        const glm::vec3* GetPAvgrDir()          const { return PAvgrDir.data(); }
+                        const float* GetPAvgrInvSegmentLength() const { return PAvgrInvSegmentLength.data(); }
+                        const float* GetPAvgrSegmentLength()    const { return PAvgrSegmentLength.data(); }
+
+                        // ----------------------------------------------------------
+                        // ctor / dtor
+
+                        SearchContext()
+                        {
+                            Generation        = 0;
+                            PathCount         = 0;
+                            PAvgrOutPathCount = 0;
+                            PathLength        = 0.0f;
+                        }
+
+                        ~SearchContext()
+                        {}
+                };
+
+		private:
+
 				// ----------------------------------------------------------
 				//
                     
@@ -71,49 +199,60 @@ namespace vml
 				std::string    FileName;                   // File name
                 unsigned char *Data;                       // Data made of 0s and 1s as a monochrome bitmap
                 int           *IdData;                     // Connected componennts bitmap
-                int           *Distance;                   // Distance matrix usde for pathfinding
-                Node          *Parent;                     // Parent matrix used for reconstrucintg path
                 Node           Adjacent[8];                // Vector to store adjacent cell grid nodes
                 glm::vec3     *Pa;                         // first vertex of mesh quad
                 glm::vec3     *Pb;                         // second vertex of mesh quad
                 glm::vec3     *Pc;                         // third vertex of mesh quad
                 glm::vec3     *Pd;                         // forth vertex of mesh quad
-                glm::vec3     *PAvgrIn;
-                glm::vec3     *PAvgrOut;
-                glm::vec3     *PAvgrDir;
-                float         *PAvgrInvSegmentLength;
-                float         *PAvgrSegmentLength;
-                glm::ivec2    *Path;
-                int            PathCount;
-                int            PAvgrOutPathCount;
                 glm::vec3      BoundingBoxMin;
                 glm::vec3      BoundingBoxMax;
                 int            AvgNeighbours;
                 int            Ai, Aj;
                 int            Bi, Bj;
-                float          PathLength;
+                SearchContext  Context;                    // Search state used by FindPath without a context
+                int            SearchMode;                 // Search algorithm used by FindPath
+                int            ClusterSize;                // Hierarchy cluster size in cells, 0 if hierarchy is not built
+                int            ClustersX;                  // Hierarchy clusters count along x
+                int            ClustersY;                  // Hierarchy clusters count along y
+                uint64_t       HierarchySourceHash;        // Hash of the nav mask the hierarchy was built from
+                float          HierarchyBuildTime;         // Hierarchy build time in milliseconds
+                std::vector<int> HierarchyNodes;           // Abstract nodes cell offsets, sorted by cluster
+                std::vector<int> HierarchyClusterFirst;    // First abstract node of each cluster, clusters count + 1 entries
+                std::vector<int> HierarchyEdgeFirst;       // First edge of each abstract node, nodes count + 1 entries
+                std::vector<HierarchyEdge> HierarchyEdges; // Abstract edges
 
                 // ------------------------------------------------------------------------------
                 //
 
                 void LoadFile2()
                 {
-                    FILE* stream;
+                    // mask is read from a mapped file or from a mounted archive
 
-                    errno_t err = fopen_s(&stream, FileName.c_str(), "rb");
+                    vml::os::FileView file;
 
-                    if (err == 0)
+                    if (file.Open(FileName))
                     {
+                        size_t position = 0;
+
+                        auto read = [this, &file, &position](void* data, size_t size)
+                        {
+                            const void* src = file.GetDataAt(position, size);
+                            if (!src)
+                                vml::os::Message::Error("PathFinder : ", "Corrupted nav mask ' ", FileName.c_str(), " '");
+                            memcpy(data, src, size);
+                            position += size;
+                        };
+
 						unsigned int maskw;
 						unsigned int maskh;
                         float maskdw;
                         float maskdh;
 
-						fread(&maskw, sizeof(unsigned int), 1, stream);
-						fread(&maskh, sizeof(unsigned int), 1, stream);
+						read(&maskw, sizeof(unsigned int));
+						read(&maskh, sizeof(unsigned int));
 
-                        fread(&maskdw, sizeof(unsigned int), 1, stream);
-                        fread(&maskdh, sizeof(unsigned int), 1, stream);
+                        read(&maskdw, sizeof(unsigned int));
+                        read(&maskdh, sizeof(unsigned int));
 
                         Width  = maskw;
                         Height = maskh;
@@ -131,25 +270,16 @@ namespace vml
 
                         Data                  = new unsigned char[Size];
                         IdData                = new int[Size];
-                        Distance              = new int[Size];
-                        Parent                = new Node[Size];
-                        Path                  = new glm::ivec2[Size];
                         Pa                    = new glm::vec3[Size];
                         Pb                    = new glm::vec3[Size];
                         Pc                    = new glm::vec3[Size];
                         Pd                    = new glm::vec3[Size];
-                        PAvgrIn               = new glm::vec3[Size];
-                        PAvgrOut              = new glm::vec3[Size];
-                        PAvgrDir              = new glm::vec3[Size];
-                        PAvgrInvSegmentLength = new float[Size];
-                        PAvgrSegmentLength    = new float[Size];
 
                         // init data for path finding
 
                         for (size_t i = 0; i < Size; ++i) IdData[i]   = -1;
-                        for (size_t i = 0; i < Size; ++i) Distance[i] =  INT_MAX;
-                        for (size_t i = 0; i < Size; ++i) Parent[i]   =  Node(-1, -1);
-                        for (size_t i = 0; i < Size; ++i) Path[i]     =  glm::ivec2(0, 0);
+
+                        Context.Resize(Size);
 
                         // read data
 
@@ -166,26 +296,26 @@ namespace vml
                                 glm::vec3 rc(-FLT_MAX, -FLT_MAX, -FLT_MAX);
                                 glm::vec3 rd(-FLT_MAX, -FLT_MAX, -FLT_MAX);
 
-                                fread(&di, sizeof(unsigned int), 1, stream);
-                                fread(&dj, sizeof(unsigned int), 1, stream);
+                                read(&di, sizeof(unsigned int));
+                                read(&dj, sizeof(unsigned int));
 
-								fread(&ra.x, sizeof(float), 1, stream);
-								fread(&ra.y, sizeof(float), 1, stream);
-								fread(&ra.z, sizeof(float), 1, stream);
+								read(&ra.x, sizeof(float));
+								read(&ra.y, sizeof(float));
+								read(&ra.z, sizeof(float));
 
-                                fread(&rb.x, sizeof(float), 1, stream);
-                                fread(&rb.y, sizeof(float), 1, stream);
-                                fread(&rb.z, sizeof(float), 1, stream);
+                                read(&rb.x, sizeof(float));
+                                read(&rb.y, sizeof(float));
+                                read(&rb.z, sizeof(float));
 
-                                fread(&rc.x, sizeof(float), 1, stream);
-                                fread(&rc.y, sizeof(float), 1, stream);
-                                fread(&rc.z, sizeof(float), 1, stream);
+                                read(&rc.x, sizeof(float));
+                                read(&rc.y, sizeof(float));
+                                read(&rc.z, sizeof(float));
 
-                                fread(&rd.x, sizeof(float), 1, stream);
-                                fread(&rd.y, sizeof(float), 1, stream);
-                                fread(&rd.z, sizeof(float), 1, stream);
+                                read(&rd.x, sizeof(float));
+                                read(&rd.y, sizeof(float));
+                                read(&rd.z, sizeof(float));
 
-                                fread(&val, sizeof(unsigned int), 1, stream);
+                                read(&val, sizeof(unsigned int));
 
                                 unsigned int offset = di + Width * dj;
 
@@ -211,10 +341,9 @@ namespace vml
 
 						}
 
-                        // close stream
+                        // close file
                         
-                        if (fclose(stream) != 0)
-                            vml::os::Message::Error("PathFinder : ", "Cannot close ' ", FileName.c_str(), " '");
+                        file.Close();
 
                         // compute connected components
                         // the idData bitmap array will contain
@@ -257,7 +386,7 @@ namespace vml
                     }
                     else
                     {
-                        vml::os::Message::Error("PathFinder : ", "Cannot load mesh ' ", FileName.c_str(), " '", " ( error code : ", err, " )");
+                        vml::os::Message::Error("PathFinder : ", "Cannot load mesh ' ", FileName.c_str(), " '");
                     }
 
                 }
@@ -490,623 +619,1800 @@ namespace vml
                 }
 
                 // ------------------------------------------------------------------------------
-                //
-
-                int heuristic(const Node& start, const Node& dest)
-                {
-                    int dx = start.X - dest.X;
-                    int dy = start.Y - dest.Y;
-                    return dx * dx + dy * dy;
-                }
-
-                // ------------------------------------------------------------------------------
-                //
-
-                int heuristic2(const Node& start, const Node& dest)
-                {
-                    return abs(start.X - dest.X) + abs(start.Y - dest.Y);
-                }
-
-		public:
-
-                // ----------------------------------------------------------
-                //
-
-                class DebugCell
-                {
-                    public:
-
-                        glm::vec3 Pa;          // first vertex of mesh quad
-                        glm::vec3 Pb;          // second vertex of mesh quad
-                        glm::vec3 Pc;          // third vertex of mesh quad
-                        glm::vec3 Pd;          // forth vertex of mesh quad
-                        int       IdData;      // Connected componennts bitmap
-
-                        // ------------------------------------------------------------------------
-                        // ctor / dtor
-
-                        DebugCell()
-                        {
-                            Pa = glm::vec3(0, 0, 0);
-                            Pb = glm::vec3(0, 0, 0);
-                            Pc = glm::vec3(0, 0, 0);
-                            Pd = glm::vec3(0, 0, 0);
-                            IdData = -1;
-                        }
-
-                        ~DebugCell()
-                        {}
-
-                };
-
-                // ---------------------------------------------------------------
-                //
-
-                int   GetSize()                         const { return Size; }
-                int   GetWidth()                        const { return Width; }
-                int   GetHeight()                       const { return Height; }
-                float GetDw()                           const { return Dw; }
-                float GetDh()                           const { return Dh; }
-                const glm::vec3& GetBoundingBoxMin()    const { return BoundingBoxMin; }
-                const glm::vec3& GetBoundingBoxMax()    const { return BoundingBoxMax; }
-                int   GetPathCount()                    const { return PAvgrOutPathCount; }
-                const glm::vec3* GetPAvgrOut()          const { return PAvgrOut; }
-                const glm::vec3* GetPAvgrDir()          const { return PAvgrDir; }
-                const float *GetPAvgrInvSegmentLength() const { return PAvgrInvSegmentLength; }
-                const float* GetPAvgrSegmentLength()    const { return PAvgrSegmentLength; }
-                float GetZDepth()                       const { return ZDepth; }
-
-                // -------------------------------------------------------------
-                //
+                // starts a new search, cells visited by previous searches are
+                // invalidated by moving to the next generation, so maps don't
+                // need to be cleared, stamps are reset only when generation wraps
 
-                bool IsPointInNavMesh(const glm::vec3& ra, const glm::vec3& rb) const
+                void BeginSearch(SearchContext& ctx) const
                 {
-                    
-                    glm::vec3 p;
-                    float t;
-
-                    glm::vec3 bmin = BoundingBoxMin;
-                    glm::vec3 bmax = BoundingBoxMax;
+                    ctx.Generation++;
 
-                    if (!vml::geo3d::intersections::TriangleVsRay(glm::vec3(bmin.x, bmin.y, bmin.z),
-                                                                  glm::vec3(bmin.x, bmax.y, bmin.z),
-                                                                  glm::vec3(bmax.x, bmax.y, bmin.z),
-                                                                  ra, rb, p, t))
+                    if (ctx.Generation == 0)
                     {
-                        if (!vml::geo3d::intersections::TriangleVsRay(glm::vec3(bmin.x, bmin.y, bmin.z),
-                                                                      glm::vec3(bmax.x, bmax.y, bmin.z),
-                                                                      glm::vec3(bmax.x, bmin.y, bmin.z),
-                                                                      ra, rb, p, t))
-                        {
-                            return false;
-                        }
+                        for (size_t i = 0; i < Size; ++i) ctx.Visited[i] = 0;
+                        ctx.Generation = 1;
                     }
-                    
-                    return true;
-                }
-                            
-                // ---------------------------------------------------------------
-                //
-
-                glm::vec3 GetCellCenterFromPoint(const glm::vec3& p) const
-                {
-                    int i = (int)((p.x - BoundingBoxMin.x) / Dw);
-                    int j = (int)((p.y - BoundingBoxMin.y) / Dh);
-                    if (i < 0 || j < 0 || i >= Width || j >= Height)
-                        vml::os::Message::Error("Pathfinder : ","index out of range");
-                    int offset = i + j * Width;
-                    return  ( Pa[offset] + Pd[offset] )*0.5f;
-                }
-
-                // ---------------------------------------------------------------
-                //
 
-                int GetCellAddressFromPoint(const glm::vec3& p) const
-                {
-                    int i = (int)((p.x - BoundingBoxMin.x) / Dw);
-                    int j = (int)((p.y - BoundingBoxMin.y) / Dh);
-                    if (i < 0 || j < 0 || i >= Width || j >= Height)
-                        vml::os::Message::Error("Pathfinder : ", "index out of range");
-                    return i + j * Width;
+                    ctx.OpenList.clear();
                 }
 
-                // ---------------------------------------------------------------
-                //
+                // ------------------------------------------------------------------------------
+                // open list binary heap, lowest F on top, same ordering as std::priority_queue
 
-                glm::ivec2 GetCellIndicesFromPoint(const glm::vec3& p) const
+                void PushOpenNode(SearchContext& ctx, const Node& node) const
                 {
-                    int i = (int)((p.x - BoundingBoxMin.x) / Dw);
-                    int j = (int)((p.y - BoundingBoxMin.y) / Dh);
-                    if (i < 0 || j < 0 || i >= Width || j >= Height)
-                        vml::os::Message::Error("Pathfinder : ", "index out of range");
-                    return glm::vec2 (i,j);
+                    ctx.OpenList.emplace_back(node);
+                    std::push_heap(ctx.OpenList.begin(), ctx.OpenList.end(), CompareNode());
                 }
 
-                // ---------------------------------------------------------------
-                //
-
-                int GetCellIdFromIndices(int i, int j) const
+                Node PopOpenNode(SearchContext& ctx) const
                 {
-                    if (i < 0 || j < 0 || i >= Width || j >= Height)
-                        vml::os::Message::Error("Pathfinder : ","index out of range");
-                    return IdData[i + j * Width];
+                    std::pop_heap(ctx.OpenList.begin(), ctx.OpenList.end(), CompareNode());
+                    Node node = ctx.OpenList.back();
+                    ctx.OpenList.pop_back();
+                    return node;
                 }
 
-                // ---------------------------------------------------------------
+                // ------------------------------------------------------------------------------
                 //
 
-                glm::vec3 GetCellCenterFromIndices(int i, int j) const
+                int heuristic(const Node& start, const Node& dest) const
                 {
-                    if (i < 0 || j < 0 || i >= Width || j >= Height)
-                        vml::os::Message::Error("Pathfinder : ", "index out of range");
-                    int offset = i + j * Width;
-                    return (Pa[offset] + Pd[offset]) * 0.5f;
+                    int dx = start.X - dest.X;
+                    int dy = start.Y - dest.Y;
+                    return dx * dx + dy * dy;
                 }
 
-                // ---------------------------------------------------------------
+                // ------------------------------------------------------------------------------
                 //
 
-                float GetPathLength() const
+                int heuristic2(const Node& start, const Node& dest) const
                 {
-                    return PathLength;
+                    return abs(start.X - dest.X) + abs(start.Y - dest.Y);
                 }
 
-                // ---------------------------------------------------------------
-                //
+                // ------------------------------------------------------------------------------
+                // greedy best first search over the 8-connected grid, stores the path
+                // into the path array from target to source
 
-                void GetCellVertices(int x, int y, glm::vec3& p0, glm::vec3& p1, glm::vec3& p2, glm::vec3& p3)
+                void AStarSearch(SearchContext& ctx, int ai, int aj, int bi, int bj) const
                 {
-                    if (x < 0) vml::os::Message::Error("PathFinder : ", "x component is less than 0");
-                    if (y < 0) vml::os::Message::Error("PathFinder : ", "y component is less than 0");
-                    if (x >= Width) vml::os::Message::Error("PathFinder : ", "x component is greater than Width ( ", Width, " )");
-                    if (y >= Height) vml::os::Message::Error("PathFinder : ", "y component is greater than Width ( ", Height, " )");
-
-                    int offset = x + y * Width;
-
-                    p0 = Pa[offset];
-                    p1 = Pb[offset];
-                    p2 = Pc[offset];
-                    p3 = Pd[offset];
+                    // start a new search generation, no need to clear maps
 
-                }
+                    BeginSearch(ctx);
+                    
+                    Node start;
+                    Node dest;
+                    Node adj;
+                    int aoffset;
+                    int uoffset;
 
-                // ------------------------------------------------------------------------------
-                //
-                
-                void SetZDepth(const float zdepth)
-                {
-                    ZDepth = zdepth;
-                }
+                    start.X = ai;
+                    start.Y = aj;
+                    start.G = 0;
+                    start.H = heuristic(start, dest);
+                    start.F = start.G + start.H;
 
-                // ------------------------------------------------------------------------------
-                //
+                    dest.X = bi;
+                    dest.Y = bj;
+                    dest.G = 0;
+                    dest.H = 0;
+                    dest.F = 0;
 
-                int FindPath(const glm::vec3 &origin,int ai, int aj, int bi, int bj)
-                {
-                                       
-                    // points are coinciding , there is no path
+                    // set initial distance to zero
 
-                    PathCount         =  0;
-                    PAvgrOutPathCount =  0;
-                    Ai                = ai;
-                    Aj                = aj;
-                    Bi                = bi;
-                    Bj                = bj;
+                    ctx.Distance[start.X + start.Y * Width] = 0;
+                    ctx.Visited[start.X + start.Y * Width]  = ctx.Generation;
 
-                    if (ai < 0) vml::os::Message::Error("PathFinder : ", "ai component is less than 0");
-                    if (aj < 0) vml::os::Message::Error("PathFinder : ", "aj component is less than 0");
-                    if (ai >= Width) vml::os::Message::Error("PathFinder : ", "ai component is greater than Width ( ", Width," )");
-                    if (aj >= Height) vml::os::Message::Error("PathFinder : ", "aj component is greater than Width ( ", Height," )");
+                    // init path finding
 
-                    if (bi < 0) vml::os::Message::Error("PathFinder : ", "bi component is less than 0");
-                    if (bj < 0) vml::os::Message::Error("PathFinder : ", "bj component is less than 0");
-                    if (bi >= Width) vml::os::Message::Error("PathFinder : ", "bi component is greater than Width ( ", Width," )");
-                    if (bj >= Height) vml::os::Message::Error("PathFinder : ", "bj component is greater than Width ( ", Height," )");
+                    PushOpenNode(ctx, start);
+                    
+                    while (!ctx.OpenList.empty())
+                    {
+                        // pop current node
 
-                    // path starts and ends in the same cell
+                        Node u = PopOpenNode(ctx);
 
-                    if (ai == bi && aj == bj)
-                        return 0;
+                        // parents are fixed when a cell is first reached, so
+                        // the path to the target can't change once it is popped
 
-                    int offseta = ai + aj * Width;
-                    int offsetb = bi + bj * Width;
+                        if (u.X == dest.X && u.Y == dest.Y)
+                            break;
 
-                //    if (IdData[offseta] != -1 && IdData[offsetb] != -1)
-                //    {
-                //       DrawCell(view, ai, aj, vml::colors::Green);
-                //       DrawCell(view, bi, bj, vml::colors::Yellow);
-                //   }
-                //    else
-                //    {
-                //      DrawCell(view, ai, aj, vml::colors::Red);
-                //       DrawCell(view, bi, bj, vml::colors::Red);
-                //    }
+                        // current cell address
 
-                    if (IdData[offseta] == -1 || IdData[offsetb] == -1)
-                        return 0;
+                        uoffset = u.X + u.Y * Width;
 
-                    // source and target are on the same
-                    // separated sub - bitmap
+                        // compute adjacent cells
 
-                    if (IdData[offseta] == IdData[offsetb])
-                    {
-                        Ai = ai;
-                        Aj = aj;
-                        Bi = bi;
-                        Bj = bj;
+                        int i = u.X;
+                        int j = u.Y;
 
-                        // auto timerstart = std::chrono::steady_clock::now();
+                        long a = i - 1;
+                        long b = j - 1;
+                        long c = i + 1;
+                        long d = j + 1;
 
-                        std::priority_queue<Node, std::vector<Node>, CompareNode> Queue;
+                        // topleft cell
 
-                        // clear maps
+                        if (a >= 0 && b >= 0)
+                        {
+                            aoffset = a + b * Width;
 
-                        for (size_t i = 0; i < Size; ++i) Distance[i] = INT_MAX;
-                        for (size_t i = 0; i < Size; ++i) Parent[i]   = Node(-1, -1);
-                        
-                        Node start;
-                        Node dest;
-                        Node adj;
-                        int aoffset;
-                        int uoffset;
+                            if (Data[aoffset])
+                            {
 
-                        start.X = ai;
-                        start.Y = aj;
-                        start.G = 0;
-                        start.H = heuristic(start, dest);
-                        start.F = start.G + start.H;
+                                adj.X = a;
+                                adj.Y = b;
+                                adj.G = ctx.Distance[uoffset];
+                                adj.H = heuristic(adj, dest);
+                                adj.F = adj.G + adj.H;
 
-                        dest.X = bi;
-                        dest.Y = bj;
-                        dest.G = 0;
-                        dest.H = 0;
-                        dest.F = 0;
+                                if (ctx.Visited[aoffset] != ctx.Generation)
+                                {
+                                    // 2 and 1 are squared of 1.41 and 1 for distance computation
 
-                        // set initial distance to zero
+                                    PushOpenNode(ctx, adj);
+                                    ctx.Distance[aoffset] = ctx.Distance[uoffset] + 2;
+                                    ctx.Parent[aoffset] = u;
+                                    ctx.Visited[aoffset] = ctx.Generation;
 
-                        Distance[start.X + start.Y * Width] = 0;
+                                }
+                            }
+                        }
 
-                        // init path finding
+                        // top cell
 
-                        Queue.push(start);
-                        
-                        while (!Queue.empty())
+                        if (i >= 0 && b >= 0)
                         {
-                            // pop current node
+                            aoffset = i + b * Width;
 
-                            Node u = Queue.top();
-
-                            Queue.pop();
+                            if (Data[aoffset])
+                            {
 
-                            // current cell address
+                                adj.X = i;
+                                adj.Y = b;
+                                adj.G = ctx.Distance[uoffset];
+                                adj.H = heuristic(adj, dest);
+                                adj.F = adj.G + adj.H;
 
-                            uoffset = u.X + u.Y * Width;
+                                if (ctx.Visited[aoffset] != ctx.Generation)
+                                {
+                                    // 2 and 1 are squared of 1.41 and 1 for distance computation
 
-                            // compute adjacent cells
+                                    PushOpenNode(ctx, adj);
+                                    ctx.Distance[aoffset] = ctx.Distance[uoffset] + 1;
+                                    ctx.Parent[aoffset] = u;
+                                    ctx.Visited[aoffset] = ctx.Generation;
 
-                            int i = u.X;
-                            int j = u.Y;
+                                }
+                            }
+                        }
 
-                            long a = i - 1;
-                            long b = j - 1;
-                            long c = i + 1;
-                            long d = j + 1;
+                        // top right cell
 
-                            // topleft cell
+                        if (c < Width && b >= 0)
+                        {
+                            aoffset = c + b * Width;
 
-                            if (a >= 0 && b >= 0)
+                            if (Data[c + b * Width])
                             {
-                                aoffset = a + b * Width;
 
-                                if (Data[aoffset])
+                                adj.X = c;
+                                adj.Y = b;
+                                adj.G = ctx.Distance[uoffset];
+                                adj.H = heuristic(adj, dest);
+                                adj.F = adj.G + adj.H;
+
+                                if (ctx.Visited[aoffset] != ctx.Generation)
                                 {
+                                    // 2 and 1 are squared of 1.41 and 1 for distance computation
 
-                                    adj.X = a;
-                                    adj.Y = b;
-                                    adj.G = Distance[uoffset];
-                                    adj.H = heuristic(adj, dest);
-                                    adj.F = adj.G + adj.H;
+                                    PushOpenNode(ctx, adj);
+                                    ctx.Distance[aoffset] = ctx.Distance[uoffset] + 2;
+                                    ctx.Parent[aoffset] = u;
+                                    ctx.Visited[aoffset] = ctx.Generation;
 
-                                    if (Distance[aoffset] == INT_MAX)
-                                    {
-                                        // 2 and 1 are squared of 1.41 and 1 for distance computation
-
-                                        Queue.push(adj);
-                                        Distance[aoffset] = Distance[uoffset] + 2;
-                                        Parent[aoffset] = u;
-
-                                    }
                                 }
                             }
+                        }
 
-                            // top cell
+                        // left cell
 
-                            if (i >= 0 && b >= 0)
-                            {
-                                aoffset = i + b * Width;
+                        if (a >= 0)
+                        {
+                            aoffset = a + j * Width;
 
-                                if (Data[aoffset])
-                                {
+                            if (Data[aoffset])
+                            {
 
-                                    adj.X = i;
-                                    adj.Y = b;
-                                    adj.G = Distance[uoffset];
-                                    adj.H = heuristic(adj, dest);
-                                    adj.F = adj.G + adj.H;
+                                adj.X = a;
+                                adj.Y = j;
+                                adj.G = ctx.Distance[uoffset];
+                                adj.H = heuristic(adj, dest);
+                                adj.F = adj.G + adj.H;
 
-                                    if (Distance[aoffset] == INT_MAX)
-                                    {
-                                        // 2 and 1 are squared of 1.41 and 1 for distance computation
+                                if (ctx.Visited[aoffset] != ctx.Generation)
+                                {
+                                    // 2 and 1 are squared of 1.41 and 1 for distance computation
 
-                                        Queue.push(adj);
-                                        Distance[aoffset] = Distance[uoffset] + 1;
-                                        Parent[aoffset] = u;
+                                    PushOpenNode(ctx, adj);
+                                    ctx.Distance[aoffset] = ctx.Distance[uoffset] + 1;
+                                    ctx.Parent[aoffset] = u;
+                                    ctx.Visited[aoffset] = ctx.Generation;
 
-                                    }
                                 }
                             }
+                        }
 
-                            // top right cell
+                        // right cell
 
-                            if (c < Width && b >= 0)
-                            {
-                                aoffset = c + b * Width;
+                        if (c < Width)
+                        {
+                            aoffset = c + j * Width;
 
-                                if (Data[c + b * Width])
-                                {
+                            if (Data[aoffset])
+                            {
 
-                                    adj.X = c;
-                                    adj.Y = b;
-                                    adj.G = Distance[uoffset];
-                                    adj.H = heuristic(adj, dest);
-                                    adj.F = adj.G + adj.H;
+                                adj.X = c;
+                                adj.Y = j;
+                                adj.G = ctx.Distance[uoffset];
+                                adj.H = heuristic(adj, dest);
+                                adj.F = adj.G + adj.H;
 
-                                    if (Distance[aoffset] == INT_MAX)
-                                    {
-                                        // 2 and 1 are squared of 1.41 and 1 for distance computation
+                                if (ctx.Visited[aoffset] != ctx.Generation)
+                                {
+                                    // 2 and 1 are squared of 1.41 and 1 for distance computation
 
-                                        Queue.push(adj);
-                                        Distance[aoffset] = Distance[uoffset] + 2;
-                                        Parent[aoffset] = u;
+                                    PushOpenNode(ctx, adj);
+                                    ctx.Distance[aoffset] = ctx.Distance[uoffset] + 1;
+                                    ctx.Parent[aoffset] = u;
+                                    ctx.Visited[aoffset] = ctx.Generation;
 
-                                    }
                                 }
                             }
+                        }
 
-                            // left cell
+                        // bottom left cell
 
-                            if (a >= 0)
-                            {
-                                aoffset = a + j * Width;
+                        if (a >= 0 && d < Height)
+                        {
+                            aoffset = a + d * Width;
 
-                                if (Data[aoffset])
-                                {
+                            if (Data[aoffset])
+                            {
 
-                                    adj.X = a;
-                                    adj.Y = j;
-                                    adj.G = Distance[uoffset];
-                                    adj.H = heuristic(adj, dest);
-                                    adj.F = adj.G + adj.H;
+                                adj.X = a;
+                                adj.Y = d;
+                                adj.G = ctx.Distance[uoffset];
+                                adj.H = heuristic(adj, dest);
+                                adj.F = adj.G + adj.H;
 
-                                    if (Distance[aoffset] == INT_MAX)
-                                    {
-                                        // 2 and 1 are squared of 1.41 and 1 for distance computation
+                                if (ctx.Visited[aoffset] != ctx.Generation)
+                                {
+                                    // 2 and 1 are squared of 1.41 and 1 for distance computation
 
-                                        Queue.push(adj);
-                                        Distance[aoffset] = Distance[uoffset] + 1;
-                                        Parent[aoffset] = u;
+                                    PushOpenNode(ctx, adj);
+                                    ctx.Distance[aoffset] = ctx.Distance[uoffset] + 2;
+                                    ctx.Parent[aoffset] = u;
+                                    ctx.Visited[aoffset] = ctx.Generation;
 
-                                    }
                                 }
                             }
+                        }
 
-                            // right cell
+                        // bottom cell
 
-                            if (c < Width)
-                            {
-                                aoffset = c + j * Width;
+                        if (d < Height)
+                        {
+                            aoffset = i + d * Width;
 
-                                if (Data[aoffset])
-                                {
+                            if (Data[aoffset])
+                            {
 
-                                    adj.X = c;
-                                    adj.Y = j;
-                                    adj.G = Distance[uoffset];
-                                    adj.H = heuristic(adj, dest);
-                                    adj.F = adj.G + adj.H;
+                                adj.X = i;
+                                adj.Y = d;
+                                adj.G = ctx.Distance[uoffset];
+                                adj.H = heuristic(adj, dest);
+                                adj.F = adj.G + adj.H;
 
-                                    if (Distance[aoffset] == INT_MAX)
-                                    {
-                                        // 2 and 1 are squared of 1.41 and 1 for distance computation
+                                if (ctx.Visited[aoffset] != ctx.Generation)
+                                {
+                                    // 2 and 1 are squared of 1.41 and 1 for distance computation
 
-                                        Queue.push(adj);
-                                        Distance[aoffset] = Distance[uoffset] + 1;
-                                        Parent[aoffset] = u;
+                                    PushOpenNode(ctx, adj);
+                                    ctx.Distance[aoffset] = ctx.Distance[uoffset] + 1;
+                                    ctx.Parent[aoffset] = u;
+                                    ctx.Visited[aoffset] = ctx.Generation;
 
-                                    }
                                 }
                             }
+                        }
 
-                            // bottom left cell
+                        // bottom right cell
 
-                            if (a >= 0 && d < Height)
-                            {
-                                aoffset = a + d * Width;
+                        if (c < Width && d < Height)
+                        {
+                            aoffset = c + d * Width;
 
-                                if (Data[aoffset])
-                                {
+                            if (Data[aoffset])
+                            {
 
-                                    adj.X = a;
-                                    adj.Y = d;
-                                    adj.G = Distance[uoffset];
-                                    adj.H = heuristic(adj, dest);
-                                    adj.F = adj.G + adj.H;
+                                adj.X = c;
+                                adj.Y = d;
+                                adj.G = ctx.Distance[uoffset];
+                                adj.H = heuristic(adj, dest);
+                                adj.F = adj.G + adj.H;
 
-                                    if (Distance[aoffset] == INT_MAX)
-                                    {
-                                        // 2 and 1 are squared of 1.41 and 1 for distance computation
+                                if (ctx.Visited[aoffset] != ctx.Generation)
+                                {
+                                    // 2 and 1 are squared of 1.41 and 1 for distance computation
 
-                                        Queue.push(adj);
-                                        Distance[aoffset] = Distance[uoffset] + 2;
-                                        Parent[aoffset] = u;
+                                    PushOpenNode(ctx, adj);
+                                    ctx.Distance[aoffset] = ctx.Distance[uoffset] + 2;
+                                    ctx.Parent[aoffset] = u;
+                                    ctx.Visited[aoffset] = ctx.Generation;
 
-                                    }
                                 }
                             }
+                        }
+                    }
+                    
+                    // store path into path array
 
-                            // bottom cell
+                    Node point = dest;
 
-                            if (d < Height)
-                            {
-                                aoffset = i + d * Width;
+                    bool found = false;
 
-                                if (Data[aoffset])
-                                {
+                    ctx.Path[0].x = point.X;
+                    ctx.Path[0].y = point.Y;
 
-                                    adj.X = i;
-                                    adj.Y = d;
-                                    adj.G = Distance[uoffset];
-                                    adj.H = heuristic(adj, dest);
-                                    adj.F = adj.G + adj.H;
+                    ctx.PathCount = 1;
 
-                                    if (Distance[aoffset] == INT_MAX)
-                                    {
-                                        // 2 and 1 are squared of 1.41 and 1 for distance computation
+                    while (!found)
+                    {
 
-                                        Queue.push(adj);
-                                        Distance[aoffset] = Distance[uoffset] + 1;
-                                        Parent[aoffset] = u;
+                        if (point.X == start.X && point.Y == start.Y)
+                        {
+                            found = true;
+                        }
+                        else
+                        {
 
-                                    }
-                                }
-                            }
+                            point = ctx.Parent[dest.X + dest.Y * Width];
 
-                            // bottom right cell
+                            ctx.Path[ctx.PathCount].x = point.X;
+                            ctx.Path[ctx.PathCount].y = point.Y;
 
-                            if (c < Width && d < Height)
-                            {
-                                aoffset = c + d * Width;
+                            ctx.PathCount++;
 
-                                if (Data[aoffset])
-                                {
+                            dest = point;
 
-                                    adj.X = c;
-                                    adj.Y = d;
-                                    adj.G = Distance[uoffset];
-                                    adj.H = heuristic(adj, dest);
-                                    adj.F = adj.G + adj.H;
+                        }
 
-                                    if (Distance[aoffset] == INT_MAX)
-                                    {
-                                        // 2 and 1 are squared of 1.41 and 1 for distance computation
+                    }
+                }
 
-                                        Queue.push(adj);
-                                        Distance[aoffset] = Distance[uoffset] + 2;
-                                        Parent[aoffset] = u;
+                // ------------------------------------------------------------------------------
+                // jump point search helpers, the grid is 8-connected and diagonal moves
+                // may cut corners, the same connectivity used by the connected components
+                // bitmap, so any pair in the same component is reachable
 
-                                    }
-                                }
-                            }
-                        }
-                        
-                        // store path into path array
+                static const int STRAIGHT_COST = 1000;
+                static const int DIAGONAL_COST = 1414;
+
+                bool IsWalkable(int x, int y) const
+                {
+                    return x >= 0 && y >= 0 && x < Width && y < Height && Data[x + y * Width];
+                }
+
+                int OctileDistance(int ax, int ay, int bx, int by) const
+                {
+                    int dx = abs(ax - bx);
+                    int dy = abs(ay - by);
+
+                    if (dx > dy)
+                        return STRAIGHT_COST * dx + (DIAGONAL_COST - STRAIGHT_COST) * dy;
+
+                    return STRAIGHT_COST * dy + (DIAGONAL_COST - STRAIGHT_COST) * dx;
+                }
+
+                // ------------------------------------------------------------------------------
+                // scans along an horizontal or vertical direction, stops at the
+                // target or at the first cell with a forced neighbour
 
-                        Node point = dest;
+                bool JumpStraight(int x, int y, int dx, int dy, int bi, int bj, int& jx, int& jy) const
+                {
+                    while (true)
+                    {
+                        x += dx;
+                        y += dy;
 
-                        bool found = false;
+                        if (!IsWalkable(x, y))
+                            return false;
 
-                        Path[0].x = point.X;
-                        Path[0].y = point.Y;
+                        bool forced;
 
-                        PathCount = 1;
+                        if (dx != 0)
+                            forced = (IsWalkable(x + dx, y + 1) && !IsWalkable(x, y + 1)) ||
+                                     (IsWalkable(x + dx, y - 1) && !IsWalkable(x, y - 1));
+                        else
+                            forced = (IsWalkable(x + 1, y + dy) && !IsWalkable(x + 1, y)) ||
+                                     (IsWalkable(x - 1, y + dy) && !IsWalkable(x - 1, y));
 
-                        while (!found)
+                        if ((x == bi && y == bj) || forced)
                         {
+                            jx = x;
+                            jy = y;
+                            return true;
+                        }
+                    }
+                }
 
-                            if (point.X == start.X && point.Y == start.Y)
-                            {
-                                found = true;
-                            }
-                            else
-                            {
+                // ------------------------------------------------------------------------------
+                // scans along a direction, diagonal steps stop where one of the
+                // straight scans they spawn finds a jump point
 
-                                point = Parent[dest.X + dest.Y * Width];
+                bool Jump(int x, int y, int dx, int dy, int bi, int bj, int& jx, int& jy) const
+                {
+                    if (dx == 0 || dy == 0)
+                        return JumpStraight(x, y, dx, dy, bi, bj, jx, jy);
 
-                                Path[PathCount].x = point.X;
-                                Path[PathCount].y = point.Y;
+                    int tx, ty;
 
-                                PathCount++;
+                    while (true)
+                    {
+                        x += dx;
+                        y += dy;
 
-                                dest = point;
+                        if (!IsWalkable(x, y))
+                            return false;
 
-                            }
+                        bool forced = (IsWalkable(x - dx, y + dy) && !IsWalkable(x - dx, y)) ||
+                                      (IsWalkable(x + dx, y - dy) && !IsWalkable(x, y - dy));
 
+                        if ((x == bi && y == bj) || forced ||
+                            JumpStraight(x, y, dx, 0, bi, bj, tx, ty) ||
+                            JumpStraight(x, y, 0, dy, bi, bj, tx, ty))
+                        {
+                            jx = x;
+                            jy = y;
+                            return true;
                         }
+                    }
+                }
 
-                        // compute average path for smoothness
+                // ------------------------------------------------------------------------------
+                // prunes neighbours of a jump point given the direction it has been
+                // reached from, returns the number of directions to scan
 
-                        int offset;
-                        glm::vec3 p(0, 0, 0);
-                        glm::vec3 q(0, 0, 0);
+                int GetJumpDirections(const Node& u, const Node& parent, glm::ivec2* dirs) const
+                {
+                    int count = 0;
 
-                        // compute centre cell points
+                    // source node scans in all directions
+
+                    if (parent.X == -1)
+                    {
+                        for (int j = -1; j <= 1; ++j)
+                            for (int i = -1; i <= 1; ++i)
+                                if (i != 0 || j != 0)
+                                    dirs[count++] = glm::ivec2(i, j);
+                        return count;
+                    }
+
+                    int dx = (u.X > parent.X) - (u.X < parent.X);
+                    int dy = (u.Y > parent.Y) - (u.Y < parent.Y);
+
+                    if (dx != 0 && dy != 0)
+                    {
+                        dirs[count++] = glm::ivec2(dx, dy);
+                        dirs[count++] = glm::ivec2(dx, 0);
+                        dirs[count++] = glm::ivec2(0, dy);
+                        if (!IsWalkable(u.X - dx, u.Y)) dirs[count++] = glm::ivec2(-dx, dy);
+                        if (!IsWalkable(u.X, u.Y - dy)) dirs[count++] = glm::ivec2(dx, -dy);
+                    }
+                    else if (dx != 0)
+                    {
+                        dirs[count++] = glm::ivec2(dx, 0);
+                        if (!IsWalkable(u.X, u.Y + 1)) dirs[count++] = glm::ivec2(dx, 1);
+                        if (!IsWalkable(u.X, u.Y - 1)) dirs[count++] = glm::ivec2(dx, -1);
+                    }
+                    else
+                    {
+                        dirs[count++] = glm::ivec2(0, dy);
+                        if (!IsWalkable(u.X + 1, u.Y)) dirs[count++] = glm::ivec2(1, dy);
+                        if (!IsWalkable(u.X - 1, u.Y)) dirs[count++] = glm::ivec2(-1, dy);
+                    }
+
+                    return count;
+                }
+
+                // ------------------------------------------------------------------------------
+                // jump point search with octile costs, jump points are linked through
+                // the parent map, segments between them are straight or diagonal and
+                // are expanded cell by cell into the path array from target to source,
+                // so the path feeds the same smoothing as the grid search
+
+                bool JumpPointSearch(SearchContext& ctx, int ai, int aj, int bi, int bj) const
+                {
+                    BeginSearch(ctx);
+
+                    int startoffset = ai + aj * Width;
+
+                    ctx.Distance[startoffset] = 0;
+                    ctx.Parent[startoffset]   = Node(-1, -1);
+                    ctx.Visited[startoffset]  = ctx.Generation;
+
+                    PushOpenNode(ctx, Node(ai, aj, 0, OctileDistance(ai, aj, bi, bj)));
+
+                    glm::ivec2 dirs[8];
 
-                        for (int i = 0; i < PathCount; ++i)
+                    bool found = false;
+
+                    while (!ctx.OpenList.empty())
+                    {
+                        Node u = PopOpenNode(ctx);
+
+                        int uoffset = u.X + u.Y * Width;
+
+                        // skip stale entries of nodes reached later with a lower cost
+
+                        if (u.G > ctx.Distance[uoffset])
+                            continue;
+
+                        if (u.X == bi && u.Y == bj)
                         {
-                            offset = Path[i].x + Path[i].y * Width;
-                        
-                            PAvgrIn[i] = (Pa[offset] + Pd[offset]) * 0.5f;
+                            found = true;
+                            break;
                         }
 
-                        //
+                        int count = GetJumpDirections(u, ctx.Parent[uoffset], dirs);
 
-                        float denum = 1.0f / ( (float)AvgNeighbours * 2.0f + 1.0f );
+                        for (int i = 0; i < count; ++i)
+                        {
+                            int jx, jy;
 
-                        // add initial point to the curve path array  
+                            if (!Jump(u.X, u.Y, dirs[i].x, dirs[i].y, bi, bj, jx, jy))
+                                continue;
 
-              //          PAvgrOut[0] = (Pa[offsetb] + Pd[offsetb]) * 0.5f;
-                        PAvgrOut[0] = origin;
+                            int joffset = jx + jy * Width;
+                            int g       = u.G + OctileDistance(u.X, u.Y, jx, jy);
 
-                        PAvgrOutPathCount = 1;
+                            if (ctx.Visited[joffset] != ctx.Generation || g < ctx.Distance[joffset])
+                            {
+                                ctx.Visited[joffset]  = ctx.Generation;
+                                ctx.Distance[joffset] = g;
+                                ctx.Parent[joffset]   = Node(u.X, u.Y);
 
-                        // compute average curve path array
+                                PushOpenNode(ctx, Node(jx, jy, g, OctileDistance(jx, jy, bi, bj)));
+                            }
+                        }
+                    }
+
+                    if (!found)
+                        return false;
+
+                    // expand jump points into cells
+
+                    int x = bi;
+                    int y = bj;
 
-                        for (int i = 1; i < PathCount; i++)
+                    ctx.Path[0]   = glm::ivec2(x, y);
+                    ctx.PathCount = 1;
+
+                    while (x != ai || y != aj)
+                    {
+                        Node point = ctx.Parent[x + y * Width];
+
+                        while (x != point.X || y != point.Y)
                         {
-                            p.x = 0;
-                            p.y = 0;
-                            p.z = 0;
+                            x += (point.X > x) - (point.X < x);
+                            y += (point.Y > y) - (point.Y < y);
 
-                            for (int j = -AvgNeighbours; j <= AvgNeighbours; j++)
+                            ctx.Path[ctx.PathCount++] = glm::ivec2(x, y);
+                        }
+                    }
+
+                    return true;
+                }
+
+                // ------------------------------------------------------------------------------
+                // hierarchical search helpers, the nav mask is split in square clusters,
+                // entrances are placed where walkable cells face each other across
+                // cluster borders and linked by cached intra cluster distances
+
+                int GetCluster(int x, int y) const
+                {
+                    return x / ClusterSize + (y / ClusterSize) * ClustersX;
+                }
+
+                int GetCluster(int offset) const
+                {
+                    return GetCluster(offset % Width, offset / Width);
+                }
+
+                // ------------------------------------------------------------------------------
+                // dijkstra restricted to a cluster, if target is -1, distances to all
+                // cells of the cluster are computed, cells are given as mask offsets
+
+                bool ClusterSearch(int cluster, int source, int target, ClusterScratch& scratch) const
+                {
+                    int x0 = (cluster % ClustersX) * ClusterSize;
+                    int y0 = (cluster / ClustersX) * ClusterSize;
+                    int w  = Width  - x0 < ClusterSize ? Width  - x0 : ClusterSize;
+                    int h  = Height - y0 < ClusterSize ? Height - y0 : ClusterSize;
+
+                    scratch.Distance.assign(w * h, INT_MAX);
+                    scratch.Parent.assign(w * h, -1);
+                    scratch.Heap.clear();
+
+                    int localsource = (source % Width - x0) + (source / Width - y0) * w;
+                    int localtarget = target == -1 ? -1 : (target % Width - x0) + (target / Width - y0) * w;
+
+                    scratch.Distance[localsource] = 0;
+                    scratch.Heap.emplace_back(0, localsource);
+
+                    while (!scratch.Heap.empty())
+                    {
+                        std::pop_heap(scratch.Heap.begin(), scratch.Heap.end(), std::greater<std::pair<int, int>>());
+                        std::pair<int, int> u = scratch.Heap.back();
+                        scratch.Heap.pop_back();
+
+                        if (u.first > scratch.Distance[u.second])
+                            continue;
+
+                        if (u.second == localtarget)
+                            return true;
+
+                        int ux = u.second % w;
+                        int uy = u.second / w;
+
+                        for (int j = -1; j <= 1; ++j)
+                        {
+                            for (int i = -1; i <= 1; ++i)
                             {
-                                p += PAvgrIn[ (i + j <= 0) || (i + j >= PathCount) ? i : i + j ];
+                                int nx = ux + i;
+                                int ny = uy + j;
+
+                                if ((i == 0 && j == 0) || nx < 0 || ny < 0 || nx >= w || ny >= h)
+                                    continue;
+
+                                if (!Data[x0 + nx + (y0 + ny) * Width])
+                                    continue;
+
+                                int local = nx + ny * w;
+                                int d     = u.first + (i != 0 && j != 0 ? DIAGONAL_COST : STRAIGHT_COST);
+
+                                if (d < scratch.Distance[local])
+                                {
+                                    scratch.Distance[local] = d;
+                                    scratch.Parent[local]   = u.second;
+                                    scratch.Heap.emplace_back(d, local);
+                                    std::push_heap(scratch.Heap.begin(), scratch.Heap.end(), std::greater<std::pair<int, int>>());
+                                }
                             }
-                            
-                            PAvgrOut[PAvgrOutPathCount++] = p * denum;
                         }
-                        
-                        // add last point to the curve path array
+                    }
 
-                        PAvgrOut[PAvgrOutPathCount++] = PAvgrIn[PathCount-1];
+                    return target == -1;
+                }
 
-                        // compute path lenght
+                // ------------------------------------------------------------------------------
+                // converts mask offsets to cluster local offsets and back
 
-                        PathLength = 0.0f;
-                        
-                        for (int i = 0; i < PAvgrOutPathCount - 1; ++i)
+                int GetClusterLocal(int cluster, int offset) const
+                {
+                    int x0 = (cluster % ClustersX) * ClusterSize;
+                    int y0 = (cluster / ClustersX) * ClusterSize;
+                    int w  = Width - x0 < ClusterSize ? Width - x0 : ClusterSize;
+                    return (offset % Width - x0) + (offset / Width - y0) * w;
+                }
+
+                int GetClusterOffset(int cluster, int local) const
+                {
+                    int x0 = (cluster % ClustersX) * ClusterSize;
+                    int y0 = (cluster / ClustersX) * ClusterSize;
+                    int w  = Width - x0 < ClusterSize ? Width - x0 : ClusterSize;
+                    return x0 + local % w + (y0 + local / w) * Width;
+                }
+
+                // ------------------------------------------------------------------------------
+                // appends the cells from the scratch search source to the given
+                // local cell, the source cell itself is not appended
+
+                void AppendClusterPath(SearchContext& ctx, int cluster, int local, const ClusterScratch& scratch, bool reversed) const
+                {
+                    size_t first = ctx.HierarchyCells.size();
+
+                    while (scratch.Parent[local] != -1)
+                    {
+                        ctx.HierarchyCells.emplace_back(GetClusterOffset(cluster, local));
+                        local = scratch.Parent[local];
+                    }
+
+                    // parents are walked from the last cell back, so cells are reversed
+                    // unless the scratch search started from the end of the segment
+
+                    if (reversed)
+                    {
+                        if (ctx.HierarchyCells.size() > first)
                         {
-                            PAvgrDir[i]= PAvgrOut[i + 1] - PAvgrOut[i];
-                            float denum = sqrtf(PAvgrDir[i].x * PAvgrDir[i].x + PAvgrDir[i].y * PAvgrDir[i].y);
-                            PAvgrInvSegmentLength[i] = 1.0f / denum;
-                            PAvgrSegmentLength[i] = denum;
-                            PathLength += denum;
+                            ctx.HierarchyCells.erase(ctx.HierarchyCells.begin() + first);
+                            ctx.HierarchyCells.emplace_back(GetClusterOffset(cluster, local));
                         }
+                    }
+                    else
+                    {
+                        std::reverse(ctx.HierarchyCells.begin() + first, ctx.HierarchyCells.end());
+                    }
+                }
 
-                        return 1;
+                // ------------------------------------------------------------------------------
+                // hashes the nav mask and the cluster size, used to validate sidecar files
 
-                    }   // if sorce and dest are inside the same connected component
-                    
-                    return 0;
+                uint64_t ComputeHierarchyHash(int clustersize) const
+                {
+                    uint32_t version = HIERARCHY_VERSION;
+                    int32_t  dims[3] = { Width, Height, clustersize };
+                    uint64_t hash    = vml::utils::hash::Fnv1a64(&version, sizeof(version));
+                    hash = vml::utils::hash::Fnv1a64(dims, sizeof(dims), hash);
+                    hash = vml::utils::hash::Fnv1a64(Data, Size, hash);
+                    return hash;
+                }
+
+                // ------------------------------------------------------------------------------
+                // adds a transition between two cells on different clusters
+
+                void AddTransition(std::vector<glm::ivec2>& transitions, int a, int b) const
+                {
+                    if (Data[a] && Data[b])
+                        transitions.emplace_back(a, b);
+                }
+
+                // ------------------------------------------------------------------------------
+                // finds transitions across cluster borders, runs of facing walkable
+                // cells produce one transition in the middle, or two at the ends if
+                // wider than MAX_ENTRANCE_WIDTH, diagonal crossings whose orthogonal
+                // cells are both blocked can't be reached through a run and get their
+                // own transition, so every crossing is represented
+
+                void FindTransitions(std::vector<glm::ivec2>& transitions) const
+                {
+                    // vertical and horizontal borders
+
+                    for (int axis = 0; axis < 2; ++axis)
+                    {
+                        int clusters = axis == 0 ? ClustersX : ClustersY;
+                        int length   = axis == 0 ? Height : Width;
+
+                        for (int k = 1; k < clusters; ++k)
+                        {
+                            int border = k * ClusterSize;
+
+                            for (int segment = 0; segment < length; segment += ClusterSize)
+                            {
+                                int end = segment + ClusterSize < length ? segment + ClusterSize : length;
+                                int run = -1;
+
+                                for (int t = segment; t <= end; ++t)
+                                {
+                                    int a = -1;
+                                    int b = -1;
+
+                                    if (t < end)
+                                    {
+                                        a = axis == 0 ? (border - 1) + t * Width : t + (border - 1) * Width;
+                                        b = axis == 0 ? border + t * Width : t + border * Width;
+                                    }
+
+                                    bool open = t < end && Data[a] && Data[b];
+
+                                    if (open && run == -1)
+                                        run = t;
+
+                                    if (!open && run != -1)
+                                    {
+                                        int first = run;
+                                        int last  = t - 1;
+
+                                        if (last - first + 1 >= MAX_ENTRANCE_WIDTH)
+                                        {
+                                            for (int c : { first, last })
+                                            {
+                                                if (axis == 0) AddTransition(transitions, (border - 1) + c * Width, border + c * Width);
+                                                else           AddTransition(transitions, c + (border - 1) * Width, c + border * Width);
+                                            }
+                                        }
+                                        else
+                                        {
+                                            int c = (first + last) / 2;
+                                            if (axis == 0) AddTransition(transitions, (border - 1) + c * Width, border + c * Width);
+                                            else           AddTransition(transitions, c + (border - 1) * Width, c + border * Width);
+                                        }
+
+                                        run = -1;
+                                    }
+                                }
+                            }
+                        }
+                    }
+
+                    // isolated diagonal crossings
+
+                    for (int y = 0; y < Height - 1; ++y)
+                    {
+                        for (int x = 0; x < Width; ++x)
+                        {
+                            if (!Data[x + y * Width])
+                                continue;
+
+                            for (int dx : { -1, 1 })
+                            {
+                                int nx = x + dx;
+                                int ny = y + 1;
+
+                                if (nx < 0 || nx >= Width || !Data[nx + ny * Width])
+                                    continue;
+
+                                if (GetCluster(x, y) == GetCluster(nx, ny))
+                                    continue;
+
+                                if (Data[nx + y * Width] || Data[x + ny * Width])
+                                    continue;
+
+                                transitions.emplace_back(x + y * Width, nx + ny * Width);
+                            }
+                        }
+                    }
+                }
+
+                // ------------------------------------------------------------------------------
+                // hierarchical search, source and target are linked to the entrances of
+                // their clusters, the abstract graph is searched with octile costs and
+                // only the intra cluster segments of the abstract path are refined,
+                // returns false if the query should be handled by the grid search
+
+                bool HierarchicalSearch(SearchContext& ctx, int ai, int aj, int bi, int bj) const
+                {
+                    if (ClusterSize == 0)
+                        return false;
+
+                    int sourcecluster = GetCluster(ai, aj);
+                    int targetcluster = GetCluster(bi, bj);
+
+                    // short queries don't benefit from the abstract graph
+
+                    if (sourcecluster == targetcluster || OctileDistance(ai, aj, bi, bj) < ClusterSize * STRAIGHT_COST)
+                        return false;
+
+                    int source = ai + aj * Width;
+                    int target = bi + bj * Width;
+
+                    // distances from source and target to their cluster cells
+
+                    ClusterSearch(sourcecluster, source, -1, ctx.SourceScratch);
+                    ClusterSearch(targetcluster, target, -1, ctx.TargetScratch);
+
+                    // abstract search, the two extra nodes are source and target
+
+                    int nodescount = (int)HierarchyNodes.size();
+                    int sourcenode = nodescount;
+                    int targetnode = nodescount + 1;
+
+                    ctx.HierarchyDistance.assign(nodescount + 2, INT_MAX);
+                    ctx.HierarchyParent.assign(nodescount + 2, -1);
+                    ctx.HierarchyOpenList.clear();
+
+                    auto push = [&](int node, int g)
+                    {
+                        int h = 0;
+
+                        if (node < nodescount)
+                        {
+                            int offset = HierarchyNodes[node];
+                            h = OctileDistance(offset % Width, offset / Width, bi, bj);
+                        }
+
+                        ctx.HierarchyOpenList.emplace_back(g + h, node);
+                        std::push_heap(ctx.HierarchyOpenList.begin(), ctx.HierarchyOpenList.end(), std::greater<std::pair<int, int>>());
+                    };
+
+                    ctx.HierarchyDistance[sourcenode] = 0;
+
+                    for (int i = HierarchyClusterFirst[sourcecluster]; i < HierarchyClusterFirst[sourcecluster + 1]; ++i)
+                    {
+                        int d = ctx.SourceScratch.Distance[GetClusterLocal(sourcecluster, HierarchyNodes[i])];
+
+                        if (d != INT_MAX)
+                        {
+                            ctx.HierarchyDistance[i] = d;
+                            ctx.HierarchyParent[i]   = sourcenode;
+                            push(i, d);
+                        }
+                    }
+
+                    bool found = false;
+
+                    while (!ctx.HierarchyOpenList.empty())
+                    {
+                        std::pop_heap(ctx.HierarchyOpenList.begin(), ctx.HierarchyOpenList.end(), std::greater<std::pair<int, int>>());
+                        std::pair<int, int> u = ctx.HierarchyOpenList.back();
+                        ctx.HierarchyOpenList.pop_back();
+
+                        int node = u.second;
+
+                        if (node == targetnode)
+                        {
+                            found = true;
+                            break;
+                        }
+
+                        int g = ctx.HierarchyDistance[node];
+
+                        // skip stale entries
+
+                        int offset = HierarchyNodes[node];
+
+                        if (u.first != g + OctileDistance(offset % Width, offset / Width, bi, bj))
+                            continue;
+
+                        // link to target
+
+                        if (GetCluster(offset) == targetcluster)
+                        {
+                            int d = ctx.TargetScratch.Distance[GetClusterLocal(targetcluster, offset)];
+
+                            if (d != INT_MAX && g + d < ctx.HierarchyDistance[targetnode])
+                            {
+                                ctx.HierarchyDistance[targetnode] = g + d;
+                                ctx.HierarchyParent[targetnode]   = node;
+                                push(targetnode, g + d);
+                            }
+                        }
+
+                        for (int e = HierarchyEdgeFirst[node]; e < HierarchyEdgeFirst[node + 1]; ++e)
+                        {
+                            const HierarchyEdge& edge = HierarchyEdges[e];
+
+                            if (g + edge.Cost < ctx.HierarchyDistance[edge.Target])
+                            {
+                                ctx.HierarchyDistance[edge.Target] = g + edge.Cost;
+                                ctx.HierarchyParent[edge.Target]   = node;
+                                push(edge.Target, g + edge.Cost);
+                            }
+                        }
+                    }
+
+                    if (!found)
+                        return false;
+
+                    // collect abstract path from source to target
+
+                    std::vector<int>& nodes = ctx.HierarchyPath;
+
+                    nodes.clear();
+
+                    for (int node = ctx.HierarchyParent[targetnode]; node != sourcenode; node = ctx.HierarchyParent[node])
+                        nodes.emplace_back(node);
+
+                    std::reverse(nodes.begin(), nodes.end());
+
+                    // refine segments
+
+                    ctx.HierarchyCells.clear();
+                    ctx.HierarchyCells.emplace_back(source);
+
+                    AppendClusterPath(ctx, sourcecluster, GetClusterLocal(sourcecluster, HierarchyNodes[nodes.front()]), ctx.SourceScratch, false);
+
+                    for (size_t i = 0; i + 1 < nodes.size(); ++i)
+                    {
+                        int a = HierarchyNodes[nodes[i]];
+                        int b = HierarchyNodes[nodes[i + 1]];
+
+                        int cluster = GetCluster(a);
+
+                        if (cluster == GetCluster(b))
+                        {
+                            ClusterSearch(cluster, a, b, ctx.RefineScratch);
+                            AppendClusterPath(ctx, cluster, GetClusterLocal(cluster, b), ctx.RefineScratch, false);
+                        }
+                        else
+                        {
+                            ctx.HierarchyCells.emplace_back(b);
+                        }
+                    }
+
+                    AppendClusterPath(ctx, targetcluster, GetClusterLocal(targetcluster, HierarchyNodes[nodes.back()]), ctx.TargetScratch, true);
+
+                    if ((int)ctx.HierarchyCells.size() > Size)
+                        return false;
+
+                    // store path from target to source
+
+                    ctx.PathCount = 0;
+
+                    for (int i = (int)ctx.HierarchyCells.size() - 1; i >= 0; --i)
+                        ctx.Path[ctx.PathCount++] = glm::ivec2(ctx.HierarchyCells[i] % Width, ctx.HierarchyCells[i] / Width);
+
+                    return true;
+                }
+
+		public:
+
+                // ----------------------------------------------------------
+                // search modes
+
+                static const int SEARCH_ASTAR = 0;         // grid search expanding every neighbour cell
+                static const int SEARCH_JPS   = 1;         // jump point search, expands only jump points
+                static const int SEARCH_HPA   = 2;         // hierarchical search over clusters, short queries use the grid search
+
+                static const int DEFAULT_CLUSTER_SIZE = 16;
+
+                // ----------------------------------------------------------
+                //
+
+                class DebugCell
+                {
+                    public:
+
+                        glm::vec3 Pa;          // first vertex of mesh quad
+                        glm::vec3 Pb;          // second vertex of mesh quad
+                        glm::vec3 Pc;          // third vertex of mesh quad
+                        glm::vec3 Pd;          // forth vertex of mesh quad
+                        int       IdData;      // Connected componennts bitmap
+
+                        // ------------------------------------------------------------------------
+                        // ctor / dtor
+
+                        DebugCell()
+                        {
+                            Pa = glm::vec3(0, 0, 0);
+                            Pb = glm::vec3(0, 0, 0);
+                            Pc = glm::vec3(0, 0, 0);
+                            Pd = glm::vec3(0, 0, 0);
+                            IdData = -1;
+                        }
+
+                        ~DebugCell()
+                        {}
+
+                };
+
+                // ---------------------------------------------------------------
+                //
+
+                int   GetSize()                         const { return Size; }
+                int   GetWidth()                        const { return Width; }
+                int   GetHeight()                       const { return Height; }
+                float GetDw()                           const { return Dw; }
+                float GetDh()                           const { return Dh; }
+                const glm::vec3& GetBoundingBoxMin()    const { return BoundingBoxMin; }
+                const glm::vec3& GetBoundingBoxMax()    const { return BoundingBoxMax; }
+                int   GetPathCount()                    const { return Context.GetPathCount(); }
+                const glm::vec3* GetPAvgrOut()          const { return Context.GetPAvgrOut(); }
+                const glm::vec3* GetPAvgrDir()          const { return Context.GetPAvgrDir(); }
+                const float *GetPAvgrInvSegmentLength() const { return Context.GetPAvgrInvSegmentLength(); }
+                const float* GetPAvgrSegmentLength()    const { return Context.GetPAvgrSegmentLength(); }
+                float GetZDepth()                       const { return ZDepth; }
+                int   GetSearchMode()                   const { return SearchMode; }
+                bool  IsHierarchyBuilt()                const { return ClusterSize != 0; }
+                int   GetClusterSize()                  const { return ClusterSize; }
+                int   GetHierarchyNodesCount()          const { return (int)HierarchyNodes.size(); }
+                int   GetHierarchyEdgesCount()          const { return (int)HierarchyEdges.size(); }
+                float GetHierarchyBuildTime()           const { return HierarchyBuildTime; }
+
+                // -------------------------------------------------------------
+                //
+
+                bool IsPointInNavMesh(const glm::vec3& ra, const glm::vec3& rb) const
+                {
+                    
+                    glm::vec3 p;
+                    float t;
+
+                    glm::vec3 bmin = BoundingBoxMin;
+                    glm::vec3 bmax = BoundingBoxMax;
+
+                    if (!vml::geo3d::intersections::TriangleVsRay(glm::vec3(bmin.x, bmin.y, bmin.z),
+                                                                  glm::vec3(bmin.x, bmax.y, bmin.z),
+                                                                  glm::vec3(bmax.x, bmax.y, bmin.z),
+                                                                  ra, rb, p, t))
+                    {
+                        if (!vml::geo3d::intersections::TriangleVsRay(glm::vec3(bmin.x, bmin.y, bmin.z),
+                                                                      glm::vec3(bmax.x, bmax.y, bmin.z),
+                                                                      glm::vec3(bmax.x, bmin.y, bmin.z),
+                                                                      ra, rb, p, t))
+                        {
+                            return false;
+                        }
+                    }
+                    
+                    return true;
+                }
+                            
+                // ---------------------------------------------------------------
+                //
+
+                glm::vec3 GetCellCenterFromPoint(const glm::vec3& p) const
+                {
+                    int i = (int)((p.x - BoundingBoxMin.x) / Dw);
+                    int j = (int)((p.y - BoundingBoxMin.y) / Dh);
+                    if (i < 0 || j < 0 || i >= Width || j >= Height)
+                        vml::os::Message::Error("Pathfinder : ","index out of range");
+                    int offset = i + j * Width;
+                    return  ( Pa[offset] + Pd[offset] )*0.5f;
+                }
+
+                // ---------------------------------------------------------------
+                //
+
+                int GetCellAddressFromPoint(const glm::vec3& p) const
+                {
+                    int i = (int)((p.x - BoundingBoxMin.x) / Dw);
+                    int j = (int)((p.y - BoundingBoxMin.y) / Dh);
+                    if (i < 0 || j < 0 || i >= Width || j >= Height)
+                        vml::os::Message::Error("Pathfinder : ", "index out of range");
+                    return i + j * Width;
+                }
+
+                // ---------------------------------------------------------------
+                //
+
+                glm::ivec2 GetCellIndicesFromPoint(const glm::vec3& p) const
+                {
+                    int i = (int)((p.x - BoundingBoxMin.x) / Dw);
+                    int j = (int)((p.y - BoundingBoxMin.y) / Dh);
+                    if (i < 0 || j < 0 || i >= Width || j >= Height)
+                        vml::os::Message::Error("Pathfinder : ", "index out of range");
+                    return glm::vec2 (i,j);
+                }
+
+                // ---------------------------------------------------------------
+                //
+
+                int GetCellIdFromIndices(int i, int j) const
+                {
+                    if (i < 0 || j < 0 || i >= Width || j >= Height)
+                        vml::os::Message::Error("Pathfinder : ","index out of range");
+                    return IdData[i + j * Width];
+                }
+
+                // ---------------------------------------------------------------
+                //
+
+                glm::vec3 GetCellCenterFromIndices(int i, int j) const
+                {
+                    if (i < 0 || j < 0 || i >= Width || j >= Height)
+                        vml::os::Message::Error("Pathfinder : ", "index out of range");
+                    int offset = i + j * Width;
+                    return (Pa[offset] + Pd[offset]) * 0.5f;
+                }
+
+                // ---------------------------------------------------------------
+                //
+
+                float GetPathLength() const
+                {
+                    return Context.GetPathLength();
+                }
+
+                // ---------------------------------------------------------------
+                //
+
+                void GetCellVertices(int x, int y, glm::vec3& p0, glm::vec3& p1, glm::vec3& p2, glm::vec3& p3)
+                {
+                    if (x < 0) vml::os::Message::Error("PathFinder : ", "x component is less than 0");
+                    if (y < 0) vml::os::Message::Error("PathFinder : ", "y component is less than 0");
+                    if (x >= Width) vml::os::Message::Error("PathFinder : ", "x component is greater than Width ( ", Width, " )");
+                    if (y >= Height) vml::os::Message::Error("PathFinder : ", "y component is greater than Width ( ", Height, " )");
+
+                    int offset = x + y * Width;
+
+                    p0 = Pa[offset];
+                    p1 = Pb[offset];
+                    p2 = Pc[offset];
+                    p3 = Pd[offset];
+
+                }
+
+                // ------------------------------------------------------------------------------
+                //
+                
+                void SetZDepth(const float zdepth)
+                {
+                    ZDepth = zdepth;
+                }
+
+                // ------------------------------------------------------------------------------
+                //
+
+                void SetSearchMode(int searchmode)
+                {
+                    if (searchmode != SEARCH_ASTAR && searchmode != SEARCH_JPS && searchmode != SEARCH_HPA)
+                        vml::os::Message::Error("PathFinder : ", "unknown search mode ", searchmode);
+
+                    SearchMode = searchmode;
+                }
+
+                // ------------------------------------------------------------------------------
+                // finds a path using the given search context, the pathfinder is
+                // not modified, so this can run concurrently on different contexts
+
+                int FindPath(SearchContext& ctx, const glm::vec3& origin, int ai, int aj, int bi, int bj) const
+                {
+                                       
+                    // points are coinciding , there is no path
+
+                    ctx.PathCount         =  0;
+                    ctx.PAvgrOutPathCount =  0;
+
+                    if (ai < 0) vml::os::Message::Error("PathFinder : ", "ai component is less than 0");
+                    if (aj < 0) vml::os::Message::Error("PathFinder : ", "aj component is less than 0");
+                    if (ai >= Width) vml::os::Message::Error("PathFinder : ", "ai component is greater than Width ( ", Width," )");
+                    if (aj >= Height) vml::os::Message::Error("PathFinder : ", "aj component is greater than Width ( ", Height," )");
+
+                    if (bi < 0) vml::os::Message::Error("PathFinder : ", "bi component is less than 0");
+                    if (bj < 0) vml::os::Message::Error("PathFinder : ", "bj component is less than 0");
+                    if (bi >= Width) vml::os::Message::Error("PathFinder : ", "bi component is greater than Width ( ", Width," )");
+                    if (bj >= Height) vml::os::Message::Error("PathFinder : ", "bj component is greater than Width ( ", Height," )");
+
+                    // path starts and ends in the same cell
+
+                    if (ai == bi && aj == bj)
+                        return 0;
+
+                    int offseta = ai + aj * Width;
+                    int offsetb = bi + bj * Width;
+
+                //    if (IdData[offseta] != -1 && IdData[offsetb] != -1)
+                //    {
+                //       DrawCell(view, ai, aj, vml::colors::Green);
+                //       DrawCell(view, bi, bj, vml::colors::Yellow);
+                //   }
+                //    else
+                //    {
+                //      DrawCell(view, ai, aj, vml::colors::Red);
+                //       DrawCell(view, bi, bj, vml::colors::Red);
+                //    }
+
+                    if (IdData[offseta] == -1 || IdData[offsetb] == -1)
+                        return 0;
+
+                    // source and target are on the same
+                    // separated sub - bitmap
+
+                    if (IdData[offseta] == IdData[offsetb])
+                    {
+                        // auto timerstart = std::chrono::steady_clock::now();
+
+                        // search path
+
+                        if (SearchMode == SEARCH_JPS)
+                        {
+                            if (!JumpPointSearch(ctx, ai, aj, bi, bj))
+                                AStarSearch(ctx, ai, aj, bi, bj);
+                        }
+                        else if (SearchMode == SEARCH_HPA)
+                        {
+                            if (!HierarchicalSearch(ctx, ai, aj, bi, bj))
+                                AStarSearch(ctx, ai, aj, bi, bj);
+                        }
+                        else
+                        {
+                            AStarSearch(ctx, ai, aj, bi, bj);
+                        }
+
+                        // compute average path for smoothness
+
+                        int offset;
+                        glm::vec3 p(0, 0, 0);
+                        glm::vec3 q(0, 0, 0);
+
+                        // compute centre cell points
+
+                        for (int i = 0; i < ctx.PathCount; ++i)
+                        {
+                            offset = ctx.Path[i].x + ctx.Path[i].y * Width;
+                        
+                            ctx.PAvgrIn[i] = (Pa[offset] + Pd[offset]) * 0.5f;
+                        }
+
+                        //
+
+                        float denum = 1.0f / ( (float)AvgNeighbours * 2.0f + 1.0f );
+
+                        // add initial point to the curve path array  
+
+              //          ctx.PAvgrOut[0] = (Pa[offsetb] + Pd[offsetb]) * 0.5f;
+                        ctx.PAvgrOut[0] = origin;
+
+                        ctx.PAvgrOutPathCount = 1;
+
+                        // compute average curve path array
+
+                        for (int i = 1; i < ctx.PathCount; i++)
+                        {
+                            p.x = 0;
+                            p.y = 0;
+                            p.z = 0;
+
+                            for (int j = -AvgNeighbours; j <= AvgNeighbours; j++)
+                            {
+                                p += ctx.PAvgrIn[ (i + j <= 0) || (i + j >= ctx.PathCount) ? i : i + j ];
+                            }
+                            
+                            ctx.PAvgrOut[ctx.PAvgrOutPathCount++] = p * denum;
+                        }
+                        
+                        // add last point to the curve path array
+
+                        ctx.PAvgrOut[ctx.PAvgrOutPathCount++] = ctx.PAvgrIn[ctx.PathCount-1];
+
+                        // compute path lenght
+
+                        ctx.PathLength = 0.0f;
+                        
+                        for (int i = 0; i < ctx.PAvgrOutPathCount - 1; ++i)
+                        {
+                            ctx.PAvgrDir[i]= ctx.PAvgrOut[i + 1] - ctx.PAvgrOut[i];
+                            float denum = sqrtf(ctx.PAvgrDir[i].x * ctx.PAvgrDir[i].x + ctx.PAvgrDir[i].y * ctx.PAvgrDir[i].y);
+                            ctx.PAvgrInvSegmentLength[i] = 1.0f / denum;
+                            ctx.PAvgrSegmentLength[i] = denum;
+                            ctx.PathLength += denum;
+                        }
+
+                        return 1;
+
+                    }   // if sorce and dest are inside the same connected component
+                    
+                    return 0;
+                }
+
+                // ------------------------------------------------------------------------------
+                // finds a path using the pathfinder own search context
+
+                int FindPath(const glm::vec3& origin, int ai, int aj, int bi, int bj)
+                {
+                    Ai = ai;
+                    Aj = aj;
+                    Bi = bi;
+                    Bj = bj;
+
+                    return FindPath(Context, origin, ai, aj, bi, bj);
+                }
+
+                // ------------------------------------------------------------------------------
+                // creates a search context for this pathfinder
+
+                void InitSearchContext(SearchContext& ctx) const
+                {
+                    ctx.Resize(Size);
+                }
+
+                // ------------------------------------------------------------------------------
+                // builds the abstract cluster graph, clusters are independent once
+                // entrances are placed, so intra cluster distances are computed in parallel
+
+                void BuildHierarchy(int clustersize = DEFAULT_CLUSTER_SIZE)
+                {
+                    if (clustersize < 2)
+                        vml::os::Message::Error("PathFinder : ", "cluster size must be greater than 1");
+
+                    vml::os::Timer timer;
+
+                    timer.Init();
+
+                    ClusterSize = clustersize;
+                    ClustersX   = (Width  + ClusterSize - 1) / ClusterSize;
+                    ClustersY   = (Height + ClusterSize - 1) / ClusterSize;
+
+                    int clusterscount = ClustersX * ClustersY;
+
+                    // place entrances
+
+                    std::vector<glm::ivec2> transitions;
+
+                    FindTransitions(transitions);
+
+                    // one abstract node per transition cell, sorted by cluster
+                    // so that each cluster owns a contiguous range of nodes
+
+                    std::vector<int> nodeofcell(Size, -1);
+
+                    HierarchyNodes.clear();
+
+                    for (const glm::ivec2& t : transitions)
+                    {
+                        for (int cell : { t.x, t.y })
+                        {
+                            if (nodeofcell[cell] == -1)
+                            {
+                                nodeofcell[cell] = 0;
+                                HierarchyNodes.emplace_back(cell);
+                            }
+                        }
+                    }
+
+                    std::sort(HierarchyNodes.begin(), HierarchyNodes.end(), [this](int a, int b)
+                    {
+                        int ca = GetCluster(a);
+                        int cb = GetCluster(b);
+                        return ca != cb ? ca < cb : a < b;
+                    });
+
+                    int nodescount = (int)HierarchyNodes.size();
+
+                    for (int i = 0; i < nodescount; ++i)
+                        nodeofcell[HierarchyNodes[i]] = i;
+
+                    HierarchyClusterFirst.assign(clusterscount + 1, 0);
+
+                    for (int i = 0; i < nodescount; ++i)
+                        HierarchyClusterFirst[GetCluster(HierarchyNodes[i]) + 1]++;
+
+                    for (int c = 0; c < clusterscount; ++c)
+                        HierarchyClusterFirst[c + 1] += HierarchyClusterFirst[c];
+
+                    // inter cluster edges
+
+                    std::vector<std::vector<HierarchyEdge>> edges(nodescount);
+
+                    for (const glm::ivec2& t : transitions)
+                    {
+                        int a    = nodeofcell[t.x];
+                        int b    = nodeofcell[t.y];
+                        int cost = (t.x % Width != t.y % Width) && (t.x / Width != t.y / Width) ? DIAGONAL_COST : STRAIGHT_COST;
+
+                        edges[a].push_back({ b, cost });
+                        edges[b].push_back({ a, cost });
+                    }
+
+                    // intra cluster distances
+
+                    std::vector<std::vector<HierarchyEdge>> intra(nodescount);
+
+                    vml::os::ThreadPool* pool = vml::os::ThreadPool::GetInstance();
+
+                    std::atomic<int> counter(0);
+
+                    for (int c = 0; c < clusterscount; ++c)
+                    {
+                        if (HierarchyClusterFirst[c] == HierarchyClusterFirst[c + 1])
+                            continue;
+
+                        pool->Submit([this, c, &intra]()
+                        {
+                            ClusterScratch scratch;
+
+                            for (int i = HierarchyClusterFirst[c]; i < HierarchyClusterFirst[c + 1]; ++i)
+                            {
+                                ClusterSearch(c, HierarchyNodes[i], -1, scratch);
+
+                                for (int j = HierarchyClusterFirst[c]; j < HierarchyClusterFirst[c + 1]; ++j)
+                                {
+                                    int d = scratch.Distance[GetClusterLocal(c, HierarchyNodes[j])];
+
+                                    if (i != j && d != INT_MAX)
+                                        intra[i].push_back({ j, d });
+                                }
+                            }
+                        }, &counter);
+                    }
+
+                    pool->Wait(counter);
+
+                    // flatten edges
+
+                    HierarchyEdgeFirst.assign(nodescount + 1, 0);
+                    HierarchyEdges.clear();
+
+                    for (int i = 0; i < nodescount; ++i)
+                    {
+                        HierarchyEdgeFirst[i] = (int)HierarchyEdges.size();
+                        HierarchyEdges.insert(HierarchyEdges.end(), edges[i].begin(), edges[i].end());
+                        HierarchyEdges.insert(HierarchyEdges.end(), intra[i].begin(), intra[i].end());
+                    }
+
+                    HierarchyEdgeFirst[nodescount] = (int)HierarchyEdges.size();
+
+                    HierarchySourceHash = ComputeHierarchyHash(ClusterSize);
+                    HierarchyBuildTime  = timer.GetElapsedTime() * 1000.0f;
+                }
+
+                // ------------------------------------------------------------------------------
+                // saves the abstract graph into a sidecar file
+
+                bool SaveHierarchy(const std::string& filename) const
+                {
+                    if (ClusterSize == 0)
+                        vml::os::Message::Error("PathFinder : ", "Hierarchy : Hierarchy is not built");
+
+                    HierarchyHeader header;
+
+                    memset(&header, 0, sizeof(HierarchyHeader));
+                    memcpy(header.Magic, "VHPA", 4);
+
+                    header.Version     = HIERARCHY_VERSION;
+                    header.SourceHash  = HierarchySourceHash;
+                    header.Width       = Width;
+                    header.Height      = Height;
+                    header.ClusterSize = ClusterSize;
+                    header.NodesCount  = (int32_t)HierarchyNodes.size();
+                    header.EdgesCount  = (int32_t)HierarchyEdges.size();
+                    header.BuildTime   = HierarchyBuildTime;
+
+                    FILE* stream;
+
+                    errno_t err = fopen_s(&stream, filename.c_str(), "wb");
+
+                    if (err != 0)
+                    {
+                        vml::utils::Logger::GetInstance()->Info("PathFinder : Hierarchy : Cannot write '" + filename + "'");
+                        return false;
+                    }
+
+                    bool ok = fwrite(&header, sizeof(HierarchyHeader), 1, stream) == 1;
+
+                    ok = ok && fwrite(HierarchyNodes.data(), sizeof(int32_t), HierarchyNodes.size(), stream) == HierarchyNodes.size();
+                    ok = ok && fwrite(HierarchyClusterFirst.data(), sizeof(int32_t), HierarchyClusterFirst.size(), stream) == HierarchyClusterFirst.size();
+                    ok = ok && fwrite(HierarchyEdgeFirst.data(), sizeof(int32_t), HierarchyEdgeFirst.size(), stream) == HierarchyEdgeFirst.size();
+                    ok = ok && fwrite(HierarchyEdges.data(), sizeof(HierarchyEdge), HierarchyEdges.size(), stream) == HierarchyEdges.size();
+
+                    if (fclose(stream) != 0)
+                        ok = false;
+
+                    if (!ok)
+                    {
+                        vml::utils::Logger::GetInstance()->Info("PathFinder : Hierarchy : Cannot write '" + filename + "'");
+                        remove(filename.c_str());
+                    }
+
+                    return ok;
+                }
+
+                // ------------------------------------------------------------------------------
+                // loads the abstract graph from a sidecar file, returns false if the
+                // file is missing or was built from a different nav mask or cluster size
+
+                bool LoadHierarchy(const std::string& filename, int clustersize = DEFAULT_CLUSTER_SIZE)
+                {
+                    vml::os::FileView file;
+
+                    if (!file.OpenCache(filename))
+                        return false;
+
+                    const HierarchyHeader* header = (const HierarchyHeader*)file.GetDataAt(0, sizeof(HierarchyHeader));
+
+                    if (!header || memcmp(header->Magic, "VHPA", 4) != 0 || header->Version != HIERARCHY_VERSION)
+                    {
+                        vml::utils::Logger::GetInstance()->Info("PathFinder : Hierarchy : '" + filename + "' has an invalid header");
+                        return false;
+                    }
+
+                    if (header->Width != Width || header->Height != Height || header->ClusterSize != clustersize ||
+                        header->SourceHash != ComputeHierarchyHash(clustersize))
+                    {
+                        vml::utils::Logger::GetInstance()->Info("PathFinder : Hierarchy : '" + filename + "' is stale");
+                        return false;
+                    }
+
+                    int clustersx     = (Width  + clustersize - 1) / clustersize;
+                    int clustersy     = (Height + clustersize - 1) / clustersize;
+                    int clusterscount = clustersx * clustersy;
+                    int nodescount    = header->NodesCount;
+                    int edgescount    = header->EdgesCount;
+
+                    if (nodescount < 0 || edgescount < 0)
+                        return false;
+
+                    size_t offset = sizeof(HierarchyHeader);
+
+                    const int32_t*       nodes        = (const int32_t*)file.GetDataAt(offset, nodescount * sizeof(int32_t));
+                    offset += nodescount * sizeof(int32_t);
+                    const int32_t*       clusterfirst = (const int32_t*)file.GetDataAt(offset, (clusterscount + 1) * sizeof(int32_t));
+                    offset += (clusterscount + 1) * sizeof(int32_t);
+                    const int32_t*       edgefirst    = (const int32_t*)file.GetDataAt(offset, (nodescount + 1) * sizeof(int32_t));
+                    offset += (nodescount + 1) * sizeof(int32_t);
+                    const HierarchyEdge* edges        = (const HierarchyEdge*)file.GetDataAt(offset, edgescount * sizeof(HierarchyEdge));
+                    offset += edgescount * sizeof(HierarchyEdge);
+
+                    if (!nodes || !clusterfirst || !edgefirst || (!edges && edgescount > 0) || offset != file.GetSize() ||
+                        clusterfirst[clusterscount] != nodescount || edgefirst[nodescount] != edgescount)
+                    {
+                        vml::utils::Logger::GetInstance()->Info("PathFinder : Hierarchy : '" + filename + "' is truncated");
+                        return false;
+                    }
+
+                    // edge ranges must start at 0 and be monotonic, nodes must be cells
+
+                    bool valid = edgefirst[0] == 0;
+
+                    for (int i = 0; i < nodescount && valid; ++i)
+                        valid = nodes[i] >= 0 && nodes[i] < Size && edgefirst[i] <= edgefirst[i + 1];
+
+                    // node ranges must start at 0 and be monotonic, each node must lie
+                    // in its own cluster, searches index cluster scratch by local cell
+
+                    valid = valid && clusterfirst[0] == 0;
+
+                    for (int c = 0; c < clusterscount && valid; ++c)
+                    {
+                        valid = clusterfirst[c] <= clusterfirst[c + 1];
+
+                        for (int i = clusterfirst[c]; i < clusterfirst[c + 1] && valid; ++i)
+                            valid = (nodes[i] % Width) / clustersize + ((nodes[i] / Width) / clustersize) * clustersx == c;
+                    }
+
+                    if (!valid)
+                    {
+                        vml::utils::Logger::GetInstance()->Info("PathFinder : Hierarchy : '" + filename + "' has invalid nodes");
+                        return false;
+                    }
+
+                    for (int i = 0; i < edgescount; ++i)
+                    {
+                        if (edges[i].Target < 0 || edges[i].Target >= nodescount)
+                        {
+                            vml::utils::Logger::GetInstance()->Info("PathFinder : Hierarchy : '" + filename + "' has invalid edges");
+                            return false;
+                        }
+                    }
+
+                    ClusterSize         = clustersize;
+                    ClustersX           = clustersx;
+                    ClustersY           = clustersy;
+                    HierarchySourceHash = header->SourceHash;
+                    HierarchyBuildTime  = header->BuildTime;
+
+                    HierarchyNodes.assign(nodes, nodes + nodescount);
+                    HierarchyClusterFirst.assign(clusterfirst, clusterfirst + clusterscount + 1);
+                    HierarchyEdgeFirst.assign(edgefirst, edgefirst + nodescount + 1);
+                    HierarchyEdges.assign(edges, edges + edgescount);
+
+                    return true;
+                }
+
+                // ------------------------------------------------------------------------------
+                // measures path queries per second and average path length for short,
+                // medium and long paths with each search mode, pairs of walkable cells
+                // are picked at random inside the same connected component and bucketed
+                // by their octile cell distance
+
+                void Benchmark(int queries = 1000, unsigned int seed = 1234)
+                {
+                    static const int SHORT_PATH  = 0;
+                    static const int MEDIUM_PATH = 1;
+                    static const int LONG_PATH   = 2;
+
+                    // bucket limits in cells, relative to the mask size
+                    // so that small masks get long paths too
+
+                    int maxsize     = Width > Height ? Width : Height;
+                    int shortlimit  = maxsize / 8 > 4 ? maxsize / 8 : 4;
+                    int mediumlimit = maxsize / 3 > shortlimit ? maxsize / 3 : shortlimit + 1;
+
+                    // collect walkable cells
+
+                    std::vector<int> cells;
+
+                    for (int i = 0; i < Size; ++i)
+                        if (IdData[i] != -1)
+                            cells.emplace_back(i);
+
+                    if (cells.size() < 2)
+                    {
+                        vml::utils::Logger::GetInstance()->Info("PathFinder : Benchmark : Not enough walkable cells in " + FileName);
+                        return;
+                    }
+
+                    // pick random cell pairs
+
+                    std::vector<glm::ivec4> pairs[3];
+
+                    std::mt19937 rng(seed);
+                    std::uniform_int_distribution<size_t> pick(0, cells.size() - 1);
+
+                    size_t attempts = (size_t)queries * 3 * 64;
+
+                    for (size_t n = 0; n < attempts; ++n)
+                    {
+                        int a = cells[pick(rng)];
+                        int b = cells[pick(rng)];
+
+                        if (a == b || IdData[a] != IdData[b])
+                            continue;
+
+                        glm::ivec4 pair(a % Width, a / Width, b % Width, b / Width);
+
+                        int dx = abs(pair.z - pair.x);
+                        int dy = abs(pair.w - pair.y);
+                        int d  = dx > dy ? dx : dy;
+
+                        int bucket = LONG_PATH;
+
+                        if (d <= shortlimit) bucket = SHORT_PATH;
+                        else if (d <= mediumlimit) bucket = MEDIUM_PATH;
+
+                        if ((int)pairs[bucket].size() < queries)
+                            pairs[bucket].emplace_back(pair);
+
+                        if ((int)pairs[SHORT_PATH].size()  == queries &&
+                            (int)pairs[MEDIUM_PATH].size() == queries &&
+                            (int)pairs[LONG_PATH].size()   == queries)
+                            break;
+                    }
+
+                    // run queries with each search mode, the same pairs are used
+                    // so that timings and path lengths can be compared
+
+                    const char* names[3] = { "Short", "Medium", "Long" };
+                    const char* modes[3] = { "A*", "JPS", "HPA" };
+
+                    int lastmode = ClusterSize != 0 ? SEARCH_HPA : SEARCH_JPS;
+
+                    int searchmode = SearchMode;
+
+                    vml::utils::Logger::GetInstance()->Info("PathFinder : Benchmark : " + FileName + " ( " + std::to_string(Width) + " x " + std::to_string(Height) + " )");
+
+                    for (int bucket = SHORT_PATH; bucket <= LONG_PATH; ++bucket)
+                    {
+                        size_t count = pairs[bucket].size();
+
+                        if (count == 0)
+                        {
+                            vml::utils::Logger::GetInstance()->Info(std::string("PathFinder : Benchmark : ") + names[bucket] + " : no pairs found");
+                            continue;
+                        }
+
+                        float elapsed[3] = { 0.0f, 0.0f, 0.0f };
+                        float length[3]  = { 0.0f, 0.0f, 0.0f };
+
+                        for (int mode = SEARCH_ASTAR; mode <= lastmode; ++mode)
+                        {
+                            SearchMode = mode;
+
+                            size_t found  = 0;
+                            size_t cellsc = 0;
+
+                            vml::os::Timer timer;
+
+                            timer.Init();
+
+                            for (size_t n = 0; n < count; ++n)
+                            {
+                                const glm::ivec4& pair = pairs[bucket][n];
+
+                                if (FindPath(GetCellCenterFromIndices(pair.x, pair.y), pair.x, pair.y, pair.z, pair.w))
+                                {
+                                    found++;
+                                    cellsc += Context.GetCellsCount();
+                                    length[mode] += Context.GetPathLength();
+                                }
+                            }
+
+                            elapsed[mode] = timer.GetElapsedTime();
+
+                            float qps = elapsed[mode] > 0.0f ? (float)count / elapsed[mode] : 0.0f;
+
+                            float avgcells  = found ? (float)cellsc / (float)found : 0.0f;
+                            float avglength = found ? length[mode] / (float)found : 0.0f;
+
+                            vml::utils::Logger::GetInstance()->Info(std::string("PathFinder : Benchmark : ") + names[bucket] + " : " + modes[mode] + " : " + std::to_string(count) + " queries, found " + std::to_string(found) +
+                                                                    ", avg cells " + std::to_string(avgcells) + ", avg length " + std::to_string(avglength) + ", " + std::to_string(elapsed[mode] * 1000.0f) + " ms, " + std::to_string((int)qps) + " queries/s");
+                        }
+
+                        for (int mode = SEARCH_JPS; mode <= lastmode; ++mode)
+                        {
+                            float speedup = elapsed[mode] > 0.0f ? elapsed[SEARCH_ASTAR] / elapsed[mode] : 0.0f;
+                            float ratio   = length[SEARCH_ASTAR] > 0.0f ? length[mode] / length[SEARCH_ASTAR] : 0.0f;
+
+                            vml::utils::Logger::GetInstance()->Info(std::string("PathFinder : Benchmark : ") + names[bucket] + " : " + modes[mode] + " speedup " + std::to_string(speedup) + "x, " + modes[mode] + " / A* length " + std::to_string(ratio));
+                        }
+                    }
+
+                    SearchMode = searchmode;
                 }
 
                 // ------------------------------------------------------------------------------
@@ -1347,23 +2653,19 @@ namespace vml
 					Data                  =  nullptr;
                     Data                  =  nullptr;
                     IdData                =  nullptr;
-                    Distance              =  nullptr;
-                    Parent                =  nullptr;
-                    Path                  =  nullptr;
                     Pa                    =  nullptr;
                     Pb                    =  nullptr;
                     Pc                    =  nullptr;
                     Pd                    =  nullptr;
                     Dw                    =  0.0f;
                     Dh                    =  0.0f;
-                    PAvgrIn               =  nullptr;
-                    PAvgrOut              =  nullptr;
-                    PAvgrDir              =  nullptr;
-                    PAvgrInvSegmentLength =  nullptr;
-                    PAvgrSegmentLength    =  nullptr;
-                    PathCount             =  0;
-                    PAvgrOutPathCount     =  0;
                     AvgNeighbours         =  2;
+                    SearchMode            =  SEARCH_ASTAR;
+                    ClusterSize           =  0;
+                    ClustersX             =  0;
+                    ClustersY             =  0;
+                    HierarchySourceHash   =  0;
+                    HierarchyBuildTime    =  0.0f;
                     BoundingBoxMin        =  glm::vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
                     BoundingBoxMax        =  glm::vec3( FLT_MAX,  FLT_MAX,  FLT_MAX);
 					FileName              =  filename;
@@ -1372,7 +2674,6 @@ namespace vml
                     Bi                    = -1;
                     Bj                    = -1;
                     ZDepth                =  0.01f;
-                    PathLength            =  0.0f;
 
 					LoadFile2();
 					
@@ -1382,18 +2683,10 @@ namespace vml
 				{
 					vml::os::SafeDelete(Data);
                     vml::os::SafeDelete(IdData);
-                    vml::os::SafeDelete(Distance);
-                    vml::os::SafeDeleteArray(Parent);
-                    vml::os::SafeDeleteArray(Path);
                     vml::os::SafeDeleteArray(Pa);
                     vml::os::SafeDeleteArray(Pb);
                     vml::os::SafeDeleteArray(Pc);
                     vml::os::SafeDeleteArray(Pd);
-                    vml::os::SafeDeleteArray(PAvgrIn);
-                    vml::os::SafeDeleteArray(PAvgrOut);
-                    vml::os::SafeDeleteArray(PAvgrDir);
-                    vml::os::SafeDeleteArray(PAvgrInvSegmentLength);
-                    vml::os::SafeDeleteArray(PAvgrSegmentLength);
                 }
 
 		};
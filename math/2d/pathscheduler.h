@@ -0,0 +1,476 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////////
+//	This source file is part of v71's engine
+//
+//	Copyright (c) 2011-2050 v71
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+namespace vml
+{
+	namespace geo2d
+	{
+
+		////////////////////////////////////////////////////////////////////////////
+		// path request scheduler
+		// agents submit path requests instead of calling the pathfinder directly,
+		// each pool thread owns a search context so requests run concurrently on
+		// the shared pathfinder, without a pool requests are time sliced on the
+		// calling thread within a per frame budget. Results are always delivered
+		// on the thread calling Update, so agents don't need to be thread safe
+
+		class PathScheduler
+		{
+			
+			public:
+
+				// ----------------------------------------------------------------
+				// path result, a copy of the smoothed path so that it
+				// stays valid after the search context is reused
+
+				struct PathResult
+				{
+					int						Id;					// request id
+					bool					Found;				// path has been found
+					float					Length;				// smoothed path length
+					std::vector<glm::vec3>	Points;				// smoothed path points
+					std::vector<glm::vec3>	Directions;			// segments directions
+					std::vector<float>		InvSegmentLength;	// segments inverse lengths
+					std::vector<float>		SegmentLength;		// segments lengths
+				};
+
+				typedef std::function<void(const PathResult&)> PathCallback;
+
+			private:
+
+				// ----------------------------------------------------------------
+				// queued request
+
+				struct PathRequest
+				{
+					glm::vec3		Origin;
+					int				Ai, Aj;
+					int				Bi, Bj;
+					unsigned int	Frame;						// frame the request has been submitted in
+					PathCallback	Callback;
+					PathResult		Result;
+				};
+
+				// ----------------------------------------------------------------
+				// private data
+
+				vml::geo2d::PathFinder*							    Finder;			// shared pathfinder
+				vml::os::ThreadPool*							    Pool;			// pool running searches, null if time sliced
+				std::vector<std::unique_ptr<PathFinder::SearchContext>> Contexts;	// one search context per pool thread
+				std::deque<std::shared_ptr<PathRequest>>		    Pending;		// requests waiting to be processed
+				std::vector<std::shared_ptr<PathRequest>>		    Completed;		// requests processed by workers
+				std::vector<std::shared_ptr<PathRequest>>		    Delivering;		// requests being delivered
+				std::unordered_set<int>							    Running;		// ids of requests handed to workers and not yet delivered
+				std::unordered_set<int>							    Cancelled;		// ids of running requests that have been cancelled
+				std::mutex										    CompletedMutex;	// guards completed requests
+				std::atomic<int>								    InFlight;		// requests submitted to workers
+				int												    NextId;			// next request id
+				unsigned int									    Frame;			// update counter
+				size_t											    Processed;		// processed requests count
+				size_t											    MaxLatency;		// max frames between submission and delivery
+
+				// ----------------------------------------------------------------
+				// runs a request on the given search context
+
+				void Process(PathFinder::SearchContext& ctx, PathRequest& request) const
+				{
+					PathResult& result = request.Result;
+
+					result.Found  = Finder->FindPath(ctx, request.Origin, request.Ai, request.Aj, request.Bi, request.Bj) != 0 && ctx.GetPathCount() > 0;
+					result.Length = 0.0f;
+
+					if (result.Found)
+					{
+						int count = ctx.GetPathCount();
+
+						result.Length = ctx.GetPathLength();
+						result.Points.assign(ctx.GetPAvgrOut(), ctx.GetPAvgrOut() + count);
+
+						// count points make count - 1 segments
+
+						result.Directions.assign(ctx.GetPAvgrDir(), ctx.GetPAvgrDir() + count - 1);
+						result.InvSegmentLength.assign(ctx.GetPAvgrInvSegmentLength(), ctx.GetPAvgrInvSegmentLength() + count - 1);
+						result.SegmentLength.assign(ctx.GetPAvgrSegmentLength(), ctx.GetPAvgrSegmentLength() + count - 1);
+					}
+				}
+
+				// ----------------------------------------------------------------
+				// calls callbacks of processed requests, unless cancelled
+
+				void Deliver(PathRequest& request)
+				{
+					Processed++;
+
+					Running.erase(request.Result.Id);
+
+					if (Cancelled.erase(request.Result.Id) > 0)
+						return;
+
+					size_t latency = Frame - request.Frame;
+
+					if (latency > MaxLatency)
+						MaxLatency = latency;
+
+					if (request.Callback)
+						request.Callback(request.Result);
+				}
+
+				// ----------------------------------------------------------------
+				// delivers requests completed by workers
+
+				void DeliverCompleted()
+				{
+					{
+						std::lock_guard<std::mutex> lock(CompletedMutex);
+						Delivering.swap(Completed);
+					}
+
+					for (size_t i = 0; i < Delivering.size(); ++i)
+						Deliver(*Delivering[i]);
+
+					Delivering.clear();
+				}
+
+				// ----------------------------------------------------------------
+				// hands all pending requests to workers
+
+				void Dispatch()
+				{
+					while (!Pending.empty())
+					{
+						std::shared_ptr<PathRequest> request = Pending.front();
+
+						Pending.pop_front();
+
+						Running.insert(request->Result.Id);
+
+						Pool->Submit([this, request]()
+						{
+							Process(*Contexts[Pool->GetThreadIndex()], *request);
+
+							std::lock_guard<std::mutex> lock(CompletedMutex);
+							Completed.emplace_back(request);
+						}, &InFlight);
+					}
+				}
+
+			public:
+
+				// ----------------------------------------------------------------
+				// queues a path request, the callback is called from Update
+				// once the path is computed, returns the request id
+
+				int Submit(const glm::vec3& origin, const glm::ivec2& a, const glm::ivec2& b, PathCallback callback)
+				{
+					std::shared_ptr<PathRequest> request = std::make_shared<PathRequest>();
+
+					request->Origin	   = origin;
+					request->Ai		   = a.x;
+					request->Aj		   = a.y;
+					request->Bi		   = b.x;
+					request->Bj		   = b.y;
+					request->Frame	   = Frame;
+					request->Callback  = std::move(callback);
+					request->Result.Id = NextId++;
+					request->Result.Found  = false;
+					request->Result.Length = 0.0f;
+
+					Pending.emplace_back(request);
+
+					return request->Result.Id;
+				}
+
+				// ----------------------------------------------------------------
+				// queues a path request, the future is fulfilled from Update
+
+				std::future<PathResult> Submit(const glm::vec3& origin, const glm::ivec2& a, const glm::ivec2& b)
+				{
+					std::shared_ptr<std::promise<PathResult>> promise = std::make_shared<std::promise<PathResult>>();
+
+					std::future<PathResult> future = promise->get_future();
+
+					Submit(origin, a, b, [promise](const PathResult& result) { promise->set_value(result); });
+
+					return future;
+				}
+
+				// ----------------------------------------------------------------
+				// cancels a request, its callback won't be called, pending
+				// requests are removed, requests already running are dropped
+				// on delivery, ids already delivered or unknown are ignored
+
+				void Cancel(int id)
+				{
+					for (auto it = Pending.begin(); it != Pending.end(); ++it)
+					{
+						if ((*it)->Result.Id == id)
+						{
+							Pending.erase(it);
+							return;
+						}
+					}
+
+					if (Running.find(id) != Running.end())
+						Cancelled.insert(id);
+				}
+
+				// ----------------------------------------------------------------
+				// called once per frame, with workers, pending requests are handed
+				// to workers and completed ones are delivered, without workers,
+				// requests are processed until the budget in milliseconds is used,
+				// at least one request is processed per frame so queues always drain
+
+				void Update(float budget)
+				{
+					Frame++;
+
+					if (GetWorkersCount() > 0)
+					{
+						Dispatch();
+						DeliverCompleted();
+						return;
+					}
+
+					// budget is measured on integer clock ticks, float timers lose
+					// sub millisecond resolution after long uptimes, huge budgets
+					// are clamped so that the conversion doesn't overflow
+
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+					std::chrono::steady_clock::duration limit = std::chrono::steady_clock::duration::max();
+
+					if (budget < 1.0e9f)
+						limit = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(budget));
+
+					while (!Pending.empty())
+					{
+						std::shared_ptr<PathRequest> request = Pending.front();
+
+						Pending.pop_front();
+
+						Process(*Contexts[0], *request);
+
+						Deliver(*request);
+
+						if (std::chrono::steady_clock::now() - start >= limit)
+							break;
+					}
+				}
+
+				// ----------------------------------------------------------------
+				// processes and delivers all requests, blocking the calling thread
+
+				void Flush()
+				{
+					if (GetWorkersCount() > 0)
+					{
+						Dispatch();
+						Pool->Wait(InFlight);
+						DeliverCompleted();
+						return;
+					}
+
+					while (!Pending.empty())
+					{
+						std::shared_ptr<PathRequest> request = Pending.front();
+
+						Pending.pop_front();
+
+						Process(*Contexts[0], *request);
+
+						Deliver(*request);
+					}
+				}
+
+				// ----------------------------------------------------------------
+				// simulates a swarm of agents re-routing on a shared pathfinder and logs
+				// frame time percentiles, agents re-route every few seconds and a quarter
+				// of them re-route together every second to reproduce frame spikes,
+				// requests are run synchronously, time sliced and on worker threads
+
+				static void Benchmark(vml::geo2d::PathFinder* pathfinder, int agents = 500, int frames = 600, float budget = 0.5f, unsigned int seed = 1234)
+				{
+					if (!pathfinder)
+						vml::os::Message::Error("PathScheduler : ", "PathFinder is null");
+
+					int width  = pathfinder->GetWidth();
+					int height = pathfinder->GetHeight();
+
+					// collect walkable cells
+
+					std::vector<glm::ivec2> cells;
+
+					for (int j = 0; j < height; ++j)
+						for (int i = 0; i < width; ++i)
+							if (pathfinder->GetCellIdFromIndices(i, j) != -1)
+								cells.emplace_back(i, j);
+
+					if (cells.empty())
+						return;
+
+					// pre generate requests so every mode runs the same workload
+
+					std::mt19937 rng(seed);
+					std::uniform_int_distribution<size_t> pick(0, cells.size() - 1);
+					std::uniform_int_distribution<int>	  reroute(0, 179);
+
+					std::vector<std::vector<glm::ivec4>> workload(frames);
+
+					for (int frame = 0; frame < frames; ++frame)
+					{
+						bool burst = frame % 60 == 59;
+
+						for (int agent = 0; agent < agents; ++agent)
+						{
+							if (burst ? agent % 4 != 0 : reroute(rng) != 0)
+								continue;
+
+							glm::ivec2 a = cells[pick(rng)];
+							glm::ivec2 b = cells[pick(rng)];
+
+							for (int n = 0; n < 16 && pathfinder->GetCellIdFromIndices(a.x, a.y) != pathfinder->GetCellIdFromIndices(b.x, b.y); ++n)
+								b = cells[pick(rng)];
+
+							workload[frame].emplace_back(a.x, a.y, b.x, b.y);
+						}
+					}
+
+					vml::os::ThreadPool* pool = vml::os::ThreadPool::GetInstance();
+
+					size_t workers = pool->GetWorkersCount();
+
+					const char* names[3] = { "Synchronous", "Time Sliced", "Workers" };
+
+					vml::utils::Logger::GetInstance()->Info("PathScheduler : Benchmark : " + std::to_string(agents) + " agents, " + std::to_string(frames) + " frames, " + std::to_string(budget) + " ms budget, " + std::to_string(workers) + " workers");
+
+					for (int mode = 0; mode < 3; ++mode)
+					{
+						PathScheduler scheduler(pathfinder, mode == 2 ? pool : nullptr);
+
+						std::vector<float> times(frames);
+
+						size_t delivered = 0;
+
+						for (int frame = 0; frame < frames; ++frame)
+						{
+							vml::os::Timer timer;
+
+							timer.Init();
+
+							for (const glm::ivec4& r : workload[frame])
+							{
+								glm::vec3 origin = pathfinder->GetCellCenterFromIndices(r.x, r.y);
+
+								if (mode == 0)
+								{
+									pathfinder->FindPath(origin, r.x, r.y, r.z, r.w);
+									delivered++;
+								}
+								else
+								{
+									scheduler.Submit(origin, glm::ivec2(r.x, r.y), glm::ivec2(r.z, r.w), [&delivered](const PathResult&) { delivered++; });
+								}
+							}
+
+							if (mode != 0)
+								scheduler.Update(budget);
+
+							times[frame] = timer.GetElapsedTime() * 1000.0f;
+						}
+
+						scheduler.Flush();
+
+						std::sort(times.begin(), times.end());
+
+						auto percentile = [&times](float p) { return times[(size_t)(p * (float)(times.size() - 1))]; };
+
+						vml::utils::Logger::GetInstance()->Info(std::string("PathScheduler : Benchmark : ") + names[mode] + " : " + std::to_string(delivered) + " paths, frame ms p50 " + std::to_string(percentile(0.5f)) +
+																", p95 " + std::to_string(percentile(0.95f)) + ", p99 " + std::to_string(percentile(0.99f)) + ", max " + std::to_string(times.back()) +
+																", max latency " + std::to_string(mode == 0 ? 0 : scheduler.GetMaxLatency()) + " frames");
+					}
+				}
+
+				// ----------------------------------------------------------------
+				// getters
+
+				size_t GetPendingCount()   const { return Pending.size(); }
+				int	   GetInFlightCount()  const { return InFlight; }
+				size_t GetProcessedCount() const { return Processed; }
+				size_t GetMaxLatency()	   const { return MaxLatency; }
+				size_t GetWorkersCount()   const { return Pool ? Pool->GetWorkersCount() : 0; }
+
+				//-----------------------------------------------------------------------------------
+				// copy constructor is private
+				// no copies allowed since classes
+				// are referenced
+
+				PathScheduler(PathScheduler& pathscheduler) = delete;
+
+				//-----------------------------------------------------------------------------------
+				// overload operator is private,
+				// no copies allowed since classes
+				// are referenced
+
+				void operator=(const PathScheduler& pathscheduler) = delete;
+
+				// ----------------------------------------------------------------
+				// ctor / dtor
+				// searches run on the given pool, usually the engine pool, if pool 
+				// is null or has no workers, requests are time sliced on the calling thread
+
+				PathScheduler(vml::geo2d::PathFinder* pathfinder, vml::os::ThreadPool* pool)
+				{
+					if (!pathfinder)
+						vml::os::Message::Error("PathScheduler : ", "PathFinder is null");
+
+					Finder	   = pathfinder;
+					Pool	   = pool;
+					InFlight   = 0;
+					NextId	   = 0;
+					Frame	   = 0;
+					Processed  = 0;
+					MaxLatency = 0;
+
+					// thread indices are per pool, index 0 is any thread not in the pool
+
+					for (size_t i = 0; i < GetWorkersCount() + 1; ++i)
+					{
+						Contexts.emplace_back(std::make_unique<PathFinder::SearchContext>());
+						Finder->InitSearchContext(*Contexts.back());
+					}
+				}
+
+				~PathScheduler()
+				{
+					// wait for running requests, they reference contexts
+
+					if (Pool)
+						Pool->Wait(InFlight);
+				}
+
+		};
+
+	}
+}
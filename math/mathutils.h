@@ -49,4 +49,5 @@
 #include <vml4.0\libs\glm\gtc\matrix_inverse.hpp>			// for inverting and transposing 
 #include <vml4.0\libs\glm\gtx\quaternion.hpp>				// quaternion class for orientation
 #include <vml4.0\libs\glm\gtx\perpendicular.hpp>			// quaternion class for orientation
+#include <vml4.0\libs\glm\gtc\packing.hpp>					// half floats packing
 
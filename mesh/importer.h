@@ -37,9 +37,47 @@ namespace vml
 		class TinyObjImporter
 		{
 	
+			public:
+
+				// ---------------------------------------------------------------------------------
+				// import timings in milliseconds, per shape stages are summed
+				// over all shapes, so with more than one loading thread their
+				// sum can exceed the total wall clock time
+
+				struct Timings
+				{
+					float Parse		= 0.0f;		// obj parsing through tinyobj
+					float Build		= 0.0f;		// unindexed vertex list
+					float Remap		= 0.0f;		// vertex remapping
+					float Optimize  = 0.0f;		// vertex cache, overdraw and vertex fetch optimization
+					float Transform = 0.0f;		// centering, transform and bounds
+					float Write		= 0.0f;		// array split and file write
+					float Lods		= 0.0f;		// level of detail simplification and write
+					float Total		= 0.0f;		// wall clock import time
+				};
+
 			private:
 
+				// ---------------------------------------------------------------------------------
+				// per shape import job, shapes are imported in parallel and each job
+				// keeps its own log and timings, which are reported in shape order
+				// once all jobs have completed
+
+				struct ShapeJob
+				{
+					const tinyobj::shape_t* Shape = nullptr;
+					std::string				FileName;
+					std::string				Log;
+					std::string				Error;
+					Timings					Time;
+				};
+
 				std::string ImportError;
+				Timings		ImportTimings;
+				bool		Optimize;
+				size_t		LodLevels;				// levels of detail generated besides the mesh itself
+				float		LodRatio;				// triangles ratio between a level and the next one
+				float		LodError;				// simplification error, relative to mesh extents
 
 				// ---------------------------------------------------------------------------------
 
@@ -161,9 +199,245 @@ namespace vml
 
 				}
 
+				// ---------------------------------------------------------------------------------
+				// splits vertices into the mesh arrays and saves them in the aligned mesh format
+
+				static bool SaveMesh(const std::string& filename,
+									 const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+									 const glm::vec3& boundingboxmin, const glm::vec3& boundingboxmax, float radius)
+				{
+					std::vector<float> vertexarray(vertices.size() * 4);
+					std::vector<float> normalarray(vertices.size() * 3);
+					std::vector<float> uvarray(vertices.size() * 2);
+
+					for (size_t i = 0; i < vertices.size(); ++i)
+					{
+						vertexarray[i * 4    ] = vertices[i].Position.x;
+						vertexarray[i * 4 + 1] = vertices[i].Position.y;
+						vertexarray[i * 4 + 2] = vertices[i].Position.z;
+						vertexarray[i * 4 + 3] = 1.0f;
+						normalarray[i * 3    ] = vertices[i].Normal.x;
+						normalarray[i * 3 + 1] = vertices[i].Normal.y;
+						normalarray[i * 3 + 2] = vertices[i].Normal.z;
+						uvarray[i * 2    ] = vertices[i].UV.x;
+						uvarray[i * 2 + 1] = vertices[i].UV.y;
+					}
+
+					return vml::meshes::Mesh3d::Save(filename, vertexarray, normalarray, uvarray, indices, boundingboxmin, boundingboxmax, radius);
+				}
+
+				// ---------------------------------------------------------------------------------
+				// imports a single shape, called on loading threads, only touches the job
+
+				void ImportShape(ShapeJob& job, const tinyobj::attrib_t& inattrib, const glm::vec3& rot, const glm::vec3& scale)
+				{
+					const tinyobj::mesh_t& mesh = job.Shape->mesh;
+
+					vml::os::Timer timer;
+
+					timer.Init();
+
+					float last = 0.0f;
+
+					// returns milliseconds elapsed since the previous call
+
+					auto lap = [&timer, &last]()
+					{
+						float now = timer.GetElapsedTime() * 1000.0f;
+						float dt  = now - last;
+						last = now;
+						return dt;
+					};
+
+					unsigned int icount = 0;
+
+					std::vector<Vertex> vertices;
+					std::vector<unsigned int> indices;
+
+					vertices.reserve(mesh.indices.size());
+					indices.reserve(mesh.indices.size());
+
+					for (const auto& index : mesh.indices)
+					{
+						tinyobj::index_t i = index;
+
+						size_t ivindex = (size_t)i.vertex_index * 3;
+						size_t inindex = (size_t)i.normal_index * 3;
+						size_t itindex = (size_t)i.texcoord_index * 2;
+
+						glm::vec3 pos(inattrib.vertices[ivindex], inattrib.vertices[ivindex + 1], inattrib.vertices[ivindex + 2]);
+						glm::vec3 normal(0, 0, 0);
+						glm::vec2 uv(0, 0);
+
+						if (inattrib.normals.size() > 0)
+							normal = glm::vec3(inattrib.normals[inindex], inattrib.normals[inindex + 1], inattrib.normals[inindex + 2]);
+
+						if (inattrib.texcoords.size() > 0)
+							uv = glm::vec2(inattrib.texcoords[itindex], inattrib.texcoords[itindex + 1]);
+
+						// add this vertex struct
+
+						vertices.emplace_back(Vertex(pos, normal, uv));
+
+						// add indices
+
+						indices.emplace_back(icount);
+
+						icount++;
+					}
+
+					job.Time.Build = lap();
+
+					// remap vertices
+
+					std::vector<unsigned int> remap(indices.size());
+					const size_t vertexCount = meshopt_generateVertexRemap(remap.data(), indices.data(), indices.size(), vertices.data(), indices.size(), sizeof(Vertex));
+
+					// create anew mesh using remapped vertices
+
+					std::vector<unsigned int> remappedIndices(indices.size());
+					std::vector<Vertex> remappedVertices(vertexCount);
+					meshopt_remapIndexBuffer(remappedIndices.data(), indices.data(), indices.size(), remap.data());
+					meshopt_remapVertexBuffer(remappedVertices.data(), vertices.data(), vertices.size(), sizeof(Vertex), remap.data());
+
+					job.Time.Remap = lap();
+
+					// reorder triangles for the post transform cache, then for overdraw,
+					// allowing 5% cache efficiency loss, then reorder vertices in first
+					// use order for the pre transform cache, indices are updated in place
+
+					if (Optimize && !remappedIndices.empty())
+					{
+						meshopt_optimizeVertexCache(remappedIndices.data(), remappedIndices.data(), remappedIndices.size(), vertexCount);
+						meshopt_optimizeOverdraw(remappedIndices.data(), remappedIndices.data(), remappedIndices.size(), &remappedVertices[0].Position.x, vertexCount, sizeof(Vertex), 1.05f);
+						meshopt_optimizeVertexFetch(remappedVertices.data(), remappedIndices.data(), remappedIndices.size(), remappedVertices.data(), vertexCount, sizeof(Vertex));
+					}
+
+					job.Time.Optimize = lap();
+
+					// create mesh 
+
+					glm::vec3 boundingboxmin(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+					glm::vec3 boundingboxmax(FLT_MAX, FLT_MAX, FLT_MAX);
+					float radius = 0.0f;
+
+					// transform mesh 
+
+					TransformMesh(remappedVertices, boundingboxmin, boundingboxmax, radius, rot, scale);
+
+					job.Time.Transform = lap();
+
+					// save in the aligned mesh format
+
+					if (!SaveMesh(job.FileName, remappedVertices, remappedIndices, boundingboxmin, boundingboxmax, radius))
+						job.Error = "Fatal : couldn't save " + job.FileName;
+
+					job.Time.Write = lap();
+
+					// generate the level of detail chain, each level is simplified from the
+					// full mesh and keeps its bounds, so culling doesn't change with the level,
+					// the chain stops when the simplifier can't reduce triangles any further
+
+					std::string lodlog;
+
+					size_t lods = 0;
+
+					if (job.Error.empty() && !remappedIndices.empty())
+					{
+						size_t previous = remappedIndices.size();
+						float  ratio	= 1.0f;
+
+						std::vector<unsigned int> lodindices(remappedIndices.size());
+						std::vector<Vertex>		  lodvertices(vertexCount);
+
+						for (size_t level = 1; level <= LodLevels && level < vml::meshes::Mesh3d::MAX_LOD_LEVELS; ++level)
+						{
+							ratio *= LodRatio;
+
+							size_t target = (size_t)(remappedIndices.size() * ratio) / 3 * 3;
+							float  error  = 0.0f;
+
+							lodindices.resize(remappedIndices.size());
+
+							size_t count = meshopt_simplify(lodindices.data(), remappedIndices.data(), remappedIndices.size(),
+															&remappedVertices[0].Position.x, vertexCount, sizeof(Vertex),
+															target, LodError, 0, &error);
+
+							if (count == 0 || count > previous * 7 / 8)
+								break;
+
+							lodindices.resize(count);
+
+							// keep only referenced vertices, in first use order
+
+							meshopt_optimizeVertexCache(lodindices.data(), lodindices.data(), count, vertexCount);
+
+							lodvertices.resize(vertexCount);
+							lodvertices.resize(meshopt_optimizeVertexFetch(lodvertices.data(), lodindices.data(), count, remappedVertices.data(), vertexCount, sizeof(Vertex)));
+
+							std::string lodfilename = vml::meshes::Mesh3d::GetLodFileName(job.FileName, level);
+
+							if (!SaveMesh(lodfilename, lodvertices, lodindices, boundingboxmin, boundingboxmax, radius))
+							{
+								job.Error = "Fatal : couldn't save " + lodfilename;
+								break;
+							}
+
+							lodlog += "lod " + std::to_string(level) + " : vertices : " + std::to_string(lodvertices.size()) +
+									  " indices : " + std::to_string(count) + " error : " + std::to_string(error) + "\n";
+
+							previous = count;
+							lods	 = level;
+						}
+					}
+
+					// remove levels left over by a previous import
+
+					for (size_t level = lods + 1; level < vml::meshes::Mesh3d::MAX_LOD_LEVELS; ++level)
+					{
+						std::error_code ec;
+						std::filesystem::remove(vml::meshes::Mesh3d::GetLodFileName(job.FileName, level), ec);
+					}
+
+					job.Time.Lods = lap();
+
+					job.Log = "saving : " + job.FileName + "\n" +
+							  "vertices : " + std::to_string(remappedVertices.size()) + "\n" +
+							  "indices : " + std::to_string(remappedIndices.size()) + "\n" +
+							  "Bmin : " + std::to_string(boundingboxmin.x) + " " + std::to_string(boundingboxmin.y) + " " + std::to_string(boundingboxmin.z) + "\n" +
+							  "Bmax : " + std::to_string(boundingboxmax.x) + " " + std::to_string(boundingboxmax.y) + " " + std::to_string(boundingboxmax.z) + "\n" +
+							  "Radius : " + std::to_string(radius) + "\n" + lodlog;
+				}
+
 		public:
 					
 			const std::string& GetError() const { return ImportError; }
+			const Timings&	   GetTimings() const { return ImportTimings; }
+			size_t			   GetLodLevels() const { return LodLevels; }
+			bool			   IsOptimizing() const { return Optimize; }
+
+			// -----------------------------------------------------------------------
+			// enables vertex cache, overdraw and vertex fetch optimization, on by default
+
+			void SetOptimize(bool optimize) { Optimize = optimize; }
+
+			// -----------------------------------------------------------------------
+			// sets the level of detail chain, levels are written alongside each mesh,
+			// see Mesh3d::GetLodFileName, each level targets ratio times the triangles
+			// of the previous one, 0 levels disables the chain
+
+			void SetLods(size_t levels, float ratio = 0.5f, float error = 0.05f)
+			{
+				if (levels >= vml::meshes::Mesh3d::MAX_LOD_LEVELS)
+					vml::os::Message::Error("Importer : ", "Too many levels of detail");
+
+				if (ratio <= 0.0f || ratio >= 1.0f)
+					vml::os::Message::Error("Importer : ", "Level of detail ratio must be in the ]0,1[ range");
+
+				LodLevels = levels;
+				LodRatio  = ratio;
+				LodError  = error;
+			}
 
 			// -----------------------------------------------------------------------
 			// import model from various file formats, thanks to assimp
@@ -184,7 +458,12 @@ namespace vml
 				
 				// start importing
 
-				ImportError = "NoError";
+				ImportError   = "NoError";
+				ImportTimings = Timings();
+
+				vml::os::Timer timer;
+
+				timer.Init();
 
 				std::string fullpath = sourcepath + sourcefilename;
 
@@ -202,6 +481,8 @@ namespace vml
 
 				bool ret = tinyobj::LoadObj(&inattrib, &inshapes, &materials, &warn, &err, &fullpath[0], &sourcepath[0]);
 
+				ImportTimings.Parse = timer.GetElapsedTime() * 1000.0f;
+
 				// check if file has been properly imported
 
 				if (!warn.empty())
@@ -237,131 +518,83 @@ namespace vml
 				std::filesystem::create_directories(meshespath);
 				std::filesystem::create_directories(texturespath);
 				
-				// import meshes
-				
-				for (const auto& shape : inshapes)
-				{
-					
-					const tinyobj::mesh_t& mesh = shape.mesh;
-					
-					int icount = 0;
-
-					std::vector<Vertex> vertices;
-					std::vector<unsigned int> indices;
+				// import meshes, shapes sharing a name would be written to
+				// the same file, only the last one is kept, as it would have
+				// overwritten the others
 
-					for (const auto& index : mesh.indices)
-					{
-						tinyobj::index_t i = index;
+				std::map<std::string, size_t> shapenames;
 
-						size_t ivindex = (size_t)i.vertex_index * 3;
-						size_t inindex = (size_t)i.normal_index * 3;
-						size_t itindex = (size_t)i.texcoord_index * 2;
-
-						glm::vec3 pos(inattrib.vertices[ivindex], inattrib.vertices[ivindex + 1], inattrib.vertices[ivindex + 2]);
-						glm::vec3 normal(0, 0, 0);
-						glm::vec2 uv(0, 0);
-
-						if (inattrib.normals.size() > 0)
-							normal = glm::vec3(inattrib.normals[inindex], inattrib.normals[inindex + 1], inattrib.normals[inindex + 2]);
+				for (size_t i = 0; i < inshapes.size(); ++i)
+					shapenames[inshapes[i].name] = i;
 
-						if (inattrib.texcoords.size() > 0)
-							uv = glm::vec2(inattrib.texcoords[itindex], inattrib.texcoords[itindex + 1]);
+				std::vector<ShapeJob> jobs(shapenames.size());
 
-						// add this vertex struct
+				size_t jobscount = 0;
 
-						vertices.emplace_back(Vertex(pos, normal, uv));
+				for (size_t i = 0; i < inshapes.size(); ++i)
+				{
+					if (shapenames[inshapes[i].name] != i)
+						continue;
 
-						// add indices
+					jobs[jobscount].Shape	 = &inshapes[i];
+					jobs[jobscount].FileName = meshespath + inshapes[i].name + ".3df";
 
-						indices.emplace_back(icount);
+					jobscount++;
+				}
 
-						icount++;
-					
-					}
-					
-					// remap vertices
+				// shapes are imported on the engine thread pool, the calling
+				// thread helps while waiting, so it counts as a worker
 
-					std::vector<unsigned int> remap(indices.size());
-					const size_t vertexCount = meshopt_generateVertexRemap(remap.data(), indices.data(), indices.size(), vertices.data(), indices.size(), sizeof(Vertex));
-					
-					// create anew mesh using remapped vertices
+				vml::os::ThreadPool* pool = vml::os::ThreadPool::GetInstance();
 
-					std::vector<unsigned int> remappedIndices(indices.size());
-					std::vector<Vertex> remappedVertices(vertexCount);
-					meshopt_remapIndexBuffer(remappedIndices.data(), indices.data(), indices.size(), remap.data());
-					meshopt_remapVertexBuffer(remappedVertices.data(), vertices.data(), vertices.size(), sizeof(Vertex), remap.data());
+				size_t workers = std::min(pool->GetWorkersCount() + 1, jobs.size());
 
-					// create mesh 
+				std::atomic<int> counter = 0;
 
-					glm::vec3 boundingboxmin(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-					glm::vec3 boundingboxmax(FLT_MAX, FLT_MAX, FLT_MAX);
-					float radius = 0.0f;
+				for (size_t i = 0; i < jobs.size(); ++i)
+				{
+					ShapeJob* job = &jobs[i];
 
-					// transform mesh 
+					pool->Submit([this, job, &inattrib, &rot, &scale]() { ImportShape(*job, inattrib, rot, scale); }, &counter);
+				}
 
-					TransformMesh(remappedVertices, boundingboxmin, boundingboxmax, radius, rot, scale);
+				pool->Wait(counter);
 
-					//
+				// report in shape order
 
-					std::string fullpathfilename = meshespath + shape.name + ".3df";
+				for (const auto& job : jobs)
+				{
+					std::cout << job.Log;
+
+					ImportTimings.Build	    += job.Time.Build;
+					ImportTimings.Remap	    += job.Time.Remap;
+					ImportTimings.Optimize  += job.Time.Optimize;
+					ImportTimings.Transform += job.Time.Transform;
+					ImportTimings.Write	    += job.Time.Write;
+					ImportTimings.Lods	    += job.Time.Lods;
+				}
 
-					std::cout << "saving : " << shape.name << std::endl;
-					std::cout << "filename :" << shape.name + ".3df" << std::endl;
-					std::cout << "saving : " << fullpathfilename << std::endl;
-					std::cout << "vertices : " << remappedVertices.size() << std::endl;
-					std::cout << "indices : " << remappedIndices.size() << std::endl;
-					
-					FILE* stream;
+				ImportTimings.Total = timer.GetElapsedTime() * 1000.0f;
 
-					errno_t err = fopen_s(&stream, fullpathfilename.c_str(), "wb");
+				vml::utils::Logger::GetInstance()->Info("Importer : " + sourcefilename + " : " + std::to_string(jobs.size()) + " shapes , " + std::to_string(workers) + " threads");
+				vml::utils::Logger::GetInstance()->Info("Importer : Parse     : " + std::to_string(ImportTimings.Parse) + " ms");
+				vml::utils::Logger::GetInstance()->Info("Importer : Build     : " + std::to_string(ImportTimings.Build) + " ms");
+				vml::utils::Logger::GetInstance()->Info("Importer : Remap     : " + std::to_string(ImportTimings.Remap) + " ms");
+				vml::utils::Logger::GetInstance()->Info("Importer : Optimize  : " + std::to_string(ImportTimings.Optimize) + " ms");
+				vml::utils::Logger::GetInstance()->Info("Importer : Transform : " + std::to_string(ImportTimings.Transform) + " ms");
+				vml::utils::Logger::GetInstance()->Info("Importer : Write     : " + std::to_string(ImportTimings.Write) + " ms");
+				vml::utils::Logger::GetInstance()->Info("Importer : Lods      : " + std::to_string(ImportTimings.Lods) + " ms");
+				vml::utils::Logger::GetInstance()->Info("Importer : Total     : " + std::to_string(ImportTimings.Total) + " ms");
 
-					// save vertices count
-					if(stream)
+				for (const auto& job : jobs)
+				{
+					if (!job.Error.empty())
 					{
-						unsigned int verticescount = (unsigned int)remappedVertices.size();
-
-						fwrite(&verticescount, sizeof(unsigned int), 1, stream);
-
-						// save vertices 
-
-						for (size_t i = 0; i < remappedVertices.size(); ++i)
-						{
-							fwrite(&remappedVertices[i].Position, sizeof(float), 3, stream);
-							fwrite(&remappedVertices[i].Normal, sizeof(float), 3, stream);
-							fwrite(&remappedVertices[i].UV, sizeof(float), 2, stream);
-						}
-
-						// save surfaces indices count
-
-						unsigned int indicescount = (unsigned int)remappedIndices.size();
-						
-						fwrite(&indicescount, sizeof(unsigned int), 1, stream);
-
-						// save surfaces indices
-						
-						fwrite(&remappedIndices[0], sizeof(unsigned int), indicescount, stream);
-
-						// save metrics
-				
-						fwrite(&boundingboxmin, sizeof(float), 3, stream);
-						fwrite(&boundingboxmax, sizeof(float), 3, stream);
-						fwrite(&radius, sizeof(float), 1, stream);
-					
-						std::cout << "Bmin : " << boundingboxmin.x << " " << boundingboxmin.y << " " << boundingboxmin.z << std::endl;
-						std::cout << "Bmax : " << boundingboxmax.x << " " << boundingboxmax.y << " " << boundingboxmax.z << std::endl;
-						std::cout << "Radius : " << radius << std::endl;
-
-						// Close stream if it is not NULL 
-					
-						if (fclose(stream) != 0)
-						{
-							ImportError = "Fatal : couldn't save " + fullpathfilename;
-							return false;
-						}
+						ImportError = job.Error;
+						return false;
 					}
-					
 				}
-				
+
 				return true;
 			}
 			
@@ -371,6 +604,10 @@ namespace vml
 			TinyObjImporter()
 			{
 				ImportError = "Ok";
+				Optimize	= true;
+				LodLevels	= 3;
+				LodRatio	= 0.5f;
+				LodError	= 0.05f;
 			}
 
 			~TinyObjImporter()
@@ -35,6 +35,9 @@ namespace vml
 				vml::geo3d::AABBox			BoundingBox;			// bounding box
 				float	 					Radius;					// radius
 				bool					    RetainData;				// Bitfield used to store preferences flags
+				uint32_t					VertexFormat;			// vertex buffers layout
+				glm::mat4					PositionMatrix;			// maps quantized positions to object space
+				size_t						VertexBufferSize;		// vertex buffers size in bytes
 				GLuint						VAOid;					// vertex array object id
 				GLuint						IndexBufferObject;		// surface index buffer object
 				GLuint						BufferObjects[8];		// buffer objects
@@ -43,6 +46,129 @@ namespace vml
 				std::vector<float>			UVArray;				// uv array
 				std::vector<unsigned int>	SurfaceIndices;			// surface indices array
 
+				// ---------------------------------------------------------------
+				// compact interleaved vertex, 16 bytes per vertex, positions are
+				// 16 bits normalized within the mesh bounds, normals are octahedral
+				// encoded, uvs are half floats
+
+				struct CompactVertex
+				{
+					uint16_t Position[4];			// normalized position, w is 1
+					int16_t	 Normal[2];				// octahedral normal
+					uint16_t UV[2];					// half float uvs
+				};
+
+				// ---------------------------------------------------------------
+				// aligned mesh file layout, the header is followed by the vertex,
+				// normal, uv and index arrays, each section starts at a 16 bytes
+				// aligned offset so it can be uploaded straight from the mapped
+				// file, legacy files have no header and start with the vertex count
+
+				struct FileHeader
+				{
+					char	 Magic[4];				// 'V3DF'
+					uint32_t Version;				// file format version
+					uint32_t VerticesCount;			// vertices count
+					uint32_t IndicesCount;			// surface indices count
+					float	 Min[3];				// bounding box
+					float	 Max[3];
+					float	 Radius;				// bounding sphere radius
+					uint32_t Flags;					// vertex format flags, 0 for float arrays
+					uint64_t VerticesOffset;		// vertex positions offset, 4 floats per vertex
+					uint64_t NormalsOffset;			// vertex normals offset, 3 floats per vertex
+					uint64_t UVsOffset;				// vertex uvs offset, 2 floats per vertex
+					uint64_t IndicesOffset;			// surface indices offset
+				};
+
+				static const uint32_t FILE_VERSION	 = 2;
+				static const uint64_t FILE_ALIGNMENT = 16;
+
+				// ---------------------------------------------------------------
+				// deferred loading state, the aligned file stays mapped and the
+				// compact vertices are encoded ahead until the vbos are created
+
+				vml::os::FileView			SourceFile;				// mapped aligned file or archive entry
+				std::vector<CompactVertex>	CompactVertices;		// compact vertices encoded ahead
+
+				// ---------------------------------------------------------------
+				// encodes a unit normal on the octahedron, the lower hemisphere
+				// is folded over the diagonals, see the phong shaders for decoding
+
+				static void EncodeOctahedral(float x, float y, float z, int16_t* out)
+				{
+					float l = fabs(x) + fabs(y) + fabs(z);
+
+					if (l < vml::math::EPSILON)
+					{
+						out[0] = 0;
+						out[1] = 0;
+						return;
+					}
+
+					x /= l;
+					y /= l;
+
+					if (z < 0.0f)
+					{
+						float ox = (1.0f - fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+						float oy = (1.0f - fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+						x = ox;
+						y = oy;
+					}
+
+					out[0] = (int16_t)roundf(glm::clamp(x, -1.0f, 1.0f) * 32767.0f);
+					out[1] = (int16_t)roundf(glm::clamp(y, -1.0f, 1.0f) * 32767.0f);
+				}
+
+				// ---------------------------------------------------------------
+				// builds compact vertices, positions are quantized within the
+				// bounds of the vertex data, the position matrix maps them back
+
+				void CreateCompactVertices(const float* vertices, const float* normals, const float* uvs, std::vector<CompactVertex>& compact)
+				{
+					glm::vec3 bmin( FLT_MAX,  FLT_MAX,  FLT_MAX);
+					glm::vec3 bmax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+					for (size_t i = 0; i < Vertices; ++i)
+					{
+						glm::vec3 p(vertices[i * 4], vertices[i * 4 + 1], vertices[i * 4 + 2]);
+						bmin = glm::min(bmin, p);
+						bmax = glm::max(bmax, p);
+					}
+
+					glm::vec3 extent = bmax - bmin;
+					glm::vec3 scale(extent.x > 0.0f ? 65535.0f / extent.x : 0.0f,
+									extent.y > 0.0f ? 65535.0f / extent.y : 0.0f,
+									extent.z > 0.0f ? 65535.0f / extent.z : 0.0f);
+
+					compact.resize(Vertices);
+
+					for (size_t i = 0; i < Vertices; ++i)
+					{
+						CompactVertex& v = compact[i];
+
+						v.Position[0] = (uint16_t)roundf(glm::clamp((vertices[i * 4	   ] - bmin.x) * scale.x, 0.0f, 65535.0f));
+						v.Position[1] = (uint16_t)roundf(glm::clamp((vertices[i * 4 + 1] - bmin.y) * scale.y, 0.0f, 65535.0f));
+						v.Position[2] = (uint16_t)roundf(glm::clamp((vertices[i * 4 + 2] - bmin.z) * scale.z, 0.0f, 65535.0f));
+						v.Position[3] = 65535;
+
+						EncodeOctahedral(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2], v.Normal);
+
+						v.UV[0] = glm::packHalf1x16(uvs[i * 2	 ]);
+						v.UV[1] = glm::packHalf1x16(uvs[i * 2 + 1]);
+					}
+
+					PositionMatrix = glm::scale(glm::translate(glm::mat4(1.0f), bmin), extent);
+				}
+
+				// ---------------------------------------------------------------
+				// aligns a file offset to the section alignment
+
+				static uint64_t AlignFileOffset(uint64_t offset)
+				{
+					return (offset + FILE_ALIGNMENT - 1) & ~(FILE_ALIGNMENT - 1);
+				}
+
 				// ---------------------------------------------------------------
 				// Memory clearing :
 				// Resets all data to initial values (0) and
@@ -58,6 +184,8 @@ namespace vml
 					Indices     = 0;
 					Radius      = 0;
 					BoundingBox = vml::geo3d::AABBox(glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
+					PositionMatrix   = glm::mat4(1.0f);
+					VertexBufferSize = 0;
 
 					// delete buffers
 
@@ -65,6 +193,10 @@ namespace vml
 					NormalArray.clear();
 					UVArray.clear();
 					SurfaceIndices.clear();
+					CompactVertices.clear();
+
+					if (SourceFile.IsOpen())
+						SourceFile.Close();
 
 					// delete vbo
 
@@ -82,9 +214,10 @@ namespace vml
 				}
 				
 				// ---------------------------------------------------------------
-				// vbo creation
+				// vbo creation, data is read from the given arrays which
+				// may point into a mapped file
 
-				void CreateVBO()
+				void CreateVBO(const float* vertices, const float* normals, const float* uvs, const unsigned int* indices)
 				{
 					// Create the vertex array object for the mesh.
 					//
@@ -112,31 +245,60 @@ namespace vml
 					glGenVertexArrays(1, &VAOid);
 					glBindVertexArray(VAOid);
 										
-					// Create the Vertex Buffer Object 
-
-					glGenBuffers(1, &BufferObjects[0]);
-					glBindBuffer(GL_ARRAY_BUFFER, BufferObjects[0]);
-					glBufferData(GL_ARRAY_BUFFER, (VertexArray.size()) * sizeof(float), &VertexArray[0], GL_STATIC_DRAW);
-					glEnableVertexAttribArray(AttributePosition);
-					glVertexAttribPointer(AttributePosition, 4, GL_FLOAT, GL_FALSE, 0, 0);
-
-					glGenBuffers(1, &BufferObjects[1]);
-					glBindBuffer(GL_ARRAY_BUFFER, BufferObjects[1]);
-					glBufferData(GL_ARRAY_BUFFER, (NormalArray.size()) * sizeof(float), &NormalArray[0], GL_STATIC_DRAW);
-					glEnableVertexAttribArray(AttributeNormal);
-					glVertexAttribPointer(AttributeNormal, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-					glGenBuffers(1, &BufferObjects[2]);
-					glBindBuffer(GL_ARRAY_BUFFER, BufferObjects[2]);
-					glBufferData(GL_ARRAY_BUFFER, (UVArray.size()) * sizeof(float), &UVArray[0], GL_STATIC_DRAW);
-					glEnableVertexAttribArray(AttributeTexCoord);
-					glVertexAttribPointer(AttributeTexCoord, 2, GL_FLOAT, GL_FALSE, 0, 0);
+					if (VertexFormat == COMPACT_VERTICES)
+					{
+						// Create a single interleaved Vertex Buffer Object, attributes
+						// are expanded to floats by the vertex fetch, normals are
+						// decoded in the shader, vertices might have been
+						// encoded ahead on a loading thread
+
+						if (CompactVertices.empty())
+							CreateCompactVertices(vertices, normals, uvs, CompactVertices);
+
+						VertexBufferSize = CompactVertices.size() * sizeof(CompactVertex);
+
+						glGenBuffers(1, &BufferObjects[0]);
+						glBindBuffer(GL_ARRAY_BUFFER, BufferObjects[0]);
+						glBufferData(GL_ARRAY_BUFFER, VertexBufferSize, CompactVertices.data(), GL_STATIC_DRAW);
+
+						std::vector<CompactVertex>().swap(CompactVertices);
+						glEnableVertexAttribArray(AttributePosition);
+						glVertexAttribPointer(AttributePosition, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, Position));
+						glEnableVertexAttribArray(AttributeNormal);
+						glVertexAttribPointer(AttributeNormal, 2, GL_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, Normal));
+						glEnableVertexAttribArray(AttributeTexCoord);
+						glVertexAttribPointer(AttributeTexCoord, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, UV));
+					}
+					else
+					{
+						// Create the Vertex Buffer Object 
+
+						glGenBuffers(1, &BufferObjects[0]);
+						glBindBuffer(GL_ARRAY_BUFFER, BufferObjects[0]);
+						glBufferData(GL_ARRAY_BUFFER, (size_t)Vertices * 4 * sizeof(float), vertices, GL_STATIC_DRAW);
+						glEnableVertexAttribArray(AttributePosition);
+						glVertexAttribPointer(AttributePosition, 4, GL_FLOAT, GL_FALSE, 0, 0);
+
+						glGenBuffers(1, &BufferObjects[1]);
+						glBindBuffer(GL_ARRAY_BUFFER, BufferObjects[1]);
+						glBufferData(GL_ARRAY_BUFFER, (size_t)Vertices * 3 * sizeof(float), normals, GL_STATIC_DRAW);
+						glEnableVertexAttribArray(AttributeNormal);
+						glVertexAttribPointer(AttributeNormal, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+						glGenBuffers(1, &BufferObjects[2]);
+						glBindBuffer(GL_ARRAY_BUFFER, BufferObjects[2]);
+						glBufferData(GL_ARRAY_BUFFER, (size_t)Vertices * 2 * sizeof(float), uvs, GL_STATIC_DRAW);
+						glEnableVertexAttribArray(AttributeTexCoord);
+						glVertexAttribPointer(AttributeTexCoord, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+						VertexBufferSize = (size_t)Vertices * 9 * sizeof(float);
+					}
 
 					// Create the Index Buffer Object
 
 					glGenBuffers(1, &IndexBufferObject);
 					glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IndexBufferObject);
-					glBufferData(GL_ELEMENT_ARRAY_BUFFER, (SurfaceIndices.size()) * sizeof(unsigned int), &SurfaceIndices[0], GL_STATIC_DRAW);
+					glBufferData(GL_ELEMENT_ARRAY_BUFFER, (size_t)Indices * sizeof(unsigned int), indices, GL_STATIC_DRAW);
 
 					// unbinds buffers
 
@@ -166,142 +328,291 @@ namespace vml
 				}
 
 				// ---------------------------------------------------------------
-				// load mesh , path is embedded into filename ,no args needed
+				// reads a legacy mesh file, vertices are stored interleaved as
+				// position, normal and uv and are deinterleaved into the given
+				// arrays, positions are expanded to 4 floats, returns the fopen
+				// error code
+
+				static errno_t ReadLegacyFile(const std::string& filename,
+											  std::vector<float>& vertexarray,
+											  std::vector<float>& normalarray,
+											  std::vector<float>& uvarray,
+											  std::vector<unsigned int>& surfaceindices,
+											  glm::vec3& bmin, glm::vec3& bmax, float& radius)
+				{
+					FILE* stream;
 
-				bool Load(const std::string& resourcefilename)
+					errno_t err = fopen_s(&stream, filename.c_str(), "rb");
+
+					if (err != 0)
+						return err;
+
+					unsigned int vertices = 0;
+					unsigned int indices  = 0;
+
+					// read number of vertices
+
+					fread(&vertices, sizeof(unsigned int), 1, stream);
+
+					vertexarray.resize((size_t)vertices * 4);
+					normalarray.resize((size_t)vertices * 3);
+					uvarray.resize((size_t)vertices * 2);
+
+					// read data
+
+					for (size_t i = 0; i < vertices; i++)
+					{
+						float p[3];
+						float n[3];
+						float t[2];
+
+						// _Post_ _Notnull_ suppress warning c6387
+
+						fread(&p, sizeof(float), 3, stream);
+						fread(&n, sizeof(float), 3, stream);
+						fread(&t, sizeof(float), 2, stream);
+
+						size_t offset;
+
+						offset = i * 4;
+
+						vertexarray[offset    ] = p[0];
+						vertexarray[offset + 1] = p[1];
+						vertexarray[offset + 2] = p[2];
+						vertexarray[offset + 3] = 1.0f;
+
+						offset = i * 3;
+
+						normalarray[offset    ] = n[0];
+						normalarray[offset + 1] = n[1];
+						normalarray[offset + 2] = n[2];
+
+						offset = i * 2;
+
+						uvarray[offset    ] = t[0];
+						uvarray[offset + 1] = t[1];
+					}
+
+					// read surface indices for vbo indexing
+					// _Post_ _Notnull_ suppress warning c6387
+
+					fread(&indices, sizeof(unsigned int), 1, stream);
+
+					surfaceindices.resize(indices);
+
+					fread(surfaceindices.data(), sizeof(unsigned int), indices, stream);
+
+					// read metrics
+
+					fread(&bmin, sizeof(float), 3, stream);
+					fread(&bmax, sizeof(float), 3, stream);
+					fread(&radius, sizeof(float), 1, stream);
+
+					// close stream
+
+					if (fclose(stream) != 0)
+						vml::os::Message::Error("Mesh3d : ", "Cannot close ' ", filename.c_str(), " '");
+
+					return 0;
+				}
+
+				// ---------------------------------------------------------------
+				// validates an aligned mesh file and returns its header, arrays
+				// are returned as pointers into the mapped file, returns nullptr
+				// if the file is a legacy file
+
+				static const FileHeader* GetMappedArrays(const vml::os::FileView& file,
+														 const float*& vertices,
+														 const float*& normals,
+														 const float*& uvs,
+														 const unsigned int*& indices)
+				{
+					const FileHeader* header = (const FileHeader*)file.GetDataAt(0, sizeof(FileHeader));
+
+					if (!header || memcmp(header->Magic, "V3DF", 4) != 0)
+						return nullptr;
+
+					if (header->Version != FILE_VERSION || header->Flags != 0)
+						vml::os::Message::Error("Mesh3d : ", "Unsupported mesh file version ' ", file.GetFileName().c_str(), " '");
+
+					size_t count = header->VerticesCount;
+
+					vertices = (const float*)file.GetDataAt((size_t)header->VerticesOffset, count * 4 * sizeof(float));
+					normals  = (const float*)file.GetDataAt((size_t)header->NormalsOffset, count * 3 * sizeof(float));
+					uvs		 = (const float*)file.GetDataAt((size_t)header->UVsOffset, count * 2 * sizeof(float));
+					indices  = (const unsigned int*)file.GetDataAt((size_t)header->IndicesOffset, (size_t)header->IndicesCount * sizeof(unsigned int));
+
+					if (!vertices || !normals || !uvs || !indices)
+						vml::os::Message::Error("Mesh3d : ", "Corrupted mesh file ' ", file.GetFileName().c_str(), " '");
+
+					return header;
+				}
+
+				// ---------------------------------------------------------------
+				// reads mesh , path is embedded into filename, aligned files are
+				// kept mapped so that the vbos can be uploaded straight from the
+				// mapped pages or from a mounted archive, data is copied only if the mesh retains it, legacy
+				// files are parsed vertex by vertex, no opengl calls are made here
+				// so this can run on a loading thread
+
+				bool Read(const std::string& resourcefilename)
 				{
 					// validate extension
 
 					if ( !resourcefilename.ends_with(".3df"))
 						vml::os::Message::Error("Mesh3d : ","Wrong extension ' ", resourcefilename.c_str()," '");
 
-					//	std::cout << "loading : " << resourcefilename << std::endl;
-				
-					FILE* stream;
+					// clears everything before loading
 
-					// models are loaded according to the model's path
+					ReleaseAll();
 
-					errno_t err = fopen_s(&stream, resourcefilename.c_str(), "rb");
+					// aligned file
 
-					if (err == 0)
+					if (SourceFile.Open(resourcefilename))
 					{
-						unsigned int vertices;
-						unsigned int indices;
-						float radius;
-						float bmin[3];
-						float bmax[3];
+						const float*		vertices;
+						const float*		normals;
+						const float*		uvs;
+						const unsigned int* indices;
 
-						// clears everything before loading
+						const FileHeader* header = GetMappedArrays(SourceFile, vertices, normals, uvs, indices);
 
-						ReleaseAll();
+						if (header)
+						{
+							Vertices = header->VerticesCount;
+							Indices	 = header->IndicesCount;
+							Surfaces = Indices / 3;
 
-						// read number of vertices
+							BoundingBox.Set(glm::vec3(header->Min[0], header->Min[1], header->Min[2]), glm::vec3(header->Max[0], header->Max[1], header->Max[2]));
+							Radius = header->Radius;
 
-						fread(&vertices, sizeof(unsigned int), 1, stream);
+							if (RetainData != DO_NOT_RETAIN_DATA)
+							{
+								VertexArray.assign(vertices, vertices + (size_t)Vertices * 4);
+								NormalArray.assign(normals, normals + (size_t)Vertices * 3);
+								UVArray.assign(uvs, uvs + (size_t)Vertices * 2);
+								SurfaceIndices.assign(indices, indices + Indices);
 
-						//	std::cout << "Vertices : " << vertices << std::endl;
-						
-						VertexArray.resize((size_t)vertices * 4);
-						NormalArray.resize((size_t)vertices * 3);
-						UVArray.resize((size_t)vertices * 2);
-						
-						// read data
-						
-						for (size_t i = 0; i < vertices; i++)
-						{
-	
-							float p[3];
-							float n[3];
-							float t[2];
+								SourceFile.Close();
+							}
 
-							// _Post_ _Notnull_ suppress warning c6387
+							return true;
+						}
 
-							fread(&p, sizeof(float), 3, stream);
-							fread(&n, sizeof(float), 3, stream);
-							fread(&t, sizeof(float), 2, stream);
+						// legacy files are parsed from disk only
 
-							size_t offset;
+						if (SourceFile.IsArchived())
+							vml::os::Message::Error("Mesh3d : ", "Legacy mesh file ' ", resourcefilename.c_str(), " ' can't be read from an archive, convert it first");
 
-							offset = i * 4;
+						SourceFile.Close();
+					}
 
-							VertexArray[offset    ] = p[0];
-							VertexArray[offset + 1] = p[1];
-							VertexArray[offset + 2] = p[2];
-							VertexArray[offset + 3] = 1.0f;
+					// legacy file
 
-							//	std::cout << i << " : " << p[0] << " " << p[1] << " " << p[2] << std::endl;
-							offset = i * 3;
+					glm::vec3 bmin;
+					glm::vec3 bmax;
+					float radius;
 
-							NormalArray[offset    ] = n[0];
-							NormalArray[offset + 1] = n[1];
-							NormalArray[offset + 2] = n[2];
+					errno_t err = ReadLegacyFile(resourcefilename, VertexArray, NormalArray, UVArray, SurfaceIndices, bmin, bmax, radius);
 
-							offset = i * 2;
+					if (err != 0)
+						vml::os::Message::Error("Mesh3d : ", "Cannot load mesh ' ", resourcefilename.c_str(), " '"," ( error code : ", err," )");
 
-							UVArray[offset    ] = t[0];
-							UVArray[offset + 1] = t[1];
-	
-							//	std::cout << i << " : " << t[0] << " " << t[1] << std::endl;
+					Vertices = (unsigned int)NormalArray.size() / 3;
+					Indices	 = (unsigned int)SurfaceIndices.size();
+					Surfaces = Indices / 3;
 
-							// increase vertex counter
-						
-							Vertices++;
-						}
-						
-						// read surface indices for vbo indexing
-						// _Post_ _Notnull_ suppress warning c6387
+					// fill metrics data
 
-						fread(&indices, sizeof(unsigned int), 1, stream);
+					BoundingBox.Set(bmin, bmax);
+					Radius = radius;
 
-						Indices = indices;
+					// once the data is uploaded into the gpu , it should be rleased
+					// see the meshsotre class, here we *DO NOT* release the data
+					// since the data itslef might be needed for further computation
+					// see the meshsotre clss where the data is explicilty releasde
 
-						//	std::cout << "Indices : " << indices << std::endl;
-						
-						Surfaces = Indices / 3;
+					return true;
+				}
 
-						// read surfaces
+				// ---------------------------------------------------------------
+				// creates vbos from the data read, either from the mapped file
+				// or from the vertex arrays, the mapped file is closed afterwards
 
-						SurfaceIndices.resize(indices);
-						
-						fread(&SurfaceIndices[0], sizeof(unsigned int), Indices, stream);
-						
-						// read metrics
+				void Upload()
+				{
+					if (SourceFile.IsOpen())
+					{
+						const float*		vertices;
+						const float*		normals;
+						const float*		uvs;
+						const unsigned int* indices;
 
-						fread(&bmin, sizeof(float), 3, stream);
-						fread(&bmax, sizeof(float), 3, stream);
-						fread(&radius, sizeof(float), 1, stream);
+						GetMappedArrays(SourceFile, vertices, normals, uvs, indices);
 
-						//	std::cout << "Bmin : " << bmin[0] << " " << bmin[1] << " " << bmin[2] << std::endl;
-						//	std::cout << "Bmax : " << bmax[0] << " " << bmax[1] << " " << bmax[2] << std::endl;
-						//	std::cout << "Radius : " << radius << std::endl;
+						CreateVBO(vertices, normals, uvs, indices);
 
-						// fill metrics data
+						SourceFile.Close();
+					}
+					else
+					{
+						CreateVBO(VertexArray.data(), NormalArray.data(), UVArray.data(), SurfaceIndices.data());
+					}
+				}
 
-						BoundingBox.Set(glm::vec3(bmin[0], bmin[1], bmin[2]), glm::vec3(bmax[0], bmax[1], bmax[2]));
-						Radius = radius;
-						
-						// create vbos
+				// ---------------------------------------------------------------
+				// load mesh , reads data and creates vbos
+
+				bool Load(const std::string& resourcefilename)
+				{
+					if (!Read(resourcefilename))
+						return false;
 
-						CreateVBO();
+					Upload();
 
-						// once the data is uploaded into the gpu , it should be rleased
-						// see the meshsotre class, here we *DO NOT* release the data
-						// since the data itslef might be needed for further computation
-						// see the meshsotre clss where the data is explicilty releasde
-										
-						// close stream
+					return true;
+				}
 
-						if (fclose(stream) != 0)
-							vml::os::Message::Error("Mesh3d : ","Cannot close ' ", resourcefilename.c_str()," '");
-						
-						return true;
-					}
-					else
+				// ---------------------------------------------------------------
+				// sets default values and mesh parameters
+				// follow this *strict* order , since each 
+				// entry is correlated to the mesh parm(s)
+				// parms[0] contains the flag to erase vertex data
+				// once the vbo is created
+				// parms[1] contains the vertex buffers layout
+
+				void SetParms(const uint32_t* parms, size_t count)
+				{
+					Surfaces           = 0;
+					Vertices           = 0;
+					Indices            = 0;
+					Radius             = 0;
+					BoundingBox		   = vml::geo3d::AABBox(glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
+					VAOid              = 0;
+					IndexBufferObject  = 0;
+					BufferObjects[0]   = 0;
+					BufferObjects[1]   = 0;
+					BufferObjects[2]   = 0;
+					BufferObjects[3]   = 0;
+					BufferObjects[4]   = 0;
+					BufferObjects[5]   = 0;
+					BufferObjects[6]   = 0;
+					BufferObjects[7]   = 0;
+					RetainData		   = DO_NOT_RETAIN_DATA;
+					VertexFormat	   = FLOAT_VERTICES;
+					PositionMatrix	   = glm::mat4(1.0f);
+					VertexBufferSize   = 0;
+
+					if (count != 0)
 					{
-						vml::os::Message::Error("Mesh3d : ", "Cannot load mesh ' ", resourcefilename.c_str(), " '"," ( error code : ", err," )");
+						RetainData = parms[0];	// first flag is for data release
+						
+						if (count > 1)
+							VertexFormat = parms[1];	// second flag is for vertex format
+
+						// Eventually other flags must be assigned here						 
+						
 					}
-					
-					return false;
 				}
 				
 		public:
@@ -312,6 +623,20 @@ namespace vml
 				static constexpr uint32_t DO_NOT_RETAIN_DATA = 0;
 				static constexpr uint32_t RETAIN_DATA	     = 1;
 
+				// ---------------------------------------------------------------
+				// vertex buffers layout, float vertices use a buffer per attribute,
+				// compact vertices use a single interleaved buffer, see CompactVertex
+
+				static constexpr uint32_t FLOAT_VERTICES   = 0;
+				static constexpr uint32_t COMPACT_VERTICES = 1;
+
+				// ---------------------------------------------------------------
+				// level of detail chain, simplified versions of a mesh are stored
+				// alongside it as 'name_lod1.3df', 'name_lod2.3df' and so on,
+				// level 0 being the mesh itself
+
+				static constexpr size_t MAX_LOD_LEVELS = 4;
+
 				// ---------------------------------------------------------------
 				//	query functions
 
@@ -324,6 +649,9 @@ namespace vml
 				GLuint						     GetVAOId()			 const { return VAOid; }							// get mesh vao id
 				bool							 IsValid()			 const { return Vertices> 0 && Surfaces> 0; }		// returns if data is valid
 				bool							 IsDataRetained()	 const { return RetainData; }
+				uint32_t						 GetVertexFormat()	 const { return VertexFormat; }						// get vertex buffers layout
+				const glm::mat4					&GetPositionMatrix() const { return PositionMatrix; }					// maps vertex buffer positions to object space
+				size_t							 GetVertexBufferSize() const { return VertexBufferSize; }				// get vertex buffers size in bytes
 				const vml::geo3d::AABBox		&GetBoundingBox()	 const { return BoundingBox; }
 				const std::vector<float>		&GetVertexArray()	 const { return VertexArray; }
 				const std::vector<float>		&GetNormalArray()	 const { return NormalArray; }
@@ -348,6 +676,17 @@ namespace vml
 					return glm::ivec3(SurfaceIndices[index], SurfaceIndices[index + 1], SurfaceIndices[index + 2]);
 				}
 
+				// ---------------------------------------------------------------
+				// gets bytes held by the mesh, vertex and index buffers plus
+				// any retained data
+
+				size_t GetMemorySize() const override
+				{
+					return VertexBufferSize + (size_t)Indices * sizeof(unsigned int) +
+						   (VertexArray.size() + NormalArray.size() + UVArray.size()) * sizeof(float) +
+						   SurfaceIndices.size() * sizeof(unsigned int);
+				}
+
 				// ---------------------------------------------------------------
 				// this function clear the data buffer once the VAO are created
 				// since we might need to preserve the data in some cases 
@@ -373,7 +712,250 @@ namespace vml
 					Surfaces   = 0;
 					Indices	   = 0;
 				}
-				
+
+				// ---------------------------------------------------------------
+				// gets the file name of a level of detail, level 0 is the mesh itself
+
+				static std::string GetLodFileName(const std::string& filename, size_t level)
+				{
+					if (level == 0)
+						return filename;
+
+					size_t dot = filename.find_last_of('.');
+					size_t sep = filename.find_last_of("/\\");
+
+					if (dot == std::string::npos || (sep != std::string::npos && dot < sep))
+						return filename + "_lod" + std::to_string(level);
+
+					return filename.substr(0, dot) + "_lod" + std::to_string(level) + filename.substr(dot);
+				}
+
+				// ---------------------------------------------------------------
+				// saves a mesh in the aligned file format, vertices have 4 floats
+				// per vertex, normals 3 and uvs 2, same as the mesh arrays
+
+				static bool Save(const std::string& filename,
+								 const std::vector<float>& vertexarray,
+								 const std::vector<float>& normalarray,
+								 const std::vector<float>& uvarray,
+								 const std::vector<unsigned int>& surfaceindices,
+								 const glm::vec3& bmin, const glm::vec3& bmax, float radius)
+				{
+					size_t vertices = normalarray.size() / 3;
+
+					if (vertexarray.size() != vertices * 4 || normalarray.size() != vertices * 3 || uvarray.size() != vertices * 2)
+						vml::os::Message::Error("Mesh3d : ", "Mismatching array sizes saving ' ", filename.c_str(), " '");
+
+					// build header
+
+					FileHeader header;
+
+					memset(&header, 0, sizeof(FileHeader));
+					memcpy(header.Magic, "V3DF", 4);
+
+					header.Version		  = FILE_VERSION;
+					header.VerticesCount  = (uint32_t)vertices;
+					header.IndicesCount	  = (uint32_t)surfaceindices.size();
+					header.Min[0]		  = bmin.x;
+					header.Min[1]		  = bmin.y;
+					header.Min[2]		  = bmin.z;
+					header.Max[0]		  = bmax.x;
+					header.Max[1]		  = bmax.y;
+					header.Max[2]		  = bmax.z;
+					header.Radius		  = radius;
+					header.VerticesOffset = AlignFileOffset(sizeof(FileHeader));
+					header.NormalsOffset  = AlignFileOffset(header.VerticesOffset + vertexarray.size() * sizeof(float));
+					header.UVsOffset	  = AlignFileOffset(header.NormalsOffset + normalarray.size() * sizeof(float));
+					header.IndicesOffset  = AlignFileOffset(header.UVsOffset + uvarray.size() * sizeof(float));
+
+					// compose the file image, padding is left zeroed, so the
+					// whole file goes to disk with a single write
+
+					size_t filesize = (size_t)header.IndicesOffset + surfaceindices.size() * sizeof(unsigned int);
+
+					std::vector<unsigned char> image(filesize, 0);
+
+					memcpy(image.data(), &header, sizeof(FileHeader));
+					memcpy(image.data() + header.VerticesOffset, vertexarray.data(), vertexarray.size() * sizeof(float));
+					memcpy(image.data() + header.NormalsOffset, normalarray.data(), normalarray.size() * sizeof(float));
+					memcpy(image.data() + header.UVsOffset, uvarray.data(), uvarray.size() * sizeof(float));
+					memcpy(image.data() + header.IndicesOffset, surfaceindices.data(), surfaceindices.size() * sizeof(unsigned int));
+
+					// write file
+
+					FILE* stream;
+
+					errno_t err = fopen_s(&stream, filename.c_str(), "wb");
+
+					if (err != 0)
+					{
+						vml::utils::Logger::GetInstance()->Info("Mesh : Cannot write '" + filename + "'");
+						return false;
+					}
+
+					size_t written = fwrite(image.data(), 1, image.size(), stream);
+
+					if (fclose(stream) != 0)
+						vml::os::Message::Error("Mesh3d : ", "Cannot close ' ", filename.c_str(), " '");
+
+					if (written != image.size())
+					{
+						vml::utils::Logger::GetInstance()->Info("Mesh : Cannot write '" + filename + "'");
+						return false;
+					}
+
+					return true;
+				}
+
+				// ---------------------------------------------------------------
+				// converts a mesh file to the aligned file format, source
+				// can be either a legacy or an aligned file
+
+				static bool Convert(const std::string& sourcefilename, const std::string& filename)
+				{
+					std::vector<float>		  vertexarray;
+					std::vector<float>		  normalarray;
+					std::vector<float>		  uvarray;
+					std::vector<unsigned int> surfaceindices;
+					glm::vec3				  bmin;
+					glm::vec3				  bmax;
+					float					  radius;
+
+					{
+						vml::os::FileView file;
+
+						const float*		vertices;
+						const float*		normals;
+						const float*		uvs;
+						const unsigned int* indices;
+
+						const FileHeader* header = file.Open(sourcefilename) ? GetMappedArrays(file, vertices, normals, uvs, indices) : nullptr;
+
+						if (header)
+						{
+							vertexarray.assign(vertices, vertices + (size_t)header->VerticesCount * 4);
+							normalarray.assign(normals, normals + (size_t)header->VerticesCount * 3);
+							uvarray.assign(uvs, uvs + (size_t)header->VerticesCount * 2);
+							surfaceindices.assign(indices, indices + header->IndicesCount);
+							bmin   = glm::vec3(header->Min[0], header->Min[1], header->Min[2]);
+							bmax   = glm::vec3(header->Max[0], header->Max[1], header->Max[2]);
+							radius = header->Radius;
+						}
+						else
+						{
+							file.Close();
+
+							if (ReadLegacyFile(sourcefilename, vertexarray, normalarray, uvarray, surfaceindices, bmin, bmax, radius) != 0)
+							{
+								vml::utils::Logger::GetInstance()->Info("Mesh : Cannot read '" + sourcefilename + "'");
+								return false;
+							}
+						}
+					}
+
+					return Save(filename, vertexarray, normalarray, uvarray, surfaceindices, bmin, bmax, radius);
+				}
+
+				// ---------------------------------------------------------------
+				// compares loading times of legacy and aligned files, each
+				// legacy file is converted to a temporary aligned file, timings
+				// cover reading the file into arrays ready for the gpu upload,
+				// for aligned files this is mapping the file and copying the
+				// mapped pages, which is what the upload does, files which are
+				// already aligned have no legacy timing and are skipped
+
+				static void Benchmark(const std::vector<std::string>& filenames, int iterations = 10)
+				{
+					for (const std::string& filename : filenames)
+					{
+						{
+							vml::os::FileView file;
+
+							const char* magic = file.Open(filename) ? (const char*)file.GetDataAt(0, 4) : nullptr;
+
+							if (magic && memcmp(magic, "V3DF", 4) == 0)
+							{
+								vml::utils::Logger::GetInstance()->Info("Mesh : Benchmark : " + filename + " : already aligned, skipped");
+								continue;
+							}
+						}
+
+						std::string alignedfilename = (std::filesystem::temp_directory_path() / (std::filesystem::path(filename).stem().string() + "_aligned.3df")).string();
+
+						if (!Convert(filename, alignedfilename))
+							continue;
+
+						std::vector<float>		   vertexarray;
+						std::vector<float>		   normalarray;
+						std::vector<float>		   uvarray;
+						std::vector<unsigned int>  surfaceindices;
+						std::vector<unsigned char> staging;
+						glm::vec3				   bmin;
+						glm::vec3				   bmax;
+						float					   radius;
+						bool					   match = true;
+
+						// legacy loading
+
+						vml::os::Timer timer;
+
+						timer.Init();
+
+						for (int i = 0; i < iterations; ++i)
+							ReadLegacyFile(filename, vertexarray, normalarray, uvarray, surfaceindices, bmin, bmax, radius);
+
+						float legacytime = timer.GetElapsedTime() * 1000.0f / iterations;
+
+						// aligned loading
+
+						timer.Init();
+
+						for (int i = 0; i < iterations; ++i)
+						{
+							vml::os::FileView file;
+
+							const float*		vertices;
+							const float*		normals;
+							const float*		uvs;
+							const unsigned int* indices;
+
+							const FileHeader* header = file.Open(alignedfilename) ? GetMappedArrays(file, vertices, normals, uvs, indices) : nullptr;
+
+							if (!header)
+							{
+								match = false;
+								break;
+							}
+
+							size_t vertexbytes = (size_t)header->VerticesCount * 4 * sizeof(float);
+							size_t normalbytes = (size_t)header->VerticesCount * 3 * sizeof(float);
+							size_t uvbytes	   = (size_t)header->VerticesCount * 2 * sizeof(float);
+							size_t indexbytes  = (size_t)header->IndicesCount * sizeof(unsigned int);
+
+							staging.resize(vertexbytes + normalbytes + uvbytes + indexbytes);
+
+							memcpy(staging.data(), vertices, vertexbytes);
+							memcpy(staging.data() + vertexbytes, normals, normalbytes);
+							memcpy(staging.data() + vertexbytes + normalbytes, uvs, uvbytes);
+							memcpy(staging.data() + vertexbytes + normalbytes + uvbytes, indices, indexbytes);
+
+							if (i == 0)
+								match = memcmp(vertices, vertexarray.data(), vertexbytes) == 0 &&
+										memcmp(normals, normalarray.data(), normalbytes) == 0 &&
+										memcmp(uvs, uvarray.data(), uvbytes) == 0 &&
+										memcmp(indices, surfaceindices.data(), indexbytes) == 0;
+						}
+
+						float alignedtime = timer.GetElapsedTime() * 1000.0f / iterations;
+
+						std::filesystem::remove(alignedfilename);
+
+						vml::utils::Logger::GetInstance()->Info("Mesh : Benchmark : " + filename + " : " + std::to_string(normalarray.size() / 3) + " vertices, " + 
+																"legacy " + std::to_string(legacytime) + " ms, aligned " + std::to_string(alignedtime) + " ms, " + 
+																"speedup " + std::to_string(alignedtime > 0.0f ? legacytime / alignedtime : 0.0f) + (match ? "" : ", data mismatch"));
+					}
+				}
+
 				// ---------------------------------------------------------------
 				// dumps mesh 
 
@@ -456,36 +1038,7 @@ namespace vml
 
 				Mesh3d(const std::string& resourcefilename, const std::initializer_list<uint32_t>& il) : vml::utils::SharedResource(resourcefilename,il)
 				{
-					Surfaces           = 0;
-					Vertices           = 0;
-					Indices            = 0;
-					Radius             = 0;
-					BoundingBox		   = vml::geo3d::AABBox(glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
-					VAOid              = 0;
-					IndexBufferObject  = 0;
-					BufferObjects[0]   = 0;
-					BufferObjects[1]   = 0;
-					BufferObjects[2]   = 0;
-					BufferObjects[3]   = 0;
-					BufferObjects[4]   = 0;
-					BufferObjects[5]   = 0;
-					BufferObjects[6]   = 0;
-					BufferObjects[7]   = 0;
-					RetainData		   = DO_NOT_RETAIN_DATA;
-
-					// Mesh uploading default parameters
-					// follow this *strict* order , since each 
-					// entry is correlated to the mesh parm(s)
-					// ep[0] contains the flag to erase vertex data
-					// once the vbo is created
-				
-					if (il.size() != 0)
-					{
-						RetainData = *(il.begin() + 0);	// first flag is for data release
-						
-						// Eventually other flags must be assigned here						 
-						
-					}
+					SetParms(il.begin(), il.size());
 
 					// cleans everything and uses raii paradigm to load mesh resource
 
@@ -493,6 +1046,44 @@ namespace vml
 
 				}
 
+				// deferred constructor, reads the mesh file and encodes compact
+				// vertices but leaves vbos creation to Finalize, see the store
+				// asynchronous loading
+
+				Mesh3d(const std::string& resourcefilename, const std::vector<uint32_t>& parms, vml::utils::SharedResource::DeferredLoad) : vml::utils::SharedResource(resourcefilename, {})
+				{
+					SetParms(parms.data(), parms.size());
+
+					Read(resourcefilename);
+
+					if (VertexFormat == COMPACT_VERTICES)
+					{
+						if (SourceFile.IsOpen())
+						{
+							const float*		vertices;
+							const float*		normals;
+							const float*		uvs;
+							const unsigned int* indices;
+
+							GetMappedArrays(SourceFile, vertices, normals, uvs, indices);
+
+							CreateCompactVertices(vertices, normals, uvs, CompactVertices);
+						}
+						else
+						{
+							CreateCompactVertices(VertexArray.data(), NormalArray.data(), UVArray.data(), CompactVertices);
+						}
+					}
+				}
+
+				// creates vbos for a mesh built with the deferred constructor,
+				// must be called on the thread owning the opengl context
+
+				void Finalize() override
+				{
+					Upload();
+				}
+
 				// destructor
 
 				~Mesh3d()
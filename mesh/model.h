@@ -30,8 +30,9 @@ namespace vml
 				glm::vec3									OriginalRotation;				// old rotation position , used for deltas
 				glm::vec3									OriginalScaling;				// old scaling position , used for deltas
 				glm::vec3									OriginalPosition;				// old vector position , used for deltas
-				std::vector<vml::meshes::Mesh3d*>			Meshes;							// Mesh pointer
+				std::vector<vml::meshes::Mesh3d*>			Meshes;							// Mesh pointer, level of detail chain, first one is full resolution
 				int											CurrentMesh;					// Currentmesh indx
+				float										LodScreenSize;					// screen height fraction below which the first simplified level is used
 				vml::geo3d::AABBox							AABoundingBox;					// Bounding box
 				vml::geo3d::AOBBox							AOBoundingBox;					// Bounding box
 				float										Radius;							// Radius
@@ -406,6 +407,48 @@ namespace vml
 					normalviewmatrix[7] = -(modelviewmatrix[0] * modelviewmatrix[ 6] - modelviewmatrix[4] * modelviewmatrix[2]) * determinant;
 					normalviewmatrix[8] = +(modelviewmatrix[0] * modelviewmatrix[ 5] - modelviewmatrix[4] * modelviewmatrix[1]) * determinant;
 
+					// pick level of detail
+
+					SelectLod(View);
+				}
+
+				// -------------------------------------------------------------
+				// selects the level of detail from the projected size of the
+				// bounding sphere, as a fraction of the viewport height, each
+				// level is used once the size halves again
+
+				void SelectLod(vml::views::View* View)
+				{
+					CurrentMesh = 0;
+
+					if (Meshes.size() < 2)
+						return;
+
+					const glm::mat4& p = View->GetProjection();
+
+					glm::vec3 center = glm::vec3(View->GetView() * glm::vec4(AABoundingBox.GetCenter(), 1.0f));
+
+					float distance = glm::length(center);
+
+					// camera is inside the bounding sphere
+
+					if (distance <= Radius)
+						return;
+
+					// p[2][3] is -1 for perspective projections and 0 for orthographic ones
+
+					float size = Radius * p[1][1];
+
+					if (p[2][3] != 0.0f)
+						size /= distance;
+
+					float threshold = LodScreenSize;
+
+					while (CurrentMesh + 1 < (int)Meshes.size() && size < threshold)
+					{
+						CurrentMesh++;
+						threshold *= 0.5f;
+					}
 				}
 
 				// -----------------------------------------------------------------------
@@ -423,9 +466,10 @@ namespace vml
 
 					const float* m = glm::value_ptr(M);
 
-					// get's model's mesh bounding box coordinates
+					// get's model's mesh bounding box coordinates, the full
+					// resolution mesh is used, so bounds don't change with lod
 
-					AOBoundingBox.Set(GetCurrentMesh()->GetBoundingBox().GetMin(), GetCurrentMesh()->GetBoundingBox().GetMax(), m);
+					AOBoundingBox.Set(Meshes[0]->GetBoundingBox().GetMin(), Meshes[0]->GetBoundingBox().GetMax(), m);
 
 					// compute axis aligned bounding box
 
@@ -494,6 +538,8 @@ namespace vml
 				vml::meshes::Mesh3d	    *GetCurrentMesh()			 const { return Meshes[CurrentMesh]; }
 				vml::meshes::Mesh3d		*GetMeshAt(const size_t pos) const { return Meshes[pos]; }
 				size_t					 GetMeshesCount()			 const { return Meshes.size(); }
+				int						 GetCurrentLod()			 const { return CurrentMesh; }
+				float					 GetLodScreenSize()			 const { return LodScreenSize; }
 
 				Model3d_2* GetChild(const std::string& childname) const
 				{
@@ -546,6 +592,11 @@ namespace vml
 
 				vml::textures::Texture* GetDiffuseTexture() const { return DiffuseTexture; }
 
+				// --------------------------------------------------------------------------
+				// physics
+
+				JPH::Shapes GetPhysicsShape() const { return PhysicsShape; }
+
 				// ----------------------------------------------------------------------------------------
 				// Setters
 
@@ -559,6 +610,8 @@ namespace vml
 				void SetCullingFlagToOutside()									  { CullingFlags = vml::views::frustum::OUTSIDE; }
 				void SetCullingFlagToIntersected()								  { CullingFlags = vml::views::frustum::INTERSECTED; }
 				void SetCullingFlagToInside()									  { CullingFlags = vml::views::frustum::INSIDE; }
+				void SetLodScreenSize(float size)								  { LodScreenSize = size; }		// 0 always renders the full resolution mesh
+				void SetPhysicsShape(JPH::Shapes shape)							  { PhysicsShape = shape; }		// shape used by ObjectManager_2::CreatePhysicsBodies
 
 				void SetRotationMode(int mode)
 				{
@@ -678,6 +731,7 @@ namespace vml
 					PreferencesFlags  = preferencesflags;
 					CullingFlags	  = 0;
 					CurrentMesh       = 0;
+					LodScreenSize	  = 0.25f;
 					DiffuseTexture	  = nullptr;
 					
 					// set model transform data
@@ -723,6 +777,18 @@ namespace vml
 					// releases vertex data *see mesh class*
 
 					Meshes.emplace_back(vml::stores::MeshStore->Load<vml::meshes::Mesh3d>(filename, {}));
+
+					// uploads the levels of detail written by the importer, if any
+
+					for (size_t level = 1; level < vml::meshes::Mesh3d::MAX_LOD_LEVELS; ++level)
+					{
+						std::string lodfilename = vml::meshes::Mesh3d::GetLodFileName(filename, level);
+
+						if (!vml::os::FileView::Exists(lodfilename))
+							break;
+
+						Meshes.emplace_back(vml::stores::MeshStore->Load<vml::meshes::Mesh3d>(lodfilename, {}));
+					}
 					
 					// init matrices
 
@@ -605,11 +605,21 @@ namespace vml
 				// cull compound bounding box
 
 				void Cull(vml::views::View* view)
+				{
+					SetCullingResult(view, vml::views::frustum::TestAABBox(view->GetFrustumPlanes(),
+																			   AABoundingBox.GetCenter(),
+																			   AABoundingBox.GetHalfExtents()));
+				}
+
+				//------------------------------------------------------------------
+				// sets the compound bounding box culling result, computed either by
+				// Cull or by a batched culling pass over many objects, and
+				// propagates it to component models
+
+				void SetCullingResult(vml::views::View* view, unsigned int result)
 				{
 
-					switch (vml::views::frustum::TestAABBox(view->GetFrustumPlanes(), 
-						                                    AABoundingBox.GetCenter(), 
-						                                    AABoundingBox.GetHalfExtents()))
+					switch (result)
 					{
 
 						case vml::views::frustum::OUTSIDE :
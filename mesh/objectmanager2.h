@@ -10,6 +10,24 @@ namespace vml
 			private:
 			
 				std::vector<Object3d_2*>  Objects;				// Objects array	
+				std::vector<float>		  CenterX;				// soa bounding box centers for batched culling
+				std::vector<float>		  CenterY;
+				std::vector<float>		  CenterZ;
+				std::vector<float>		  ExtentX;				// soa bounding box half extents for batched culling
+				std::vector<float>		  ExtentY;
+				std::vector<float>		  ExtentZ;
+				std::vector<unsigned int> CullingResults;		// batched culling results
+				vml::octree::DynamicBVH	  ObjectIndex;			// spatial index for culling and proximity queries
+				std::vector<int>		  ObjectProxies;		// index proxies, one per object
+				std::unordered_map<const Object3d_2*, int> ObjectProxyIds;	// index proxy of each object, proxies don't move when objects are removed
+				std::vector<size_t>		  QueryResults;			// index query results
+				std::vector<unsigned int> QueryCullingResults;	// index frustum query culling results
+				bool					  IndexedCulling;		// cull objects through the spatial index
+
+				// ----------------------------------------------------
+				// minimum number of objects transformed per thread
+
+				static const size_t TRANSFORM_BATCH = 64;
 
 				// ----------------------------------------------------
 				// release memory
@@ -24,6 +42,22 @@ namespace vml
 					// clear objects array
 
 					Objects.clear();
+
+					// clear spatial index
+
+					ObjectIndex.Clear();
+					ObjectProxies.clear();
+					ObjectProxyIds.clear();
+				}
+
+				// ----------------------------------------------------
+				// converts index query results to objects
+
+				void GetQueryObjects(std::vector<Object3d_2*>& objects) const
+				{
+					objects.resize(QueryResults.size());
+					for (size_t i = 0; i < QueryResults.size(); ++i)
+						objects[i] = Objects[QueryResults[i]];
 				}
 				
 			public:
@@ -51,6 +85,13 @@ namespace vml
 						}
 
 						// if we get here, we can store the object in the pointer vector
+						// and in the spatial index, proxies store the object position 
+
+						const vml::geo3d::AABBox& boundingbox = object->GetAABoundingBox();
+
+						ObjectProxies.emplace_back(ObjectIndex.CreateProxy(boundingbox.GetMin(), boundingbox.GetMax(), Objects.size()));
+
+						ObjectProxyIds[object] = ObjectProxies.back();
 
 						Objects.emplace_back(object);
 
@@ -96,6 +137,66 @@ namespace vml
 					return Objects.size();
 				}
 
+				// -----------------------------------------------------------------
+				// spatial queries, results are cleared first
+
+				// objects whose bounding box overlaps the given box
+
+				void FindObjectsInAABB(const glm::vec3& min, const glm::vec3& max, std::vector<Object3d_2*>& objects)
+				{
+					ObjectIndex.QueryAABB(min, max, QueryResults);
+					GetQueryObjects(objects);
+				}
+
+				// objects whose bounding box overlaps the given sphere
+
+				void FindObjectsInSphere(const glm::vec3& center, float radius, std::vector<Object3d_2*>& objects)
+				{
+					ObjectIndex.QuerySphere(center, radius, QueryResults);
+					GetQueryObjects(objects);
+				}
+
+				// objects inside or intersecting the view frustum, as of the last transform
+
+				void FindObjectsInFrustum(vml::views::View* view, std::vector<Object3d_2*>& objects)
+				{
+					ObjectIndex.QueryFrustum(view->GetFrustumPlanes(), QueryResults, QueryCullingResults);
+					GetQueryObjects(objects);
+				}
+
+				// k nearest objects to position, sorted by distance, filter
+				// can be used to select objects of a given kind
+
+				void FindNearestObjects(const glm::vec3& position, size_t k, std::vector<Object3d_2*>& objects,
+										float maxdistance = FLT_MAX,
+										const std::function<bool(Object3d_2*)>& filter = nullptr)
+				{
+					if (filter)
+						ObjectIndex.QueryNearest(position, k, QueryResults, maxdistance, [this, &filter](size_t i) { return filter(Objects[i]); });
+					else
+						ObjectIndex.QueryNearest(position, k, QueryResults, maxdistance);
+					GetQueryObjects(objects);
+				}
+
+				// -----------------------------------------------------------------
+				// culling through the spatial index pays off when many objects 
+				// are out of the view, otherwise the batched culler is faster
+
+				void SetIndexedCulling(bool indexedculling)
+				{
+					IndexedCulling = indexedculling;
+				}
+
+				bool IsIndexedCulling() const
+				{
+					return IndexedCulling;
+				}
+
+				const vml::octree::DynamicBVH& GetObjectIndex() const
+				{
+					return ObjectIndex;
+				}
+
 				// ------------------------------------------------------------------
 				// tranform object 
 
@@ -106,6 +207,13 @@ namespace vml
 
 					object->Transform();
 
+					// refit spatial index
+
+					auto it = ObjectProxyIds.find(object);
+
+					if (it != ObjectProxyIds.end())
+						ObjectIndex.MoveProxy(it->second, object->GetAABoundingBox().GetMin(), object->GetAABoundingBox().GetMax());
+
 					// cull objects
 
 					object->Cull(view);
@@ -131,14 +239,137 @@ namespace vml
 				}
 
 				// ----------------------------------------------------
-				// tranform objects 
+				// tranform objects, bounding boxes are gathered once
+				// objects are transformed and culled in a single batch
 
 				void TransformPipeline(vml::views::View* view)
 				{
+					size_t n = Objects.size();
+
+					if (n == 0)
+						return;
+
+					CenterX.resize(n); CenterY.resize(n); CenterZ.resize(n);
+					ExtentX.resize(n); ExtentY.resize(n); ExtentZ.resize(n);
+					CullingResults.resize(n);
+
+					vml::os::ThreadPool* pool = vml::os::ThreadPool::GetInstance();
+
+					// transform objects and gather bounding boxes, objects only
+					// write their own data, so batches run on the engine thread pool
+
+					pool->ParallelFor(n, TRANSFORM_BATCH, [this](size_t first, size_t last)
+					{
+						for (size_t i = first; i < last; ++i)
+						{
+							Objects[i]->Transform();
+
+							const vml::geo3d::AABBox& boundingbox = Objects[i]->GetAABoundingBox();
+
+							CenterX[i] = boundingbox.GetCenter().x;
+							CenterY[i] = boundingbox.GetCenter().y;
+							CenterZ[i] = boundingbox.GetCenter().z;
+							ExtentX[i] = boundingbox.GetHalfExtents().x;
+							ExtentY[i] = boundingbox.GetHalfExtents().y;
+							ExtentZ[i] = boundingbox.GetHalfExtents().z;
+						}
+					});
+
+					// refit the spatial index
+
+					for (size_t i = 0; i < n; ++i)
+					{
+						const vml::geo3d::AABBox& boundingbox = Objects[i]->GetAABoundingBox();
+
+						ObjectIndex.MoveProxy(ObjectProxies[i], boundingbox.GetMin(), boundingbox.GetMax());
+					}
+
+					// cull objects, objects not returned by the index are outside
+
+					if (IndexedCulling)
+					{
+						for (size_t i = 0; i < n; ++i)
+							CullingResults[i] = vml::views::frustum::OUTSIDE;
+
+						ObjectIndex.QueryFrustum(view->GetFrustumPlanes(), QueryResults, QueryCullingResults);
+
+						for (size_t i = 0; i < QueryResults.size(); ++i)
+							CullingResults[QueryResults[i]] = QueryCullingResults[i];
+					}
+					else
+					{
+						vml::views::frustum::BatchCuller::Cull(view->GetFrustumPlanes(),
+															   CenterX.data(), CenterY.data(), CenterZ.data(),
+															   ExtentX.data(), ExtentY.data(), ExtentZ.data(),
+															   n, CullingResults.data());
+					}
+
+					// if object is in frustum, transform view objects
+
+					pool->ParallelFor(n, TRANSFORM_BATCH, [this, view](size_t first, size_t last)
+					{
+						for (size_t i = first; i < last; ++i)
+						{
+							Objects[i]->SetCullingResult(view, CullingResults[i]);
+
+							if (Objects[i]->GetCullingFlags() != vml::views::frustum::OUTSIDE)
+								Objects[i]->TransformToView(view);
+						}
+					});
+				}
+
+				// -----------------------------------------------------------------
+				// creates physics bodies for the whole population in one batch, 
+				// bodies are fitted to the root model bounding box, objects whose
+				// root model has no physics shape get an invalid id, so ids[i]
+				// always refers to object i
+
+				void CreatePhysicsBodies(JPH::JoltPhysics* physics, std::vector<JPH::BodyID>& ids, bool dynamic = true)
+				{
+					if (!physics)
+						vml::os::Message::Error("Object Manager : ", "Physics is null");
+
+					std::vector<JPH::BodySpawn> spawns;
+					std::vector<size_t>			spawned;
+
+					spawns.reserve(Objects.size());
+					spawned.reserve(Objects.size());
+
 					for (size_t i = 0; i < Objects.size(); ++i)
 					{
-						TransformObject(view,Objects[i]);
+						vml::models::Model3d_2* model = Objects[i]->GetRootModel();
+
+						if (model->GetPhysicsShape() == JPH::Shapes::NO_SHAPE)
+							continue;
+
+						model->ComputeMatrix();
+
+						const vml::geo3d::AABBox& boundingbox = model->GetCurrentMesh()->GetBoundingBox();
+
+						// flat meshes would give a degenerate shape
+
+						glm::vec3 halfextents = glm::max(boundingbox.GetHalfExtents() * glm::abs(model->GetScaling()), glm::vec3(0.01f));
+
+						JPH::BodySpawn spawn;
+
+						spawn.Shape		  = model->GetPhysicsShape();
+						spawn.Position	  = glm::vec3(model->GetM() * glm::vec4(boundingbox.GetCenter(), 1.0f));
+						spawn.Rotation	  = glm::quat_cast(glm::mat3(model->GetR()));
+						spawn.HalfExtents = spawn.Shape == JPH::Shapes::SPHERE_SHAPE ? glm::vec3(std::max(halfextents.x, std::max(halfextents.y, halfextents.z))) : halfextents;
+						spawn.Dynamic	  = dynamic;
+
+						spawns.emplace_back(spawn);
+						spawned.emplace_back(i);
 					}
+
+					std::vector<JPH::BodyID> bodies;
+
+					physics->CreateBodies(spawns, bodies);
+
+					ids.assign(Objects.size(), JPH::BodyID());
+
+					for (size_t i = 0; i < spawned.size(); ++i)
+						ids[spawned[i]] = bodies[i];
 				}
 
 				// -----------------------------------------------------------------
@@ -151,11 +382,23 @@ namespace vml
 
 					// release object memenory 
 
+					ObjectProxyIds.erase(Objects[pos]);
+
 					vml::os::SafeDelete(Objects[pos]);
 
 					// remove from array
 
 					Objects.erase(Objects.begin() + pos);
+
+					// remove from spatial index, objects after the removed one
+					// shift back, so their proxies are updated
+
+					ObjectIndex.DestroyProxy(ObjectProxies[pos]);
+
+					ObjectProxies.erase(ObjectProxies.begin() + pos);
+
+					for (size_t i = pos; i < ObjectProxies.size(); ++i)
+						ObjectIndex.SetUserData(ObjectProxies[i], i);
 				}
 				
 				// -----------------------------------------------------------------
@@ -184,6 +427,7 @@ namespace vml
 
 				ObjectManager_2()
 				{
+					IndexedCulling = false;
 					vml::utils::Logger::GetInstance()->Info("Object Handler : Initting Object Handler");
 				}
 
@@ -0,0 +1,867 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////////
+//	This source file is part of v71's engine
+//
+//	Copyright (c) 2011-2050 v71
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+namespace vml
+{
+	namespace octree
+	{
+
+		////////////////////////////////////////////////////////////////////////////
+		// dynamic bounding volume hierarchy for moving objects
+		// each object is a leaf holding its bounding box and a fat box
+		// enlarged by a margin, as long as the object's box stays inside 
+		// the fat box, moving it costs nothing, otherwise the leaf is 
+		// removed and reinserted, the tree is kept balanced with avl like
+		// rotations, so its height stays logarithmic with the leaves count
+
+		class DynamicBVH
+		{
+
+			private:
+
+				// ----------------------------------------------------------------
+				// tree node, leaves have no children, parent is used
+				// as the next free node when the node is in the free list
+
+				struct Node
+				{
+					glm::vec3 Min;				// fat bounding box
+					glm::vec3 Max;
+					glm::vec3 TightMin;			// object bounding box, leaves only
+					glm::vec3 TightMax;
+					int		  Parent;			// parent node, or next free node
+					int		  Child[2];			// children nodes, NULL_NODE for leaves
+					int		  Height;			// 0 for leaves, -1 for free nodes
+					size_t	  UserData;			// object identifier, leaves only
+
+					bool IsLeaf() const { return Child[0] == NULL_NODE; }
+				};
+
+				// ----------------------------------------------------------------
+				// private data
+
+				std::vector<Node> Nodes;			// node pool
+				int				  Root;				// root node
+				int				  FreeList;			// first free node
+				size_t			  ProxiesCount;		// leaves count
+				float			  Margin;			// fat box enlargement, relative to box extents
+
+				static const int  STACK_SIZE = 256;	// traversal stack size, tree height is logarithmic
+
+				// ----------------------------------------------------------------
+				// box helpers
+
+				static float Area(const glm::vec3& min, const glm::vec3& max)
+				{
+					glm::vec3 d = max - min;
+					return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+				}
+
+				static bool Contains(const glm::vec3& min, const glm::vec3& max, const glm::vec3& innermin, const glm::vec3& innermax)
+				{
+					return min.x <= innermin.x && min.y <= innermin.y && min.z <= innermin.z &&
+						   max.x >= innermax.x && max.y >= innermax.y && max.z >= innermax.z;
+				}
+
+				static bool Overlaps(const glm::vec3& amin, const glm::vec3& amax, const glm::vec3& bmin, const glm::vec3& bmax)
+				{
+					return !(amax.x < bmin.x || amin.x > bmax.x ||
+							 amax.y < bmin.y || amin.y > bmax.y ||
+							 amax.z < bmin.z || amin.z > bmax.z);
+				}
+
+				// squared distance from a point to a box, 0 if point is inside
+
+				static float SquaredDistance(const glm::vec3& p, const glm::vec3& min, const glm::vec3& max)
+				{
+					glm::vec3 d = glm::max(glm::max(min - p, p - max), glm::vec3(0, 0, 0));
+					return d.x * d.x + d.y * d.y + d.z * d.z;
+				}
+
+				// ----------------------------------------------------------------
+				// node pool
+
+				int AllocateNode()
+				{
+					int id;
+
+					if (FreeList != NULL_NODE)
+					{
+						id		 = FreeList;
+						FreeList = Nodes[id].Parent;
+					}
+					else
+					{
+						id = (int)Nodes.size();
+						Nodes.emplace_back();
+					}
+
+					Node& node = Nodes[id];
+
+					node.Parent	  = NULL_NODE;
+					node.Child[0] = NULL_NODE;
+					node.Child[1] = NULL_NODE;
+					node.Height	  = 0;
+					node.UserData = 0;
+
+					return id;
+				}
+
+				void FreeNode(int id)
+				{
+					Nodes[id].Parent = FreeList;
+					Nodes[id].Height = -1;
+					FreeList		 = id;
+				}
+
+				// ----------------------------------------------------------------
+				// recomputes a branch box and height from its children
+
+				void FixNode(int id)
+				{
+					Node& node = Nodes[id];
+
+					const Node& a = Nodes[node.Child[0]];
+					const Node& b = Nodes[node.Child[1]];
+
+					node.Min	= glm::min(a.Min, b.Min);
+					node.Max	= glm::max(a.Max, b.Max);
+					node.Height = 1 + (a.Height > b.Height ? a.Height : b.Height);
+				}
+
+				// ----------------------------------------------------------------
+				// inserts a leaf, the sibling is found descending the tree
+				// towards the child whose surface area grows the least
+
+				void InsertLeaf(int leaf)
+				{
+					if (Root == NULL_NODE)
+					{
+						Root = leaf;
+						Nodes[Root].Parent = NULL_NODE;
+						return;
+					}
+
+					glm::vec3 leafmin = Nodes[leaf].Min;
+					glm::vec3 leafmax = Nodes[leaf].Max;
+
+					int index = Root;
+
+					while (!Nodes[index].IsLeaf())
+					{
+						const Node& node = Nodes[index];
+
+						float area			= Area(node.Min, node.Max);
+						float combinedarea	= Area(glm::min(node.Min, leafmin), glm::max(node.Max, leafmax));
+
+						// cost of creating a new parent for this node and the new leaf
+
+						float cost = 2.0f * combinedarea;
+
+						// minimum cost of pushing the leaf further down the tree
+
+						float inheritancecost = 2.0f * (combinedarea - area);
+
+						float childcost[2];
+
+						for (int i = 0; i < 2; ++i)
+						{
+							const Node& child = Nodes[node.Child[i]];
+
+							float newarea = Area(glm::min(child.Min, leafmin), glm::max(child.Max, leafmax));
+
+							if (child.IsLeaf())
+								childcost[i] = newarea + inheritancecost;
+							else
+								childcost[i] = newarea - Area(child.Min, child.Max) + inheritancecost;
+						}
+
+						// descend according to the minimum cost
+
+						if (cost < childcost[0] && cost < childcost[1])
+							break;
+
+						index = childcost[0] < childcost[1] ? node.Child[0] : node.Child[1];
+					}
+
+					int sibling = index;
+
+					// create a new parent
+
+					int oldparent = Nodes[sibling].Parent;
+					int newparent = AllocateNode();
+
+					Nodes[newparent].Parent	  = oldparent;
+					Nodes[newparent].Child[0] = sibling;
+					Nodes[newparent].Child[1] = leaf;
+					Nodes[sibling].Parent	  = newparent;
+					Nodes[leaf].Parent		  = newparent;
+
+					if (oldparent != NULL_NODE)
+					{
+						if (Nodes[oldparent].Child[0] == sibling)
+							Nodes[oldparent].Child[0] = newparent;
+						else
+							Nodes[oldparent].Child[1] = newparent;
+					}
+					else
+					{
+						Root = newparent;
+					}
+
+					// walk back up the tree fixing heights and boxes
+
+					for (index = newparent; index != NULL_NODE; index = Nodes[index].Parent)
+					{
+						index = Balance(index);
+						FixNode(index);
+					}
+				}
+
+				// ----------------------------------------------------------------
+				// removes a leaf, its sibling takes the parent's place
+
+				void RemoveLeaf(int leaf)
+				{
+					if (leaf == Root)
+					{
+						Root = NULL_NODE;
+						return;
+					}
+
+					int parent		= Nodes[leaf].Parent;
+					int grandparent = Nodes[parent].Parent;
+					int sibling		= Nodes[parent].Child[0] == leaf ? Nodes[parent].Child[1] : Nodes[parent].Child[0];
+
+					if (grandparent != NULL_NODE)
+					{
+						if (Nodes[grandparent].Child[0] == parent)
+							Nodes[grandparent].Child[0] = sibling;
+						else
+							Nodes[grandparent].Child[1] = sibling;
+
+						Nodes[sibling].Parent = grandparent;
+
+						FreeNode(parent);
+
+						for (int index = grandparent; index != NULL_NODE; index = Nodes[index].Parent)
+						{
+							index = Balance(index);
+							FixNode(index);
+						}
+					}
+					else
+					{
+						Root				  = sibling;
+						Nodes[sibling].Parent = NULL_NODE;
+						FreeNode(parent);
+					}
+				}
+
+				// ----------------------------------------------------------------
+				// rotates the grandchild of the taller child up if the children
+				// heights differ by more than one, returns the new subtree root
+
+				int Balance(int ia)
+				{
+					Node& a = Nodes[ia];
+
+					if (a.IsLeaf() || a.Height < 2)
+						return ia;
+
+					int ib = a.Child[0];
+					int ic = a.Child[1];
+
+					int balance = Nodes[ic].Height - Nodes[ib].Height;
+
+					if (balance > 1)
+						return Rotate(ia, ic, 1);
+
+					if (balance < -1)
+						return Rotate(ia, ib, 0);
+
+					return ia;
+				}
+
+				// ----------------------------------------------------------------
+				// moves child up in place of a, child is a's child at slot
+
+				int Rotate(int ia, int ichild, int slot)
+				{
+					Node& a		= Nodes[ia];
+					Node& child = Nodes[ichild];
+
+					int ig = child.Child[0];
+					int ih = child.Child[1];
+
+					// swap a and child
+
+					child.Child[0] = ia;
+					child.Parent   = a.Parent;
+					a.Parent	   = ichild;
+
+					if (child.Parent != NULL_NODE)
+					{
+						if (Nodes[child.Parent].Child[0] == ia)
+							Nodes[child.Parent].Child[0] = ichild;
+						else
+							Nodes[child.Parent].Child[1] = ichild;
+					}
+					else
+					{
+						Root = ichild;
+					}
+
+					// the taller grandchild stays under child, the other one goes to a
+
+					int taller  = Nodes[ig].Height > Nodes[ih].Height ? ig : ih;
+					int shorter = taller == ig ? ih : ig;
+
+					child.Child[1]		  = taller;
+					a.Child[slot]		  = shorter;
+					Nodes[shorter].Parent = ia;
+
+					FixNode(ia);
+					FixNode(ichild);
+
+					return ichild;
+				}
+
+			public:
+
+				static const int NULL_NODE = -1;
+
+				// ----------------------------------------------------------------
+				// creates a proxy for an object bounding box, returns the proxy id
+
+				int CreateProxy(const glm::vec3& min, const glm::vec3& max, size_t userdata)
+				{
+					int proxy = AllocateNode();
+
+					glm::vec3 margin = (max - min) * Margin;
+
+					Nodes[proxy].TightMin = min;
+					Nodes[proxy].TightMax = max;
+					Nodes[proxy].Min	  = min - margin;
+					Nodes[proxy].Max	  = max + margin;
+					Nodes[proxy].UserData = userdata;
+					Nodes[proxy].Height	  = 0;
+
+					InsertLeaf(proxy);
+
+					ProxiesCount++;
+
+					return proxy;
+				}
+
+				// ----------------------------------------------------------------
+				// destroys a proxy
+
+				void DestroyProxy(int proxy)
+				{
+					if (proxy < 0 || proxy >= (int)Nodes.size() || !Nodes[proxy].IsLeaf() || Nodes[proxy].Height != 0)
+						vml::os::Message::Error("DynamicBVH : ", "Invalid proxy");
+
+					RemoveLeaf(proxy);
+					FreeNode(proxy);
+
+					ProxiesCount--;
+				}
+
+				// ----------------------------------------------------------------
+				// updates a proxy bounding box, the tree is modified only if
+				// the box leaves the fat box, returns true in this case
+
+				bool MoveProxy(int proxy, const glm::vec3& min, const glm::vec3& max)
+				{
+					Node& node = Nodes[proxy];
+
+					node.TightMin = min;
+					node.TightMax = max;
+
+					if (Contains(node.Min, node.Max, min, max))
+						return false;
+
+					RemoveLeaf(proxy);
+
+					glm::vec3 margin = (max - min) * Margin;
+
+					Nodes[proxy].Min = min - margin;
+					Nodes[proxy].Max = max + margin;
+
+					InsertLeaf(proxy);
+
+					return true;
+				}
+
+				// ----------------------------------------------------------------
+				// getters / setters
+
+				size_t GetUserData(int proxy) const
+				{
+					return Nodes[proxy].UserData;
+				}
+
+				void SetUserData(int proxy, size_t userdata)
+				{
+					Nodes[proxy].UserData = userdata;
+				}
+
+				size_t GetProxiesCount() const
+				{
+					return ProxiesCount;
+				}
+
+				int GetHeight() const
+				{
+					return Root == NULL_NODE ? 0 : Nodes[Root].Height;
+				}
+
+				float GetMargin() const
+				{
+					return Margin;
+				}
+
+				// margin is applied to proxies created or moved from now on
+
+				void SetMargin(float margin)
+				{
+					Margin = margin;
+				}
+
+				// ----------------------------------------------------------------
+				// finds objects whose bounding box overlaps the given box
+
+				void QueryAABB(const glm::vec3& min, const glm::vec3& max, std::vector<size_t>& results) const
+				{
+					results.clear();
+
+					if (Root == NULL_NODE)
+						return;
+
+					int stack[STACK_SIZE];
+					int stackcounter = 0;
+
+					stack[stackcounter++] = Root;
+
+					while (stackcounter > 0)
+					{
+						const Node& node = Nodes[stack[--stackcounter]];
+
+						if (!Overlaps(node.Min, node.Max, min, max))
+							continue;
+
+						if (node.IsLeaf())
+						{
+							if (Overlaps(node.TightMin, node.TightMax, min, max))
+								results.emplace_back(node.UserData);
+						}
+						else
+						{
+							stack[stackcounter++] = node.Child[0];
+							stack[stackcounter++] = node.Child[1];
+						}
+					}
+				}
+
+				// ----------------------------------------------------------------
+				// finds objects whose bounding box overlaps the given sphere
+
+				void QuerySphere(const glm::vec3& center, float radius, std::vector<size_t>& results) const
+				{
+					results.clear();
+
+					if (Root == NULL_NODE)
+						return;
+
+					float squaredradius = radius * radius;
+
+					int stack[STACK_SIZE];
+					int stackcounter = 0;
+
+					stack[stackcounter++] = Root;
+
+					while (stackcounter > 0)
+					{
+						const Node& node = Nodes[stack[--stackcounter]];
+
+						if (SquaredDistance(center, node.Min, node.Max) > squaredradius)
+							continue;
+
+						if (node.IsLeaf())
+						{
+							if (SquaredDistance(center, node.TightMin, node.TightMax) <= squaredradius)
+								results.emplace_back(node.UserData);
+						}
+						else
+						{
+							stack[stackcounter++] = node.Child[0];
+							stack[stackcounter++] = node.Child[1];
+						}
+					}
+				}
+
+				// ----------------------------------------------------------------
+				// finds objects inside or intersecting the frustum, culling results
+				// match the ones computed on the objects' own bounding boxes,
+				// subtrees fully inside the frustum are accepted without tests
+
+				void QueryFrustum(const glm::vec4* planes, std::vector<size_t>& results, std::vector<unsigned int>& cullingresults) const
+				{
+					results.clear();
+					cullingresults.clear();
+
+					if (Root == NULL_NODE)
+						return;
+
+					int  stack[STACK_SIZE];
+					bool inside[STACK_SIZE];
+					int  stackcounter = 0;
+
+					stack[stackcounter]	   = Root;
+					inside[stackcounter++] = false;
+
+					while (stackcounter > 0)
+					{
+						--stackcounter;
+
+						const Node& node = Nodes[stack[stackcounter]];
+
+						bool parentinside = inside[stackcounter];
+
+						if (node.IsLeaf())
+						{
+							unsigned int result = vml::views::frustum::INSIDE;
+
+							if (!parentinside)
+								result = vml::views::frustum::TestAABBox(planes, (node.TightMin + node.TightMax) * 0.5f, (node.TightMax - node.TightMin) * 0.5f);
+
+							if (result != vml::views::frustum::OUTSIDE)
+							{
+								results.emplace_back(node.UserData);
+								cullingresults.emplace_back(result);
+							}
+
+							continue;
+						}
+
+						bool nodeinside = parentinside;
+
+						if (!parentinside)
+						{
+							unsigned int result = vml::views::frustum::TestAABBox(planes, (node.Min + node.Max) * 0.5f, (node.Max - node.Min) * 0.5f);
+
+							if (result == vml::views::frustum::OUTSIDE)
+								continue;
+
+							nodeinside = result == vml::views::frustum::INSIDE;
+						}
+
+						stack[stackcounter]	   = node.Child[0];
+						inside[stackcounter++] = nodeinside;
+						stack[stackcounter]	   = node.Child[1];
+						inside[stackcounter++] = nodeinside;
+					}
+				}
+
+				// ----------------------------------------------------------------
+				// finds the k objects whose bounding box center is nearest to 
+				// position, within maxdistance, results are sorted by distance,
+				// if filter is given, only objects accepted by it are returned
+
+				void QueryNearest(const glm::vec3& position, size_t k, std::vector<size_t>& results, 
+								  float maxdistance = FLT_MAX, 
+								  const std::function<bool(size_t)>& filter = nullptr) const
+				{
+					results.clear();
+
+					if (Root == NULL_NODE || k == 0)
+						return;
+
+					// best objects found, sorted by distance
+
+					typedef std::pair<float, size_t> Entry;
+
+					std::vector<Entry> best;
+
+					best.reserve(k + 1);
+
+					float bound = maxdistance < FLT_MAX ? maxdistance * maxdistance : FLT_MAX;
+
+					// depth first, nearer child first, a box center
+					// can't be nearer than its box, so farther boxes are pruned
+
+					int   stack[STACK_SIZE];
+					float distances[STACK_SIZE];
+					int   stackcounter = 0;
+
+					stack[stackcounter]		  = Root;
+					distances[stackcounter++] = SquaredDistance(position, Nodes[Root].Min, Nodes[Root].Max);
+
+					while (stackcounter > 0)
+					{
+						--stackcounter;
+
+						if (distances[stackcounter] > bound)
+							continue;
+
+						const Node& node = Nodes[stack[stackcounter]];
+
+						if (node.IsLeaf())
+						{
+							glm::vec3 d		   = (node.TightMin + node.TightMax) * 0.5f - position;
+							float	  distance = d.x * d.x + d.y * d.y + d.z * d.z;
+
+							if (distance > bound)
+								continue;
+
+							if (filter && !filter(node.UserData))
+								continue;
+
+							// insert in sorted position
+
+							size_t i = best.size();
+
+							best.emplace_back(distance, node.UserData);
+
+							while (i > 0 && best[i - 1].first > distance)
+							{
+								best[i] = best[i - 1];
+								i--;
+							}
+
+							best[i] = Entry(distance, node.UserData);
+
+							if (best.size() > k)
+								best.pop_back();
+
+							if (best.size() == k)
+								bound = best.back().first;
+						}
+						else
+						{
+							float d0 = SquaredDistance(position, Nodes[node.Child[0]].Min, Nodes[node.Child[0]].Max);
+							float d1 = SquaredDistance(position, Nodes[node.Child[1]].Min, Nodes[node.Child[1]].Max);
+
+							// push farther child first, so nearer child is visited first
+
+							int first  = d0 <= d1 ? 1 : 0;
+							int second = 1 - first;
+
+							float df = first  == 0 ? d0 : d1;
+							float ds = second == 0 ? d0 : d1;
+
+							if (df <= bound)
+							{
+								stack[stackcounter]		  = node.Child[first];
+								distances[stackcounter++] = df;
+							}
+
+							if (ds <= bound)
+							{
+								stack[stackcounter]		  = node.Child[second];
+								distances[stackcounter++] = ds;
+							}
+						}
+					}
+
+					results.resize(best.size());
+
+					for (size_t i = 0; i < best.size(); ++i)
+						results[i] = best[i].second;
+				}
+
+				// ----------------------------------------------------------------
+				// removes all proxies
+
+				void Clear()
+				{
+					Nodes.clear();
+					Root		 = NULL_NODE;
+					FreeList	 = NULL_NODE;
+					ProxiesCount = 0;
+				}
+
+				// ----------------------------------------------------------------
+				// measures insertion, refit and query times against linear
+				// scans, from 100 to 100k random objects, results are
+				// written to the log
+
+				static void Benchmark()
+				{
+					std::mt19937 generator(71);
+					std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+					std::uniform_real_distribution<float> size(0.5f, 5.0f);
+					std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+
+					const size_t queries = 1000;
+
+					for (size_t count = 100; count <= 100000; count *= 10)
+					{
+						std::vector<glm::vec3> mins(count);
+						std::vector<glm::vec3> maxs(count);
+
+						for (size_t i = 0; i < count; ++i)
+						{
+							glm::vec3 p(position(generator), position(generator), position(generator));
+							glm::vec3 s(size(generator), size(generator), size(generator));
+							mins[i] = p - s;
+							maxs[i] = p + s;
+						}
+
+						DynamicBVH bvh;
+
+						std::vector<int> proxies(count);
+
+						vml::os::Timer timer;
+
+						// insertion
+
+						timer.Init();
+
+						for (size_t i = 0; i < count; ++i)
+							proxies[i] = bvh.CreateProxy(mins[i], maxs[i], i);
+
+						float inserttime = timer.GetElapsedTime() * 1000.0f;
+
+						// refit with small moves
+
+						timer.Init();
+
+						for (size_t i = 0; i < count; ++i)
+						{
+							glm::vec3 d(jitter(generator), jitter(generator), jitter(generator));
+							mins[i] += d;
+							maxs[i] += d;
+							bvh.MoveProxy(proxies[i], mins[i], maxs[i]);
+						}
+
+						float movetime = timer.GetElapsedTime() * 1000.0f;
+
+						// box queries
+
+						std::vector<size_t> results;
+						size_t found = 0;
+
+						timer.Init();
+
+						for (size_t i = 0; i < queries; ++i)
+						{
+							glm::vec3 p(position(generator), position(generator), position(generator));
+							bvh.QueryAABB(p - 50.0f, p + 50.0f, results);
+							found += results.size();
+						}
+
+						float querytime = timer.GetElapsedTime() * 1000.0f;
+
+						timer.Init();
+
+						for (size_t i = 0; i < queries; ++i)
+						{
+							glm::vec3 p(position(generator), position(generator), position(generator));
+							glm::vec3 qmin = p - 50.0f;
+							glm::vec3 qmax = p + 50.0f;
+							results.clear();
+							for (size_t j = 0; j < count; ++j)
+								if (Overlaps(mins[j], maxs[j], qmin, qmax))
+									results.emplace_back(j);
+							found += results.size();
+						}
+
+						float lineartime = timer.GetElapsedTime() * 1000.0f;
+
+						// nearest neighbour queries
+
+						timer.Init();
+
+						for (size_t i = 0; i < queries; ++i)
+						{
+							glm::vec3 p(position(generator), position(generator), position(generator));
+							bvh.QueryNearest(p, 1, results);
+							found += results.size();
+						}
+
+						float nearesttime = timer.GetElapsedTime() * 1000.0f;
+
+						timer.Init();
+
+						for (size_t i = 0; i < queries; ++i)
+						{
+							glm::vec3 p(position(generator), position(generator), position(generator));
+							float distmin = FLT_MAX;
+							size_t minid = 0;
+							for (size_t j = 0; j < count; ++j)
+							{
+								glm::vec3 d = (mins[j] + maxs[j]) * 0.5f - p;
+								float distance = d.x * d.x + d.y * d.y + d.z * d.z;
+								if (distance < distmin) { distmin = distance; minid = j; }
+							}
+							found += minid;
+						}
+
+						float linearnearesttime = timer.GetElapsedTime() * 1000.0f;
+
+						vml::utils::Logger::GetInstance()->Info("DynamicBVH : Benchmark : " + std::to_string(count) + " objects, height " + std::to_string(bvh.GetHeight()) + ", found " + std::to_string(found) +
+																" : insert " + std::to_string(inserttime) + " ms" +
+																", move " + std::to_string(movetime) + " ms" +
+																", " + std::to_string(queries) + " box queries " + std::to_string(querytime) + " ms (linear " + std::to_string(lineartime) + " ms)" +
+																", " + std::to_string(queries) + " nearest queries " + std::to_string(nearesttime) + " ms (linear " + std::to_string(linearnearesttime) + " ms)");
+					}
+				}
+
+				//-----------------------------------------------------------------------------------
+				// copy constructor is private
+				// no copies allowed since classes
+				// are referenced
+
+				DynamicBVH(DynamicBVH& dynamicbvh) = delete;
+
+				//-----------------------------------------------------------------------------------
+				// overload operator is private,
+				// no copies allowed since classes
+				// are referenced
+
+				void operator=(const DynamicBVH& dynamicbvh) = delete;
+
+				// ----------------------------------------------------------------
+				// ctor / dtor
+				// margin is the fat box enlargement, relative to box extents
+
+				DynamicBVH(float margin = 0.25f)
+				{
+					Root		 = NULL_NODE;
+					FreeList	 = NULL_NODE;
+					ProxiesCount = 0;
+					Margin		 = margin;
+				}
+
+				~DynamicBVH()
+				{
+				}
+
+		};
+
+	}
+}
@@ -33,6 +33,77 @@ namespace vml
 						glm::mat4			MVP;
 						glm::mat3			NV;
 
+					public:
+
+						// ---------------------------------------------------------------
+						// meshlet, a cluster of leaf triangles stored as a contiguous range
+						// of the leaf index buffer, with a bounding sphere for frustum culling
+						// and a normal cone for backface culling, see meshopt_computeMeshletBounds
+
+						struct Meshlet
+						{
+							uint32_t  FirstIndex;		// range in the leaf index buffer
+							uint32_t  IndicesCount;
+							glm::vec3 Center;			// bounding sphere
+							float	  Radius;
+							glm::vec3 ConeApex;			// normal cone
+							glm::vec3 ConeAxis;
+							float	  ConeCutoff;		// cosine of the cone half angle, 1 if the cone is degenerate
+						};
+
+						static const size_t	   MESHLET_MAX_VERTICES	 = 64;
+						static const size_t	   MESHLET_MAX_TRIANGLES = 124;		// must be a multiple of 4
+						static constexpr float MESHLET_CONE_WEIGHT	 = 0.25f;	// favours tighter normal cones over meshlet size
+
+					private:
+
+						std::vector<Meshlet> Meshlets;				// leaf meshlets, empty if not built
+						uint32_t			 FirstCommand;			// culled meshlets draw commands range
+						uint32_t			 CommandsCount;
+
+						// ---------------------------------------------------------------
+						// partitions the leaf triangles into meshlets and rewrites the
+						// index array so each meshlet is a contiguous range, triangles
+						// are the same, so the leaf still draws whole with a single call
+
+						void BuildMeshlets(const float* vertexarray, size_t vertices, std::vector<unsigned int>& indices)
+						{
+							size_t maxmeshlets = meshopt_buildMeshletsBound(indices.size(), MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES);
+
+							std::vector<meshopt_Meshlet> meshlets(maxmeshlets);
+							std::vector<unsigned int>	 meshletvertices(maxmeshlets * MESHLET_MAX_VERTICES);
+							std::vector<unsigned char>	 meshlettriangles(maxmeshlets * MESHLET_MAX_TRIANGLES * 3);
+
+							size_t count = meshopt_buildMeshlets(meshlets.data(), meshletvertices.data(), meshlettriangles.data(),
+																 indices.data(), indices.size(), vertexarray, vertices, 4 * sizeof(float),
+																 MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES, MESHLET_CONE_WEIGHT);
+
+							Meshlets.resize(count);
+
+							size_t k = 0;
+
+							for (size_t i = 0; i < count; ++i)
+							{
+								const meshopt_Meshlet& m = meshlets[i];
+
+								meshopt_Bounds bounds = meshopt_computeMeshletBounds(&meshletvertices[m.vertex_offset], &meshlettriangles[m.triangle_offset],
+																					 m.triangle_count, vertexarray, vertices, 4 * sizeof(float));
+
+								Meshlet& meshlet = Meshlets[i];
+
+								meshlet.FirstIndex	 = (uint32_t)k;
+								meshlet.IndicesCount = m.triangle_count * 3;
+								meshlet.Center		 = glm::vec3(bounds.center[0], bounds.center[1], bounds.center[2]);
+								meshlet.Radius		 = bounds.radius;
+								meshlet.ConeApex	 = glm::vec3(bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2]);
+								meshlet.ConeAxis	 = glm::vec3(bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2]);
+								meshlet.ConeCutoff	 = bounds.cone_cutoff;
+
+								for (size_t j = 0; j < (size_t)m.triangle_count * 3; ++j)
+									indices[k++] = meshletvertices[m.vertex_offset + meshlettriangles[m.triangle_offset + j]];
+							}
+						}
+
 					public:
 						
 						
@@ -60,6 +131,9 @@ namespace vml
 						size_t					  GetSurfacesCount()   const { return Surfaces; }
 						size_t					  GetIndicesCount()    const { return Indices; }
 						GLuint					  GetVAOId()		   const { return VAOid; }
+						const std::vector<Meshlet>& GetMeshlets()	   const { return Meshlets; }
+						uint32_t				  GetFirstCommand()	   const { return FirstCommand; }
+						uint32_t				  GetCommandsCount()   const { return CommandsCount; }
 						const					  glm::mat4& GetM()    const { return M; }
 						const					  glm::mat4& GetMV()   const { return MV; }
 						const					  glm::mat4& GetMVP()  const { return MVP; }
@@ -69,9 +143,12 @@ namespace vml
 						// setters
 
 						void SetChild(int pos, OctTreeNode* child) { Child[pos] = child; }
+						void SetId(int id)						   { Id = id; }
 						void SetParent(OctTreeNode* parent)		   { Parent = parent; Leaf = false; }
 						void SetLeaf()							   { Leaf = true; }
 						void ResetVisibleFlag()					   { Visible = OUTSIDE; }
+						void SetVisibleFlag(unsigned int visible)  { Visible = visible; }
+						void SetCommands(uint32_t first, uint32_t count) { FirstCommand = first; CommandsCount = count; }
 						
 						// ------------------------------------------------------------------------------
 						// test an object's axis aligned bounding box against the view frustum
@@ -151,7 +228,7 @@ namespace vml
 						// ---------------------------------------------------------------
 						// vbo creation
 
-						void CreateVAO(const std::vector<vml::geo3d::Vertex> &srcvertexarray,const std::vector<vml::geo3d::IndexedTriangle>&srcsurfacearray)
+						void CreateVAO(const std::vector<vml::geo3d::Vertex> &srcvertexarray,const std::vector<vml::geo3d::IndexedTriangle>&srcsurfacearray, bool meshlets = false)
 						{
 							// Create the vertex array object for the mesh.
 							//
@@ -196,11 +273,33 @@ namespace vml
 								surfaceindices.emplace_back(srcsurfacearray[i].I2);
 							}
 
+							CreateVAO(&vertexarray[0], &normalarray[0], srcvertexarray.size(), &surfaceindices[0], surfaceindices.size(), meshlets);
+						}
+
+						// ---------------------------------------------------------------
+						// vbo creation from packed arrays, positions have 4 components,
+						// normals have 3 components, data can come straight 
+						// from a memory mapped octree cache, if meshlets are requested
+						// a reordered copy of the indices is uploaded
+
+						void CreateVAO(const float* vertexarray, const float* normalarray, size_t vertices, const unsigned int* surfaceindices, size_t indices, bool meshlets = false)
+						{
+							std::vector<unsigned int> meshletindices;
+
+							Meshlets.clear();
+
+							if (meshlets && indices > 0)
+							{
+								meshletindices.assign(surfaceindices, surfaceindices + indices);
+								BuildMeshlets(vertexarray, vertices, meshletindices);
+								surfaceindices = meshletindices.data();
+							}
+
 							// get vertex, surfaces and indices count for node metrics
 
-							Vertices = (unsigned int)srcvertexarray.size();
-							Surfaces = (unsigned int)srcsurfacearray.size(); 
-							Indices  = (unsigned int)surfaceindices.size();
+							Vertices = (unsigned int)vertices;
+							Surfaces = (unsigned int)indices / 3; 
+							Indices  = (unsigned int)indices;
 
 							// clear opengl vao data buffers
 
@@ -228,13 +327,13 @@ namespace vml
 
 							glGenBuffers(1, &BufferObjects[0]);
 							glBindBuffer(GL_ARRAY_BUFFER, BufferObjects[0]);
-							glBufferData(GL_ARRAY_BUFFER, ((unsigned int)vertexarray.size()) * sizeof(float), &vertexarray[0], GL_STATIC_DRAW);
+							glBufferData(GL_ARRAY_BUFFER, Vertices * 4 * sizeof(float), vertexarray, GL_STATIC_DRAW);
 							glEnableVertexAttribArray(AttributePosition);
 							glVertexAttribPointer(AttributePosition, 4, GL_FLOAT, GL_FALSE, 0, 0);
 
 							glGenBuffers(1, &BufferObjects[1]);
 							glBindBuffer(GL_ARRAY_BUFFER, BufferObjects[1]);
-							glBufferData(GL_ARRAY_BUFFER, ((unsigned int)normalarray.size()) * sizeof(float), &normalarray[0], GL_STATIC_DRAW);
+							glBufferData(GL_ARRAY_BUFFER, Vertices * 3 * sizeof(float), normalarray, GL_STATIC_DRAW);
 							glEnableVertexAttribArray(AttributeNormal);
 							glVertexAttribPointer(AttributeNormal, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
@@ -244,7 +343,7 @@ namespace vml
 
 							glGenBuffers(1, &IndexBufferObject);
 							glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IndexBufferObject);
-							glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indices * sizeof(unsigned int), &surfaceindices[0], GL_STATIC_DRAW);
+							glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indices * sizeof(unsigned int), surfaceindices, GL_STATIC_DRAW);
 
 							// unbinds buffers
 
@@ -331,6 +430,8 @@ namespace vml
 							BufferObjects[1]   =  0;
 							BufferObjects[2]   =  0;
 							BufferObjects[3]   =  0;
+							FirstCommand	   =  0;
+							CommandsCount	   =  0;
 							M = glm::mat4(1, 0, 0, 0,
 							 		      0, 1, 0, 0,
 									      0, 0, 1, 0,
@@ -354,14 +455,182 @@ namespace vml
 
 				};
 					
+				////////////////////////////////////////////////////////////////////////////
+				// flat octree node, nodes are packed in breadth first order into
+				// a contiguous array, siblings are stored next to each other, so
+				// a node only needs the index of its first child and the children count,
+				// bounding boxes are stored apart in soa arrays
+
+				struct FlatOctTreeNode
+				{
+					uint32_t FirstChild;		// index of the first child in the flat array
+					uint32_t ChildCount;		// children count, 0 if node has no children
+					uint32_t NodeIndex;			// index of the pointer based node holding rendering data
+					uint32_t Leaf;				// node is a leaf if it contains rendering data
+				};
+
+				////////////////////////////////////////////////////////////////////////////
+				// ray used for octree queries, points along the ray are 
+				// origin + t * direction with t in [0, maxt], a segment from a to b
+				// is the ray with origin a, direction b - a and maxt 1
+
+				struct OctTreeRay
+				{
+					glm::vec3 Origin;			// ray origin
+					glm::vec3 Direction;		// ray direction, doesn't need to be normalized
+					float	  MaxT;				// max ray parameter
+
+					OctTreeRay(const glm::vec3& origin, const glm::vec3& direction, float maxt = FLT_MAX)
+					{
+						Origin	  = origin;
+						Direction = direction;
+						MaxT	  = maxt;
+					}
+
+					OctTreeRay()
+					{
+						Origin	  = glm::vec3(0, 0, 0);
+						Direction = glm::vec3(0, 0, 1);
+						MaxT	  = FLT_MAX;
+					}
+				};
+
+				////////////////////////////////////////////////////////////////////////////
+				// nearest hit along a ray, triangle is the map mesh surface index,
+				// -1 if the ray doesn't hit anything
+
+				struct OctTreeRayHit
+				{
+					float	  T;				// ray parameter at hit point
+					int		  Triangle;			// hit triangle
+					glm::vec3 Normal;			// hit triangle normal
+
+					OctTreeRayHit()
+					{
+						T		 = FLT_MAX;
+						Triangle = -1;
+						Normal	 = glm::vec3(0, 0, 0);
+					}
+				};
+
 				////////////////////////////////////////////////////////////////////////////
 				// Octree generator
 
 				class OctTree
 				{
 
+					public:
+
+						// ----------------------------------------------------------------
+						// indirect draw command, layout is fixed by glMultiDrawElementsIndirect
+
+						struct MeshletCommand
+						{
+							GLuint Count;
+							GLuint InstanceCount;
+							GLuint FirstIndex;
+							GLint  BaseVertex;
+							GLuint BaseInstance;
+						};
+
 					private:
 						
+						// ----------------------------------------------------------------
+						// per thread scratch buffers used during compilation
+
+						struct ScratchBuffers
+						{
+							std::deque<std::vector<vml::geo3d::IndexedTriangle>> Lists;		// triangle lists, handed out in stack order
+							size_t												 UsedLists = 0;	// lists currently in use
+							std::vector<vml::geo3d::Vertex>						 Vertices;		// clipped vertices
+							std::vector<vml::geo3d::IndexedTriangle>			 Surfaces;		// clipped surfaces
+						};
+
+						// ----------------------------------------------------------------
+						// node data computed by the parallel build
+
+						struct PendingNode
+						{
+							size_t									 SurfacesCount = 0;		// surfaces intersecting the node
+							bool									 Leaf		   = false;	// node has rendering data
+							std::vector<uint32_t>					 Triangles;				// surfaces intersecting a childless node, for ray queries
+							std::vector<vml::geo3d::Vertex>			 Vertices;				// clipped vertices
+							std::vector<vml::geo3d::IndexedTriangle> Surfaces;				// clipped surfaces
+						};
+
+						// ----------------------------------------------------------------
+						// octree cache file layout, the header is followed by the node
+						// records and by the leaf vertex, normal and index arrays, each
+						// section starts at a 16 bytes aligned offset so it can be
+						// used straight from the mapped file
+
+						struct CacheHeader
+						{
+							char	 Magic[4];				// 'VOCT'
+							uint32_t Version;				// cache format version
+							uint64_t SourceHash;			// hash of the source mesh
+							uint32_t NodesCount;			// node records count
+							uint32_t LeafNodes;				// leaf nodes count
+							uint32_t MaxSurfaces;			// max number of surfaces per node
+							float	 BuildTime;				// compilation time in milliseconds
+							uint64_t NodesOffset;			// node records offset
+							uint64_t VerticesOffset;		// vertex positions offset, 4 floats per vertex
+							uint64_t NormalsOffset;			// vertex normals offset, 3 floats per vertex
+							uint64_t IndicesOffset;			// surface indices offset
+							uint64_t VerticesCount;			// total vertices count
+							uint64_t IndicesCount;			// total indices count
+							uint64_t TrianglesOffset;		// ray query triangle ids offset
+							uint64_t TrianglesCount;		// ray query triangle ids count, 0 if not retained
+						};
+
+						struct CacheNode
+						{
+							float	 Min[3];				// bounding box
+							float	 Max[3];
+							int32_t	 Parent;				// parent node id, -1 for root
+							int32_t	 Child[8];				// children node ids, -1 if node has no children
+							uint32_t Leaf;					// node has rendering data
+							uint32_t FirstVertex;			// leaf vertices range
+							uint32_t VerticesCount;
+							uint32_t FirstIndex;			// leaf indices range
+							uint32_t IndicesCount;
+							uint32_t FirstTriangle;			// ray query triangle ids range
+							uint32_t TrianglesCount;
+						};
+
+						// ----------------------------------------------------------------
+						// leaf data range in the retained leaf arrays
+
+						struct LeafRange
+						{
+							uint32_t FirstVertex;
+							uint32_t VerticesCount;
+							uint32_t FirstIndex;
+							uint32_t IndicesCount;
+						};
+
+						// ----------------------------------------------------------------
+						// range of triangle ids in the leaf triangles array
+
+						struct TriangleRange
+						{
+							uint32_t First = 0;
+							uint32_t Count = 0;
+						};
+
+						// ----------------------------------------------------------------
+						// ray traversal stack entry
+
+						struct RayStackEntry
+						{
+							uint32_t Node;				// flat node index
+							float	 TEnter;			// ray parameter where the ray enters the node
+						};
+
+						static const uint32_t CACHE_VERSION	   = 2;
+						static const size_t	  RAY_PACKET_SIZE  = 8;		// rays traversed together in packet mode
+						static const size_t	  RAY_BATCH_SIZE   = 64;	// rays per task in multithreaded mode
+
 						// ----------------------------------------------------------------
 						// private data
 
@@ -382,6 +651,39 @@ namespace vml
 						unsigned int							   Flags;
 						std::vector<OctTreeNode*>				   QueryOctTreeNodes;			// octree nodes vector for fast searches
 						int										   QueryOctTreeNodesCount;
+						std::vector<FlatOctTreeNode>			   FlatNodes;					// flat nodes in breadth first order
+						std::vector<uint32_t>					   FlatStack;					// stack for flat traversal
+						std::vector<unsigned int>				   FlatVisible;					// frustum culling results for flat nodes
+						std::vector<float>						   FlatCenterX;					// soa bounding box centers
+						std::vector<float>						   FlatCenterY;
+						std::vector<float>						   FlatCenterZ;
+						std::vector<float>						   FlatExtentX;					// soa bounding box half extents
+						std::vector<float>						   FlatExtentY;
+						std::vector<float>						   FlatExtentZ;
+						std::vector<float>						   FlatMinX;					// soa bounding box min and max
+						std::vector<float>						   FlatMinY;
+						std::vector<float>						   FlatMinZ;
+						std::vector<float>						   FlatMaxX;
+						std::vector<float>						   FlatMaxY;
+						std::vector<float>						   FlatMaxZ;
+						std::vector<ScratchBuffers>				   Scratch;						// per thread scratch buffers
+						std::unordered_map<OctTreeNode*, PendingNode> PendingNodes;			// nodes data computed by the parallel build
+						std::mutex								   PendingNodesMutex;
+						std::vector<float>						   LeafVertexData;				// retained leaf positions, used to write the cache
+						std::vector<float>						   LeafNormalData;				// retained leaf normals
+						std::vector<unsigned int>				   LeafIndexData;				// retained leaf indices
+						std::unordered_map<int, LeafRange>		   LeafRanges;					// leaf data ranges, keyed by node id
+						uint64_t								   SourceHash;					// hash of the source mesh
+						float									   BuildTime;					// last compilation time in milliseconds
+						std::vector<glm::vec3>					   RayVertices;					// map mesh triangles, 3 vertices per triangle, for ray queries
+						std::vector<glm::vec3>					   RayNormals;					// map mesh triangle normals
+						std::vector<uint32_t>					   LeafTriangles;				// triangle ids of childless nodes
+						std::vector<TriangleRange>				   LeafTriangleRanges;			// leaf triangle ranges, indexed by node id
+						std::vector<MeshletCommand>				   MeshletCommands;				// draw commands for the meshlets surviving culling
+						GLuint									   IndirectBufferObject;		// draw indirect buffer holding the meshlet commands
+						bool									   MeshletCommandsDirty;		// commands changed since last upload
+						size_t									   RenderedSurfacesCount;		// surfaces in rendered leaves
+						size_t									   SubmittedSurfacesCount;		// surfaces in meshlets surviving culling
 
 						// ----------------------------------------------------------------
 						// octree node position identifiers
@@ -443,9 +745,11 @@ namespace vml
 						// ----------------------------------------------------------------
 						// Iterates throigh the input list and check if triangle is 
 						// inside or interseting the bounding box, if so , put 
-						// int he destination list
+						// int he destination list, destination list is cleared first
 
-						std::vector<vml::geo3d::IndexedTriangle> CheckTrianglesInNode(OctTreeNode* node, const std::vector<vml::geo3d::IndexedTriangle>& surfaceindices) const
+						void CheckTrianglesInNode(OctTreeNode* node, 
+												  const std::vector<vml::geo3d::IndexedTriangle>& surfaceindices,
+												  std::vector<vml::geo3d::IndexedTriangle>& destsurfaceindices) const
 						{
 							const glm::vec3& bmin = node->GetBoundingBox().GetMin() - BoundingBoxEps;
 							const glm::vec3& bmax = node->GetBoundingBox().GetMax() + BoundingBoxEps;
@@ -453,7 +757,7 @@ namespace vml
 							// enlarge bounding box to clip triangles
 							// very near to bouding box faces
 
-							std::vector<vml::geo3d::IndexedTriangle> destsurfaceindices;
+							destsurfaceindices.clear();
 
 							for (int i = 0; i < surfaceindices.size(); ++i)
 							{
@@ -483,17 +787,20 @@ namespace vml
 								}
 
 							}
-							return destsurfaceindices;
 						}
 												
 						// ----------------------------------------------------------------
-						//
-
-						bool CreateNode(OctTreeNode* node, const std::vector<vml::geo3d::IndexedTriangle>& surfaceindices)
+						// clips triangles against node's bounding box and removes 
+						// redundant vertices, returns false if there is no data left,
+						// destination arrays are cleared first
+
+						bool ClipTrianglesInNode(OctTreeNode* node, 
+												 const std::vector<vml::geo3d::IndexedTriangle>& surfaceindices,
+												 std::vector<vml::geo3d::Vertex>& destvertexarray,
+												 std::vector<vml::geo3d::IndexedTriangle>& destsurfacearray) const
 						{
-							
-							std::vector<vml::geo3d::Vertex>	 destvertexarray;
-							std::vector<vml::geo3d::IndexedTriangle> destsurfacearray;
+							destvertexarray.clear();
+							destsurfacearray.clear();
 
 							for (int i = 0; i < surfaceindices.size(); ++i)
 							{
@@ -516,9 +823,9 @@ namespace vml
 									destvertexarray.emplace_back(VertexArray[i2]);
 
 									destsurfacearray.emplace_back(vml::geo3d::IndexedTriangle((int)destsurfacearray.size(),
-																					          (int)destvertexarray.size() - 3,
-																						      (int)destvertexarray.size() - 2,
-																						      (int)destvertexarray.size() - 1));
+																							  (int)destvertexarray.size() - 3,
+																							  (int)destvertexarray.size() - 2,
+																							  (int)destvertexarray.size() - 1));
 								}
 
 								if (result == vml::geo3d::Results::DOES_INTERSECT)
@@ -537,21 +844,31 @@ namespace vml
 								}
 							}
 
-							// remove redundant vertices and creates arenderable node
-							// if there is no dta, node will be an empty leaf and 
-							// will be flagged as non leaf
+							// remove redundant vertices, if there is no data,
+							// node will be an empty leaf and will be flagged as non leaf
 
 							if (destvertexarray.size() != 0 && destsurfacearray.size() != 0)
 							{
-
 								vml::meshes::RemoveDuplicates3D rd;
 								rd.Begin(node->GetBoundingBox().GetMin(), node->GetBoundingBox().GetMax());
 								rd.RemoveDuplicates(destvertexarray, destsurfacearray);
 								rd.Finalize();
+								return true;
+							}
 
+							return false;
+						}
+
+						// ----------------------------------------------------------------
+						// creates a renderable node
+
+						bool CreateNode(OctTreeNode* node, const std::vector<vml::geo3d::IndexedTriangle>& surfaceindices, ScratchBuffers& scratch)
+						{
+							if (ClipTrianglesInNode(node, surfaceindices, scratch.Vertices, scratch.Surfaces))
+							{
 								// create node vao
 	
-								node->CreateVAO(destvertexarray, destsurfacearray);
+								UploadLeaf(node, scratch.Vertices, scratch.Surfaces);
 
 								// se this node as leaf
 
@@ -563,30 +880,48 @@ namespace vml
 							return false;
 						}
 						
+						// ----------------------------------------------------------------
+						// scratch triangle lists are handed out in stack order, a list
+						// is released once the node's children are done with it
+
+						std::vector<vml::geo3d::IndexedTriangle>& AcquireList(ScratchBuffers& scratch) const
+						{
+							if (scratch.UsedLists == scratch.Lists.size())
+								scratch.Lists.emplace_back();
+							return scratch.Lists[scratch.UsedLists++];
+						}
+
+						void ReleaseList(ScratchBuffers& scratch) const
+						{
+							scratch.UsedLists--;
+						}
+
 						// ----------------------------------------------------------------
 						// recursicve function to split a node into further 8 children and
 						// add triangles if they intersects any of the previously split children
 
-						void RecurseNode(OctTreeNode* node, const std::vector<vml::geo3d::IndexedTriangle>& sourcelist)
+						void RecurseNode(OctTreeNode* node, const std::vector<vml::geo3d::IndexedTriangle>& sourcelist, ScratchBuffers& scratch)
 						{
 
-							std::vector<vml::geo3d::IndexedTriangle> destlist = CheckTrianglesInNode(node, sourcelist);
+							std::vector<vml::geo3d::IndexedTriangle>& destlist = AcquireList(scratch);
+							
+							CheckTrianglesInNode(node, sourcelist, destlist);
 
 							if (destlist.size() > MaxSurfaces)
 							{
 
-								std::vector<OctTreeNode*> nodes = SplitNode(node);
+								std::vector<OctTreeNode*> nodes = SplitNode(node, true);
 
 								std::cout << "Octree : Branch node, Surfaces in node " << destlist.size() << " recursing" << std::endl;
 
-								RecurseNode(nodes[0], destlist);
-								RecurseNode(nodes[1], destlist);
-								RecurseNode(nodes[2], destlist);
-								RecurseNode(nodes[3], destlist);
-								RecurseNode(nodes[4], destlist);
-								RecurseNode(nodes[5], destlist);
-								RecurseNode(nodes[6], destlist);
-								RecurseNode(nodes[7], destlist);
+								RecurseNode(nodes[0], destlist, scratch);
+								RecurseNode(nodes[1], destlist, scratch);
+								RecurseNode(nodes[2], destlist, scratch);
+								RecurseNode(nodes[3], destlist, scratch);
+								RecurseNode(nodes[4], destlist, scratch);
+								RecurseNode(nodes[5], destlist, scratch);
+								RecurseNode(nodes[6], destlist, scratch);
+								RecurseNode(nodes[7], destlist, scratch);
 
 							}
 							else
@@ -598,7 +933,9 @@ namespace vml
 							
 									std::cout << "Octree : Leaf node, Surfaces in node " << destlist.size() << std::endl;
 
-									if (CreateNode(node, destlist))
+									AddLeafTriangles(node, destlist);
+
+									if (CreateNode(node, destlist, scratch))
 									{
 										LeafNodes++;
 									}
@@ -606,177 +943,1018 @@ namespace vml
 
 							}
 
-						}
-						
-						// ----------------------------------------------------------------
-						//
-
-						OctTreeNode* AddBox(OctTreeNode* parent, int i, const glm::vec3& min, const glm::vec3& max)
-						{
-							OctTreeNode* node = new OctTreeNode(parent, (int)OctTreeNodes.size(), min, max);
-							parent->SetChild(i, node);
-							OctTreeNodes.emplace_back(node);
-							return node;
+							ReleaseList(scratch);
 						}
 
 						// ----------------------------------------------------------------
-						//
+						// parallel version of RecurseNode, children subtrees are split into
+						// tasks, gl calls can't be issued from worker threads, so
+						// clipped geometry is stored and vaos are created by FinalizeNode,
+						// node ids are assigned there too, following the serial order
 
-						std::vector<OctTreeNode*> SplitNode(OctTreeNode* node)
+						void RecurseNodeParallel(vml::os::ThreadPool* pool, OctTreeNode* node, const std::vector<vml::geo3d::IndexedTriangle>& sourcelist)
 						{
-							glm::vec3 bMin   = node->GetBoundingBox().GetMin();
-							float halfWidth  = node->GetBoundingBox().GetHalfExtents().x;
-							float halfHeight = node->GetBoundingBox().GetHalfExtents().y;
-							float halfDepth  = node->GetBoundingBox().GetHalfExtents().z;
-							
-							std::vector<OctTreeNode*> nodes;
-							
-							// far bottom left node
+							ScratchBuffers& scratch = Scratch[pool->GetThreadIndex()];
 
-							nodes.emplace_back(AddBox(node, FAR_BOTTOM_LEFT_NODE, bMin, bMin + glm::vec3(halfWidth, halfHeight, halfDepth)));
+							std::vector<vml::geo3d::IndexedTriangle>& destlist = AcquireList(scratch);
 
-							// far bottom right node
-
-							nodes.emplace_back(AddBox(node, FAR_BOTTOM_RIGHT_NODE, bMin + glm::vec3(halfWidth, 0, 0), bMin + glm::vec3(2 * halfWidth, halfHeight, halfDepth)));
-
-							// far top right node
+							CheckTrianglesInNode(node, sourcelist, destlist);
 
-							nodes.emplace_back(AddBox(node, FAR_TOP_RIGHT_NODE, bMin + glm::vec3(halfWidth, halfHeight, 0), bMin + glm::vec3(2 * halfWidth, 2 * halfHeight, halfDepth)));
+							if (destlist.size() > MaxSurfaces)
+							{
+								AddPendingNode(node, destlist.size());
 
-							// far top left node
+								std::vector<OctTreeNode*> nodes = SplitNode(node, false);
 
-							nodes.emplace_back(AddBox(node, FAR_TOP_LEFT_NODE, bMin + glm::vec3(0, halfHeight, 0), bMin + glm::vec3(halfWidth, 2 * halfHeight, halfDepth)));
+								std::atomic<int> counter = 0;
 
-							// near bottom left node
+								for (size_t i = 0; i < nodes.size(); ++i)
+								{
+									OctTreeNode* child = nodes[i];
+									pool->Submit([this, pool, child, &destlist]() { RecurseNodeParallel(pool, child, destlist); }, &counter);
+								}
 
-							nodes.emplace_back(AddBox(node, NEAR_BOTTOM_LEFT_NODE, bMin + glm::vec3(0, 0, halfDepth), bMin + glm::vec3(halfWidth, halfHeight, 2 * halfDepth)));
+								// children read the destination list, wait for them before releasing it
 
-							// near bottom right node
+								pool->Wait(counter);
+							}
+							else
+							{
+								if (destlist.size() > 0)
+								{
+									PendingNode& pending = AddPendingNode(node, destlist.size());
 
-							nodes.emplace_back(AddBox(node, NEAR_BOTTOM_RIGHT_NODE, bMin + glm::vec3(halfWidth, 0, halfDepth), bMin + glm::vec3(2 * halfWidth, halfHeight, 2 * halfDepth)));
+									if (vml::utils::bits32::Get(Flags, RAY_QUERIES))
+									{
+										pending.Triangles.resize(destlist.size());
+										for (size_t i = 0; i < destlist.size(); ++i)
+											pending.Triangles[i] = (uint32_t)destlist[i].I0 / 3;
+									}
 
-							// near top right node
+									if (ClipTrianglesInNode(node, destlist, scratch.Vertices, scratch.Surfaces))
+									{
+										pending.Vertices = scratch.Vertices;
+										pending.Surfaces = scratch.Surfaces;
+										pending.Leaf	 = true;
+									}
+								}
+							}
 
-							nodes.emplace_back(AddBox(node, NEAR_TOP_RIGHT_NODE, bMin + glm::vec3(halfWidth, halfHeight, halfDepth), bMin + glm::vec3(2 * halfWidth, 2 * halfHeight, 2 * halfDepth)));
+							ReleaseList(scratch);
+						}
 
-							// near top left node
+						// ----------------------------------------------------------------
+						// stores build data for a node, map elements never move,
+						// so the returned reference stays valid while other threads insert
 
-							nodes.emplace_back(AddBox(node, NEAR_TOP_LEFT_NODE, bMin + glm::vec3(0, halfHeight, halfDepth), bMin + glm::vec3(halfWidth, 2 * halfHeight, 2 * halfDepth)));
-							
-							return nodes;
+						PendingNode& AddPendingNode(OctTreeNode* node, size_t surfacescount)
+						{
+							std::lock_guard<std::mutex> lock(PendingNodesMutex);
+							PendingNode& pending = PendingNodes[node];
+							pending.SurfacesCount = surfacescount;
+							pending.Leaf		  = false;
+							return pending;
 						}
-						
+
 						// ----------------------------------------------------------------
-						// allocate data for breadth-first traversal
+						// walks the tree built in parallel in the same order as
+						// the serial build, assigns ids and creates vaos
 
-						void CreateStack()
+						void FinalizeNode(OctTreeNode* node)
 						{
-							
-							size_t n = OctTreeNodes.size();
-							
-							if (n < 1)
-								vml::os::Message::Error("Octree : ","Cannot create stack");
+							auto it = PendingNodes.find(node);
 
-							// allocate stack
+							// node had no triangles
 
-							Stack = new OctTreeNode *[n];
+							if (it == PendingNodes.end())
+								return;
 
-							StackCounter = 0;
+							PendingNode& pending = it->second;
 
-							for (size_t i = 0; i < n; ++i)
-								Stack[i] = nullptr;
+							if (node->GetChild(0))
+							{
+								std::cout << "Octree : Branch node, Surfaces in node " << pending.SurfacesCount << " recursing" << std::endl;
 
-							// allocate space for rednered nodes
+								for (size_t i = 0; i < 8; ++i)
+								{
+									node->GetChild(i)->SetId((int)OctTreeNodes.size());
+									OctTreeNodes.emplace_back(node->GetChild(i));
+								}
 
-							RenderedNodes = new OctTreeNode *[n];
+								for (size_t i = 0; i < 8; ++i)
+									FinalizeNode(node->GetChild(i));
+							}
+							else
+							{
+								std::cout << "Octree : Leaf node, Surfaces in node " << pending.SurfacesCount << std::endl;
 
-							RenderedNodesCount = 0;
+								if (vml::utils::bits32::Get(Flags, RAY_QUERIES))
+								{
+									TriangleRange& range = GetLeafTriangleRange(node->GetId());
+									range.First = (uint32_t)LeafTriangles.size();
+									range.Count = (uint32_t)pending.Triangles.size();
+									LeafTriangles.insert(LeafTriangles.end(), pending.Triangles.begin(), pending.Triangles.end());
+								}
 
-							for (size_t i = 0; i < n; ++i)
-								RenderedNodes[i] = nullptr;
+								if (pending.Leaf)
+								{
+									UploadLeaf(node, pending.Vertices, pending.Surfaces);
+									node->SetLeaf();
+									LeafNodes++;
+								}
+							}
 
-						}
+							// release build data
 
+							std::vector<vml::geo3d::Vertex>().swap(pending.Vertices);
+							std::vector<vml::geo3d::IndexedTriangle>().swap(pending.Surfaces);
+							std::vector<uint32_t>().swap(pending.Triangles);
+						}
+						
 						// ----------------------------------------------------------------
-						// clear data
+						// ray query data, triangles are copied from the map mesh, so
+						// triangle ids are the mesh surface indices
 
-						void ReleaseAll()
+						void CreateRayData(const vml::meshes::Mesh3d* mesh)
 						{
-							// release nodes
-
-							for (size_t i = 0; i < OctTreeNodes.size(); ++i)
-								vml::os::SafeDelete(OctTreeNodes[i]);
+							const std::vector<float>&		 vertexarray	= mesh->GetVertexArray();
+							const std::vector<unsigned int>& surfaceindices = mesh->GetSurfaceIndices();
 
-							// release stack
-
-							vml::os::SafeDeleteArray(Stack);
-							vml::os::SafeDeleteArray(RenderedNodes);
+							size_t triangles = surfaceindices.size() / 3;
 
-							// clear arrays
-
-							VertexArray.clear();
-							SurfaceIndices.clear();
-							OctTreeNodes.clear();
+							RayVertices.resize(triangles * 3);
+							RayNormals.resize(triangles);
 
-							// null data members
+							for (size_t i = 0; i < triangles; ++i)
+							{
+								for (size_t j = 0; j < 3; ++j)
+								{
+									size_t idx = (size_t)surfaceindices[i * 3 + j] * 4;
+									RayVertices[i * 3 + j] = glm::vec3(vertexarray[idx], vertexarray[idx + 1], vertexarray[idx + 2]);
+								}
 
-							Root		       = nullptr;
-							CurrentNode        = 0;
-							LeafNodes	       = 0;
-							StackCounter       = 0;
-							RenderedNodesCount = 0;
-							RenderedNodeRatio  = 0.0f;
+								glm::vec3 n = glm::cross(RayVertices[i * 3 + 1] - RayVertices[i * 3], RayVertices[i * 3 + 2] - RayVertices[i * 3]);
+								float length = glm::length(n);
+								RayNormals[i] = length > 0 ? n / length : glm::vec3(0, 0, 0);
+							}
 						}
-						
-					public:
-						
-						// ----------------------------------------------------------------
-						// getters
 
-						const OctTreeNode* GetRoot() const 
-						{
-							return Root; 
-						}
-						
-						size_t GetMaxSurfaces() const 
-						{
-							return MaxSurfaces; 
-						}
-						
-						size_t GetLeafNodesCount() const 
+						TriangleRange& GetLeafTriangleRange(int id)
 						{
-							return LeafNodes; 
-						}
-						
-						const OctTreeNode* GetCurrentNode() const 
-						{ 
-							return OctTreeNodes[CurrentNode]; 
+							if (LeafTriangleRanges.size() <= (size_t)id)
+								LeafTriangleRanges.resize((size_t)id + 1);
+							return LeafTriangleRanges[id];
 						}
 
-						void GetNextCurrentNode() 
-						{
-							int n = (int)OctTreeNodes.size() - 1;
-							CurrentNode++;
-							if (CurrentNode >= n) CurrentNode = n;
-						}
+						// ----------------------------------------------------------------
+						// stores the triangles of a childless node for ray queries,
+						// ConvertData lays out 3 vertices per source surface, so the
+						// surface index is the first vertex index divided by 3
 
-						void GetPrevCurrentNode()
+						void AddLeafTriangles(OctTreeNode* node, const std::vector<vml::geo3d::IndexedTriangle>& surfaceindices)
 						{
-							CurrentNode--;
-							if (CurrentNode <= 0) CurrentNode = 0;
+							if (!vml::utils::bits32::Get(Flags, RAY_QUERIES))
+								return;
+
+							TriangleRange& range = GetLeafTriangleRange(node->GetId());
+
+							range.First = (uint32_t)LeafTriangles.size();
+							range.Count = (uint32_t)surfaceindices.size();
+
+							for (size_t i = 0; i < surfaceindices.size(); ++i)
+								LeafTriangles.emplace_back((uint32_t)surfaceindices[i].I0 / 3);
 						}
 
-						size_t GetNodesCount() const
+						// ----------------------------------------------------------------
+						// slab test between a ray and a flat node bounding box, 
+						// invdir is the componentwise inverse of the ray direction,
+						// returns true if the box overlaps the ray in [tmin, tmax]
+
+						bool RayVsFlatNode(uint32_t idx, const glm::vec3& origin, const glm::vec3& invdir, float tmin, float tmax, float& tenter) const
 						{
-							return OctTreeNodes.size();
+							float t0 = (FlatMinX[idx] - origin.x) * invdir.x;
+							float t1 = (FlatMaxX[idx] - origin.x) * invdir.x;
+							if (t0 > t1) std::swap(t0, t1);
+							if (t0 > tmin) tmin = t0;
+							if (t1 < tmax) tmax = t1;
+
+							t0 = (FlatMinY[idx] - origin.y) * invdir.y;
+							t1 = (FlatMaxY[idx] - origin.y) * invdir.y;
+							if (t0 > t1) std::swap(t0, t1);
+							if (t0 > tmin) tmin = t0;
+							if (t1 < tmax) tmax = t1;
+
+							t0 = (FlatMinZ[idx] - origin.z) * invdir.z;
+							t1 = (FlatMaxZ[idx] - origin.z) * invdir.z;
+							if (t0 > t1) std::swap(t0, t1);
+							if (t0 > tmin) tmin = t0;
+							if (t1 < tmax) tmax = t1;
+
+							tenter = tmin;
+
+							return tmin <= tmax;
 						}
 
-						size_t GetRenderedNodesCount() const
+						// ----------------------------------------------------------------
+						// inverse ray direction, near zero components are clamped
+						// as done by the intersections tests
+
+						static glm::vec3 GetInverseDirection(const glm::vec3& direction, const float eps = vml::math::EPSILON)
 						{
-							return RenderedNodesCount;
+							glm::vec3 d = direction;
+							if (d.x > -eps && d.x < eps) d.x = eps;
+							if (d.y > -eps && d.y < eps) d.y = eps;
+							if (d.z > -eps && d.z < eps) d.z = eps;
+							return glm::vec3(1.0f / d.x, 1.0f / d.y, 1.0f / d.z);
 						}
 
-						OctTreeNode** GetRenderedNodes() const
+						// ----------------------------------------------------------------
+						// tests the triangles of a leaf against a ray, keeps the nearest hit
+
+						void RayVsLeaf(uint32_t idx, const OctTreeRay& ray, OctTreeRayHit& hit) const
+						{
+							uint32_t id = FlatNodes[idx].NodeIndex;
+
+							if (id >= LeafTriangleRanges.size())
+								return;
+
+							const TriangleRange& range = LeafTriangleRanges[id];
+
+							glm::vec3 end = ray.Origin + ray.Direction;
+							glm::vec3 p;
+							float	  t;
+
+							for (uint32_t i = range.First; i < range.First + range.Count; ++i)
+							{
+								uint32_t triangle = LeafTriangles[i];
+
+								const glm::vec3* v = &RayVertices[(size_t)triangle * 3];
+
+								if (vml::geo3d::intersections::TriangleVsRay(v[0], v[1], v[2], ray.Origin, end, p, t))
+								{
+									if (t >= 0 && t <= ray.MaxT && t < hit.T)
+									{
+										hit.T		 = t;
+										hit.Triangle = (int)triangle;
+										hit.Normal	 = RayNormals[triangle];
+									}
+								}
+							}
+						}
+
+						// ----------------------------------------------------------------
+						// pushes children of a flat node, farthest first, so nearest
+						// children are popped first, tenter holds the children entry
+						// parameters, children not hit have FLT_MAX
+
+						void PushChildren(const FlatOctTreeNode& flatnode, const float* tenter, std::vector<RayStackEntry>& stack) const
+						{
+							RayStackEntry entries[8];
+
+							uint32_t count = 0;
+
+							for (uint32_t i = 0; i < flatnode.ChildCount; ++i)
+							{
+								if (tenter[i] == FLT_MAX)
+									continue;
+
+								// insertion sort by decreasing entry parameter
+
+								uint32_t j = count++;
+
+								while (j > 0 && entries[j - 1].TEnter < tenter[i])
+								{
+									entries[j] = entries[j - 1];
+									j--;
+								}
+
+								entries[j].Node	  = flatnode.FirstChild + i;
+								entries[j].TEnter = tenter[i];
+							}
+
+							stack.insert(stack.end(), entries, entries + count);
+						}
+
+						// ----------------------------------------------------------------
+						// casts a single ray, leaves are visited front to back and
+						// nodes farther than the nearest hit are skipped
+
+						void CastRay(const OctTreeRay& ray, OctTreeRayHit& hit, std::vector<RayStackEntry>& stack) const
+						{
+							hit = OctTreeRayHit();
+
+							if (FlatNodes.empty())
+								return;
+
+							glm::vec3 invdir = GetInverseDirection(ray.Direction);
+
+							float tenter;
+
+							if (!RayVsFlatNode(0, ray.Origin, invdir, 0, ray.MaxT, tenter))
+								return;
+
+							stack.clear();
+							stack.push_back({ 0, tenter });
+
+							while (!stack.empty())
+							{
+								RayStackEntry entry = stack.back();
+								stack.pop_back();
+
+								if (entry.TEnter > hit.T)
+									continue;
+
+								const FlatOctTreeNode& flatnode = FlatNodes[entry.Node];
+
+								if (flatnode.ChildCount == 0)
+								{
+									RayVsLeaf(entry.Node, ray, hit);
+									continue;
+								}
+
+								float childtenter[8];
+
+								for (uint32_t i = 0; i < flatnode.ChildCount; ++i)
+								{
+									float tmax = hit.T < ray.MaxT ? hit.T : ray.MaxT;
+
+									if (!RayVsFlatNode(flatnode.FirstChild + i, ray.Origin, invdir, 0, tmax, childtenter[i]))
+										childtenter[i] = FLT_MAX;
+								}
+
+								PushChildren(flatnode, childtenter, stack);
+							}
+						}
+
+						// ----------------------------------------------------------------
+						// casts a packet of coherent rays, the packet walks the tree once,
+						// a node is visited if any ray in the packet reaches it before
+						// its own nearest hit, children are ordered by their nearest
+						// entry among the packet rays
+
+						void CastRayPacket(const OctTreeRay* rays, OctTreeRayHit* hits, size_t count, std::vector<RayStackEntry>& stack) const
+						{
+							glm::vec3 invdir[RAY_PACKET_SIZE];
+
+							for (size_t i = 0; i < count; ++i)
+							{
+								hits[i]	  = OctTreeRayHit();
+								invdir[i] = GetInverseDirection(rays[i].Direction);
+							}
+
+							if (FlatNodes.empty())
+								return;
+
+							stack.clear();
+							stack.push_back({ 0, 0 });
+
+							while (!stack.empty())
+							{
+								RayStackEntry entry = stack.back();
+								stack.pop_back();
+
+								// find rays which still reach the node
+
+								bool active[RAY_PACKET_SIZE];
+								bool any = false;
+
+								for (size_t i = 0; i < count; ++i)
+								{
+									float tenter;
+									float tmax = hits[i].T < rays[i].MaxT ? hits[i].T : rays[i].MaxT;
+									active[i]  = RayVsFlatNode(entry.Node, rays[i].Origin, invdir[i], 0, tmax, tenter);
+									any		  |= active[i];
+								}
+
+								if (!any)
+									continue;
+
+								const FlatOctTreeNode& flatnode = FlatNodes[entry.Node];
+
+								if (flatnode.ChildCount == 0)
+								{
+									for (size_t i = 0; i < count; ++i)
+										if (active[i])
+											RayVsLeaf(entry.Node, rays[i], hits[i]);
+									continue;
+								}
+
+								float childtenter[8];
+
+								for (uint32_t j = 0; j < flatnode.ChildCount; ++j)
+								{
+									childtenter[j] = FLT_MAX;
+
+									for (size_t i = 0; i < count; ++i)
+									{
+										if (!active[i])
+											continue;
+
+										float tenter;
+										float tmax = hits[i].T < rays[i].MaxT ? hits[i].T : rays[i].MaxT;
+
+										if (RayVsFlatNode(flatnode.FirstChild + j, rays[i].Origin, invdir[i], 0, tmax, tenter) && tenter < childtenter[j])
+											childtenter[j] = tenter;
+									}
+								}
+
+								PushChildren(flatnode, childtenter, stack);
+							}
+						}
+
+						// ----------------------------------------------------------------
+						// casts rays in [first, last), in packets or one by one
+
+						void CastRayRange(const OctTreeRay* rays, OctTreeRayHit* hits, size_t first, size_t last, bool packets) const
+						{
+							std::vector<RayStackEntry> stack;
+
+							stack.reserve(64);
+
+							if (packets)
+							{
+								for (size_t i = first; i < last; i += RAY_PACKET_SIZE)
+								{
+									size_t count = last - i < RAY_PACKET_SIZE ? last - i : RAY_PACKET_SIZE;
+									CastRayPacket(rays + i, hits + i, count, stack);
+								}
+							}
+							else
+							{
+								for (size_t i = first; i < last; ++i)
+									CastRay(rays[i], hits[i], stack);
+							}
+						}
+
+						// ----------------------------------------------------------------
+						// casts a batch of rays, if a thread pool is given, the batch
+						// is split in tasks and this function waits for them
+
+						void CastRayBatch(const std::vector<OctTreeRay>& rays, std::vector<OctTreeRayHit>& hits, vml::os::ThreadPool* pool, bool packets) const
+						{
+							if (!vml::utils::bits32::Get(Flags, RAY_QUERIES))
+								vml::os::Message::Error("Octree : ", "Ray queries need the RAY_QUERIES flag");
+
+							hits.resize(rays.size());
+
+							if (rays.empty())
+								return;
+
+							if (!pool || pool->GetWorkersCount() == 0 || rays.size() <= RAY_BATCH_SIZE)
+							{
+								CastRayRange(rays.data(), hits.data(), 0, rays.size(), packets);
+								return;
+							}
+
+							std::atomic<int> counter = 0;
+
+							for (size_t i = 0; i < rays.size(); i += RAY_BATCH_SIZE)
+							{
+								size_t first = i;
+								size_t last  = i + RAY_BATCH_SIZE < rays.size() ? i + RAY_BATCH_SIZE : rays.size();
+
+								pool->Submit([this, &rays, &hits, first, last, packets]() { CastRayRange(rays.data(), hits.data(), first, last, packets); }, &counter);
+							}
+
+							pool->Wait(counter);
+						}
+
+						// ----------------------------------------------------------------
+						// creates the node vao, if leaf data must be cached, converted
+						// arrays are retained and the vao is created from them
+
+						void UploadLeaf(OctTreeNode* node, const std::vector<vml::geo3d::Vertex>& vertices, const std::vector<vml::geo3d::IndexedTriangle>& surfaces)
+						{
+							bool meshlets = vml::utils::bits32::Get(Flags, MESHLETS);
+
+							if (!vml::utils::bits32::Get(Flags, CACHE_LEAF_DATA))
+							{
+								node->CreateVAO(vertices, surfaces, meshlets);
+								return;
+							}
+
+							LeafRange range;
+
+							range.FirstVertex   = (uint32_t)(LeafNormalData.size() / 3);
+							range.VerticesCount = (uint32_t)vertices.size();
+							range.FirstIndex    = (uint32_t)LeafIndexData.size();
+							range.IndicesCount  = (uint32_t)surfaces.size() * 3;
+
+							for (size_t i = 0; i < vertices.size(); ++i)
+							{
+								LeafVertexData.emplace_back(vertices[i].Pos.x);
+								LeafVertexData.emplace_back(vertices[i].Pos.y);
+								LeafVertexData.emplace_back(vertices[i].Pos.z);
+								LeafVertexData.emplace_back(1);
+
+								LeafNormalData.emplace_back(vertices[i].Normal.x);
+								LeafNormalData.emplace_back(vertices[i].Normal.y);
+								LeafNormalData.emplace_back(vertices[i].Normal.z);
+							}
+
+							for (size_t i = 0; i < surfaces.size(); ++i)
+							{
+								LeafIndexData.emplace_back(surfaces[i].I0);
+								LeafIndexData.emplace_back(surfaces[i].I1);
+								LeafIndexData.emplace_back(surfaces[i].I2);
+							}
+
+							node->CreateVAO(&LeafVertexData[range.FirstVertex * 4], 
+											&LeafNormalData[range.FirstVertex * 3], range.VerticesCount, 
+											&LeafIndexData[range.FirstIndex], range.IndicesCount, meshlets);
+
+							LeafRanges[node->GetId()] = range;
+						}
+
+						// ----------------------------------------------------------------
+						// release retained leaf data
+
+						void ReleaseLeafData()
+						{
+							std::vector<float>().swap(LeafVertexData);
+							std::vector<float>().swap(LeafNormalData);
+							std::vector<unsigned int>().swap(LeafIndexData);
+							LeafRanges.clear();
+						}
+
+						// ----------------------------------------------------------------
+						// hashes the mesh arrays the octree is compiled from
+
+						static uint64_t ComputeSourceHash(const vml::meshes::Mesh3d* mesh)
+						{
+							uint32_t version = CACHE_VERSION;
+							uint64_t hash	 = vml::utils::hash::Fnv1a64(&version, sizeof(version));
+							hash = vml::utils::hash::Fnv1a64(mesh->GetVertexArray(), hash);
+							hash = vml::utils::hash::Fnv1a64(mesh->GetNormalArray(), hash);
+							hash = vml::utils::hash::Fnv1a64(mesh->GetUVArray(), hash);
+							hash = vml::utils::hash::Fnv1a64(mesh->GetSurfaceIndices(), hash);
+							return hash;
+						}
+
+						// ----------------------------------------------------------------
+						// rounds a cache file offset up to 16 bytes
+
+						static uint64_t AlignCacheOffset(uint64_t offset)
+						{
+							return (offset + 15) & ~(uint64_t)15;
+						}
+
+						// ----------------------------------------------------------------
+						// writes zeroes up to the given file offset, returns false on write error
+
+						static bool PadCacheFile(FILE* stream, uint64_t& position, uint64_t offset)
+						{
+							static const unsigned char zeroes[16] = { 0 };
+							size_t count = offset > position ? (size_t)(offset - position) : 0;
+							position = offset;
+							return fwrite(zeroes, 1, count, stream) == count;
+						}
+
+						// ----------------------------------------------------------------
+						// creates a child node, if registernode is false, node isn't
+						// added to the node list and its id is assigned later
+
+						OctTreeNode* AddBox(OctTreeNode* parent, int i, const glm::vec3& min, const glm::vec3& max, bool registernode)
+						{
+							if (!registernode)
+							{
+								OctTreeNode* node = new OctTreeNode(parent, -1, min, max);
+								parent->SetChild(i, node);
+								return node;
+							}
+
+							OctTreeNode* node = new OctTreeNode(parent, (int)OctTreeNodes.size(), min, max);
+							parent->SetChild(i, node);
+							OctTreeNodes.emplace_back(node);
+							return node;
+						}
+
+						// ----------------------------------------------------------------
+						//
+
+						std::vector<OctTreeNode*> SplitNode(OctTreeNode* node, bool registernodes)
+						{
+							glm::vec3 bMin   = node->GetBoundingBox().GetMin();
+							float halfWidth  = node->GetBoundingBox().GetHalfExtents().x;
+							float halfHeight = node->GetBoundingBox().GetHalfExtents().y;
+							float halfDepth  = node->GetBoundingBox().GetHalfExtents().z;
+							
+							std::vector<OctTreeNode*> nodes;
+							
+							// far bottom left node
+
+							nodes.emplace_back(AddBox(node, FAR_BOTTOM_LEFT_NODE, bMin, bMin + glm::vec3(halfWidth, halfHeight, halfDepth), registernodes));
+
+							// far bottom right node
+
+							nodes.emplace_back(AddBox(node, FAR_BOTTOM_RIGHT_NODE, bMin + glm::vec3(halfWidth, 0, 0), bMin + glm::vec3(2 * halfWidth, halfHeight, halfDepth), registernodes));
+
+							// far top right node
+
+							nodes.emplace_back(AddBox(node, FAR_TOP_RIGHT_NODE, bMin + glm::vec3(halfWidth, halfHeight, 0), bMin + glm::vec3(2 * halfWidth, 2 * halfHeight, halfDepth), registernodes));
+
+							// far top left node
+
+							nodes.emplace_back(AddBox(node, FAR_TOP_LEFT_NODE, bMin + glm::vec3(0, halfHeight, 0), bMin + glm::vec3(halfWidth, 2 * halfHeight, halfDepth), registernodes));
+
+							// near bottom left node
+
+							nodes.emplace_back(AddBox(node, NEAR_BOTTOM_LEFT_NODE, bMin + glm::vec3(0, 0, halfDepth), bMin + glm::vec3(halfWidth, halfHeight, 2 * halfDepth), registernodes));
+
+							// near bottom right node
+
+							nodes.emplace_back(AddBox(node, NEAR_BOTTOM_RIGHT_NODE, bMin + glm::vec3(halfWidth, 0, halfDepth), bMin + glm::vec3(2 * halfWidth, halfHeight, 2 * halfDepth), registernodes));
+
+							// near top right node
+
+							nodes.emplace_back(AddBox(node, NEAR_TOP_RIGHT_NODE, bMin + glm::vec3(halfWidth, halfHeight, halfDepth), bMin + glm::vec3(2 * halfWidth, 2 * halfHeight, 2 * halfDepth), registernodes));
+
+							// near top left node
+
+							nodes.emplace_back(AddBox(node, NEAR_TOP_LEFT_NODE, bMin + glm::vec3(0, halfHeight, halfDepth), bMin + glm::vec3(halfWidth, 2 * halfHeight, 2 * halfDepth), registernodes));
+							
+							return nodes;
+						}
+						
+						// ----------------------------------------------------------------
+						// allocate data for breadth-first traversal
+
+						void CreateStack()
+						{
+							
+							size_t n = OctTreeNodes.size();
+							
+							if (n < 1)
+								vml::os::Message::Error("Octree : ","Cannot create stack");
+
+							// allocate stack
+
+							Stack = new OctTreeNode *[n];
+
+							StackCounter = 0;
+
+							for (size_t i = 0; i < n; ++i)
+								Stack[i] = nullptr;
+
+							// allocate space for rednered nodes
+
+							RenderedNodes = new OctTreeNode *[n];
+
+							RenderedNodesCount = 0;
+
+							for (size_t i = 0; i < n; ++i)
+								RenderedNodes[i] = nullptr;
+
+						}
+
+						// ----------------------------------------------------------------
+						// packs nodes into a contiguous array in breadth first order,
+						// children are referenced by index and bounding boxes are
+						// stored in separate soa arrays, this layout is walked by
+						// transform and queries when the FLAT_LAYOUT flag is set
+
+						void CreateFlatLayout()
+						{
+							size_t n = OctTreeNodes.size();
+
+							if (n < 1)
+								vml::os::Message::Error("Octree : ", "Cannot create flat layout");
+
+							// breadth first queue, once complete it holds nodes in flat order
+
+							std::vector<OctTreeNode*> queue;
+
+							queue.reserve(n);
+							queue.emplace_back(Root);
+
+							FlatNodes.clear();
+							FlatNodes.reserve(n);
+
+							for (size_t i = 0; i < queue.size(); ++i)
+							{
+								OctTreeNode* node = queue[i];
+
+								FlatOctTreeNode flatnode;
+
+								flatnode.FirstChild = (uint32_t)queue.size();
+								flatnode.ChildCount = 0;
+								flatnode.NodeIndex  = (uint32_t)node->GetId();
+								flatnode.Leaf       = node->IsLeaf() ? 1 : 0;
+
+								// siblings are queued together, so they end up contiguous
+
+								if (!node->IsLeaf())
+								{
+									for (size_t j = 0; j < 8; ++j)
+									{
+										if (node->GetChild(j))
+										{
+											queue.emplace_back(node->GetChild(j));
+											flatnode.ChildCount++;
+										}
+									}
+								}
+
+								FlatNodes.emplace_back(flatnode);
+							}
+
+							// allocate soa arrays
+
+							FlatCenterX.resize(n); FlatCenterY.resize(n); FlatCenterZ.resize(n);
+							FlatExtentX.resize(n); FlatExtentY.resize(n); FlatExtentZ.resize(n);
+							FlatMinX.resize(n);    FlatMinY.resize(n);    FlatMinZ.resize(n);
+							FlatMaxX.resize(n);    FlatMaxY.resize(n);    FlatMaxZ.resize(n);
+
+							for (size_t i = 0; i < n; ++i)
+							{
+								const vml::geo3d::AABBox& boundingbox = queue[i]->GetBoundingBox();
+
+								FlatCenterX[i] = boundingbox.GetCenter().x;
+								FlatCenterY[i] = boundingbox.GetCenter().y;
+								FlatCenterZ[i] = boundingbox.GetCenter().z;
+								FlatExtentX[i] = boundingbox.GetHalfExtents().x;
+								FlatExtentY[i] = boundingbox.GetHalfExtents().y;
+								FlatExtentZ[i] = boundingbox.GetHalfExtents().z;
+								FlatMinX[i]	   = boundingbox.GetMin().x;
+								FlatMinY[i]	   = boundingbox.GetMin().y;
+								FlatMinZ[i]	   = boundingbox.GetMin().z;
+								FlatMaxX[i]	   = boundingbox.GetMax().x;
+								FlatMaxY[i]	   = boundingbox.GetMax().y;
+								FlatMaxZ[i]	   = boundingbox.GetMax().z;
+							}
+
+							// allocate flat stack and culling results
+
+							FlatStack.resize(n);
+							FlatVisible.resize(n);
+						}
+
+						// ----------------------------------------------------------------
+						// culls the pointer based tree, fills the rendered nodes
+						// array and returns the number of visited nodes
+
+						size_t CullPointerTree(const glm::vec4* planes)
+						{
+							Stack[0] = Root;
+
+							StackCounter = 1;
+
+							RenderedNodesCount = 0;
+
+							for (size_t i = 0; i < StackCounter; ++i)
+							{
+
+								if (Stack[i]->TestAABBox(planes) != OctTreeNode::OUTSIDE)
+								{
+									if (Stack[i]->IsLeaf())
+									{
+										RenderedNodes[RenderedNodesCount++] = Stack[i];
+									}
+									else
+									{
+										if (Stack[i]->GetChild(0)) Stack[StackCounter++] = Stack[i]->GetChild(0);
+										if (Stack[i]->GetChild(1)) Stack[StackCounter++] = Stack[i]->GetChild(1);
+										if (Stack[i]->GetChild(2)) Stack[StackCounter++] = Stack[i]->GetChild(2);
+										if (Stack[i]->GetChild(3)) Stack[StackCounter++] = Stack[i]->GetChild(3);
+										if (Stack[i]->GetChild(4)) Stack[StackCounter++] = Stack[i]->GetChild(4);
+										if (Stack[i]->GetChild(5)) Stack[StackCounter++] = Stack[i]->GetChild(5);
+										if (Stack[i]->GetChild(6)) Stack[StackCounter++] = Stack[i]->GetChild(6);
+										if (Stack[i]->GetChild(7)) Stack[StackCounter++] = Stack[i]->GetChild(7);
+									}
+								}
+							}
+
+							return StackCounter;
+						}
+
+						// ----------------------------------------------------------------
+						// culls the flat layout, only rendered leaves are dereferenced,
+						// siblings are contiguous in the soa arrays, so children of a
+						// visible node are culled as a batch, returns the number of
+						// tested nodes
+
+						size_t CullFlatTree(const glm::vec4* planes)
+						{
+							uint32_t*	  stack	  = FlatStack.data();
+							unsigned int* visible = FlatVisible.data();
+
+							size_t stackcounter = 0;
+							size_t tested		= 1;
+
+							RenderedNodesCount = 0;
+
+							// test root node
+
+							vml::views::frustum::BatchCuller::Cull(planes,
+																   &FlatCenterX[0], &FlatCenterY[0], &FlatCenterZ[0],
+																   &FlatExtentX[0], &FlatExtentY[0], &FlatExtentZ[0],
+																   1, visible);
+
+							if (visible[0] != OctTreeNode::OUTSIDE)
+								stack[stackcounter++] = 0;
+
+							for (size_t i = 0; i < stackcounter; ++i)
+							{
+								const FlatOctTreeNode& flatnode = FlatNodes[stack[i]];
+
+								if (flatnode.Leaf)
+								{
+									OctTreeNode* node = OctTreeNodes[flatnode.NodeIndex];
+									node->SetVisibleFlag(visible[stack[i]]);
+									RenderedNodes[RenderedNodesCount++] = node;
+								}
+								else if (flatnode.ChildCount > 0)
+								{
+									uint32_t first = flatnode.FirstChild;
+
+									vml::views::frustum::BatchCuller::Cull(planes,
+																		   &FlatCenterX[first], &FlatCenterY[first], &FlatCenterZ[first],
+																		   &FlatExtentX[first], &FlatExtentY[first], &FlatExtentZ[first],
+																		   flatnode.ChildCount, &visible[first]);
+
+									tested += flatnode.ChildCount;
+
+									for (uint32_t j = 0; j < flatnode.ChildCount; ++j)
+										if (visible[first + j] != OctTreeNode::OUTSIDE)
+											stack[stackcounter++] = first + j;
+								}
+							}
+
+							return tested;
+						}
+
+						// ----------------------------------------------------------------
+						// culls the meshlets of rendered leaves against the frustum and
+						// their normal cones against the camera position, surviving
+						// meshlets become draw commands, contiguous ones are merged,
+						// meshlets of leaves fully inside the frustum skip the sphere test
+
+						void CullMeshlets(vml::views::View* view)
+						{
+							const glm::vec4* planes = view->GetFrustumPlanes();
+							const glm::vec3& eye	= view->GetPosition();
+
+							MeshletCommands.clear();
+
+							RenderedSurfacesCount  = 0;
+							SubmittedSurfacesCount = 0;
+
+							for (size_t i = 0; i < RenderedNodesCount; ++i)
+							{
+								OctTreeNode* node = RenderedNodes[i];
+
+								uint32_t first	= (uint32_t)MeshletCommands.size();
+								bool	 inside = node->IsVisible();
+
+								RenderedSurfacesCount += node->GetSurfacesCount();
+
+								for (const OctTreeNode::Meshlet& meshlet : node->GetMeshlets())
+								{
+									if (!inside && vml::views::frustum::TestSphere(planes, meshlet.Center, meshlet.Radius) == vml::views::frustum::OUTSIDE)
+										continue;
+
+									if (glm::dot(glm::normalize(meshlet.ConeApex - eye), meshlet.ConeAxis) >= meshlet.ConeCutoff)
+										continue;
+
+									SubmittedSurfacesCount += meshlet.IndicesCount / 3;
+
+									if (MeshletCommands.size() > first && MeshletCommands.back().FirstIndex + MeshletCommands.back().Count == meshlet.FirstIndex)
+									{
+										MeshletCommands.back().Count += meshlet.IndicesCount;
+										continue;
+									}
+
+									MeshletCommands.push_back({ meshlet.IndicesCount, 1, meshlet.FirstIndex, 0, 0 });
+								}
+
+								node->SetCommands(first, (uint32_t)MeshletCommands.size() - first);
+							}
+
+							MeshletCommandsDirty = true;
+						}
+
+						// ----------------------------------------------------------------
+						// clear data
+
+						void ReleaseAll()
+						{
+							// release nodes
+
+							for (size_t i = 0; i < OctTreeNodes.size(); ++i)
+								vml::os::SafeDelete(OctTreeNodes[i]);
+
+							// release stack
+
+							vml::os::SafeDeleteArray(Stack);
+							vml::os::SafeDeleteArray(RenderedNodes);
+
+							// clear arrays
+
+							VertexArray.clear();
+							SurfaceIndices.clear();
+							OctTreeNodes.clear();
+							FlatNodes.clear();
+							FlatStack.clear();
+							Scratch.clear();
+							PendingNodes.clear();
+							FlatVisible.clear();
+							FlatCenterX.clear(); FlatCenterY.clear(); FlatCenterZ.clear();
+							FlatExtentX.clear(); FlatExtentY.clear(); FlatExtentZ.clear();
+							FlatMinX.clear();    FlatMinY.clear();    FlatMinZ.clear();
+							FlatMaxX.clear();    FlatMaxY.clear();    FlatMaxZ.clear();
+							ReleaseLeafData();
+							RayVertices.clear();
+							RayNormals.clear();
+							LeafTriangles.clear();
+							LeafTriangleRanges.clear();
+							MeshletCommands.clear();
+
+							if (IndirectBufferObject) { glDeleteBuffers(1, &IndirectBufferObject); IndirectBufferObject = 0; }
+
+							// null data members
+
+							Root		       = nullptr;
+							CurrentNode        = 0;
+							LeafNodes	       = 0;
+							StackCounter       = 0;
+							RenderedNodesCount = 0;
+							RenderedNodeRatio  = 0.0f;
+							SourceHash		   = 0;
+							BuildTime		   = 0.0f;
+							MeshletCommandsDirty   = false;
+							RenderedSurfacesCount  = 0;
+							SubmittedSurfacesCount = 0;
+						}
+						
+					public:
+						
+						// ----------------------------------------------------------------
+						// compilation flags
+
+						static const unsigned int FLAT_LAYOUT		  = vml::utils::bits32::BIT0;	// traverse the flat node layout
+						static const unsigned int PARALLEL_BUILD	  = vml::utils::bits32::BIT1;	// compile subtrees on a thread pool
+						static const unsigned int DETERMINISTIC_BUILD = vml::utils::bits32::BIT2;	// run parallel build tasks in serial order on the calling thread
+						static const unsigned int CACHE_LEAF_DATA	  = vml::utils::bits32::BIT3;	// retain leaf data so the octree can be saved with SaveCache
+						static const unsigned int RAY_QUERIES		  = vml::utils::bits32::BIT4;	// retain map triangles for ray and segment queries
+						static const unsigned int MESHLETS			  = vml::utils::bits32::BIT5;	// split leaves into meshlets, culled per meshlet and drawn indirectly
+
+						// ----------------------------------------------------------------
+						// getters
+
+						const OctTreeNode* GetRoot() const 
+						{
+							return Root; 
+						}
+						
+						size_t GetMaxSurfaces() const 
+						{
+							return MaxSurfaces; 
+						}
+
+						float GetBuildTime() const
+						{
+							return BuildTime;
+						}
+
+						uint64_t GetSourceHash() const
+						{
+							return SourceHash;
+						}
+						
+						size_t GetLeafNodesCount() const 
+						{
+							return LeafNodes; 
+						}
+						
+						const OctTreeNode* GetCurrentNode() const 
+						{ 
+							return OctTreeNodes[CurrentNode]; 
+						}
+
+						void GetNextCurrentNode() 
+						{
+							int n = (int)OctTreeNodes.size() - 1;
+							CurrentNode++;
+							if (CurrentNode >= n) CurrentNode = n;
+						}
+
+						void GetPrevCurrentNode()
+						{
+							CurrentNode--;
+							if (CurrentNode <= 0) CurrentNode = 0;
+						}
+
+						size_t GetNodesCount() const
+						{
+							return OctTreeNodes.size();
+						}
+
+						size_t GetRenderedNodesCount() const
+						{
+							return RenderedNodesCount;
+						}
+
+						OctTreeNode** GetRenderedNodes() const
 						{
 							return RenderedNodes;
 						}
@@ -806,48 +1984,82 @@ namespace vml
 							return Root != nullptr;
 						}
 
+						bool IsFlatLayout() const
+						{
+							return vml::utils::bits32::Get(Flags, FLAT_LAYOUT);
+						}
+
+						const std::vector<FlatOctTreeNode>& GetFlatNodes() const
+						{
+							return FlatNodes;
+						}
+
+						bool HasMeshlets() const
+						{
+							return vml::utils::bits32::Get(Flags, MESHLETS);
+						}
+
+						// surfaces in rendered leaves, what drawing whole leaves submits
+
+						size_t GetRenderedSurfacesCount() const
+						{
+							return RenderedSurfacesCount;
+						}
+
+						// surfaces in meshlets surviving culling, what indirect drawing submits
+
+						size_t GetSubmittedSurfacesCount() const
+						{
+							return SubmittedSurfacesCount;
+						}
+
+						const std::vector<MeshletCommand>& GetMeshletCommands() const
+						{
+							return MeshletCommands;
+						}
+
 						// ----------------------------------------------------------------
-						// transform octrees nodes 
+						// binds the draw indirect buffer, uploading the meshlet commands
+						// if they changed, leaves are then drawn with
+						// glMultiDrawElementsIndirect, see OctTreeNode::GetFirstCommand
 
-						void Transform(vml::views::View* view)
+						void BindMeshletCommands()
 						{
-							if (!Root)
-								vml::os::Message::Error("Octree : ", "Compile Map before trasnforming");
+							if (!IndirectBufferObject)
+								glGenBuffers(1, &IndirectBufferObject);
 
-							// set visible state back to default for all nodes
+							glBindBuffer(GL_DRAW_INDIRECT_BUFFER, IndirectBufferObject);
 
-							for (size_t i = 0; i < OctTreeNodes.size(); ++i)
-								OctTreeNodes[i]->ResetVisibleFlag();
-							
-							// travese tree
+							if (MeshletCommandsDirty)
+							{
+								glBufferData(GL_DRAW_INDIRECT_BUFFER, MeshletCommands.size() * sizeof(MeshletCommand), MeshletCommands.data(), GL_STREAM_DRAW);
+								MeshletCommandsDirty = false;
+							}
+						}
 
-							Stack[0] = Root;
+						// ----------------------------------------------------------------
+						// transform octrees nodes 
 
-							StackCounter = 1;
+						void Transform(vml::views::View* view)
+						{
+							if (!Root)
+								vml::os::Message::Error("Octree : ", "Compile Map before trasnforming");
 
-							RenderedNodesCount = 0;
+							// travese tree, the flat layout only touches
+							// the visibility flag of rendered leaves
 
-							for (size_t i = 0; i < StackCounter; ++i)
+							if (vml::utils::bits32::Get(Flags, FLAT_LAYOUT))
 							{
+								CullFlatTree(view->GetFrustumPlanes());
+							}
+							else
+							{
+								// set visible state back to default for all nodes
 
-								if (Stack[i]->TestAABBox(view->GetFrustumPlanes())!= OctTreeNode::OUTSIDE)
-								{
-									if (Stack[i]->IsLeaf())
-									{
-										RenderedNodes[RenderedNodesCount++] = Stack[i];
-									}
-									else
-									{
-										if (Stack[i]->GetChild(0)) Stack[StackCounter++] = Stack[i]->GetChild(0);
-										if (Stack[i]->GetChild(1)) Stack[StackCounter++] = Stack[i]->GetChild(1);
-										if (Stack[i]->GetChild(2)) Stack[StackCounter++] = Stack[i]->GetChild(2);
-										if (Stack[i]->GetChild(3)) Stack[StackCounter++] = Stack[i]->GetChild(3);
-										if (Stack[i]->GetChild(4)) Stack[StackCounter++] = Stack[i]->GetChild(4);
-										if (Stack[i]->GetChild(5)) Stack[StackCounter++] = Stack[i]->GetChild(5);
-										if (Stack[i]->GetChild(6)) Stack[StackCounter++] = Stack[i]->GetChild(6);
-										if (Stack[i]->GetChild(7)) Stack[StackCounter++] = Stack[i]->GetChild(7);
-									}
-								}
+								for (size_t i = 0; i < OctTreeNodes.size(); ++i)
+									OctTreeNodes[i]->ResetVisibleFlag();
+
+								CullPointerTree(view->GetFrustumPlanes());
 							}
 
 							// transfor rendered nodes to view
@@ -855,6 +2067,11 @@ namespace vml
 							for (size_t i = 0; i < RenderedNodesCount; ++i)
 								RenderedNodes[i]->TransformToView(view);
 
+							// cull meshlets of rendered nodes
+
+							if (vml::utils::bits32::Get(Flags, MESHLETS))
+								CullMeshlets(view);
+
 							// compute rednered node ratio
 
 							RenderedNodeRatio = 100.0f * float(RenderedNodesCount) / float(LeafNodes);
@@ -873,6 +2090,44 @@ namespace vml
 							
 							QueryOctTreeNodesCount = 0;
 
+							if (vml::utils::bits32::Get(Flags, FLAT_LAYOUT))
+							{
+								const glm::vec3& bmin = boundingbox.GetMin();
+								const glm::vec3& bmax = boundingbox.GetMax();
+
+								uint32_t* stack = FlatStack.data();
+
+								size_t stackcounter = 1;
+
+								stack[0] = 0;
+
+								for (size_t i = 0; i < stackcounter; ++i)
+								{
+									uint32_t idx = stack[i];
+
+									// skip disjoint boxes
+
+									if (FlatMaxX[idx] < bmin.x || FlatMinX[idx] > bmax.x ||
+										FlatMaxY[idx] < bmin.y || FlatMinY[idx] > bmax.y ||
+										FlatMaxZ[idx] < bmin.z || FlatMinZ[idx] > bmax.z)
+										continue;
+
+									const FlatOctTreeNode& flatnode = FlatNodes[idx];
+
+									if (flatnode.Leaf)
+									{
+										QueryOctTreeNodes[QueryOctTreeNodesCount++] = OctTreeNodes[flatnode.NodeIndex];
+									}
+									else
+									{
+										for (uint32_t j = 0; j < flatnode.ChildCount; ++j)
+											stack[stackcounter++] = flatnode.FirstChild + j;
+									}
+								}
+
+								return;
+							}
+
 							Stack[0] = Root;
 
 							StackCounter = 1;
@@ -904,6 +2159,88 @@ namespace vml
 							}
 						}
 
+						// ----------------------------------------------------------------
+						// compares frustum traversal throughput of the pointer based
+						// tree and of the flat layout, using the current view,
+						// results are written to the log as nodes per second
+
+						void Benchmark(vml::views::View* view, int iterations = 1000)
+						{
+							if (!Root)
+								vml::os::Message::Error("Octree : ", "Compile Map before benchmarking");
+
+							if (iterations < 1)
+								vml::os::Message::Error("Octree : ", "Benchmark iterations must be greater than zero");
+
+							const glm::vec4* planes = view->GetFrustumPlanes();
+
+							vml::os::Timer timer;
+
+							timer.Init();
+
+							// pointer based tree
+
+							size_t pointervisited = 0;
+
+							float start = timer.GetElapsedTime();
+
+							for (int i = 0; i < iterations; ++i)
+							{
+								for (size_t j = 0; j < OctTreeNodes.size(); ++j)
+									OctTreeNodes[j]->ResetVisibleFlag();
+
+								pointervisited += CullPointerTree(planes);
+							}
+
+							float pointertime = timer.GetElapsedTime() - start;
+
+							// flat layout
+
+							size_t flatvisited = 0;
+
+							start = timer.GetElapsedTime();
+
+							for (int i = 0; i < iterations; ++i)
+								flatvisited += CullFlatTree(planes);
+
+							float flattime = timer.GetElapsedTime() - start;
+
+							// restore rendered nodes according to the current traversal mode
+
+							Transform(view);
+
+							double pointerrate = pointertime > 0 ? double(pointervisited) / double(pointertime) : 0.0;
+							double flatrate	   = flattime    > 0 ? double(flatvisited)    / double(flattime)    : 0.0;
+
+							vml::utils::Logger::GetInstance()->Info("Octree : Benchmark : " + ResourceFileName);
+							vml::utils::Logger::GetInstance()->Info("Octree : Benchmark : Nodes : " + std::to_string(OctTreeNodes.size()) + " , Iterations : " + std::to_string(iterations));
+							vml::utils::Logger::GetInstance()->Info("Octree : Benchmark : Pointer tree : " + std::to_string(pointerrate) + " nodes/s");
+							vml::utils::Logger::GetInstance()->Info("Octree : Benchmark : Flat layout  : " + std::to_string(flatrate) + " nodes/s");
+
+							if (vml::utils::bits32::Get(Flags, MESHLETS))
+							{
+								vml::utils::Logger::GetInstance()->Info("Octree : Benchmark : Leaf triangles    : " + std::to_string(RenderedSurfacesCount));
+								vml::utils::Logger::GetInstance()->Info("Octree : Benchmark : Meshlet triangles : " + std::to_string(SubmittedSurfacesCount) + " , Commands : " + std::to_string(MeshletCommands.size()));
+							}
+						}
+
+						// ----------------------------------------------------------------
+						// benchmarks vertex welding on the level mesh, vertices are
+						// unindexed the same way they are before leaves are clipped
+
+						void BenchmarkRemoveDuplicates(const vml::meshes::Mesh3d* mesh, int iterations = 10)
+						{
+							if (!mesh)
+								vml::os::Message::Error("Octree : ", "Mesh is null");
+
+							ConvertData(&mesh->GetVertexArray(), &mesh->GetNormalArray(), &mesh->GetUVArray(), &mesh->GetSurfaceIndices());
+
+							vml::meshes::RemoveDuplicates3D::Benchmark(VertexArray, mesh->GetBoundingBox().GetMin(), mesh->GetBoundingBox().GetMax(), iterations);
+
+							VertexArray.clear();
+							SurfaceIndices.clear();
+						}
+
 						// ----------------------------------------------------------------
 						//
 						
@@ -925,6 +2262,16 @@ namespace vml
 								// release data or not according to flag
 
 								Flags = flags;
+
+								// time compilation, the cache stores it for load reports
+
+								vml::os::Timer timer;
+								timer.Init();
+
+								SourceHash = ComputeSourceHash(mesh);
+
+								if (vml::utils::bits32::Get(Flags, RAY_QUERIES))
+									CreateRayData(mesh);
 																
 								// converts mesh data to internal format 
 
@@ -945,13 +2292,48 @@ namespace vml
 
 								OctTreeNodes.emplace_back(Root);
 								
-								// build octree
-					
-								RecurseNode(Root, SurfaceIndices);
+								// build octree, both builds produce the same nodes, 
+								// ids and vaos
+
+								if (vml::utils::bits32::Get(Flags, PARALLEL_BUILD))
+								{
+									// deterministic builds run on a pool without workers,
+									// others on the engine thread pool
+
+									vml::os::ThreadPool serialpool(0);
+
+									vml::os::ThreadPool* pool = vml::os::ThreadPool::GetInstance();
+
+									if (vml::utils::bits32::Get(Flags, DETERMINISTIC_BUILD))
+										pool = &serialpool;
+
+									Scratch.resize(pool->GetWorkersCount() + 1);
+
+									RecurseNodeParallel(pool, Root, SurfaceIndices);
+
+									FinalizeNode(Root);
+
+									PendingNodes.clear();
+								}
+								else
+								{
+									Scratch.resize(1);
+
+									RecurseNode(Root, SurfaceIndices, Scratch[0]);
+								}
+
+								Scratch.clear();
+
+								if (vml::utils::bits32::Get(Flags, RAY_QUERIES))
+									LeafTriangleRanges.resize(OctTreeNodes.size());
 								
 								// create octree node stack
 
 								CreateStack();
+
+								// pack nodes for flat traversal
+
+								CreateFlatLayout();
 								
 								// create daa structure for queries
 
@@ -962,6 +2344,8 @@ namespace vml
 
 								VertexArray.clear();
 								SurfaceIndices.clear();
+
+								BuildTime = timer.GetElapsedTime() * 1000.0f;
 																
 								for (size_t i = 0; i < GetNodesCount(); ++i)
 								{
@@ -983,6 +2367,361 @@ namespace vml
 							
 						}
 
+						// ----------------------------------------------------------------
+						// ray and segment queries, octree must have been compiled with
+						// the RAY_QUERIES flag, hits hold the nearest triangle along
+						// each ray, queries only read octree data, so they can be issued
+						// from several threads
+
+						bool CastRay(const OctTreeRay& ray, OctTreeRayHit& hit) const
+						{
+							if (!vml::utils::bits32::Get(Flags, RAY_QUERIES))
+								vml::os::Message::Error("Octree : ", "Ray queries need the RAY_QUERIES flag");
+
+							std::vector<RayStackEntry> stack;
+
+							CastRay(ray, hit, stack);
+
+							return hit.Triangle != -1;
+						}
+
+						bool CastSegment(const glm::vec3& a, const glm::vec3& b, OctTreeRayHit& hit) const
+						{
+							return CastRay(OctTreeRay(a, b - a, 1.0f), hit);
+						}
+
+						// ----------------------------------------------------------------
+						// casts a batch of rays one by one, if pool is not null
+						// the batch is split among the pool threads
+
+						void CastRays(const std::vector<OctTreeRay>& rays, std::vector<OctTreeRayHit>& hits, vml::os::ThreadPool* pool = nullptr) const
+						{
+							CastRayBatch(rays, hits, pool, false);
+						}
+
+						// ----------------------------------------------------------------
+						// casts a batch of rays in packets, consecutive rays should be
+						// coherent, for example rays from the same eye towards 
+						// nearby targets, if pool is not null the batch is split
+						// among the pool threads
+
+						void CastRayPackets(const std::vector<OctTreeRay>& rays, std::vector<OctTreeRayHit>& hits, vml::os::ThreadPool* pool = nullptr) const
+						{
+							CastRayBatch(rays, hits, pool, true);
+						}
+
+						// ----------------------------------------------------------------
+						// saves the compiled octree, octree must have been compiled
+						// with the CACHE_LEAF_DATA flag, retained leaf data is released
+						// once the file is written
+
+						bool SaveCache(const std::string& filename)
+						{
+							if (!Root)
+								vml::os::Message::Error("Octree : ", "Cache : Octree is not compiled");
+
+							if (!vml::utils::bits32::Get(Flags, CACHE_LEAF_DATA))
+								vml::os::Message::Error("Octree : ", "Cache : Leaf data is not retained, compile with CACHE_LEAF_DATA flag");
+
+							// build node records
+
+							std::vector<CacheNode> nodes(OctTreeNodes.size());
+
+							for (size_t i = 0; i < OctTreeNodes.size(); ++i)
+							{
+								const OctTreeNode* node = OctTreeNodes[i];
+								CacheNode& record = nodes[i];
+
+								memset(&record, 0, sizeof(CacheNode));
+
+								record.Min[0] = node->GetBoundingBox().GetMin().x;
+								record.Min[1] = node->GetBoundingBox().GetMin().y;
+								record.Min[2] = node->GetBoundingBox().GetMin().z;
+								record.Max[0] = node->GetBoundingBox().GetMax().x;
+								record.Max[1] = node->GetBoundingBox().GetMax().y;
+								record.Max[2] = node->GetBoundingBox().GetMax().z;
+								record.Parent = node->GetParent() ? node->GetParent()->GetId() : -1;
+
+								for (size_t j = 0; j < 8; ++j)
+									record.Child[j] = node->GetChild(j) ? node->GetChild(j)->GetId() : -1;
+
+								auto it = LeafRanges.find(node->GetId());
+
+								if ((size_t)node->GetId() < LeafTriangleRanges.size())
+								{
+									record.FirstTriangle  = LeafTriangleRanges[node->GetId()].First;
+									record.TrianglesCount = LeafTriangleRanges[node->GetId()].Count;
+								}
+
+								if (node->IsLeaf() && it != LeafRanges.end())
+								{
+									record.Leaf			 = 1;
+									record.FirstVertex	 = it->second.FirstVertex;
+									record.VerticesCount = it->second.VerticesCount;
+									record.FirstIndex	 = it->second.FirstIndex;
+									record.IndicesCount	 = it->second.IndicesCount;
+								}
+							}
+
+							// build header
+
+							CacheHeader header;
+
+							memset(&header, 0, sizeof(CacheHeader));
+							memcpy(header.Magic, "VOCT", 4);
+
+							header.Version		  = CACHE_VERSION;
+							header.SourceHash	  = SourceHash;
+							header.NodesCount	  = (uint32_t)nodes.size();
+							header.LeafNodes	  = (uint32_t)LeafNodes;
+							header.MaxSurfaces	  = (uint32_t)MaxSurfaces;
+							header.BuildTime	  = BuildTime;
+							header.VerticesCount  = LeafNormalData.size() / 3;
+							header.IndicesCount	  = LeafIndexData.size();
+							header.NodesOffset	  = AlignCacheOffset(sizeof(CacheHeader));
+							header.VerticesOffset = AlignCacheOffset(header.NodesOffset + nodes.size() * sizeof(CacheNode));
+							header.NormalsOffset  = AlignCacheOffset(header.VerticesOffset + LeafVertexData.size() * sizeof(float));
+							header.IndicesOffset  = AlignCacheOffset(header.NormalsOffset + LeafNormalData.size() * sizeof(float));
+							header.TrianglesCount  = LeafTriangles.size();
+							header.TrianglesOffset = AlignCacheOffset(header.IndicesOffset + LeafIndexData.size() * sizeof(unsigned int));
+
+							// write file
+
+							FILE* stream;
+
+							errno_t err = fopen_s(&stream, filename.c_str(), "wb");
+
+							if (err != 0)
+							{
+								vml::utils::Logger::GetInstance()->Info("Octree : Cache : Cannot write '" + filename + "'");
+								return false;
+							}
+
+							uint64_t position = 0;
+
+							bool ok = fwrite(&header, sizeof(CacheHeader), 1, stream) == 1;
+							position += sizeof(CacheHeader);
+
+							ok = ok && PadCacheFile(stream, position, header.NodesOffset);
+							ok = ok && fwrite(nodes.data(), sizeof(CacheNode), nodes.size(), stream) == nodes.size();
+							position += nodes.size() * sizeof(CacheNode);
+
+							ok = ok && PadCacheFile(stream, position, header.VerticesOffset);
+							ok = ok && fwrite(LeafVertexData.data(), sizeof(float), LeafVertexData.size(), stream) == LeafVertexData.size();
+							position += LeafVertexData.size() * sizeof(float);
+
+							ok = ok && PadCacheFile(stream, position, header.NormalsOffset);
+							ok = ok && fwrite(LeafNormalData.data(), sizeof(float), LeafNormalData.size(), stream) == LeafNormalData.size();
+							position += LeafNormalData.size() * sizeof(float);
+
+							ok = ok && PadCacheFile(stream, position, header.IndicesOffset);
+							ok = ok && fwrite(LeafIndexData.data(), sizeof(unsigned int), LeafIndexData.size(), stream) == LeafIndexData.size();
+							position += LeafIndexData.size() * sizeof(unsigned int);
+
+							ok = ok && PadCacheFile(stream, position, header.TrianglesOffset);
+							ok = ok && fwrite(LeafTriangles.data(), sizeof(uint32_t), LeafTriangles.size(), stream) == LeafTriangles.size();
+
+							if (fclose(stream) != 0)
+								ok = false;
+
+							// don't leave a truncated cache behind, leaf data is retained
+							// so the cache can be saved again
+
+							if (!ok)
+							{
+								vml::utils::Logger::GetInstance()->Info("Octree : Cache : Cannot write '" + filename + "'");
+								remove(filename.c_str());
+								return false;
+							}
+
+							// leaf data is no longer needed
+
+							ReleaseLeafData();
+
+							vml::utils::Logger::GetInstance()->Info("Octree : Cache : Saved '" + filename + "'");
+
+							return true;
+						}
+
+						// ----------------------------------------------------------------
+						// loads a compiled octree from a cache file, returns false if
+						// the file is missing, has a different version, doesn't match
+						// the mesh or is corrupted, in which case octree must be compiled 
+
+						bool LoadCache(const std::string& filename, const vml::meshes::Mesh3d* mesh, unsigned int flags = 0)
+						{
+							if (!mesh)
+								vml::os::Message::Error("Octree : ", "Cache : Mesh is null");
+
+							if (!mesh->IsValid())
+								vml::os::Message::Error("Octree : ", "Cache : Mesh is not valid");
+
+							vml::os::FileView file;
+
+							if (!file.OpenCache(filename))
+								return false;
+
+							// validate header
+
+							const CacheHeader* header = (const CacheHeader*)file.GetDataAt(0, sizeof(CacheHeader));
+
+							if (!header || memcmp(header->Magic, "VOCT", 4) != 0 || header->Version != CACHE_VERSION)
+							{
+								vml::utils::Logger::GetInstance()->Info("Octree : Cache : Invalid cache file '" + filename + "'");
+								return false;
+							}
+
+							uint64_t hash = ComputeSourceHash(mesh);
+
+							if (header->SourceHash != hash)
+							{
+								vml::utils::Logger::GetInstance()->Info("Octree : Cache : Cache is out of date '" + filename + "'");
+								return false;
+							}
+
+							// get sections
+
+							const CacheNode*    nodes    = (const CacheNode*)file.GetDataAt((size_t)header->NodesOffset, (size_t)header->NodesCount * sizeof(CacheNode));
+							const float*	    vertices = (const float*)file.GetDataAt((size_t)header->VerticesOffset, (size_t)header->VerticesCount * 4 * sizeof(float));
+							const float*	    normals  = (const float*)file.GetDataAt((size_t)header->NormalsOffset, (size_t)header->VerticesCount * 3 * sizeof(float));
+							const unsigned int* indices  = (const unsigned int*)file.GetDataAt((size_t)header->IndicesOffset, (size_t)header->IndicesCount * sizeof(unsigned int));
+							const uint32_t*		triangles = (const uint32_t*)file.GetDataAt((size_t)header->TrianglesOffset, (size_t)header->TrianglesCount * sizeof(uint32_t));
+
+							// ray queries need the triangle ids
+
+							bool rayqueries = vml::utils::bits32::Get(flags, RAY_QUERIES);
+
+							if (rayqueries && header->TrianglesCount == 0)
+							{
+								vml::utils::Logger::GetInstance()->Info("Octree : Cache : Cache has no ray query data '" + filename + "'");
+								return false;
+							}
+
+							if (!nodes || !vertices || !normals || !indices || !triangles || header->NodesCount == 0)
+							{
+								vml::utils::Logger::GetInstance()->Info("Octree : Cache : Corrupted cache file '" + filename + "'");
+								return false;
+							}
+
+							// validate node records before creating anything, parents
+							// always precede children, leaf ranges must lay in the arrays
+
+							for (uint32_t i = 0; i < header->NodesCount; ++i)
+							{
+								const CacheNode& record = nodes[i];
+
+								bool valid = (i == 0) ? record.Parent == -1 : (record.Parent >= 0 && (uint32_t)record.Parent < i);
+
+								for (size_t j = 0; j < 8; ++j)
+									valid &= record.Child[j] == -1 || ((uint32_t)record.Child[j] > i && (uint32_t)record.Child[j] < header->NodesCount);
+
+								if (record.Leaf)
+								{
+									valid &= (uint64_t)record.FirstVertex + record.VerticesCount <= header->VerticesCount;
+									valid &= (uint64_t)record.FirstIndex + record.IndicesCount <= header->IndicesCount;
+									valid &= record.VerticesCount > 0 && record.IndicesCount > 0;
+
+									for (uint32_t j = 0; valid && j < record.IndicesCount; ++j)
+										valid &= indices[record.FirstIndex + j] < record.VerticesCount;
+								}
+
+								if (rayqueries)
+								{
+									valid &= (uint64_t)record.FirstTriangle + record.TrianglesCount <= header->TrianglesCount;
+
+									for (uint32_t j = 0; valid && j < record.TrianglesCount; ++j)
+										valid &= triangles[record.FirstTriangle + j] < mesh->GetSurfaceCount();
+								}
+
+								if (!valid)
+								{
+									vml::utils::Logger::GetInstance()->Info("Octree : Cache : Corrupted cache file '" + filename + "'");
+									return false;
+								}
+							}
+
+							// free octree data
+
+							ReleaseAll();
+
+							ResourceFileName = mesh->GetResourceFileName();
+							Flags			 = flags & ~CACHE_LEAF_DATA;
+							SourceHash		 = hash;
+							MaxSurfaces		 = (int)header->MaxSurfaces;
+							BuildTime		 = header->BuildTime;
+
+							// create nodes, ids match the node positions
+
+							for (uint32_t i = 0; i < header->NodesCount; ++i)
+							{
+								const CacheNode& record = nodes[i];
+
+								OctTreeNode* parent = record.Parent >= 0 ? OctTreeNodes[record.Parent] : nullptr;
+
+								OctTreeNodes.emplace_back(new OctTreeNode(parent, (int)i, 
+																		  glm::vec3(record.Min[0], record.Min[1], record.Min[2]),
+																		  glm::vec3(record.Max[0], record.Max[1], record.Max[2])));
+							}
+
+							// link children and create leaf vaos straight from the mapped file
+
+							for (uint32_t i = 0; i < header->NodesCount; ++i)
+							{
+								const CacheNode& record = nodes[i];
+
+								OctTreeNode* node = OctTreeNodes[i];
+
+								for (size_t j = 0; j < 8; ++j)
+									if (record.Child[j] >= 0)
+										node->SetChild((int)j, OctTreeNodes[record.Child[j]]);
+
+								if (record.Leaf)
+								{
+									node->CreateVAO(vertices + (size_t)record.FirstVertex * 4, 
+													normals  + (size_t)record.FirstVertex * 3, record.VerticesCount, 
+													indices  + record.FirstIndex, record.IndicesCount, 
+													vml::utils::bits32::Get(Flags, MESHLETS));
+									node->SetLeaf();
+									LeafNodes++;
+								}
+							}
+
+							Root = OctTreeNodes[0];
+
+							// ray query data
+
+							if (rayqueries)
+							{
+								CreateRayData(mesh);
+
+								LeafTriangles.assign(triangles, triangles + header->TrianglesCount);
+								LeafTriangleRanges.resize(header->NodesCount);
+
+								for (uint32_t i = 0; i < header->NodesCount; ++i)
+								{
+									LeafTriangleRanges[i].First = nodes[i].FirstTriangle;
+									LeafTriangleRanges[i].Count = nodes[i].TrianglesCount;
+								}
+							}
+
+							// create octree node stack
+
+							CreateStack();
+
+							// pack nodes for flat traversal
+
+							CreateFlatLayout();
+
+							// create data structure for queries
+
+							QueryOctTreeNodes.resize(OctTreeNodes.size());
+							QueryOctTreeNodesCount = 0;
+
+							vml::utils::Logger::GetInstance()->Info("Octree : Cache : Loaded '" + filename + "'");
+
+							return true;
+						}
+
 						//-----------------------------------------------------------------------------------
 						// copy constructor is private
 						// no copies allowed since classes
@@ -1014,6 +2753,12 @@ namespace vml
 							MaxSurfaces	           = 512;
 							Flags			       = 0;
 							QueryOctTreeNodesCount = 0;
+							SourceHash			   = 0;
+							BuildTime			   = 0.0f;
+							IndirectBufferObject   = 0;
+							MeshletCommandsDirty   = false;
+							RenderedSurfacesCount  = 0;
+							SubmittedSurfacesCount = 0;
 						}
 
 						~OctTree()
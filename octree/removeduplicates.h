@@ -6,118 +6,155 @@ namespace vml
 	namespace meshes
 	{
 		////////////////////////////////////////////////////////////////////////////
-		//
+		// welds vertices whose attributes differ by less than the tolerance,
+		// positions are quantized to a grid whose cells are twice the tolerance,
+		// cells are stored in an open addressing table, a vertex can only match
+		// vertices in its cell or in the nearest neighbour cell along each axis,
+		// so lookups probe eight cells at most, regardless of the cell density
 
 		class RemoveDuplicates3D
 		{
 			private:
 
 				// ----------------------------------------------------------------------
-				// 
+				// quantized position
 
-				class HashedVertex
+				struct WeldCell
+				{
+					long long X;
+					long long Y;
+					long long Z;
+
+					bool operator==(const WeldCell& cell) const
+					{
+						return X == cell.X && Y == cell.Y && Z == cell.Z;
+					}
+				};
+
+				// ----------------------------------------------------------------------
+				// open addressing table, slots hold indices into the welded
+				// vertex array, vertices falling in the same cell are stored
+				// along the same probe sequence, in insertion order
+
+				class WeldTable
 				{
 					private:
 
-						int Id;
+						std::vector<int>	Slots;
+						size_t				Mask;
 
 					public:
 
 						// ---------------------------------------------------------------
 
-						int GetId() const { return Id; }
+						std::vector<vml::geo3d::Vertex> Vertices;		// welded vertices
+						std::vector<WeldCell>			Cells;			// welded vertices cells
 
 						// ---------------------------------------------------------------
 
-						vml::geo3d::Vertex Vertex;
+						static size_t Hash(const WeldCell& cell)
+						{
+							unsigned long long h = (unsigned long long)cell.X * 0x9E3779B97F4A7C15ull ^
+												   (unsigned long long)cell.Y * 0xC2B2AE3D27D4EB4Full ^
+												   (unsigned long long)cell.Z * 0x165667B19E3779F9ull;
+							return (size_t)(h ^ (h >> 29));
+						}
 
 						// ---------------------------------------------------------------
-						// ctor / dtor
+						// capacity is kept at least twice the number of vertices
+						// to be inserted, so probe sequences stay short
 
-						HashedVertex(const vml::geo3d::Vertex& v, const int id)
+						void Reset(size_t count)
 						{
-							Vertex = v;
-							Id = id;
-						}
+							size_t capacity = 16;
 
-						HashedVertex()
-						{
-							Id = -1;
-						}
+							while (capacity < count * 2)
+								capacity <<= 1;
 
-						~HashedVertex()
-						{}
-				};
+							Slots.assign(capacity, -1);
+							Mask = capacity - 1;
 
-				// ----------------------------------------------------------------------
-				// Gridcell class 
-				// this class contains the vertices enclosed in the cell's bounding box
+							Vertices.clear();
+							Cells.clear();
+							Vertices.reserve(count);
+							Cells.reserve(count);
+						}
 
-				class GridCell
-				{
-					private:
+						// ---------------------------------------------------------------
+						// returns the first vertex in the cell within tolerance, -1 if none
 
-					public:
+						int Find(const WeldCell& cell, const vml::geo3d::Vertex& vertex, const float tolerance) const
+						{
+							for (size_t i = Hash(cell) & Mask; Slots[i] != -1; i = (i + 1) & Mask)
+							{
+								int id = Slots[i];
 
-						// ---------------------------------------------------------------
-						// 
+								if (Cells[id] == cell && IsEqual(Vertices[id], vertex, tolerance))
+									return id;
+							}
 
-						std::vector<HashedVertex> VertexArray;
+							return -1;
+						}
 
 						// ---------------------------------------------------------------
-						// vertex comparison predicate 
 
-						int FindVertex(const vml::geo3d::Vertex& vertex, const float eps = 0.000000000001f) const
+						int Insert(const WeldCell& cell, const vml::geo3d::Vertex& vertex)
 						{
-							for (size_t i = 0; i < VertexArray.size(); ++i)
-							{
-								if (fabsf(VertexArray[i].Vertex.Pos.x    - vertex.Pos.x)    < eps &&
-									fabsf(VertexArray[i].Vertex.Pos.y    - vertex.Pos.y)    < eps &&
-									fabsf(VertexArray[i].Vertex.Pos.z    - vertex.Pos.z)    < eps &&
-									fabsf(VertexArray[i].Vertex.Normal.x - vertex.Normal.x) < eps &&
-									fabsf(VertexArray[i].Vertex.Normal.y - vertex.Normal.y) < eps &&
-									fabsf(VertexArray[i].Vertex.Normal.z - vertex.Normal.z) < eps &&
-									fabsf(VertexArray[i].Vertex.UV.x     - vertex.UV.x)     < eps &&
-									fabsf(VertexArray[i].Vertex.UV.y     - vertex.UV.y)     < eps)
-								{
-									return VertexArray[i].GetId();
-								}
-							}
-							return -1;
+							size_t i = Hash(cell) & Mask;
+
+							while (Slots[i] != -1)
+								i = (i + 1) & Mask;
+
+							Slots[i] = (int)Vertices.size();
+
+							Vertices.emplace_back(vertex);
+							Cells.emplace_back(cell);
+
+							return Slots[i];
 						}
 
 						// ---------------------------------------------------------------
 						// ctor / dtor
 
-						GridCell()
-						{}
+						WeldTable()
+						{
+							Mask = 0;
+						}
 
-						~GridCell()
+						~WeldTable()
 						{}
+				};
+
+				// ----------------------------------------------------------------------
+				// reference implementation, vertices are bucketed in a fixed 16x16x16
+				// grid spanning the bounding box and each bucket is scanned linearly,
+				// it is only kept to benchmark the hashed welding against
+
+				class GridCell
+				{
+					public:
 
+						std::vector<vml::geo3d::Vertex> VertexArray;
+						std::vector<int>				Id;
 				};
 
 				// ---------------------------------------------------------------
-				// 
+				//
 
-				static const unsigned int CELLSIZE = 16;
+				static const unsigned int GRIDCELLSIZE		 = 16;
+				static const size_t		  MIN_CHUNK_VERTICES = 16384;
 
 				// ---------------------------------------------------------------
-				// 
+				//
 
 				glm::vec3	 BoundingBoxMin;			// bounding box minimum position
 				glm::vec3	 BoundingBoxMax;			// bounding box maximum position
 				glm::vec3	 BoundingBoxExtents;		// bounding box half extents
-
+				float		 Tolerance;					// welding tolerance
+				double		 InvCellSize;				// inverse of the quantization cell size
 				float		 GainRatio;
 				unsigned int Flags;
 
-				// ---------------------------------------------------------------
-				// 
-
-				GridCell* Cell;
-				int GridSize;
-
 				// ---------------------------------------------------------------
 				//
 
@@ -125,37 +162,208 @@ namespace vml
 				static const unsigned int FINALIZED = vml::utils::bits32::BIT1;
 
 				// ---------------------------------------------------------------
-				// 
+				// vertex comparison predicate
 
-				GridCell* GetCellFromVertex(const vml::geo3d::Vertex& p)
+				static bool IsEqual(const vml::geo3d::Vertex& a, const vml::geo3d::Vertex& b, const float eps)
 				{
-					float ix = (p.Pos.x - BoundingBoxMin.x) * (CELLSIZE - 1) / BoundingBoxExtents.x;
-					float iy = (p.Pos.y - BoundingBoxMin.y) * (CELLSIZE - 1) / BoundingBoxExtents.y;
-					float iz = (p.Pos.z - BoundingBoxMin.z) * (CELLSIZE - 1) / BoundingBoxExtents.z;
+					return fabsf(a.Pos.x    - b.Pos.x)    < eps &&
+						   fabsf(a.Pos.y    - b.Pos.y)    < eps &&
+						   fabsf(a.Pos.z    - b.Pos.z)    < eps &&
+						   fabsf(a.Normal.x - b.Normal.x) < eps &&
+						   fabsf(a.Normal.y - b.Normal.y) < eps &&
+						   fabsf(a.Normal.z - b.Normal.z) < eps &&
+						   fabsf(a.UV.x     - b.UV.x)     < eps &&
+						   fabsf(a.UV.y     - b.UV.y)     < eps;
+				}
+
+				// ---------------------------------------------------------------
+				// quantizes a coordinate, side is set to the neighbour cell
+				// nearest to the coordinate, coordinates are clamped so that
+				// far away vertices still get a valid cell
+
+				long long Quantize(const float x, const float origin, int& side) const
+				{
+					double q = ((double)x - (double)origin) * InvCellSize;
+
+					if (q >  4.0e18) q =  4.0e18;
+					if (q < -4.0e18) q = -4.0e18;
 
-					int ii = int(ix);
-					int jj = int(iy);
-					int kk = int(iz);
+					double c = floor(q);
 
-					if (ii < 0 || ii >= CELLSIZE) { vml::os::Message::Error("removeduplicates :", "ii overflow ", ii); }
-					if (jj < 0 || jj >= CELLSIZE) { vml::os::Message::Error("removeduplicates :", "jj overflow ", jj); }
-					if (kk < 0 || kk >= CELLSIZE) { vml::os::Message::Error("removeduplicates :", "kk overflow ", kk); }
+					side = q - c < 0.5 ? -1 : 1;
 
-					return &Cell[ii + jj * CELLSIZE + kk * CELLSIZE * CELLSIZE];
+					return (long long)c;
 				}
 
-			public:
+				// ---------------------------------------------------------------
+				// returns the welded index of a vertex, the cell of the vertex
+				// is probed first, since exact duplicates always fall there
+
+				int Weld(WeldTable& table, const vml::geo3d::Vertex& vertex) const
+				{
+					int sx, sy, sz;
+
+					WeldCell cell = { Quantize(vertex.Pos.x, BoundingBoxMin.x, sx),
+									  Quantize(vertex.Pos.y, BoundingBoxMin.y, sy),
+									  Quantize(vertex.Pos.z, BoundingBoxMin.z, sz) };
+
+					int id = table.Find(cell, vertex, Tolerance);
+
+					if (id != -1)
+						return id;
+
+					for (int i = 1; i < 8; ++i)
+					{
+						WeldCell neighbour = { cell.X + ((i & 1) ? sx : 0),
+											   cell.Y + ((i & 2) ? sy : 0),
+											   cell.Z + ((i & 4) ? sz : 0) };
+
+						id = table.Find(neighbour, vertex, Tolerance);
+
+						if (id != -1)
+							return id;
+					}
+
+					return table.Insert(cell, vertex);
+				}
 
 				// ---------------------------------------------------------------
-				// 
+				// welds the vertex array, remapping holds the welded index of
+				// each source vertex, if a pool is given and the array is large
+				// enough, chunks are welded in parallel and the chunks welded
+				// vertices are then welded in chunk order, which yields the same
+				// vertices and order as the serial welding for exact duplicates
+
+				void Weld(const std::vector<vml::geo3d::Vertex>& srcvertexarray,
+						  std::vector<vml::geo3d::Vertex>& destvertexarray,
+						  std::vector<int>& remapping,
+						  vml::os::ThreadPool* pool) const
+				{
+					size_t count = srcvertexarray.size();
 
-				void Begin(const glm::vec3& bmin, const glm::vec3& bmax, const float& eps = vml::math::EPSILON)
+					remapping.resize(count);
+
+					size_t chunks = 1;
+
+					if (pool)
+						chunks = std::min(pool->GetWorkersCount() + 1, count / MIN_CHUNK_VERTICES);
+
+					WeldTable table;
+
+					if (chunks < 2)
+					{
+						table.Reset(count);
+
+						for (size_t i = 0; i < count; ++i)
+							remapping[i] = Weld(table, srcvertexarray[i]);
+
+						destvertexarray.swap(table.Vertices);
+
+						return;
+					}
+
+					// weld chunks, remapping holds chunk local indices
+
+					std::vector<WeldTable> chunktables(chunks);
+
+					std::atomic<int> counter(0);
+
+					for (size_t c = 0; c < chunks; ++c)
+					{
+						pool->Submit([this, c, chunks, count, &srcvertexarray, &remapping, &chunktables]()
+						{
+							size_t first = count * c / chunks;
+							size_t last  = count * (c + 1) / chunks;
+
+							chunktables[c].Reset(last - first);
+
+							for (size_t i = first; i < last; ++i)
+								remapping[i] = Weld(chunktables[c], srcvertexarray[i]);
+
+						}, &counter);
+					}
+
+					pool->Wait(counter);
+
+					// weld chunks vertices
+
+					size_t total = 0;
+
+					for (size_t c = 0; c < chunks; ++c)
+						total += chunktables[c].Vertices.size();
+
+					table.Reset(total);
+
+					std::vector<std::vector<int>> chunkremapping(chunks);
+
+					for (size_t c = 0; c < chunks; ++c)
+					{
+						chunkremapping[c].resize(chunktables[c].Vertices.size());
+
+						for (size_t i = 0; i < chunktables[c].Vertices.size(); ++i)
+							chunkremapping[c][i] = Weld(table, chunktables[c].Vertices[i]);
+					}
+
+					for (size_t c = 0; c < chunks; ++c)
+					{
+						size_t first = count * c / chunks;
+						size_t last  = count * (c + 1) / chunks;
+
+						for (size_t i = first; i < last; ++i)
+							remapping[i] = chunkremapping[c][remapping[i]];
+					}
+
+					destvertexarray.swap(table.Vertices);
+				}
+
+				// ---------------------------------------------------------------
+				// reference grid welding, see GridCell
+
+				void WeldGrid(const std::vector<vml::geo3d::Vertex>& srcvertexarray,
+							  std::vector<vml::geo3d::Vertex>& destvertexarray,
+							  std::vector<int>& remapping) const
 				{
-					// clear grid
+					std::vector<GridCell> cells(GRIDCELLSIZE * GRIDCELLSIZE * GRIDCELLSIZE);
+
+					remapping.resize(srcvertexarray.size());
+
+					destvertexarray.clear();
+
+					for (size_t i = 0; i < srcvertexarray.size(); ++i)
+					{
+						const vml::geo3d::Vertex& p = srcvertexarray[i];
+
+						int ii = std::clamp(int((p.Pos.x - BoundingBoxMin.x) * (GRIDCELLSIZE - 1) / BoundingBoxExtents.x), 0, (int)GRIDCELLSIZE - 1);
+						int jj = std::clamp(int((p.Pos.y - BoundingBoxMin.y) * (GRIDCELLSIZE - 1) / BoundingBoxExtents.y), 0, (int)GRIDCELLSIZE - 1);
+						int kk = std::clamp(int((p.Pos.z - BoundingBoxMin.z) * (GRIDCELLSIZE - 1) / BoundingBoxExtents.z), 0, (int)GRIDCELLSIZE - 1);
+
+						GridCell& cell = cells[ii + jj * GRIDCELLSIZE + kk * GRIDCELLSIZE * GRIDCELLSIZE];
+
+						int vertexindex = -1;
+
+						for (size_t j = 0; j < cell.VertexArray.size() && vertexindex == -1; ++j)
+							if (IsEqual(cell.VertexArray[j], p, Tolerance))
+								vertexindex = cell.Id[j];
 
-					for (size_t i = 0; i < GridSize; ++i)
-						Cell[i].VertexArray.clear();
+						if (vertexindex == -1)
+						{
+							vertexindex = (int)destvertexarray.size();
+							cell.VertexArray.emplace_back(p);
+							cell.Id.emplace_back(vertexindex);
+							destvertexarray.emplace_back(p);
+						}
+
+						remapping[i] = vertexindex;
+					}
+				}
 
+			public:
+
+				// ---------------------------------------------------------------
+				//
+
+				void Begin(const glm::vec3& bmin, const glm::vec3& bmax, const float& eps = vml::math::EPSILON)
+				{
 					// compute bounding box
 
 					BoundingBoxMin = bmin;
@@ -177,7 +385,7 @@ namespace vml
 				}
 
 				// ---------------------------------------------------------------
-				// 
+				//
 
 				void Finalize()
 				{
@@ -185,10 +393,12 @@ namespace vml
 				}
 
 				// ---------------------------------------------------------------
-				// 
+				// removes duplicated vertices and reindexes surfaces, if pool
+				// is not null, large arrays are welded in parallel
 
 				void RemoveDuplicates(std::vector<vml::geo3d::Vertex>& srcvertexarray,
-									  std::vector<vml::geo3d::IndexedTriangle>& surfacesarray)
+									  std::vector<vml::geo3d::IndexedTriangle>& surfacesarray,
+									  vml::os::ThreadPool* pool = nullptr)
 				{
 					if (!vml::utils::bits32::Get(Flags, INITTED))
 						vml::os::Message::Error("RemoveDupliacted : ","Cannot initt function");
@@ -197,98 +407,114 @@ namespace vml
 
 					std::vector<int> ReMapping;
 
-					int destvertices = 0;
+					std::vector<vml::geo3d::Vertex> destvertexarray;
 
 					int oldverts = (int)srcvertexarray.size();
 
-					ReMapping.resize(oldverts);
+					Weld(srcvertexarray, destvertexarray, ReMapping, pool);
 
-					std::vector<vml::geo3d::Vertex> destvertexarray;
-
-					for (size_t i = 0; i < srcvertexarray.size(); ++i)
-					{
+					// copy new array into old one
 
-						GridCell* cell = GetCellFromVertex(srcvertexarray[i]);
+					srcvertexarray.swap(destvertexarray);
 
-						int vertexindex = cell->FindVertex(srcvertexarray[i]);
+					int newverts = (int)srcvertexarray.size();
 
-						//	vml::os::Trace("vertex %d ( %f %f %f , %f %f %f ) mapped to %d\n", i,
-						//		vertexarray[i].Pos.x, vertexarray[i].Pos.y, vertexarray[i].Pos.z,
-						//		vertexarray[i].Normal.x, vertexarray[i].Normal.y, vertexarray[i].Normal.z,
-						//		vertexindex);
+					GainRatio = 100.0f * ((float)oldverts - (float)newverts) / (float)oldverts;
 
-						if (vertexindex != -1)
-						{
+				//	vml::os::Message::Trace("Mesh Builder : ","Gain ", GainRatio,"%");
 
-							// Vertex i is a duplicate of one inserted earlier into the
-							// table.  Map vertex i to the first-found copy.
+					std::cout << "Mesh Builder : Gain : " << GainRatio << std::endl;
 
-							ReMapping[i] = vertexindex;
+					// reindex surface indices
 
-						}
-						else
-						{
+					for (int i = 0; i < surfacesarray.size(); i++)
+					{
+						surfacesarray[i].I0 = ReMapping[surfacesarray[i].I0];
+						surfacesarray[i].I1 = ReMapping[surfacesarray[i].I1];
+						surfacesarray[i].I2 = ReMapping[surfacesarray[i].I2];
+					}
 
-							// emplace vertex in the current cell
+				}
 
-							cell->VertexArray.emplace_back(HashedVertex(srcvertexarray[i], destvertices));
+				// ---------------------------------------------------------------
+				// compares the reference grid welding with the hashed welding,
+				// serial and parallel, results are written to the log, welded
+				// vertices must match since both weld to the first found copy
 
-							// copy in dest vertex array
+				static void Benchmark(const std::vector<vml::geo3d::Vertex>& vertexarray, const glm::vec3& bmin, const glm::vec3& bmax, int iterations = 10)
+				{
+					if (iterations < 1)
+						vml::os::Message::Error("RemoveDuplicates : ", "Benchmark iterations must be greater than zero");
 
-							destvertexarray.emplace_back(srcvertexarray[i]);
+					RemoveDuplicates3D rd;
 
-							// save index to remap
+					rd.Begin(bmin, bmax);
 
-							ReMapping[i] = destvertices++;
+					std::vector<vml::geo3d::Vertex> gridvertices;
+					std::vector<vml::geo3d::Vertex> hashvertices;
+					std::vector<vml::geo3d::Vertex> parallelvertices;
+					std::vector<int>				gridremapping;
+					std::vector<int>				hashremapping;
+					std::vector<int>				parallelremapping;
 
-						}
+					vml::os::ThreadPool* pool = vml::os::ThreadPool::GetInstance();
 
-					}
+					vml::os::Timer timer;
 
-					// copy new array into old one
+					// reference grid
 
-					srcvertexarray = destvertexarray;
+					timer.Init();
 
-					int newverts = (int)srcvertexarray.size();
+					for (int i = 0; i < iterations; ++i)
+						rd.WeldGrid(vertexarray, gridvertices, gridremapping);
 
-					GainRatio = 100.0f * ((float)oldverts - (float)newverts) / (float)oldverts;
+					float gridtime = timer.GetElapsedTime() * 1000.0f / iterations;
 
-				//	vml::os::Message::Trace("Mesh Builder : ","Gain ", GainRatio,"%");
-					
-					std::cout << "Mesh Builder : Gain : " << GainRatio << std::endl;
+					// hashed, serial
 
-					// reindex surface indices
+					timer.Init();
 
-					for (int i = 0; i < surfacesarray.size(); i++)
-					{
-						//			vml::os::Trace("surface %d ( %d %d %d )\n", i, ReMapping[surfacesrray[i].I0],ReMapping[surfacesrray[i].I1],ReMapping[surfacesrray[i].I2]);
+					for (int i = 0; i < iterations; ++i)
+						rd.Weld(vertexarray, hashvertices, hashremapping, nullptr);
 
-						surfacesarray[i].I0 = ReMapping[surfacesarray[i].I0];
-						surfacesarray[i].I1 = ReMapping[surfacesarray[i].I1];
-						surfacesarray[i].I2 = ReMapping[surfacesarray[i].I2];
-					}
+					float hashtime = timer.GetElapsedTime() * 1000.0f / iterations;
 
-					//
+					// hashed, parallel
 
-				//	for (size_t i = 0; i < n; ++i)
-					{
-						//	vml::os::Trace("cell %d\n", i);
+					timer.Init();
 
-				//		for (size_t j = 0; j < Cell[i].VertexArray.size(); ++j)
-						{
+					for (int i = 0; i < iterations; ++i)
+						rd.Weld(vertexarray, parallelvertices, parallelremapping, pool);
 
-							//		vml::os::Trace("		vertex %d ( %f %f %f ), (%f %f %f)\n", j,
-							//						Cell[i].VertexArray[j].Vertex.Pos.x, Cell[i].VertexArray[j].Vertex.Pos.y, Cell[i].VertexArray[j].Vertex.Pos.z,
-							//						Cell[i].VertexArray[j].Vertex.Normal.x, Cell[i].VertexArray[j].Vertex.Normal.y, Cell[i].VertexArray[j].Vertex.Normal.z);
+					float paralleltime = timer.GetElapsedTime() * 1000.0f / iterations;
 
-						}
-					}
+					bool match = gridremapping == hashremapping && gridremapping == parallelremapping;
 
+					vml::utils::Logger::GetInstance()->Info("RemoveDuplicates : Benchmark : " + std::to_string(vertexarray.size()) + " vertices welded to " + std::to_string(hashvertices.size()) +
+															 " , Iterations : " + std::to_string(iterations) + " , Workers : " + std::to_string(pool->GetWorkersCount() + 1));
+					vml::utils::Logger::GetInstance()->Info("RemoveDuplicates : Benchmark : Grid            : " + std::to_string(gridtime) + " ms");
+					vml::utils::Logger::GetInstance()->Info("RemoveDuplicates : Benchmark : Hashed          : " + std::to_string(hashtime) + " ms");
+					vml::utils::Logger::GetInstance()->Info("RemoveDuplicates : Benchmark : Hashed parallel : " + std::to_string(paralleltime) + " ms");
+					vml::utils::Logger::GetInstance()->Info("RemoveDuplicates : Benchmark : Match : " + std::string(match ? "yes" : "no"));
 				}
 
 				// ---------------------------------------------------------------
 
 				float GetGainRatio() const { return GainRatio; }
+				float GetTolerance() const { return Tolerance; }
+
+				// ---------------------------------------------------------------
+				// vertices are welded if all their attributes differ by less
+				// than tolerance, tolerance must be greater than zero
+
+				void SetTolerance(const float tolerance)
+				{
+					if (tolerance <= 0.0f)
+						vml::os::Message::Error("RemoveDuplicates : ", "Tolerance must be greater than zero");
+
+					Tolerance   = tolerance;
+					InvCellSize = 1.0 / (2.0 * (double)tolerance);
+				}
 
 				// ---------------------------------------------------------------
 				// ctor / dtor
@@ -300,14 +526,12 @@ namespace vml
 					BoundingBoxExtents = glm::vec3(0, 0, 0);
 					Flags              = 0;
 					GainRatio          = 0.0f;
-					GridSize           = CELLSIZE * CELLSIZE * CELLSIZE;
-					Cell               = new GridCell[GridSize];
+
+					SetTolerance(0.000000000001f);
 				}
 
 				~RemoveDuplicates3D()
-				{
-					vml::os::SafeDeleteArray(Cell);
-				}
+				{}
 
 		};
 
@@ -103,6 +103,7 @@ namespace vml
 				GLint PhongLightDirectionLocation;
 				GLint PhongLightPowerLocation;
 				GLint PhongLightCameraSpaceLocation;
+				GLint PhongOctahedralNormalsLocation;
 
 				// debug directiona light debug material 
 
@@ -124,6 +125,7 @@ namespace vml
 				GLint TexturePhongLightDirectionLocation;
 				GLint TexturePhongLightPowerLocation;
 				GLint TexturePhongLightCameraSpaceLocation;
+				GLint TexturePhongOctahedralNormalsLocation;
 
 				// color location for debug rendering
 
@@ -144,6 +146,34 @@ namespace vml
 				const std::string TextureShaderFilename	 	  = ShadersStorePath + "debug_texture.shd";
 				const std::string TexturePhongShaderFilename  = ShadersStorePath + "debug_texture_phong_dir.shd";
 
+				// -----------------------------------------------------------------------------------
+				// sets model, model view and model view projection matrices for a mesh,
+				// compact meshes store quantized positions, the mesh position matrix is
+				// folded into the matrices to map them back into object space, the normal
+				// matrix is left untouched since normals are not quantized by position
+
+				void SetMeshMatrices(vml::shaders::GlShaderProgram* shader, const vml::meshes::Mesh3d* mesh, const glm::mat4& M, const glm::mat4& MV, const glm::mat4& MVP)
+				{
+					if (mesh->GetVertexFormat() == vml::meshes::Mesh3d::COMPACT_VERTICES)
+					{
+						const glm::mat4& P = mesh->GetPositionMatrix();
+
+						glm::mat4 PM   = M * P;
+						glm::mat4 PMV  = MV * P;
+						glm::mat4 PMVP = MVP * P;
+
+						glUniformMatrix4fv(shader->GetModelMatrixLocation(), 1, GL_FALSE, glm::value_ptr(PM));
+						glUniformMatrix4fv(shader->GetModelViewMatrixLocation(), 1, GL_FALSE, glm::value_ptr(PMV));
+						glUniformMatrix4fv(shader->GetModelViewProjectionMatrixLocation(), 1, GL_FALSE, glm::value_ptr(PMVP));
+					}
+					else
+					{
+						glUniformMatrix4fv(shader->GetModelMatrixLocation(), 1, GL_FALSE, glm::value_ptr(M));
+						glUniformMatrix4fv(shader->GetModelViewMatrixLocation(), 1, GL_FALSE, glm::value_ptr(MV));
+						glUniformMatrix4fv(shader->GetModelViewProjectionMatrixLocation(), 1, GL_FALSE, glm::value_ptr(MVP));
+					}
+				}
+
 				// -----------------------------------------------------------------------------------
 				// closes debug renderer and release memory
 
@@ -940,10 +970,9 @@ namespace vml
 
 						glUniformMatrix4fv(PhongShader->GetViewMatrixLocation()				   , 1, GL_FALSE, view->GetVptr());
 						glUniformMatrix4fv(PhongShader->GetProjectionMatrixLocation()		   , 1, GL_FALSE, view->GetPptr());
-						glUniformMatrix4fv(PhongShader->GetModelMatrixLocation()			   , 1, GL_FALSE, model->GetMptr());
 						glUniformMatrix3fv(PhongShader->GetNormalMatrixLocation()			   , 1, GL_FALSE, model->GetNVptr());
-						glUniformMatrix4fv(PhongShader->GetModelViewMatrixLocation()           , 1, GL_FALSE, model->GetMVptr());
-						glUniformMatrix4fv(PhongShader->GetModelViewProjectionMatrixLocation() , 1, GL_FALSE, model->GetMVPptr());
+						SetMeshMatrices(PhongShader, model->GetCurrentMesh(), model->GetM(), model->GetMV(), model->GetMVP());
+						glUniform1i(PhongOctahedralNormalsLocation, model->GetCurrentMesh()->GetVertexFormat() == vml::meshes::Mesh3d::COMPACT_VERTICES);
 
 						glUniform4fv(PhongMaterialAmbientLocation, 1, &material.Ambient[0]);
 						glUniform4fv(PhongMaterialDiffuseLocation, 1, &material.Diffuse[0]);
@@ -1001,10 +1030,9 @@ namespace vml
 
 						glUniformMatrix4fv(TexturePhongShader->GetViewMatrixLocation(), 1, GL_FALSE, view->GetVptr());
 						glUniformMatrix4fv(TexturePhongShader->GetProjectionMatrixLocation(), 1, GL_FALSE, view->GetPptr());
-						glUniformMatrix4fv(TexturePhongShader->GetModelMatrixLocation(), 1, GL_FALSE, model->GetMptr());
 						glUniformMatrix3fv(TexturePhongShader->GetNormalMatrixLocation(), 1, GL_FALSE, model->GetNVptr());
-						glUniformMatrix4fv(TexturePhongShader->GetModelViewMatrixLocation(), 1, GL_FALSE, model->GetMVptr());
-						glUniformMatrix4fv(TexturePhongShader->GetModelViewProjectionMatrixLocation(), 1, GL_FALSE, model->GetMVPptr());
+						SetMeshMatrices(TexturePhongShader, model->GetCurrentMesh(), model->GetM(), model->GetMV(), model->GetMVP());
+						glUniform1i(TexturePhongOctahedralNormalsLocation, model->GetCurrentMesh()->GetVertexFormat() == vml::meshes::Mesh3d::COMPACT_VERTICES);
 						glUniformMatrix2fv(TexturePhongShader->GetTextureMatrixLocation(), 1, GL_FALSE, model->GetTMptr());
 
 						glUniform4fv(TexturePhongMaterialAmbientLocation, 1, &material.Ambient[0]);
@@ -1069,10 +1097,8 @@ namespace vml
 
 						glUniformMatrix4fv(SingleColorShader->GetViewMatrixLocation(), 1, GL_FALSE, view->GetVptr());
 						glUniformMatrix4fv(SingleColorShader->GetProjectionMatrixLocation(), 1, GL_FALSE, view->GetPptr());
-						glUniformMatrix4fv(SingleColorShader->GetModelMatrixLocation(), 1, GL_FALSE, model->GetMptr());
 						glUniformMatrix3fv(SingleColorShader->GetNormalMatrixLocation(), 1, GL_FALSE, model->GetNVptr());
-						glUniformMatrix4fv(SingleColorShader->GetModelViewMatrixLocation(), 1, GL_FALSE, model->GetMVptr());
-						glUniformMatrix4fv(SingleColorShader->GetModelViewProjectionMatrixLocation(), 1, GL_FALSE, model->GetMVPptr());
+						SetMeshMatrices(SingleColorShader, model->GetCurrentMesh(), model->GetM(), model->GetMV(), model->GetMVP());
 
 						glUniform4f(ColorLocation, WireFrameColor[0], WireFrameColor[1], WireFrameColor[2], WireFrameColor[3]);
 
@@ -1211,10 +1237,9 @@ namespace vml
 
 						glUniformMatrix4fv(PhongShader->GetViewMatrixLocation(), 1, GL_FALSE, view->GetVptr());
 						glUniformMatrix4fv(PhongShader->GetProjectionMatrixLocation(), 1, GL_FALSE, view->GetPptr());
-						glUniformMatrix4fv(PhongShader->GetModelMatrixLocation(), 1, GL_FALSE, glm::value_ptr(M));
 						glUniformMatrix3fv(PhongShader->GetNormalMatrixLocation(), 1, GL_FALSE, glm::value_ptr(NV));
-						glUniformMatrix4fv(PhongShader->GetModelViewMatrixLocation(), 1, GL_FALSE, glm::value_ptr(MV));
-						glUniformMatrix4fv(PhongShader->GetModelViewProjectionMatrixLocation(), 1, GL_FALSE, glm::value_ptr(MVP));
+						SetMeshMatrices(PhongShader, mesh, M, MV, MVP);
+						glUniform1i(PhongOctahedralNormalsLocation, mesh->GetVertexFormat() == vml::meshes::Mesh3d::COMPACT_VERTICES);
 
 						glUniform4fv(PhongMaterialAmbientLocation, 1, &material.Ambient[0]);
 						glUniform4fv(PhongMaterialDiffuseLocation, 1, &material.Diffuse[0]);
@@ -1369,9 +1394,7 @@ namespace vml
 						
 						glUniformMatrix4fv(TextureShader->GetViewMatrixLocation(), 1, GL_FALSE, view->GetVptr());
 						glUniformMatrix4fv(TextureShader->GetProjectionMatrixLocation(), 1, GL_FALSE, view->GetPptr());
-						glUniformMatrix4fv(TextureShader->GetModelMatrixLocation(), 1, GL_FALSE, glm::value_ptr(M));
-						glUniformMatrix4fv(TextureShader->GetModelViewMatrixLocation(), 1, GL_FALSE, glm::value_ptr(MV));
-						glUniformMatrix4fv(TextureShader->GetModelViewProjectionMatrixLocation(), 1, GL_FALSE, glm::value_ptr(MVP));
+						SetMeshMatrices(TextureShader, mesh, M, MV, MVP);
 						glUniformMatrix2fv(TextureShader->GetTextureMatrixLocation(), 1, GL_FALSE, glm::value_ptr(TM));
 						glUniform1i(TextureSamplerLocation, 0);
 
@@ -1477,10 +1500,8 @@ namespace vml
 
 						glUniformMatrix4fv(SingleColorShader->GetViewMatrixLocation(), 1, GL_FALSE, view->GetVptr());
 						glUniformMatrix4fv(SingleColorShader->GetProjectionMatrixLocation(), 1, GL_FALSE, view->GetPptr());
-						glUniformMatrix4fv(SingleColorShader->GetModelMatrixLocation(), 1, GL_FALSE, glm::value_ptr(M));
 						glUniformMatrix3fv(SingleColorShader->GetNormalMatrixLocation(), 1, GL_FALSE, glm::value_ptr(NV));
-						glUniformMatrix4fv(SingleColorShader->GetModelViewMatrixLocation(), 1, GL_FALSE, glm::value_ptr(MV));
-						glUniformMatrix4fv(SingleColorShader->GetModelViewProjectionMatrixLocation(), 1, GL_FALSE, glm::value_ptr(MVP));
+						SetMeshMatrices(SingleColorShader, mesh, M, MV, MVP);
 
 						glUniform4f(ColorLocation, col[0], col[1], col[2], col[3]);
 
@@ -1605,10 +1626,9 @@ namespace vml
 
 								vml::models::Model3d_2* model = object->GetModelAt(i);
 
-								glUniformMatrix4fv(PhongShader->GetModelMatrixLocation(), 1, GL_FALSE, model->GetMptr());
 								glUniformMatrix3fv(PhongShader->GetNormalMatrixLocation(), 1, GL_FALSE, model->GetNVptr());
-								glUniformMatrix4fv(PhongShader->GetModelViewMatrixLocation(), 1, GL_FALSE, model->GetMVptr());
-								glUniformMatrix4fv(PhongShader->GetModelViewProjectionMatrixLocation(), 1, GL_FALSE, model->GetMVPptr());
+								SetMeshMatrices(PhongShader, model->GetCurrentMesh(), model->GetM(), model->GetMV(), model->GetMVP());
+								glUniform1i(PhongOctahedralNormalsLocation, model->GetCurrentMesh()->GetVertexFormat() == vml::meshes::Mesh3d::COMPACT_VERTICES);
 
 								DirectionalLight.CameraSpaceDirection = glm::normalize(view->GetView() * DirectionalLight.Direction);
 								glUniform4fv(PhongLightCameraSpaceLocation, 1, &DirectionalLight.CameraSpaceDirection[0]);
@@ -1876,6 +1896,13 @@ namespace vml
 
 					vml::octree::OctTreeNode** renderednodes = oct->GetRenderedNodes();
 
+					// meshlets surviving culling are drawn through the indirect buffer
+
+					bool meshlets = oct->HasMeshlets();
+
+					if (meshlets)
+						oct->BindMeshletCommands();
+
 					for (size_t i = 0; i < renderednodescount; ++i)
 					{
 						vml::octree::OctTreeNode* node = renderednodes[i];
@@ -1931,16 +1958,32 @@ namespace vml
 
 						glBindVertexArray(node->GetVAOId());
 
-						glDrawElements(
-							GL_TRIANGLES,						// mode
-							(GLsizei)node->GetIndicesCount(),	// count
-							GL_UNSIGNED_INT,					// type
-							(void*)0							// element array buffer offset
-						);
+						if (meshlets)
+						{
+							glMultiDrawElementsIndirect(
+								GL_TRIANGLES,																		// mode
+								GL_UNSIGNED_INT,																	// type
+								(void*)(node->GetFirstCommand() * sizeof(vml::octree::OctTree::MeshletCommand)),	// indirect buffer offset
+								(GLsizei)node->GetCommandsCount(),													// draw count
+								0																					// tightly packed commands
+							);
+						}
+						else
+						{
+							glDrawElements(
+								GL_TRIANGLES,						// mode
+								(GLsizei)node->GetIndicesCount(),	// count
+								GL_UNSIGNED_INT,					// type
+								(void*)0							// element array buffer offset
+							);
+						}
 
 						glBindVertexArray(0);
 						glUseProgram(0);
 					}
+
+					if (meshlets)
+						glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
 				}
 
 				/*
@@ -2354,6 +2397,7 @@ namespace vml
 					PhongLightDirectionLocation    = glGetUniformLocation(Id, "DirectionalLight.direction");
 					PhongLightPowerLocation        = glGetUniformLocation(Id, "DirectionalLight.power");
 					PhongLightCameraSpaceLocation  = glGetUniformLocation(Id, "DirectionalLight.cameraspacedirection");
+					PhongOctahedralNormalsLocation = glGetUniformLocation(Id, "OctahedralNormals");
 					glUseProgram(0);
 					if (PhongMaterialAmbientLocation   == -1) vml::os::Message::Error("GlProgram : ", "debug_phong_dir requires 'Material.ambient' uniform, check shader source code");
 					if (PhongMaterialDiffuseLocation   == -1) vml::os::Message::Error("GlProgram : ", "debug_phong_dir requires 'MaterialDiffuseLocation' uniform, check shader source code");
@@ -2399,6 +2443,7 @@ namespace vml
 					TexturePhongLightDirectionLocation    = glGetUniformLocation(Id, "DirectionalLight.direction");
 					TexturePhongLightPowerLocation        = glGetUniformLocation(Id, "DirectionalLight.power");
 					TexturePhongLightCameraSpaceLocation  = glGetUniformLocation(Id, "DirectionalLight.cameraspacedirection");
+					TexturePhongOctahedralNormalsLocation = glGetUniformLocation(Id, "OctahedralNormals");
 					glUseProgram(0);
 					
 					// retrieve shader alpha textured
@@ -2548,6 +2593,8 @@ namespace vml
 					TexturePhongLightDirectionLocation   = -1;
 					TexturePhongLightPowerLocation		 = -1;
 					TexturePhongLightCameraSpaceLocation = -1;
+					TexturePhongOctahedralNormalsLocation = -1;
+					PhongOctahedralNormalsLocation		 = -1;
 
 					TextureSamplerLocation				 = -1;
 					TexturePhongSamplerLocation			 = -1;
@@ -493,61 +493,33 @@ namespace fa2040
 					
 					std::cout << "MeshBuilder : Saving " << ResourceFileName << std::endl;
 					
-					FILE* stream;
+					// split vertices into the mesh arrays
 
-					errno_t err = fopen_s(&stream, ResourceFileName.c_str(), "wb");
+					std::vector<float> vertexarray(VertexArray.size() * 4);
+					std::vector<float> normalarray(VertexArray.size() * 3);
+					std::vector<float> uvarray(VertexArray.size() * 2);
 
-					if (err == 0)
+					for (size_t i = 0; i < VertexArray.size(); ++i)
 					{
-						// save vertices count
-
-						unsigned int verticescount = (unsigned int)VertexArray.size();
-						fwrite(&verticescount, sizeof(unsigned int), 1, stream);
-
-						// save vertices
-
-						for (size_t i = 0; i < verticescount; ++i)
-						{
-							fwrite(&VertexArray[i].Pos, sizeof(float), 3, stream);
-							fwrite(&VertexArray[i].Normal, sizeof(float), 3, stream);
-							fwrite(&VertexArray[i].UV, sizeof(float), 2, stream);
-						}
-
-					//	std::cout << "MeshBuilder : Saving  vertices " << verticescount << std::endl;
-
-						// save surfaces indices count
-
-						unsigned int indicescount = (int)SurfaceIndices.size();
-						fwrite(&indicescount, sizeof(unsigned int), 1, stream);
-
-						// save surfaces indices
-
-						fwrite(&SurfaceIndices[0], sizeof(unsigned int), indicescount, stream);
-
-					//	std::cout << "MeshBuilder : Saving " << indicescount << std::endl;
-
-						// save metrics
-
-						fwrite(&BoundingBox.GetMin(), sizeof(float), 3, stream);
-						fwrite(&BoundingBox.GetMax(), sizeof(float), 3, stream);
-						fwrite(&Radius, sizeof(float), 1, stream);
+						vertexarray[i * 4    ] = VertexArray[i].Pos.x;
+						vertexarray[i * 4 + 1] = VertexArray[i].Pos.y;
+						vertexarray[i * 4 + 2] = VertexArray[i].Pos.z;
+						vertexarray[i * 4 + 3] = 1.0f;
+						normalarray[i * 3    ] = VertexArray[i].Normal.x;
+						normalarray[i * 3 + 1] = VertexArray[i].Normal.y;
+						normalarray[i * 3 + 2] = VertexArray[i].Normal.z;
+						uvarray[i * 2    ] = VertexArray[i].UV.x;
+						uvarray[i * 2 + 1] = VertexArray[i].UV.y;
+					}
 
-					//	std::cout << "Bmin : " << BoundingBox.GetMin().x << " " << BoundingBox.GetMin().y << " " << BoundingBox.GetMin().z << std::endl;
-					//	std::cout << "Bmax : " << BoundingBox.GetMax().x << " " << BoundingBox.GetMax().y << " " << BoundingBox.GetMax().z << std::endl;
-					//	std::cout << "Radius : " << Radius << std::endl;
+					std::vector<unsigned int> surfaceindices(SurfaceIndices.begin(), SurfaceIndices.end());
 
-						// Close stream if it is not NULL 
+					// save in the aligned mesh format
 
-						if (fclose(stream) != 0)
-							vml::os::Message::Error("MeshBuilder : ", "Cannot close mesh file ' ", ResourceFileName.c_str(), " '");
+					if (!vml::meshes::Mesh3d::Save(ResourceFileName, vertexarray, normalarray, uvarray, surfaceindices, BoundingBox.GetMin(), BoundingBox.GetMax(), Radius))
+						vml::os::Message::Error("MeshBuilder : ", "Cannot save mesh ' ", ResourceFileName.c_str(), " '");
 
-						std::cout << "MeshBuilder : Finished Saving " << ResourceFileName << std::endl;
-						
-					}
-					else
-					{
-						vml::os::Message::Error("MeshBuilder : ", "Cannot save mesh ' ", ResourceFileName.c_str(), " ' (error code : ", err, " )");
-					}
+					std::cout << "MeshBuilder : Finished Saving " << ResourceFileName << std::endl;
 				
 				}
 
@@ -9,6 +9,7 @@
 // view frustum intersection tests
 
 #include <vml4.0\opengl\view\frustum3d.h>
+#include <vml4.0\opengl\view\frustumbatch.h>
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 // view 
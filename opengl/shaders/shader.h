@@ -106,20 +106,16 @@ namespace vml
 					if (filename.empty())
 						vml::os::Message::Error("CGlShaderProgram : ","filename is empty");
 
-					std::ifstream file(filename.c_str(), std::ios::binary);
+					// load source file, from disk or from a mounted archive
 
-					if (!file.is_open())
+					vml::os::FileView file;
+
+					if (!file.Open(filename))
 						return false;
 
-					// load source file
+					std::string source((const char*)file.GetData(), file.GetSize());
 
-					std::string source;
-					file.seekg(0, std::ios::end);
-					unsigned int fileSize = static_cast<unsigned int>(file.tellg());
-					source.resize(fileSize);
-					file.seekg(0, std::ios::beg);
-					file.read(&source[0], fileSize);
-					file.close();
+					file.Close();
 
 					// compile
 
@@ -33,9 +33,10 @@ namespace vml
 				unsigned char* Data;				// actual image bytes
 				
 				// --------------------------------------------------------------------------
-				// create texture according to specified parameters
+				// decodes image and validates texture parameters, no opengl calls
+				// are made here so this can run on a loading thread
 
-				void CreateTexture2dFromData()
+				void DecodeImage()
 				{
 					// set parameters for this texture
 					
@@ -43,13 +44,16 @@ namespace vml
 					Height        = 0;
 					BPP           = 0;
 				
-					// load image trhouhg stb
+					// load image trhouhg stb, flip flag is per thread
+
+					stbi_set_flip_vertically_on_load_thread(true);
 
-					stbi_set_flip_vertically_on_load(true);
+					// fill data, image is decoded from a mapped file or from a mounted archive
 
-					// fill data
+					vml::os::FileView file;
 
-					Data = stbi_load(ResourceFileName.c_str(), &Width, &Height, &BPP, 0);
+					if (file.Open(ResourceFileName))
+						Data = stbi_load_from_memory(file.GetData(), (int)file.GetSize(), &Width, &Height, &BPP, 0);
 
 					//vml::utils::Logger::GetInstance()->Info("Texture", "Creating : " + ResourceFileName);
 
@@ -124,7 +128,21 @@ namespace vml
 							DataFormat = TEXTURE_RGBA;
 							Format = GammaCorrection ? TEXTURE_SRGB_ALPHA : TEXTURE_RGBA;
 						}
+					}
+					else
+					{
+						vml::os::Message::Error("Texture :","failed to load at path : ' ", ResourceFileName.c_str()," '");
+						stbi_image_free(Data);
+					}
+				}
+
+				// --------------------------------------------------------------------------
+				// creates opengl texture from decoded image
 
+				void CreateGLTexture()
+				{
+					if (Data)
+					{
 						// generate texture
 
 						glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
@@ -183,10 +201,54 @@ namespace vml
 						}
 
 					}
-					else
+				}
+
+				// --------------------------------------------------------------------------
+				// create texture according to specified parameters
+
+				void CreateTexture2dFromData()
+				{
+					DecodeImage();
+					CreateGLTexture();
+				}
+
+				// --------------------------------------------------------------------------
+				// sets default values and texture parameters, follow this *strict* 
+				// order , since each entry is correlated to the opengl texture parm(s)
+
+				void SetParms(const uint32_t* parms, size_t count)
+				{
+					TextureType			= GL_TEXTURE_2D;
+					Width				= 0;
+					Height				= 0;	
+					ID					= 0;	
+					BPP					= 0;		
+					Format				= 0;
+					DataFormat			= 0;
+					Anisotropy			= 0;
+					Data				= nullptr;						// image buffer
+					RepeatS				= TEXTURE_REPEAT_S;				// repeats;
+					RepeatT				= TEXTURE_REPEAT_T;				// repeatt;
+					Magnification		= TEXTURE_FILTER_MAG_LINEAR;	// magnification;
+					Minification		= TEXTURE_FILTER_MIN_LINEAR;	// minification;
+					MipMapsGenerated	= TEXTURE_MIPMAP_TRUE;			// mipmapsgenerated;
+					GammaCorrection		= TEXTURE_GAMMA_FALSE;			// gammacorrection;
+					ReleaseTextureData	= TEXTURE_RELEASE_DATA_TRUE;	// preservedata;
+					Resident			= TEXTURE_RESIDENT_FALSE;		// resident;
+
+					// if extra pack is provided then extract pack data
+					// and assign to each texture parm(s)
+					
+					if (count != 0 )
 					{
-						vml::os::Message::Error("Texture :","failed to load at path : ' ", ResourceFileName.c_str()," '");
-						stbi_image_free(Data);
+						RepeatS			   = parms[0];		// repeats;
+						RepeatT			   = parms[1];		// repeatt;
+						Magnification	   = parms[2];		// magnification;
+						Minification	   = parms[3];		// minification;
+						MipMapsGenerated   = parms[4];		// mipmapsgenerated;
+						GammaCorrection    = parms[5];		// gammacorrection;
+						ReleaseTextureData = parms[6];		// preservedata;
+						Resident		   = parms[7];		// resident;
 					}
 				}
 				
@@ -382,6 +444,17 @@ namespace vml
 				constexpr bool		    IsValid()                const { return ( Data != nullptr) && (Width!=0) && (Height!=0); }
 				constexpr bool		    IsDataPreserved()        const { return ReleaseTextureData; }
 					
+				// ------------------------------------------------------------
+				// gets bytes held by the texture, mipmaps chain adds a third,
+				// image data counts if it is preserved
+
+				size_t GetMemorySize() const override
+				{
+					size_t bytes = (size_t)Width * Height * BPP;
+					size_t gpu	 = MipMapsGenerated == TEXTURE_MIPMAP_TRUE ? bytes * 4 / 3 : bytes;
+					return Data ? gpu + bytes : gpu;
+				}
+
 				// ------------------------------------------------------------
 				// Texture uploading default parameters
 				// follow this *strict* order , since each 
@@ -401,46 +474,31 @@ namespace vml
 
 				Texture( const std::string &resourcefilename, const std::initializer_list<uint32_t>& il) : vml::utils::SharedResource(resourcefilename,il)
 				{
-
-					TextureType			= GL_TEXTURE_2D;
-					Width				= 0;
-					Height				= 0;	
-					ID					= 0;	
-					BPP					= 0;		
-					Format				= 0;
-					DataFormat			= 0;
-					Anisotropy			= 0;
-					Data				= nullptr;						// image buffer
-					RepeatS				= TEXTURE_REPEAT_S;				// repeats;
-					RepeatT				= TEXTURE_REPEAT_T;				// repeatt;
-					Magnification		= TEXTURE_FILTER_MAG_LINEAR;	// magnification;
-					Minification		= TEXTURE_FILTER_MIN_LINEAR;	// minification;
-					MipMapsGenerated	= TEXTURE_MIPMAP_TRUE;			// mipmapsgenerated;
-					GammaCorrection		= TEXTURE_GAMMA_FALSE;			// gammacorrection;
-					ReleaseTextureData	= TEXTURE_RELEASE_DATA_TRUE;	// preservedata;
-					Resident			= TEXTURE_RESIDENT_FALSE;		// resident;
-
-					// if extra pack is provided then extract pack data
-					// and assign to each texture parm(s), follow strictly 
-					// the assigned order
-					
-					if (il.size() != 0 )
-					{
-						RepeatS			   = *(il.begin() + 0);		// repeats;
-						RepeatT			   = *(il.begin() + 1);		// repeatt;
-						Magnification	   = *(il.begin() + 2);		// magnification;
-						Minification	   = *(il.begin() + 3);		// minification;
-						MipMapsGenerated   = *(il.begin() + 4);		// mipmapsgenerated;
-						GammaCorrection    = *(il.begin() + 5);		// gammacorrection;
-						ReleaseTextureData = *(il.begin() + 6);		// preservedata;
-						Resident		   = *(il.begin() + 7);		// resident;
-					}
+					SetParms(il.begin(), il.size());
 
 					// create opengl texture
 
 					CreateTexture2dFromData();
 				}
 
+				// deferred constructor, decodes the image but leaves texture
+				// creation to Finalize, see the store asynchronous loading
+
+				Texture(const std::string& resourcefilename, const std::vector<uint32_t>& parms, vml::utils::SharedResource::DeferredLoad) : vml::utils::SharedResource(resourcefilename, {})
+				{
+					SetParms(parms.data(), parms.size());
+
+					DecodeImage();
+				}
+
+				// creates opengl texture, must be called on the thread owning the 
+				// opengl context
+
+				void Finalize() override
+				{
+					CreateGLTexture();
+				}
+
 				~Texture()
 				{
 					if (ID) glDeleteTextures(1, &ID);
@@ -0,0 +1,347 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////////
+//	This source file is part of v71's engine
+//
+//	Copyright (c) 2011-2050 v71
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in-
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#include <immintrin.h>
+
+////////////////////////////////////////////////////////////////////////////////////
+// msvc emits avx instructions without any compiler switch, gcc and clang
+// need the target to be enabled on a per function basis
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define VML_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define VML_TARGET_AVX2
+#endif
+
+namespace vml
+{
+
+	namespace views
+	{
+
+		namespace frustum
+		{
+
+			///////////////////////////////////////////////////////////////
+			// batched frustum culling, boxes are given as soa arrays of
+			// centers and half extents, a result code for each box is
+			// written into the results array, result codes are the same
+			// as the ones returned by TestAABBox
+
+			class BatchCuller
+			{
+
+				public:
+
+					// ---------------------------------------------------------------
+					// culling kernels
+
+					static const unsigned int SCALAR = 0;
+					static const unsigned int SSE	 = 1;
+					static const unsigned int AVX2	 = 2;
+
+				private:
+
+					// ---------------------------------------------------------------
+					// kernel currently in use, and the best kernel the cpu supports
+					// detection is performed only once, the first time the culler
+					// is accessed, only the needed cpu features are queried since
+					// a full SystemInfo measure also times the cpu clock
+
+					static unsigned int DetectKernel()
+					{
+						if (vml::os::SystemInfo::QueryAVX2()) return AVX2;
+						if (vml::os::SystemInfo::QuerySSE2()) return SSE;
+
+						return SCALAR;
+					}
+
+					static unsigned int& SupportedKernel()
+					{
+						static unsigned int kernel = DetectKernel();
+						return kernel;
+					}
+
+					static unsigned int& ActiveKernel()
+					{
+						static unsigned int kernel = SupportedKernel();
+						return kernel;
+					}
+
+					// ---------------------------------------------------------------
+					// scalar kernel, also used for the tail of the simd kernels
+
+					static void CullScalar(const glm::vec4* planes,
+										   const float* centerx, const float* centery, const float* centerz,
+										   const float* extentx, const float* extenty, const float* extentz,
+										   size_t first, size_t count, unsigned int* results)
+					{
+						for (size_t i = first; i < count; ++i)
+						{
+							unsigned int result = INSIDE;
+
+							for (size_t j = 0; j < 6; ++j)
+							{
+								float d = centerx[i] * planes[j].x + centery[i] * planes[j].y + centerz[i] * planes[j].z + planes[j].w;
+								float r = extentx[i] * fabs(planes[j].x) + extenty[i] * fabs(planes[j].y) + extentz[i] * fabs(planes[j].z);
+
+								if (d + r < 0) { result = OUTSIDE; break; }			// out
+								if (d - r < 0)	 result = INTERSECTED;				// intersection
+							}
+
+							results[i] = result;
+						}
+					}
+
+					// ---------------------------------------------------------------
+					// sse kernel, 4 boxes per iteration, a box is outside if it lies behind
+					// any plane, intersected if it straddles any plane, otherwise inside
+
+					static void CullSSE(const glm::vec4* planes,
+										const float* centerx, const float* centery, const float* centerz,
+										const float* extentx, const float* extenty, const float* extentz,
+										size_t count, unsigned int* results)
+					{
+						__m128 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+
+						for (size_t j = 0; j < 6; ++j)
+						{
+							px[j] = _mm_set1_ps(planes[j].x);
+							py[j] = _mm_set1_ps(planes[j].y);
+							pz[j] = _mm_set1_ps(planes[j].z);
+							pw[j] = _mm_set1_ps(planes[j].w);
+							ax[j] = _mm_set1_ps(fabs(planes[j].x));
+							ay[j] = _mm_set1_ps(fabs(planes[j].y));
+							az[j] = _mm_set1_ps(fabs(planes[j].z));
+						}
+
+						const __m128  zero		  = _mm_setzero_ps();
+						const __m128i outside	  = _mm_set1_epi32(OUTSIDE);
+						const __m128i inside	  = _mm_set1_epi32(INSIDE);
+						const __m128i intersected = _mm_set1_epi32(INTERSECTED);
+
+						size_t n = count & ~size_t(3);
+
+						for (size_t i = 0; i < n; i += 4)
+						{
+							__m128 cx = _mm_loadu_ps(centerx + i);
+							__m128 cy = _mm_loadu_ps(centery + i);
+							__m128 cz = _mm_loadu_ps(centerz + i);
+							__m128 ex = _mm_loadu_ps(extentx + i);
+							__m128 ey = _mm_loadu_ps(extenty + i);
+							__m128 ez = _mm_loadu_ps(extentz + i);
+
+							__m128 outmask	 = _mm_setzero_ps();
+							__m128 intermask = _mm_setzero_ps();
+
+							for (size_t j = 0; j < 6; ++j)
+							{
+								__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, px[j]), _mm_mul_ps(cy, py[j])), _mm_add_ps(_mm_mul_ps(cz, pz[j]), pw[j]));
+								__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ax[j]), _mm_mul_ps(ey, ay[j])), _mm_mul_ps(ez, az[j]));
+
+								outmask	  = _mm_or_ps(outmask,   _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+								intermask = _mm_or_ps(intermask, _mm_cmplt_ps(_mm_sub_ps(d, r), zero));
+							}
+
+							// select result codes, outside takes precedence over intersected
+
+							__m128i om = _mm_castps_si128(outmask);
+							__m128i im = _mm_castps_si128(intermask);
+
+							__m128i result = _mm_or_si128(_mm_and_si128(im, intersected), _mm_andnot_si128(im, inside));
+							result		   = _mm_or_si128(_mm_and_si128(om, outside),	  _mm_andnot_si128(om, result));
+
+							_mm_storeu_si128((__m128i*)(results + i), result);
+						}
+
+						CullScalar(planes, centerx, centery, centerz, extentx, extenty, extentz, n, count, results);
+					}
+
+					// ---------------------------------------------------------------
+					// avx2 kernel, 8 boxes per iteration
+
+					VML_TARGET_AVX2 static void CullAVX2(const glm::vec4* planes,
+														 const float* centerx, const float* centery, const float* centerz,
+														 const float* extentx, const float* extenty, const float* extentz,
+														 size_t count, unsigned int* results)
+					{
+						__m256 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+
+						for (size_t j = 0; j < 6; ++j)
+						{
+							px[j] = _mm256_set1_ps(planes[j].x);
+							py[j] = _mm256_set1_ps(planes[j].y);
+							pz[j] = _mm256_set1_ps(planes[j].z);
+							pw[j] = _mm256_set1_ps(planes[j].w);
+							ax[j] = _mm256_set1_ps(fabs(planes[j].x));
+							ay[j] = _mm256_set1_ps(fabs(planes[j].y));
+							az[j] = _mm256_set1_ps(fabs(planes[j].z));
+						}
+
+						const __m256  zero		  = _mm256_setzero_ps();
+						const __m256i outside	  = _mm256_set1_epi32(OUTSIDE);
+						const __m256i inside	  = _mm256_set1_epi32(INSIDE);
+						const __m256i intersected = _mm256_set1_epi32(INTERSECTED);
+
+						size_t n = count & ~size_t(7);
+
+						for (size_t i = 0; i < n; i += 8)
+						{
+							__m256 cx = _mm256_loadu_ps(centerx + i);
+							__m256 cy = _mm256_loadu_ps(centery + i);
+							__m256 cz = _mm256_loadu_ps(centerz + i);
+							__m256 ex = _mm256_loadu_ps(extentx + i);
+							__m256 ey = _mm256_loadu_ps(extenty + i);
+							__m256 ez = _mm256_loadu_ps(extentz + i);
+
+							__m256 outmask	 = _mm256_setzero_ps();
+							__m256 intermask = _mm256_setzero_ps();
+
+							for (size_t j = 0; j < 6; ++j)
+							{
+								__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, px[j]), _mm256_mul_ps(cy, py[j])), _mm256_add_ps(_mm256_mul_ps(cz, pz[j]), pw[j]));
+								__m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, ax[j]), _mm256_mul_ps(ey, ay[j])), _mm256_mul_ps(ez, az[j]));
+
+								outmask	  = _mm256_or_ps(outmask,   _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_LT_OQ));
+								intermask = _mm256_or_ps(intermask, _mm256_cmp_ps(_mm256_sub_ps(d, r), zero, _CMP_LT_OQ));
+							}
+
+							// select result codes, outside takes precedence over intersected
+
+							__m256i result = _mm256_blendv_epi8(inside, intersected, _mm256_castps_si256(intermask));
+							result		   = _mm256_blendv_epi8(result, outside,	 _mm256_castps_si256(outmask));
+
+							_mm256_storeu_si256((__m256i*)(results + i), result);
+						}
+
+						CullScalar(planes, centerx, centery, centerz, extentx, extenty, extentz, n, count, results);
+					}
+
+				public:
+
+					// ---------------------------------------------------------------
+					// culls count boxes against the frustum planes
+
+					static void Cull(const glm::vec4* planes,
+									 const float* centerx, const float* centery, const float* centerz,
+									 const float* extentx, const float* extenty, const float* extentz,
+									 size_t count, unsigned int* results)
+					{
+						switch (ActiveKernel())
+						{
+							case AVX2 : CullAVX2(planes, centerx, centery, centerz, extentx, extenty, extentz, count, results);	   break;
+							case SSE  : CullSSE(planes, centerx, centery, centerz, extentx, extenty, extentz, count, results);	   break;
+							default	  : CullScalar(planes, centerx, centery, centerz, extentx, extenty, extentz, 0, count, results); break;
+						}
+					}
+
+					// ---------------------------------------------------------------
+					// kernel selection, a kernel can be forced, for example to compare
+					// kernels, but it can't exceed what the cpu supports
+
+					static unsigned int GetKernel()
+					{
+						return ActiveKernel();
+					}
+
+					static unsigned int GetSupportedKernel()
+					{
+						return SupportedKernel();
+					}
+
+					static void SetKernel(unsigned int kernel)
+					{
+						if (kernel > SupportedKernel())
+							vml::os::Message::Error("Frustum : ", "Culling kernel is not supported by this cpu");
+						ActiveKernel() = kernel;
+					}
+
+					static std::string GetKernelString(unsigned int kernel)
+					{
+						switch (kernel)
+						{
+							case AVX2 : return "AVX2";
+							case SSE  : return "SSE";
+						}
+						return "Scalar";
+					}
+
+					// ---------------------------------------------------------------
+					// microbenchmark, culls random boxes against the given frustum with
+					// every supported kernel, from 1k to 1M boxes, results are written
+					// to the log as boxes per second
+
+					static void Benchmark(const glm::vec4* planes, int iterations = 16)
+					{
+						if (iterations < 1)
+							vml::os::Message::Error("Frustum : ", "Benchmark iterations must be greater than zero");
+
+						unsigned int activekernel = ActiveKernel();
+
+						std::mt19937 generator(71);
+						std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+						std::uniform_real_distribution<float> extent(0.1f, 10.0f);
+
+						vml::os::Timer timer;
+
+						timer.Init();
+
+						for (size_t count = 1000; count <= 1000000; count *= 10)
+						{
+							std::vector<float> cx(count), cy(count), cz(count);
+							std::vector<float> ex(count), ey(count), ez(count);
+							std::vector<unsigned int> results(count);
+
+							for (size_t i = 0; i < count; ++i)
+							{
+								cx[i] = position(generator); cy[i] = position(generator); cz[i] = position(generator);
+								ex[i] = extent(generator);	 ey[i] = extent(generator);	  ez[i] = extent(generator);
+							}
+
+							for (unsigned int kernel = SCALAR; kernel <= SupportedKernel(); ++kernel)
+							{
+								ActiveKernel() = kernel;
+
+								float start = timer.GetElapsedTime();
+
+								for (int i = 0; i < iterations; ++i)
+									Cull(planes, cx.data(), cy.data(), cz.data(), ex.data(), ey.data(), ez.data(), count, results.data());
+
+								float elapsed = timer.GetElapsedTime() - start;
+
+								double rate = elapsed > 0 ? double(count) * double(iterations) / double(elapsed) : 0.0;
+
+								vml::utils::Logger::GetInstance()->Info("Frustum : Benchmark : " + GetKernelString(kernel) + " : " + std::to_string(count) + " boxes : " + std::to_string(rate) + " boxes/s");
+							}
+						}
+
+						ActiveKernel() = activekernel;
+					}
+
+			};
+
+		}
+	}
+}
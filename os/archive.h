@@ -0,0 +1,942 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////////
+//	This source file is part of v71's engine
+//
+//	Copyright (c) 2011-2050 v71
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+namespace vml
+{
+	namespace os
+	{
+
+		////////////////////////////////////////////////////////////////////////////
+		// lz4 block format codec, compression is greedy with a single hash
+		// probe per position, which is fast and good enough for packing,
+		// decompression validates every sequence against both buffers
+
+		namespace lz4
+		{
+
+			// ---------------------------------------------------------------
+			// format constants
+
+			static const size_t MIN_MATCH	   = 4;			// minimum match length
+			static const size_t LAST_LITERALS  = 5;			// last bytes are always literals
+			static const size_t MATCH_LIMIT	   = 12;		// last match must start before this distance from the end
+			static const size_t MAX_OFFSET	   = 65535;		// matches offset is 16 bits
+			static const int	HASH_LOG	   = 16;		// hash table size
+
+			// ---------------------------------------------------------------
+			// worst case compressed size
+
+			static size_t GetMaxCompressedSize(size_t size)
+			{
+				return size + size / 255 + 16;
+			}
+
+			// ---------------------------------------------------------------
+			// writes a length continuation
+
+			static size_t WriteLength(unsigned char* dst, size_t op, size_t length)
+			{
+				while (length >= 255)
+				{
+					dst[op++] = 255;
+					length -= 255;
+				}
+
+				dst[op++] = (unsigned char)length;
+
+				return op;
+			}
+
+			// ---------------------------------------------------------------
+			// compresses src into dst, dst must hold GetMaxCompressedSize
+			// bytes, returns the compressed size
+
+			static size_t Compress(const unsigned char* src, size_t size, unsigned char* dst)
+			{
+				std::vector<uint32_t> table((size_t)1 << HASH_LOG, UINT32_MAX);
+
+				size_t ip	  = 0;
+				size_t anchor = 0;
+				size_t op	  = 0;
+
+				if (size > MATCH_LIMIT)
+				{
+					size_t limit = size - MATCH_LIMIT;
+
+					while (ip <= limit)
+					{
+						uint32_t sequence;
+
+						memcpy(&sequence, src + ip, sizeof(uint32_t));
+
+						uint32_t h	 = (sequence * 2654435761u) >> (32 - HASH_LOG);
+						uint32_t ref = table[h];
+
+						table[h] = (uint32_t)ip;
+
+						if (ref == UINT32_MAX || ip - ref > MAX_OFFSET || memcmp(src + ref, src + ip, MIN_MATCH) != 0)
+						{
+							ip++;
+							continue;
+						}
+
+						// extend match, the last literals are never matched
+
+						size_t length	 = MIN_MATCH;
+						size_t maxlength = size - LAST_LITERALS - ip;
+
+						while (length < maxlength && src[ref + length] == src[ip + length])
+							length++;
+
+						// token, literals, offset and match length
+
+						size_t literals = ip - anchor;
+						size_t token	= op++;
+
+						dst[token] = (unsigned char)(std::min<size_t>(literals, 15) << 4);
+
+						if (literals >= 15)
+							op = WriteLength(dst, op, literals - 15);
+
+						memcpy(dst + op, src + anchor, literals);
+						op += literals;
+
+						size_t offset = ip - ref;
+
+						dst[op++] = (unsigned char)(offset & 255);
+						dst[op++] = (unsigned char)(offset >> 8);
+
+						size_t matchlength = length - MIN_MATCH;
+
+						dst[token] |= (unsigned char)std::min<size_t>(matchlength, 15);
+
+						if (matchlength >= 15)
+							op = WriteLength(dst, op, matchlength - 15);
+
+						ip	  += length;
+						anchor = ip;
+					}
+				}
+
+				// last sequence is literals only
+
+				size_t literals = size - anchor;
+
+				dst[op++] = (unsigned char)(std::min<size_t>(literals, 15) << 4);
+
+				if (literals >= 15)
+					op = WriteLength(dst, op, literals - 15);
+
+				memcpy(dst + op, src + anchor, literals);
+				op += literals;
+
+				return op;
+			}
+
+			// ---------------------------------------------------------------
+			// decompresses src into dst, returns false if data is corrupted
+			// or doesn't decompress to exactly size bytes
+
+			static bool Decompress(const unsigned char* src, size_t packedsize, unsigned char* dst, size_t size)
+			{
+				size_t ip = 0;
+				size_t op = 0;
+
+				while (ip < packedsize)
+				{
+					unsigned char token = src[ip++];
+
+					// literals
+
+					size_t literals = token >> 4;
+
+					if (literals == 15)
+					{
+						unsigned char b;
+
+						do
+						{
+							if (ip >= packedsize)
+								return false;
+							b = src[ip++];
+							literals += b;
+						} while (b == 255);
+					}
+
+					if (literals > packedsize - ip || literals > size - op)
+						return false;
+
+					memcpy(dst + op, src + ip, literals);
+					ip += literals;
+					op += literals;
+
+					// last sequence has no match
+
+					if (ip == packedsize)
+						break;
+
+					// match
+
+					if (packedsize - ip < 2)
+						return false;
+
+					size_t offset = (size_t)src[ip] | ((size_t)src[ip + 1] << 8);
+
+					ip += 2;
+
+					if (offset == 0 || offset > op)
+						return false;
+
+					size_t length = token & 15;
+
+					if (length == 15)
+					{
+						unsigned char b;
+
+						do
+						{
+							if (ip >= packedsize)
+								return false;
+							b = src[ip++];
+							length += b;
+						} while (b == 255);
+					}
+
+					length += MIN_MATCH;
+
+					if (length > size - op)
+						return false;
+
+					// matches can overlap the bytes they produce
+
+					const unsigned char* match = dst + op - offset;
+
+					for (size_t i = 0; i < length; ++i)
+						dst[op + i] = match[i];
+
+					op += length;
+				}
+
+				return op == size;
+			}
+
+		}
+
+		////////////////////////////////////////////////////////////////////////////
+		// packed assets archive, files are stored at 16 bytes aligned offsets
+		// so that uncompressed entries can be used in place from the mapped 
+		// archive, the directory is sorted by path hash, paths are stored 
+		// relative to the archive root, lower case with forward slashes.
+		// archives are mounted over a directory, files under that directory
+		// are looked up in mounted archives first, see FileView
+		//
+		// layout : header, entries data, directory, names
+
+		class Archive
+		{
+
+			public:
+
+				// ----------------------------------------------------------------
+				// file layout
+
+				struct Header
+				{
+					char	 Magic[4];				// 'VPAK'
+					uint32_t Version;				// archive format version
+					uint32_t EntriesCount;			// directory entries count
+					uint32_t Reserved;
+					uint64_t DirectoryOffset;		// directory offset
+					uint64_t NamesOffset;			// names offset
+					uint64_t NamesSize;				// names size in bytes
+				};
+
+				struct Entry
+				{
+					uint64_t Hash;					// path hash
+					uint64_t Offset;				// data offset, 16 bytes aligned
+					uint64_t Size;					// file size
+					uint64_t PackedSize;			// stored size, equals size if not compressed
+					uint32_t Flags;					// entry flags
+					uint32_t NameOffset;			// path offset in names
+					uint32_t NameLength;			// path length
+					uint32_t Reserved;
+				};
+
+				static const uint32_t VERSION		   = 1;
+				static const uint64_t ALIGNMENT		   = 16;
+				static const uint32_t ENTRY_COMPRESSED = 1;
+
+			private:
+
+				// ----------------------------------------------------------------
+				// private data
+
+				vml::os::MappedFile File;			// mapped archive
+				std::string			Root;			// normalized mount directory, with trailing slash
+				const Header*		ArchiveHeader;	// archive header
+				const Entry*		Entries;		// sorted directory
+				const char*			Names;			// paths
+
+				// ----------------------------------------------------------------
+				// mounted archives, most recently mounted are searched first
+
+				static inline std::shared_mutex					  MountMutex;
+				static inline std::vector<std::shared_ptr<Archive>> Mounted;
+
+				// ----------------------------------------------------------------
+				// aligns an offset to entries alignment
+
+				static uint64_t AlignOffset(uint64_t offset)
+				{
+					return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+				}
+
+				// ----------------------------------------------------------------
+				// writes zeroes up to the given offset, returns false on a short write
+
+				static bool PadFile(FILE* stream, uint64_t& position, uint64_t offset)
+				{
+					static const unsigned char zero[ALIGNMENT] = {};
+					size_t size = (size_t)(offset - position);
+					position = offset;
+					return fwrite(zero, 1, size, stream) == size;
+				}
+
+			public:
+
+				// ----------------------------------------------------------------
+				// normalizes a path for lookup, lower case and forward slashes
+
+				static std::string NormalizePath(const std::string& path)
+				{
+					std::string normalized;
+
+					normalized.reserve(path.size());
+
+					for (char c : path)
+					{
+						if (c == '\\')
+							c = '/';
+
+						// collapse repeated separators
+
+						if (c == '/' && !normalized.empty() && normalized.back() == '/')
+							continue;
+
+						normalized.push_back((char)tolower((unsigned char)c));
+					}
+
+					return normalized;
+				}
+
+				// ----------------------------------------------------------------
+				// opens an archive and mounts it over root directory, returns 
+				// false if the file is missing or is not a valid archive
+
+				bool Open(const std::string& filename, const std::string& root)
+				{
+					Close();
+
+					if (!File.Open(filename))
+						return false;
+
+					const Header* header = (const Header*)File.GetDataAt(0, sizeof(Header));
+
+					if (!header || memcmp(header->Magic, "VPAK", 4) != 0 || header->Version != VERSION)
+					{
+						File.Close();
+						return false;
+					}
+
+					Entries = (const Entry*)File.GetDataAt((size_t)header->DirectoryOffset, (size_t)header->EntriesCount * sizeof(Entry));
+					Names	= (const char*)File.GetDataAt((size_t)header->NamesOffset, (size_t)header->NamesSize);
+
+					if (!Entries || (!Names && header->NamesSize != 0))
+					{
+						File.Close();
+						return false;
+					}
+
+					// validate entries against file and names, stored entries are
+					// used in place, so their size must be their stored size
+
+					for (uint32_t i = 0; i < header->EntriesCount; ++i)
+					{
+						const Entry& entry = Entries[i];
+
+						bool stored = (entry.Flags & ENTRY_COMPRESSED) == 0;
+
+						if (!File.GetDataAt((size_t)entry.Offset, (size_t)entry.PackedSize) || (uint64_t)entry.NameOffset + entry.NameLength > header->NamesSize || (stored && entry.Size != entry.PackedSize))
+						{
+							File.Close();
+							return false;
+						}
+					}
+
+					ArchiveHeader = header;
+
+					Root = NormalizePath(root);
+
+					if (!Root.empty() && Root.back() != '/')
+						Root.push_back('/');
+
+					return true;
+				}
+
+				// ----------------------------------------------------------------
+				// closes archive
+
+				void Close()
+				{
+					File.Close();
+					Root.clear();
+					ArchiveHeader = nullptr;
+					Entries		  = nullptr;
+					Names		  = nullptr;
+				}
+
+				// ----------------------------------------------------------------
+				// finds an entry from a full path, returns nullptr if path is 
+				// not under the archive root or not in the archive
+
+				const Entry* Find(const std::string& filename) const
+				{
+					if (!ArchiveHeader)
+						return nullptr;
+
+					std::string path = NormalizePath(filename);
+
+					if (path.compare(0, Root.size(), Root) != 0)
+						return nullptr;
+
+					std::string name = path.substr(Root.size());
+
+					uint64_t hash = vml::utils::hash::Fnv1a64(name);
+
+					const Entry* first = Entries;
+					const Entry* last  = Entries + ArchiveHeader->EntriesCount;
+
+					const Entry* it = std::lower_bound(first, last, hash, [](const Entry& entry, uint64_t h) { return entry.Hash < h; });
+
+					for (; it != last && it->Hash == hash; ++it)
+						if (name.compare(0, std::string::npos, Names + it->NameOffset, it->NameLength) == 0)
+							return it;
+
+					return nullptr;
+				}
+
+				// ----------------------------------------------------------------
+				// gets entry data in place, nullptr for compressed entries
+
+				const unsigned char* GetEntryData(const Entry* entry) const
+				{
+					if (entry->Flags & ENTRY_COMPRESSED)
+						return nullptr;
+
+					return (const unsigned char*)File.GetDataAt((size_t)entry->Offset, (size_t)entry->Size);
+				}
+
+				// ----------------------------------------------------------------
+				// reads entry data, compressed entries are decompressed
+
+				bool Read(const Entry* entry, std::vector<unsigned char>& data) const
+				{
+					const unsigned char* src = (const unsigned char*)File.GetDataAt((size_t)entry->Offset, (size_t)entry->PackedSize);
+
+					if (!src)
+						return false;
+
+					data.resize((size_t)entry->Size);
+
+					if (entry->Flags & ENTRY_COMPRESSED)
+						return lz4::Decompress(src, (size_t)entry->PackedSize, data.data(), data.size());
+
+					memcpy(data.data(), src, data.size());
+
+					return true;
+				}
+
+				// ----------------------------------------------------------------
+				// getters
+
+				uint32_t		   GetEntriesCount()			const { return ArchiveHeader ? ArchiveHeader->EntriesCount : 0; }
+				const Entry*	   GetEntry(uint32_t i)		const { return &Entries[i]; }
+				std::string		   GetEntryName(uint32_t i)	const { return std::string(Names + Entries[i].NameOffset, Entries[i].NameLength); }
+				const std::string& GetRoot()					const { return Root; }
+				const std::string& GetFileName()				const { return File.GetFileName(); }
+				bool			   IsOpen()						const { return ArchiveHeader != nullptr; }
+
+				// ----------------------------------------------------------------
+				// mounts an archive over root directory, file views opened from an
+				// archive keep it alive, so it can be unmounted while resources
+				// read from it are still loading
+
+				static bool Mount(const std::string& filename, const std::string& root)
+				{
+					std::shared_ptr<Archive> archive = std::make_shared<Archive>();
+
+					if (!archive->Open(filename, root))
+						return false;
+
+					std::unique_lock<std::shared_mutex> lock(MountMutex);
+
+					Mounted.push_back(std::move(archive));
+
+					return true;
+				}
+
+				// ----------------------------------------------------------------
+				// unmounts an archive, returns false if it is not mounted
+
+				static bool Unmount(const std::string& filename)
+				{
+					std::unique_lock<std::shared_mutex> lock(MountMutex);
+
+					for (auto it = Mounted.begin(); it != Mounted.end(); ++it)
+					{
+						if ((*it)->GetFileName() == filename)
+						{
+							Mounted.erase(it);
+							return true;
+						}
+					}
+
+					return false;
+				}
+
+				// ----------------------------------------------------------------
+				// unmounts all archives
+
+				static void UnmountAll()
+				{
+					std::unique_lock<std::shared_mutex> lock(MountMutex);
+
+					Mounted.clear();
+				}
+
+				// ----------------------------------------------------------------
+				// finds a file in mounted archives, the returned archive stays
+				// valid, along with entry, even if it is unmounted meanwhile
+
+				static bool Resolve(const std::string& filename, std::shared_ptr<const Archive>& archive, const Entry*& entry)
+				{
+					std::shared_lock<std::shared_mutex> lock(MountMutex);
+
+					for (auto it = Mounted.rbegin(); it != Mounted.rend(); ++it)
+					{
+						entry = (*it)->Find(filename);
+
+						if (entry)
+						{
+							archive = *it;
+							return true;
+						}
+					}
+
+					archive = nullptr;
+					entry	= nullptr;
+
+					return false;
+				}
+
+				// ----------------------------------------------------------------
+				// packs files into an archive, paths are stored relative to root,
+				// if compression is requested entries are compressed only if they
+				// shrink by at least an eighth, so that most data stays usable in
+				// place, returns false if any file can't be read or written, in 
+				// which case the partial archive is removed
+
+				static bool Pack(const std::string& filename, const std::string& root, const std::vector<std::string>& filenames, bool compress, std::string& error)
+				{
+					std::string normalizedroot = NormalizePath(root);
+
+					if (!normalizedroot.empty() && normalizedroot.back() != '/')
+						normalizedroot.push_back('/');
+
+					// collect names
+
+					std::vector<Entry>		 entries(filenames.size());
+					std::vector<std::string> names(filenames.size());
+					std::string				 namesblob;
+
+					for (size_t i = 0; i < filenames.size(); ++i)
+					{
+						std::string path = NormalizePath(filenames[i]);
+
+						if (path.compare(0, normalizedroot.size(), normalizedroot) != 0)
+						{
+							error = "'" + filenames[i] + "' is not under '" + root + "'";
+							return false;
+						}
+
+						names[i] = path.substr(normalizedroot.size());
+
+						Entry& entry = entries[i];
+
+						memset(&entry, 0, sizeof(Entry));
+
+						entry.Hash		 = vml::utils::hash::Fnv1a64(names[i]);
+						entry.NameOffset = (uint32_t)namesblob.size();
+						entry.NameLength = (uint32_t)names[i].size();
+
+						namesblob += names[i];
+					}
+
+					FILE* stream;
+
+					if (fopen_s(&stream, filename.c_str(), "wb") != 0)
+					{
+						error = "Cannot create '" + filename + "'";
+						return false;
+					}
+
+					Header header;
+
+					memset(&header, 0, sizeof(Header));
+					memcpy(header.Magic, "VPAK", 4);
+
+					header.Version		= VERSION;
+					header.EntriesCount = (uint32_t)entries.size();
+
+					bool ok = fwrite(&header, sizeof(Header), 1, stream) == 1;
+
+					uint64_t position = sizeof(Header);
+
+					// write entries data
+
+					std::vector<unsigned char> data;
+					std::vector<unsigned char> packed;
+
+					for (size_t i = 0; ok && i < filenames.size(); ++i)
+					{
+						std::ifstream file(filenames[i].c_str(), std::ios::binary);
+
+						if (!file.is_open())
+						{
+							error = "Cannot read '" + filenames[i] + "'";
+							ok	  = false;
+							break;
+						}
+
+						file.seekg(0, std::ios::end);
+						data.resize((size_t)file.tellg());
+						file.seekg(0, std::ios::beg);
+						file.read((char*)data.data(), data.size());
+
+						if (!file || (size_t)file.gcount() != data.size())
+						{
+							error = "Cannot read '" + filenames[i] + "'";
+							ok	  = false;
+							break;
+						}
+
+						Entry& entry = entries[i];
+
+						entry.Size		 = data.size();
+						entry.PackedSize = data.size();
+
+						const unsigned char* source = data.data();
+
+						if (compress && !data.empty())
+						{
+							packed.resize(lz4::GetMaxCompressedSize(data.size()));
+
+							size_t packedsize = lz4::Compress(data.data(), data.size(), packed.data());
+
+							if (packedsize < data.size() - data.size() / 8)
+							{
+								entry.PackedSize = packedsize;
+								entry.Flags		|= ENTRY_COMPRESSED;
+								source			 = packed.data();
+							}
+						}
+
+						ok = PadFile(stream, position, AlignOffset(position));
+
+						entry.Offset = position;
+
+						ok = ok && fwrite(source, 1, (size_t)entry.PackedSize, stream) == (size_t)entry.PackedSize;
+
+						if (!ok)
+							error = "Cannot write '" + filename + "'";
+
+						position += entry.PackedSize;
+					}
+
+					// write directory sorted by hash, then names
+
+					if (ok)
+					{
+						std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.Hash < b.Hash; });
+
+						ok = PadFile(stream, position, AlignOffset(position));
+
+						header.DirectoryOffset = position;
+
+						ok = ok && fwrite(entries.data(), sizeof(Entry), entries.size(), stream) == entries.size();
+
+						position += entries.size() * sizeof(Entry);
+
+						header.NamesOffset = position;
+						header.NamesSize   = namesblob.size();
+
+						ok = ok && fwrite(namesblob.data(), 1, namesblob.size(), stream) == namesblob.size();
+
+						// patch header
+
+						ok = ok && fseek(stream, 0, SEEK_SET) == 0;
+						ok = ok && fwrite(&header, sizeof(Header), 1, stream) == 1;
+
+						if (!ok)
+							error = "Cannot write '" + filename + "'";
+					}
+
+					if (fclose(stream) != 0 && ok)
+					{
+						error = "Cannot write '" + filename + "'";
+						ok	  = false;
+					}
+
+					if (!ok)
+						remove(filename.c_str());
+
+					return ok;
+				}
+
+				//-----------------------------------------------------------------------------------
+				// copy constructor is private
+				// no copies allowed since classes
+				// are referenced
+
+				Archive(const Archive& archive) = delete;
+
+				//-----------------------------------------------------------------------------------
+				// overload operator is private,
+				// no copies allowed since classes
+				// are referenced
+
+				Archive& operator=(const Archive& archive) = delete;
+
+				// ----------------------------------------------------------------
+				// ctor / dtor
+
+				Archive()
+				{
+					ArchiveHeader = nullptr;
+					Entries		  = nullptr;
+					Names		  = nullptr;
+				}
+
+				~Archive()
+				{
+					Close();
+				}
+
+		};
+
+		////////////////////////////////////////////////////////////////////////////
+		// read only view of a file, looked up in mounted archives first, then
+		// mapped from disk, uncompressed archive entries are used in place,
+		// compressed entries are decompressed into an owned buffer
+
+		class FileView
+		{
+
+			private:
+
+				// ----------------------------------------------------------------
+				// private data
+
+				vml::os::MappedFile				File;		// mapped loose file
+				std::shared_ptr<const Archive>	Source;		// archive the file was found in, kept alive while data is in use
+				std::vector<unsigned char>		Buffer;		// decompressed archive entry
+				const unsigned char*	   Data;		// file content
+				size_t					   Size;		// file size in bytes
+				bool					   Archived;	// file was found in an archive
+				std::string				   FileName;	// file name
+
+			public:
+
+				// ----------------------------------------------------------------
+				// opens a file, returns false if the file can't be found or read
+
+				bool Open(const std::string& filename)
+				{
+					Close();
+
+					std::shared_ptr<const Archive> archive;
+					const Archive::Entry*		   entry;
+
+					if (Archive::Resolve(filename, archive, entry))
+					{
+						Data = archive->GetEntryData(entry);
+
+						if (!Data)
+						{
+							if (!archive->Read(entry, Buffer))
+								return false;
+
+							Data = Buffer.data();
+						}
+
+						Source	 = archive;
+						Size	 = (size_t)entry->Size;
+						Archived = true;
+						FileName = filename;
+
+						return true;
+					}
+
+					return OpenLoose(filename);
+				}
+
+				// ----------------------------------------------------------------
+				// opens a cache file, caches rebuilt at runtime are saved loose
+				// to disk, so a loose copy newer than the archive is preferred, 
+				// otherwise a stale packed cache would shadow the fresh one and
+				// the cache would be rebuilt on every load
+
+				bool OpenCache(const std::string& filename)
+				{
+					std::shared_ptr<const Archive> archive;
+					const Archive::Entry*		   entry;
+
+					if (Archive::Resolve(filename, archive, entry))
+					{
+						std::error_code looseerror;
+						std::error_code archiveerror;
+
+						std::filesystem::file_time_type loosetime   = std::filesystem::last_write_time(filename, looseerror);
+						std::filesystem::file_time_type archivetime = std::filesystem::last_write_time(archive->GetFileName(), archiveerror);
+
+						if (!looseerror && !archiveerror && loosetime > archivetime)
+						{
+							Close();
+
+							if (OpenLoose(filename))
+								return true;
+						}
+					}
+
+					return Open(filename);
+				}
+
+			private:
+
+				// ----------------------------------------------------------------
+				// maps a loose file from disk
+
+				bool OpenLoose(const std::string& filename)
+				{
+					if (!File.Open(filename))
+						return false;
+
+					Data	 = (const unsigned char*)File.GetData();
+					Size	 = File.GetSize();
+					FileName = filename;
+
+					return true;
+				}
+
+			public:
+
+				// ----------------------------------------------------------------
+				// closes file
+
+				void Close()
+				{
+					File.Close();
+					Source.reset();
+					std::vector<unsigned char>().swap(Buffer);
+					Data	 = nullptr;
+					Size	 = 0;
+					Archived = false;
+					FileName.clear();
+				}
+
+				// ----------------------------------------------------------------
+				// returns a pointer at the given byte offset, if the requested
+				// range doesn't fit in the file, nullptr is returned
+
+				const void* GetDataAt(size_t offset, size_t size) const
+				{
+					if (!Data || offset > Size || size > Size - offset)
+						return nullptr;
+					return Data + offset;
+				}
+
+				// ----------------------------------------------------------------
+				// getters
+
+				const unsigned char* GetData()	   const { return Data; }
+				size_t				 GetSize()	   const { return Size; }
+				bool				 IsOpen()	   const { return Data != nullptr; }
+				bool				 IsArchived()  const { return Archived; }
+				const std::string&	 GetFileName() const { return FileName; }
+
+				// ----------------------------------------------------------------
+				// checks if a file exists in mounted archives or on disk
+
+				static bool Exists(const std::string& filename)
+				{
+					std::shared_ptr<const Archive> archive;
+					const Archive::Entry*		   entry;
+
+					return Archive::Resolve(filename, archive, entry) || std::filesystem::exists(filename);
+				}
+
+				//-----------------------------------------------------------------------------------
+				// copy constructor is private
+				// no copies allowed since classes
+				// are referenced
+
+				FileView(const FileView& fileview) = delete;
+
+				//-----------------------------------------------------------------------------------
+				// overload operator is private,
+				// no copies allowed since classes
+				// are referenced
+
+				FileView& operator=(const FileView& fileview) = delete;
+
+				// ----------------------------------------------------------------
+				// ctor / dtor
+
+				FileView()
+				{
+					Data	 = nullptr;
+					Size	 = 0;
+					Archived = false;
+				}
+
+				~FileView()
+				{
+				}
+
+		};
+
+	}
+}
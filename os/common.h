@@ -59,7 +59,9 @@
 //#include <algorithm>		
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <deque>
+#include <list>
 
 #include <math.h>
 
@@ -71,11 +73,16 @@
 //#include <set>
 
 #include <random>
-//#include <functional>
+#include <functional>
 
 #include <format>
 #include <thread>
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <memory>
 #include <queue>
 #include <regex>
 
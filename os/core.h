@@ -141,6 +141,12 @@ namespace vml
 
 				vml::utils::Logger::GetInstance()->Info("Core : Initting performance timer : Done");
 
+				// init engine wide thread pool
+
+				vml::os::ThreadPool::GetInstance();
+
+				vml::utils::Logger::GetInstance()->Info("Core : Initting Thread Pool : " + std::to_string(vml::os::ThreadPool::GetInstance()->GetWorkersCount()) + " workers : Done");
+
 				//start measuring
 
 				if (IsVerbose())
@@ -208,6 +214,16 @@ namespace vml
 
 			}
 
+			// -----------------------------------------------------------------------------
+			// finalizes resources loaded asynchronously, call once per frame
+			// from the rendering thread, budget is in milliseconds per store
+
+			void UpdateStores(float budget) const
+			{
+				vml::stores::MeshStore->Update(budget);
+				vml::stores::TextureStore->Update(budget);
+			}
+
 			// -----------------------------------------------------------------------------
 			// closes Core
 
@@ -241,6 +257,12 @@ namespace vml
 
 				vml::utils::Logger::GetInstance()->Info("Core : Shutting Down Stores : Done");
 
+				// shut down thread pool, stores have waited for their loads
+
+				vml::os::ThreadPool::DeleteInstance();
+
+				vml::utils::Logger::GetInstance()->Info("Core : Shutting Down Thread Pool : Done");
+
 				// close opengl context
 
 				vml::os::SafeDelete(OpenGLContextWindow);
@@ -150,7 +150,7 @@ namespace vml
 					HASMOVOPT,
 					HASMULTITHREADING,
 
-					UNUSED25,
+					HASAVX2,
 					UNUSED26,
 					UNUSED27,
 					UNUSED28,
@@ -255,7 +255,7 @@ namespace vml
 					"MOV optimization",
 					"Multithreading",
 
-					"Unused25",
+					"Advanced Vector Extensions 2",
 					"Unused26",
 					"Unused27",
 					"Unused28",
@@ -455,6 +455,10 @@ namespace vml
 					CpuFeaturesTable[HAS3DNOWEXT]		= (edx & 0x40000000) != 0;
 					CpuFeaturesTable[HAS3DNOW]			= (edx & 0x80000000) != 0;
 
+					// avx2, see QueryAVX2
+
+					CpuFeaturesTable[HASAVX2] = QueryAVX2();
+
 					// Interpret CPU brand string and cache information.
 
 					int CPUInfo[4] = { -1 };
@@ -635,6 +639,61 @@ namespace vml
 
 				
 			public:
+
+				//-----------------------------------------------------------------------------
+				// cheap simd feature queries, only the needed cpuid leaves are read
+				// so they can be used to pick simd kernels without calling Measure
+
+				static bool QuerySSE2()
+				{
+					int regs[4] = { 0 };
+
+					__cpuidex(regs, 0, 0);
+
+					if (regs[0] < 1)
+						return false;
+
+					__cpuidex(regs, 1, 0);
+
+					return (regs[3] & 0x4000000) != 0;		// edx bit 26
+				}
+
+				//-----------------------------------------------------------------------------
+				// avx2 is reported in the structured extended feature leaf,
+				// ymm state must also be enabled by the os, otherwise
+				// avx instructions will fault
+
+				static bool QueryAVX2()
+				{
+					int regs[4] = { 0 };
+
+					__cpuidex(regs, 0, 0);
+
+					if (regs[0] < 7)
+						return false;
+
+					// avx and xgetbv enabled by the os, ecx bits 28 and 27
+
+					__cpuidex(regs, 1, 0);
+
+					if ((regs[2] & 0x10000000) == 0 || (regs[2] & 0x8000000) == 0)
+						return false;
+
+					#if _MSC_VER
+						uint64_t xcr0 = _xgetbv(0);
+					#else
+						uint32_t xcr0lo, xcr0hi;
+						__asm__ __volatile__("xgetbv" : "=a"(xcr0lo), "=d"(xcr0hi) : "c"(0));
+						uint64_t xcr0 = ((uint64_t)xcr0hi << 32) | xcr0lo;
+					#endif
+
+					if ((xcr0 & 0x6) != 0x6)
+						return false;
+
+					__cpuidex(regs, 7, 0);
+
+					return (regs[1] & 0x20) != 0;			// ebx bit 5
+				}
 				
 				//-----------------------------------------------------------------------------
 				// start measuring services
@@ -808,6 +867,34 @@ namespace vml
 					return "Unknown feature";
 				}
 
+				const bool HasSSE2() const
+				{
+					if (CpuIdMaxFunction >= 1)
+						return CpuFeaturesTable[HASSSE2] != 0;
+					return false;
+				}
+
+				const bool HasSSE41() const
+				{
+					if (CpuIdMaxFunction >= 1)
+						return CpuFeaturesTable[HASSSE4_1] != 0;
+					return false;
+				}
+
+				const bool HasAVX() const
+				{
+					if (CpuIdMaxFunction >= 1)
+						return CpuFeaturesTable[HASAVX] != 0;
+					return false;
+				}
+
+				const bool HasAVX2() const
+				{
+					if (CpuIdMaxFunction >= 7)
+						return CpuFeaturesTable[HASAVX2] != 0;
+					return false;
+				}
+
 				const double GetCpuSpeed() const
 				{
 					return EstimatedCpuSpeed;
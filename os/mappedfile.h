@@ -0,0 +1,164 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////////
+//	This source file is part of v71's engine
+//
+//	Copyright (c) 2011-2050 v71
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+namespace vml
+{
+	namespace os
+	{
+
+		////////////////////////////////////////////////////////////////////////////
+		// read only memory mapped file, the file content is accessible
+		// through a pointer until the file is closed, pages are loaded
+		// by the os on demand
+
+		class MappedFile
+		{
+
+			private:
+
+				// ----------------------------------------------------------------
+				// private data
+
+				std::string	FileName;			// mapped file name
+				HANDLE		FileHandle;			// file handle
+				HANDLE		MappingHandle;		// file mapping handle
+				const void*	Data;				// mapped view
+				size_t		Size;				// file size in bytes
+
+			public:
+
+				// ----------------------------------------------------------------
+				// maps a file, returns false if the file can't be opened or mapped
+
+				bool Open(const std::string& filename)
+				{
+					Close();
+
+					FileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+					if (FileHandle == INVALID_HANDLE_VALUE)
+					{
+						FileHandle = nullptr;
+						return false;
+					}
+
+					LARGE_INTEGER filesize;
+
+					if (!GetFileSizeEx(FileHandle, &filesize) || filesize.QuadPart == 0)
+					{
+						Close();
+						return false;
+					}
+
+					MappingHandle = CreateFileMappingA(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+					if (!MappingHandle)
+					{
+						Close();
+						return false;
+					}
+
+					Data = MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+					if (!Data)
+					{
+						Close();
+						return false;
+					}
+
+					Size	 = (size_t)filesize.QuadPart;
+					FileName = filename;
+
+					return true;
+				}
+
+				// ----------------------------------------------------------------
+				// unmaps the file
+
+				void Close()
+				{
+					if (Data)		   UnmapViewOfFile(Data);
+					if (MappingHandle) CloseHandle(MappingHandle);
+					if (FileHandle)	   CloseHandle(FileHandle);
+
+					Data		  = nullptr;
+					MappingHandle = nullptr;
+					FileHandle	  = nullptr;
+					Size		  = 0;
+					FileName.clear();
+				}
+
+				// ----------------------------------------------------------------
+				// getters
+
+				const void*		   GetData()	 const { return Data; }
+				size_t			   GetSize()	 const { return Size; }
+				bool			   IsOpen()		 const { return Data != nullptr; }
+				const std::string& GetFileName() const { return FileName; }
+
+				// returns a pointer at the given byte offset, if the requested
+				// range doesn't fit in the file, nullptr is returned
+
+				const void* GetDataAt(size_t offset, size_t size) const
+				{
+					if (!Data || offset > Size || size > Size - offset)
+						return nullptr;
+					return (const unsigned char*)Data + offset;
+				}
+
+				//-----------------------------------------------------------------------------------
+				// copy constructor is private
+				// no copies allowed since classes
+				// are referenced
+
+				MappedFile(MappedFile& mappedfile) = delete;
+
+				//-----------------------------------------------------------------------------------
+				// overload operator is private,
+				// no copies allowed since classes
+				// are referenced
+
+				void operator=(const MappedFile& mappedfile) = delete;
+
+				// ----------------------------------------------------------------
+				// ctor / dtor
+
+				MappedFile()
+				{
+					FileHandle	  = nullptr;
+					MappingHandle = nullptr;
+					Data		  = nullptr;
+					Size		  = 0;
+				}
+
+				~MappedFile()
+				{
+					Close();
+				}
+
+		};
+
+	}
+}
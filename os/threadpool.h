@@ -0,0 +1,416 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////////
+//	This source file is part of v71's engine
+//
+//	Copyright (c) 2011-2050 v71
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+namespace vml
+{
+	namespace os
+	{
+
+		////////////////////////////////////////////////////////////////////////////
+		// work stealing thread pool
+		// each worker owns a task queue, tasks submitted by a worker are pushed
+		// on its own queue and popped in lifo order, idle workers steal from
+		// the front of other queues. Tasks can be tracked with an atomic counter
+		// which is decremented when the task completes, threads waiting for
+		// a counter execute pending tasks instead of blocking, so tasks can
+		// spawn and wait for subtasks without deadlocking the pool.
+		// Jobs are tasks which are queued once the jobs they depend on have
+		// completed. The engine wide pool returned by GetInstance is shared
+		// by physics, asset loading and scene update, so the engine never
+		// runs more threads than cores
+
+		class ThreadPool
+		{
+
+			public:
+
+				// ----------------------------------------------------------------
+				// task with dependencies, dependencies count is the number of
+				// jobs not yet completed this job depends on, plus one which is
+				// held while the job is being submitted
+
+				struct Job
+				{
+					std::function<void()>			  Task;
+					std::atomic<int>				  Dependencies;		// pending dependencies
+					std::atomic<bool>				  Done;				// task has been executed
+					std::atomic<int>*				  Counter;			// counter decremented once done
+					std::mutex						  Mutex;			// guards continuations
+					std::vector<std::shared_ptr<Job>> Continuations;	// jobs depending on this one
+				};
+
+				using JobHandle = std::shared_ptr<Job>;
+
+			private:
+
+				// ----------------------------------------------------------------
+				// per thread task queue
+
+				struct WorkQueue
+				{
+					std::mutex						  Mutex;
+					std::deque<std::function<void()>> Tasks;
+				};
+
+				// ----------------------------------------------------------------
+				// private data
+
+				std::vector<std::thread>				Workers;			// worker threads
+				std::vector<std::unique_ptr<WorkQueue>> Queues;				// task queues, queue 0 is shared by non worker threads
+				std::atomic<bool>						Quit;				// quit flag
+				std::atomic<size_t>						PendingTasks;		// tasks in queues, not yet executed
+				std::mutex								WakeMutex;			// mutex used to wake up workers
+				std::condition_variable					WakeCondition;		// wakes up idle workers
+				static ThreadPool*						Singleton;			// engine wide pool
+
+				// ----------------------------------------------------------------
+				// index of the queue owned by the current thread, 0 for threads
+				// which are not part of any pool
+
+				static int& CurrentQueue()
+				{
+					static thread_local int queue = 0;
+					return queue;
+				}
+
+				static ThreadPool*& CurrentPool()
+				{
+					static thread_local ThreadPool* pool = nullptr;
+					return pool;
+				}
+
+				size_t GetThreadQueue() const
+				{
+					if (CurrentPool() == this)
+						return (size_t)CurrentQueue();
+					return 0;
+				}
+
+				// ----------------------------------------------------------------
+				// pops from own queue back, then steals from others' front
+
+				bool PopTask(size_t queue, std::function<void()>& task)
+				{
+					{
+						std::lock_guard<std::mutex> lock(Queues[queue]->Mutex);
+
+						if (!Queues[queue]->Tasks.empty())
+						{
+							task = std::move(Queues[queue]->Tasks.back());
+							Queues[queue]->Tasks.pop_back();
+							PendingTasks--;
+							return true;
+						}
+					}
+
+					for (size_t i = 1; i < Queues.size(); ++i)
+					{
+						size_t victim = (queue + i) % Queues.size();
+
+						std::lock_guard<std::mutex> lock(Queues[victim]->Mutex);
+
+						if (!Queues[victim]->Tasks.empty())
+						{
+							task = std::move(Queues[victim]->Tasks.front());
+							Queues[victim]->Tasks.pop_front();
+							PendingTasks--;
+							return true;
+						}
+					}
+
+					return false;
+				}
+
+				// ----------------------------------------------------------------
+				// releases one dependency, the job is queued once none is left
+
+				void ReleaseJob(const JobHandle& job)
+				{
+					if (--job->Dependencies == 0)
+						Submit([this, job]() { RunJob(job); });
+				}
+
+				// ----------------------------------------------------------------
+				// executes a job and releases the jobs depending on it
+
+				void RunJob(const JobHandle& job)
+				{
+					job->Task();
+
+					std::vector<JobHandle> continuations;
+
+					{
+						std::lock_guard<std::mutex> lock(job->Mutex);
+						job->Done = true;
+						continuations.swap(job->Continuations);
+					}
+
+					for (size_t i = 0; i < continuations.size(); ++i)
+						ReleaseJob(continuations[i]);
+
+					if (job->Counter)
+						(*job->Counter)--;
+				}
+
+				// ----------------------------------------------------------------
+				// worker loop
+
+				void WorkerLoop(int queue)
+				{
+					CurrentQueue() = queue;
+					CurrentPool()  = this;
+
+					while (!Quit)
+					{
+						if (!RunPendingTask())
+						{
+							std::unique_lock<std::mutex> lock(WakeMutex);
+							WakeCondition.wait(lock, [this] { return Quit || PendingTasks > 0; });
+						}
+					}
+				}
+
+			public:
+
+				// ----------------------------------------------------------------
+				// submits a task, if counter is not null, it is incremented now
+				// and decremented once the task has been executed
+
+				void Submit(std::function<void()> task, std::atomic<int>* counter = nullptr)
+				{
+					if (counter)
+					{
+						(*counter)++;
+
+						task = [task = std::move(task), counter]() { task(); (*counter)--; };
+					}
+
+					// with no workers, tasks are executed in place
+
+					if (Workers.empty())
+					{
+						task();
+						return;
+					}
+
+					size_t queue = GetThreadQueue();
+
+					{
+						std::lock_guard<std::mutex> lock(Queues[queue]->Mutex);
+						Queues[queue]->Tasks.emplace_back(std::move(task));
+						PendingTasks++;
+					}
+
+					{
+						std::lock_guard<std::mutex> lock(WakeMutex);
+					}
+
+					WakeCondition.notify_one();
+				}
+
+				// ----------------------------------------------------------------
+				// submits a job which runs once all of its dependencies have
+				// completed, the returned handle can be used as a dependency of
+				// further jobs, if counter is not null, it is incremented now
+				// and decremented once the job has been executed
+
+				JobHandle SubmitAfter(const std::vector<JobHandle>& dependencies, std::function<void()> task, std::atomic<int>* counter = nullptr)
+				{
+					JobHandle job = std::make_shared<Job>();
+
+					job->Task		  = std::move(task);
+					job->Dependencies = 1;
+					job->Done		  = false;
+					job->Counter	  = counter;
+
+					if (counter)
+						(*counter)++;
+
+					for (size_t i = 0; i < dependencies.size(); ++i)
+					{
+						std::lock_guard<std::mutex> lock(dependencies[i]->Mutex);
+
+						if (!dependencies[i]->Done)
+						{
+							job->Dependencies++;
+							dependencies[i]->Continuations.emplace_back(job);
+						}
+					}
+
+					ReleaseJob(job);
+
+					return job;
+				}
+
+				// ----------------------------------------------------------------
+				// splits the range [0, count) in one batch per thread, batches
+				// hold at least grain items, function is called with the first
+				// and last index of each batch, the calling thread runs the first
+				// batch and returns once all of them have completed
+
+				void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& function)
+				{
+					if (count == 0)
+						return;
+
+					size_t batches = std::min(GetWorkersCount() + 1, (count + grain - 1) / std::max((size_t)1, grain));
+
+					if (batches < 2)
+					{
+						function(0, count);
+						return;
+					}
+
+					std::atomic<int> counter = 0;
+
+					for (size_t i = 1; i < batches; ++i)
+						Submit([&function, i, batches, count]() { function(count * i / batches, count * (i + 1) / batches); }, &counter);
+
+					function(0, count / batches);
+
+					Wait(counter);
+				}
+
+				// ----------------------------------------------------------------
+				// runs one pending task, if any
+
+				bool RunPendingTask()
+				{
+					std::function<void()> task;
+
+					if (!PopTask(GetThreadQueue(), task))
+						return false;
+
+					task();
+
+					return true;
+				}
+
+				// ----------------------------------------------------------------
+				// waits for a counter to reach zero, executing pending tasks meanwhile
+
+				void Wait(const std::atomic<int>& counter)
+				{
+					while (counter > 0)
+					{
+						if (!RunPendingTask())
+							std::this_thread::yield();
+					}
+				}
+
+				// waits for a job to complete, executing pending tasks meanwhile
+
+				void Wait(const JobHandle& job)
+				{
+					while (!job->Done)
+					{
+						if (!RunPendingTask())
+							std::this_thread::yield();
+					}
+				}
+
+				// ----------------------------------------------------------------
+				// engine wide pool, allocated on first use, one core is left
+				// to the main thread, which helps while waiting
+
+				static ThreadPool* GetInstance()
+				{
+					if (Singleton == nullptr)
+						Singleton = new ThreadPool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+					return Singleton;
+				}
+
+				// deletes the engine wide pool, all submitted tasks must have completed
+
+				static void DeleteInstance()
+				{
+					vml::os::SafeDelete(Singleton);
+				}
+
+				// ----------------------------------------------------------------
+				// getters
+
+				size_t GetWorkersCount() const
+				{
+					return Workers.size();
+				}
+
+				// index of the calling thread in the pool, 0 for the threads
+				// outside of the pool, 1 to workers count for workers
+
+				size_t GetThreadIndex() const
+				{
+					return GetThreadQueue();
+				}
+
+				//-----------------------------------------------------------------------------------
+				// copy constructor is private
+				// no copies allowed since classes
+				// are referenced
+
+				ThreadPool(ThreadPool& threadpool) = delete;
+
+				//-----------------------------------------------------------------------------------
+				// overload operator is private,
+				// no copies allowed since classes
+				// are referenced
+
+				void operator=(const ThreadPool& threadpool) = delete;
+
+				// ----------------------------------------------------------------
+				// ctor / dtor
+				// if workers count is 0, tasks are executed on the calling thread
+
+				ThreadPool(size_t workers)
+				{
+					Quit		 = false;
+					PendingTasks = 0;
+
+					// queue 0 is used by threads outside of the pool
+
+					for (size_t i = 0; i < workers + 1; ++i)
+						Queues.emplace_back(std::make_unique<WorkQueue>());
+
+					for (size_t i = 0; i < workers; ++i)
+						Workers.emplace_back(&ThreadPool::WorkerLoop, this, (int)i + 1);
+				}
+
+				~ThreadPool()
+				{
+					{
+						std::lock_guard<std::mutex> lock(WakeMutex);
+						Quit = true;
+					}
+
+					WakeCondition.notify_all();
+
+					for (size_t i = 0; i < Workers.size(); ++i)
+						Workers[i].join();
+				}
+
+		};
+
+	}
+}
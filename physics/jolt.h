@@ -6,20 +6,29 @@
 //#define JPH_DEBUG_RENDERER
 
 #include <mutex>
+#include <atomic>
 #include <thread>
+#include <map>
+#include <tuple>
 #include <vector>
+#include <random>
+#include <fstream>
+#include <algorithm>
 #include <unordered_set>
 
 #include <Jolt/Jolt.h>
 #include <Jolt/RegisterTypes.h>
 #include <Jolt/Core/Factory.h>
 #include <Jolt/Core/TempAllocator.h>
-#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Core/StreamWrapper.h>
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/Physics/PhysicsSystem.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
 #include <Jolt/Physics/Collision/Shape/SphereShape.h>
 #include <Jolt/Physics/Collision/Shape/MeshShape.h>
+#include <Jolt/Physics/Collision/Shape/ScaledShape.h>
 //#include <Jolt/Physics/Collision/Shape/CapsuleShape.h>
 //#include <Jolt/Physics/Collision/Shape/CompoundShape.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
@@ -34,6 +43,7 @@
 #include <Jolt/Physics/Collision/CollisionCollector.h>
 #include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
 #include <Jolt/Physics/Body/BodyManager.h>
+#include <Jolt/Physics/Body/BodyLock.h>
 #include <Jolt/Renderer/DebugRenderer.h>
 #include <Jolt/Renderer/DebugRendererSimple.h>
 
@@ -286,6 +296,126 @@ namespace JPH
 
 	};
 
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Jolt job system running on the engine thread pool, so physics shares the
+	// workers with the rest of the engine instead of spawning its own threads,
+	// jobs are allocated from a fixed size free list, barriers are implemented
+	// by JobSystemWithBarrier
+
+	class EngineJobSystem final : public JPH::JobSystemWithBarrier
+	{
+		private:
+
+			using AvailableJobs = JPH::FixedSizeFreeList<Job>;
+
+			AvailableJobs		 Jobs;			// jobs free list
+			vml::os::ThreadPool* Pool;			// engine thread pool
+			std::atomic<int>	 Queued;		// jobs queued on the pool, not yet released
+
+		protected:
+
+			// ---------------------------------------------------------------------------
+			// queued jobs hold a reference until the pool runs them, a thread waiting
+			// on a barrier may have executed the job first, Execute does nothing then
+
+			virtual void QueueJob(Job* inJob) override
+			{
+				inJob->AddRef();
+
+				Pool->Submit([inJob]()
+				{
+					inJob->Execute();
+					inJob->Release();
+				}, &Queued);
+			}
+
+			virtual void QueueJobs(Job** inJobs, JPH::uint inNumJobs) override
+			{
+				for (JPH::uint i = 0; i < inNumJobs; ++i)
+					QueueJob(inJobs[i]);
+			}
+
+			virtual void FreeJob(Job* inJob) override
+			{
+				Jobs.DestructObject(inJob);
+			}
+
+		public:
+
+			// ---------------------------------------------------------------------------
+			// the thread waiting on a barrier executes jobs as well
+
+			virtual int GetMaxConcurrency() const override
+			{
+				return (int)Pool->GetWorkersCount() + 1;
+			}
+
+			// ---------------------------------------------------------------------------
+			// if the free list is exhausted, pending tasks are executed until a job is freed
+
+			virtual JobHandle CreateJob(const char* inName, JPH::ColorArg inColor, const JobFunction& inJobFunction, JPH::uint32 inNumDependencies = 0) override
+			{
+				JPH::uint32 index = Jobs.ConstructObject(inName, inColor, this, inJobFunction, inNumDependencies);
+
+				while (index == AvailableJobs::cInvalidObjectIndex)
+				{
+					if (!Pool->RunPendingTask())
+						std::this_thread::yield();
+
+					index = Jobs.ConstructObject(inName, inColor, this, inJobFunction, inNumDependencies);
+				}
+
+				Job* job = &Jobs.Get(index);
+
+				// keep a reference, the job may complete as soon as it is queued
+
+				JobHandle handle(job);
+
+				if (inNumDependencies == 0)
+					QueueJob(job);
+
+				return handle;
+			}
+
+			//-----------------------------------------------------------------------------------
+			// copy constructor is private
+			// no copies allowed since classes
+			// are referenced
+
+			EngineJobSystem(EngineJobSystem& jobsystem) = delete;
+
+			//-----------------------------------------------------------------------------------
+			// overload operator is private,
+			// no copies allowed since classes
+			// are referenced
+
+			void operator=(const EngineJobSystem& jobsystem) = delete;
+
+			// ---------------------------------------------------------------------------
+			// ctor / dtor
+
+			EngineJobSystem(vml::os::ThreadPool* pool, JPH::uint maxjobs, JPH::uint maxbarriers)
+			{
+				if (!pool)
+					vml::os::Message::Error("Jolt : ", "Thread pool is null");
+
+				Pool   = pool;
+				Queued = 0;
+
+				JobSystemWithBarrier::Init(maxbarriers);
+
+				Jobs.Init(maxjobs, maxjobs);
+			}
+
+			~EngineJobSystem()
+			{
+				// jobs still queued on the pool reference the free list
+
+				Pool->Wait(Queued);
+			}
+
+	};
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////
 
 	class ThreadSafeDebugRenderer : public JPH::DebugRendererSimple
@@ -768,6 +898,90 @@ namespace JPH
 		}
 	};
 
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// batched queries, direction length is the cast length
+
+	struct RayQuery
+	{
+		glm::vec3 Origin	= glm::vec3(0, 0, 0);
+		glm::vec3 Direction = glm::vec3(0, 0, 0);
+	};
+
+	struct SphereCastQuery
+	{
+		glm::vec3 Origin	= glm::vec3(0, 0, 0);
+		glm::vec3 Direction = glm::vec3(0, 0, 0);
+		float	  Radius	= 1.0f;
+	};
+
+	struct BoxOverlapQuery
+	{
+		glm::vec3 Center	  = glm::vec3(0, 0, 0);
+		glm::vec3 HalfExtents = glm::vec3(1, 1, 1);
+		glm::quat Rotation	  = glm::quat(1, 0, 0, 0);
+	};
+
+	// closest hit of a ray or a sphere cast, fraction is along the direction
+
+	struct QueryHit
+	{
+		bool		HasHit	 = false;
+		float		Fraction = 1.0f;
+		JPH::BodyID Body;
+		glm::vec3	Position = glm::vec3(0, 0, 0);
+		glm::vec3	Normal	 = glm::vec3(0, 0, 0);
+	};
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// pose of a tracked body, see JoltPhysics::Step
+
+	struct BodyPose
+	{
+		glm::vec3 Position = glm::vec3(0, 0, 0);
+		glm::quat Rotation = glm::quat(1, 0, 0, 0);
+	};
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// input stream over a memory block, used to restore cached shapes from file views,
+	// reading past the end fails the stream like StreamInWrapper does
+
+	class MemoryStreamIn : public JPH::StreamIn
+	{
+		private:
+
+			const unsigned char* Data;
+			size_t				 Size;
+			size_t				 Position;
+			bool				 Failed;
+
+		public:
+
+			virtual void ReadBytes(void* outData, size_t inNumBytes) override
+			{
+				if (Failed || inNumBytes > Size - Position)
+				{
+					memset(outData, 0, inNumBytes);
+					Position = Size;
+					Failed	 = true;
+					return;
+				}
+
+				memcpy(outData, Data + Position, inNumBytes);
+				Position += inNumBytes;
+			}
+
+			virtual bool IsEOF()	const override { return Failed; }
+			virtual bool IsFailed() const override { return Failed; }
+
+			MemoryStreamIn(const unsigned char* data, size_t size)
+			{
+				Data	 = data;
+				Size	 = size;
+				Position = 0;
+				Failed	 = false;
+			}
+	};
+
 	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// shapes
 
@@ -777,6 +991,18 @@ namespace JPH
 		BOX_SHAPE = 1,
 		SPHERE_SHAPE = 2,
 	};
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// body spawn description for batched creation, spheres use HalfExtents.x as radius
+
+	struct BodySpawn
+	{
+		Shapes	  Shape		  = Shapes::SPHERE_SHAPE;
+		glm::vec3 Position	  = glm::vec3(0, 0, 0);
+		glm::quat Rotation	  = glm::quat(1, 0, 0, 0);
+		glm::vec3 HalfExtents = glm::vec3(1, 1, 1);
+		bool	  Dynamic	  = true;
+	};
 	
 	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Jolt physics engine wrapper
@@ -785,6 +1011,355 @@ namespace JPH
 	{
 		private:
 
+			// ---------------------------------------------------------------------------
+			// per thread query data, collectors and hits are reused between batches
+
+			struct QueryContext
+			{
+				JPH::ClosestHitCollisionCollector<JPH::CastShapeCollector> CastCollector;
+				JPH::AllHitCollisionCollector<JPH::CollideShapeCollector>  OverlapCollector;
+				std::vector<Hit>										   Hits;			// overlap hits, gathered once the batch is done
+				size_t													   Index;			// context index
+			};
+
+			// minimum number of queries run by a thread
+
+			static const size_t QUERY_BATCH = 64;
+
+			std::vector<std::unique_ptr<QueryContext>> QueryContexts;
+
+			// ---------------------------------------------------------------------------
+			// runs function on each query index, on the engine thread pool if parallel
+			// is true, each thread uses its own context, so batches must not be issued
+			// concurrently from several threads outside of the pool
+
+			template <typename Function>
+			void RunQueries(size_t count, bool parallel, Function function)
+			{
+				vml::os::ThreadPool* pool = vml::os::ThreadPool::GetInstance();
+
+				while (QueryContexts.size() < pool->GetWorkersCount() + 1)
+				{
+					QueryContexts.emplace_back(std::make_unique<QueryContext>());
+					QueryContexts.back()->Index = QueryContexts.size() - 1;
+				}
+
+				for (size_t i = 0; i < QueryContexts.size(); ++i)
+					QueryContexts[i]->Hits.clear();
+
+				if (!parallel)
+				{
+					for (size_t i = 0; i < count; ++i)
+						function(*QueryContexts[0], i);
+					return;
+				}
+
+				pool->ParallelFor(count, QUERY_BATCH, [this, pool, &function](size_t first, size_t last)
+				{
+					QueryContext& context = *QueryContexts[pool->GetThreadIndex()];
+
+					for (size_t i = first; i < last; ++i)
+						function(context, i);
+				});
+			}
+
+			// ---------------------------------------------------------------------------
+
+			static JPH::Vec3 ToJolt(const glm::vec3& v)
+			{
+				return JPH::Vec3(v.x, v.y, v.z);
+			}
+
+			static glm::vec3 ToGlm(JPH::Vec3Arg v)
+			{
+				return glm::vec3(v.GetX(), v.GetY(), v.GetZ());
+			}
+
+			// ---------------------------------------------------------------------------
+			// mesh shape cache, the header is followed by the shape saved
+			// with its children and materials
+
+			static const uint32_t MESH_CACHE_MAGIC	 = 0x534d4a56;		// 'VJMS'
+			static const uint32_t MESH_CACHE_VERSION = 1;
+
+			JPH::MeshShapeSettings::EBuildQuality MeshBuildQuality;
+			float								  MeshBuildTime;
+			float								  MeshLoadTime;
+
+			// ---------------------------------------------------------------------------
+			// batched body creation, scaled shapes are shared by bodies with the same
+			// shape and scale, the broadphase is optimized once enough bodies were added
+
+			using ScaledShapeKey = std::tuple<uint32_t, float, float, float>;
+
+			std::map<ScaledShapeKey, JPH::RefConst<JPH::Shape>> ScaledShapes;
+			size_t												BodiesAddedSinceOptimize;
+
+			// ---------------------------------------------------------------------------
+			// returns the unit shape scaled to half extents
+
+			JPH::RefConst<JPH::Shape> GetScaledShape(Shapes shape, const glm::vec3& halfextents)
+			{
+				JPH::RefConst<JPH::Shape> base;
+
+				glm::vec3 scale = halfextents;
+
+				switch (shape)
+				{
+					case Shapes::BOX_SHAPE	 : base = BoxShape; break;
+					case Shapes::SPHERE_SHAPE: base = SphereShape; scale = glm::vec3(halfextents.x); break;
+					default: vml::os::Message::Error("Jolt : ", "Unsupported body shape"); break;
+				}
+
+				if (scale == glm::vec3(1, 1, 1))
+					return base;
+
+				ScaledShapeKey key((uint32_t)shape, scale.x, scale.y, scale.z);
+
+				auto it = ScaledShapes.find(key);
+
+				if (it != ScaledShapes.end())
+					return it->second;
+
+				JPH::RefConst<JPH::Shape> scaled = new JPH::ScaledShape(base, ToJolt(scale));
+
+				ScaledShapes.emplace(key, scaled);
+
+				return scaled;
+			}
+
+			// ---------------------------------------------------------------------------
+			// fixed step data, previous and current poses are written by the
+			// stepping thread, interpolated poses are only written by the thread
+			// calling Step or EndStep
+
+			float					   Accumulator;
+			float					   Alpha;
+			int						   PendingSteps;
+			bool					   StepInFlight;
+			std::atomic<int>		   StepCounter;
+			std::vector<JPH::BodyID>   TrackedBodies;
+			std::vector<BodyPose>	   PreviousPoses;
+			std::vector<BodyPose>	   CurrentPoses;
+			std::vector<BodyPose>	   InterpolatedPoses;
+
+			// ---------------------------------------------------------------------------
+			// reads tracked bodies poses
+
+			void CapturePoses(std::vector<BodyPose>& poses) const
+			{
+				for (size_t i = 0; i < TrackedBodies.size(); ++i)
+				{
+					JPH::RVec3 position;
+					JPH::Quat  rotation;
+
+					BodyInterface->GetPositionAndRotation(TrackedBodies[i], position, rotation);
+
+					poses[i].Position = ToGlm(JPH::Vec3(position));
+					poses[i].Rotation = glm::quat(rotation.GetW(), rotation.GetX(), rotation.GetY(), rotation.GetZ());
+				}
+			}
+
+			// ---------------------------------------------------------------------------
+			// runs fixed steps, the pose before the last step is kept so 
+			// that render transforms can be interpolated
+
+			void RunSteps(int steps)
+			{
+				for (int i = 0; i < steps; ++i)
+				{
+					if (i == steps - 1)
+					{
+						if (i == 0)
+							PreviousPoses.swap(CurrentPoses);
+						else
+							CapturePoses(PreviousPoses);
+					}
+
+					PhysicsSystem->Update(DeltaTime, CollisionSteps, TempAllocator, JobSystem);
+				}
+
+				if (steps > 0)
+					CapturePoses(CurrentPoses);
+			}
+
+			// ---------------------------------------------------------------------------
+			// adds frame time to the accumulator and returns the number of
+			// fixed steps to run, time exceeding MaxStepsPerFrame steps is dropped
+
+			int ConsumeSteps(float frametime)
+			{
+				Accumulator += std::max(0.0f, frametime);
+				Accumulator	 = std::min(Accumulator, DeltaTime * (float)MaxStepsPerFrame);
+
+				int steps = (int)(Accumulator / DeltaTime);
+
+				Accumulator -= (float)steps * DeltaTime;
+
+				Alpha = std::min(1.0f, Accumulator / DeltaTime);
+
+				return steps;
+			}
+
+			// ---------------------------------------------------------------------------
+			// blends previous and current poses by the accumulator remainder
+
+			void InterpolatePoses()
+			{
+				for (size_t i = 0; i < TrackedBodies.size(); ++i)
+				{
+					InterpolatedPoses[i].Position = glm::mix(PreviousPoses[i].Position, CurrentPoses[i].Position, Alpha);
+					InterpolatedPoses[i].Rotation = glm::slerp(PreviousPoses[i].Rotation, CurrentPoses[i].Rotation, Alpha);
+				}
+			}
+
+			// ---------------------------------------------------------------------------
+			// hashes the mesh arrays the shape is built from and the build quality
+
+			uint64_t ComputeMeshHash(const vml::meshes::Mesh3d* collisionmesh) const
+			{
+				uint32_t version = MESH_CACHE_VERSION;
+				uint32_t quality = (uint32_t)MeshBuildQuality;
+				uint64_t hash	 = vml::utils::hash::Fnv1a64(&version, sizeof(version));
+				hash = vml::utils::hash::Fnv1a64(&quality, sizeof(quality), hash);
+				hash = vml::utils::hash::Fnv1a64(collisionmesh->GetVertexArray(), hash);
+				hash = vml::utils::hash::Fnv1a64(collisionmesh->GetSurfaceIndices(), hash);
+				return hash;
+			}
+
+			// ---------------------------------------------------------------------------
+			// builds the mesh shape from the collision mesh arrays
+
+			void BuildMeshShape(const vml::meshes::Mesh3d* collisionmesh)
+			{
+				const std::vector<unsigned int>& indices = collisionmesh->GetSurfaceIndices();
+				const std::vector<float>& vertices = collisionmesh->GetVertexArray();
+
+				JPH::VertexList vertexList;
+				JPH::IndexedTriangleList triangleList;
+
+				vertexList.reserve(vertices.size() / 4);
+				triangleList.reserve(indices.size() / 3);
+
+				for (size_t i = 0; i < vertices.size() / 4; ++i)
+				{
+					size_t idx = i * 4;
+					vertexList.emplace_back(JPH::Float3(vertices[idx], vertices[idx + 1], vertices[idx + 2]));
+				}
+
+				for (size_t i = 0; i < indices.size() / 3; ++i)
+				{
+					size_t idx = i * 3;
+					triangleList.emplace_back(JPH::IndexedTriangle((uint32_t)indices[idx], (uint32_t)indices[idx + 1], (uint32_t)indices[idx + 2]));
+				}
+
+				// Create mesh shape settings
+				JPH::MeshShapeSettings settings(vertexList, triangleList);
+				settings.Sanitize();
+				settings.mBuildQuality = MeshBuildQuality;
+
+				// Create shape
+				JPH::Shape::ShapeResult result = settings.Create();
+				if (result.IsValid())
+					mesh_shape = result.Get();
+				else
+					vml::os::Message::Error("Jolt : ", "Couldn't create mesh shape : ", result.GetError().c_str());
+			}
+
+			// ---------------------------------------------------------------------------
+			// saves the mesh shape, returns false if the file can't be written
+
+			bool SaveMeshCache(const std::string& filename, uint64_t hash)
+			{
+				std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+
+				if (!file)
+				{
+					vml::utils::Logger::GetInstance()->Info("Jolt : Mesh Cache : Cannot write '" + filename + "'");
+					return false;
+				}
+
+				JPH::StreamOutWrapper stream(file);
+
+				uint32_t magic	 = MESH_CACHE_MAGIC;
+				uint32_t version = MESH_CACHE_VERSION;
+
+				stream.Write(magic);
+				stream.Write(version);
+				stream.Write(hash);
+				stream.Write(MeshBuildTime);
+
+				JPH::Shape::ShapeToIDMap	shapemap;
+				JPH::Shape::MaterialToIDMap materialmap;
+
+				mesh_shape->SaveWithChildren(stream, shapemap, materialmap);
+
+				if (stream.IsFailed())
+				{
+					vml::utils::Logger::GetInstance()->Info("Jolt : Mesh Cache : Cannot write '" + filename + "'");
+					return false;
+				}
+
+				vml::utils::Logger::GetInstance()->Info("Jolt : Mesh Cache : Saved '" + filename + "'");
+
+				return true;
+			}
+
+			// ---------------------------------------------------------------------------
+			// restores the mesh shape, returns false if the file is missing, has
+			// a different version, doesn't match the mesh or is corrupted
+
+			bool LoadMeshCache(const std::string& filename, uint64_t hash)
+			{
+				// the cache can be packed in the level archive, a newer
+				// cache rebuilt on disk takes precedence
+
+				vml::os::FileView file;
+
+				if (!file.OpenCache(filename))
+					return false;
+
+				JPH::MemoryStreamIn stream(file.GetData(), file.GetSize());
+
+				uint32_t magic		= 0;
+				uint32_t version	= 0;
+				uint64_t sourcehash = 0;
+				float	 buildtime	= 0.0f;
+
+				stream.Read(magic);
+				stream.Read(version);
+				stream.Read(sourcehash);
+				stream.Read(buildtime);
+
+				if (stream.IsFailed() || magic != MESH_CACHE_MAGIC || version != MESH_CACHE_VERSION)
+				{
+					vml::utils::Logger::GetInstance()->Info("Jolt : Mesh Cache : Invalid cache file '" + filename + "'");
+					return false;
+				}
+
+				if (sourcehash != hash)
+				{
+					vml::utils::Logger::GetInstance()->Info("Jolt : Mesh Cache : Cache is out of date '" + filename + "'");
+					return false;
+				}
+
+				JPH::Shape::IDToShapeMap	shapemap;
+				JPH::Shape::IDToMaterialMap materialmap;
+
+				JPH::Shape::ShapeResult result = JPH::Shape::sRestoreWithChildren(stream, shapemap, materialmap);
+
+				if (!result.IsValid() || stream.IsFailed())
+				{
+					vml::utils::Logger::GetInstance()->Info("Jolt : Mesh Cache : Corrupted cache file '" + filename + "'");
+					return false;
+				}
+
+				mesh_shape	  = result.Get();
+				MeshBuildTime = buildtime;
+
+				return true;
+			}
+
 		public:
 
 			// This is the max amount of rigid bodies that you can add to the physics system. If you try to add more you'll get an error.
@@ -811,6 +1386,16 @@ namespace JPH
 			// We simulate the physics world in discrete time steps. 60 Hz is a good rate to update the physics system.
 			float DeltaTime;
 
+			// collision steps per fixed step, use more than one when DeltaTime is larger than 1 / 60 s
+			int CollisionSteps;
+
+			// max fixed steps run per frame, time beyond that is dropped so a slow frame can't snowball
+			int MaxStepsPerFrame;
+
+			// CreateBodies optimizes the broadphase when bodies added since the last optimization 
+			// exceed this fraction of the bodies in the system
+			float BroadPhaseOptimizeRatio;
+
 			// Create mapping table from object layer to broadphase layer
 			// Note: As this is an interface, PhysicsSystem will take a reference to this so this instance needs to stay alive!
 			// Also have a look at BroadPhaseLayerInterfaceTable or BroadPhaseLayerInterfaceMask for a simpler interface.
@@ -829,7 +1414,7 @@ namespace JPH
 			// Now we can create the actual physics system.
 			JPH::PhysicsSystem* PhysicsSystem;
 			JPH::TempAllocatorImpl* TempAllocator;
-			JPH::JobSystemThreadPool* JobSystem;
+			EngineJobSystem* JobSystem;
 
 			MyBodyActivationListener BodyActivationListener;
 			MyContactListener ContactListener;
@@ -845,37 +1430,39 @@ namespace JPH
 
 			// ---------------------------------------------------------------------------
 
-			void CreateConcaveMesh(vml::meshes::Mesh3d* collisionmesh)
+			// ---------------------------------------------------------------------------
+			// creates the static level collision body, if cachefilename is not empty
+			// the mesh shape is restored from the cache file, if the cache is missing
+			// or doesn't match the mesh, the shape is built and the cache is saved
+
+			void CreateConcaveMesh(vml::meshes::Mesh3d* collisionmesh, const std::string& cachefilename = "")
 			{
-				const std::vector<unsigned int>& indices = collisionmesh->GetSurfaceIndices();
-				const std::vector<float>& vertices = collisionmesh->GetVertexArray();
+				if (!collisionmesh)
+					vml::os::Message::Error("Jolt : ", "Collision mesh is null");
 
-				JPH::VertexList vertexList;
-				JPH::IndexedTriangleList triangleList;
+				vml::os::Timer timer;
+				timer.Init();
 
-				for (size_t i = 0; i < vertices.size() / 4; ++i)
-				{
-					size_t idx = i * 4;
-					vertexList.emplace_back(JPH::Float3(vertices[idx], vertices[idx + 1], vertices[idx + 2]));
-				}
+				uint64_t hash = ComputeMeshHash(collisionmesh);
 
-				for (size_t i = 0; i < indices.size() / 3; ++i)
+				if (!cachefilename.empty() && LoadMeshCache(cachefilename, hash))
 				{
-					size_t idx = i * 3;
-					triangleList.emplace_back(JPH::IndexedTriangle((uint32_t)indices[idx], (uint32_t)indices[idx + 1], (uint32_t)indices[idx + 2]));
+					MeshLoadTime = timer.GetElapsedTime() * 1000.0f;
+
+					vml::utils::Logger::GetInstance()->Info("Jolt : Mesh Shape Cached Load : " + std::to_string(MeshLoadTime) + " ms, Cold Build : " + std::to_string(MeshBuildTime) + " ms");
 				}
+				else
+				{
+					BuildMeshShape(collisionmesh);
 
-				// Create mesh shape settings
-				JPH::MeshShapeSettings settings(vertexList, triangleList);
-				settings.Sanitize();
-				settings.mBuildQuality = JPH::MeshShapeSettings::EBuildQuality::FavorRuntimePerformance;
+					MeshBuildTime = timer.GetElapsedTime() * 1000.0f;
+					MeshLoadTime  = MeshBuildTime;
 
-				// Create shape
-				JPH::Shape::ShapeResult result = settings.Create();
-				if (result.IsValid())
-					mesh_shape = result.Get();
-				else
-					vml::os::Message::Error("couldn't get resulting shape {}", result.GetError());
+					if (!cachefilename.empty())
+						SaveMeshCache(cachefilename, hash);
+
+					vml::utils::Logger::GetInstance()->Info("Jolt : Mesh Shape Build : " + std::to_string(MeshBuildTime) + " ms, Triangles : " + std::to_string(collisionmesh->GetSurfaceIndices().size() / 3));
+				}
 
 				JPH::BodyCreationSettings mesh_settings(mesh_shape, JPH::RVec3(0.0_r, 0.0_r, 0.0_r), JPH::Quat::sIdentity(), JPH::EMotionType::Static, Layers::NON_MOVING);
 				JPH::Body* mesh_body = BodyInterface->CreateBody(mesh_settings); // Note that if we run out of bodies this can return nullptr
@@ -883,6 +1470,23 @@ namespace JPH
 				collisionMapId = mesh_body->GetID();
 			}
 
+			// ---------------------------------------------------------------------------
+			// mesh shape build quality, FavorBuildSpeed trades query speed for a
+			// faster build, cached shapes built with another quality are rebuilt
+
+			void SetMeshBuildQuality(JPH::MeshShapeSettings::EBuildQuality quality)
+			{
+				MeshBuildQuality = quality;
+			}
+
+			JPH::MeshShapeSettings::EBuildQuality GetMeshBuildQuality() const { return MeshBuildQuality; }
+
+			// last mesh shape build and load times in milliseconds, build time is
+			// read from the cache file when the shape is restored
+
+			float GetMeshBuildTime() const { return MeshBuildTime; }
+			float GetMeshLoadTime()  const { return MeshLoadTime; }
+
 			// ---------------------------------------------------------------------------
 
 			void Init()
@@ -911,10 +1515,9 @@ namespace JPH
 				// malloc / free.
 				TempAllocator = new JPH::TempAllocatorImpl(MaxMem);
 
-				// We need a job system that will execute physics jobs on multiple threads. Typically
-				// you would implement the JobSystem interface yourself and let Jolt Physics run on top
-				// of your own job scheduler. JobSystemThreadPool is an example implementation.
-				JobSystem = new JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, std::thread::hardware_concurrency() - 1u);
+				// physics jobs run on the engine thread pool, which is shared with
+				// asset loading and scene update, so cores are not oversubscribed
+				JobSystem = new EngineJobSystem(vml::os::ThreadPool::GetInstance(), JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers);
 
 				PhysicsSystem = new JPH::PhysicsSystem;
 
@@ -969,15 +1572,454 @@ namespace JPH
 			void OptimizeBroadPhase()
 			{
 				PhysicsSystem->OptimizeBroadPhase();
+
+				BodiesAddedSinceOptimize = 0;
+			}
+
+			// ---------------------------------------------------------------------------
+			// creates bodies in one batch, ids receives one body id per spawn, bodies
+			// are inserted in the broadphase with AddBodiesPrepare / AddBodiesFinalize,
+			// which builds a tree for the whole batch, the broadphase is optimized if
+			// bodies added since the last optimization exceed BroadPhaseOptimizeRatio
+			// times the bodies count, call between steps
+
+			void CreateBodies(const std::vector<BodySpawn>& spawns, std::vector<JPH::BodyID>& ids)
+			{
+				if (StepInFlight)
+					vml::os::Message::Error("Jolt : ", "Cannot create bodies while a step is in flight");
+
+				ids.resize(spawns.size());
+
+				// dynamic bodies are activated, static ones are not, so each
+				// kind is added as a separate batch
+
+				std::vector<JPH::BodyID> dynamicbodies;
+				std::vector<JPH::BodyID> staticbodies;
+
+				for (size_t i = 0; i < spawns.size(); ++i)
+				{
+					const BodySpawn& spawn = spawns[i];
+
+					JPH::BodyCreationSettings settings(GetScaledShape(spawn.Shape, spawn.HalfExtents),
+													   JPH::RVec3(ToJolt(spawn.Position)),
+													   JPH::Quat(spawn.Rotation.x, spawn.Rotation.y, spawn.Rotation.z, spawn.Rotation.w).Normalized(),
+													   spawn.Dynamic ? JPH::EMotionType::Dynamic : JPH::EMotionType::Static,
+													   spawn.Dynamic ? Layers::MOVING : Layers::NON_MOVING);
+
+					JPH::Body* body = BodyInterface->CreateBody(settings);
+
+					if (!body)
+						vml::os::Message::Error("Jolt : ", "Out of bodies, increase MaxBodies");
+
+					ids[i] = body->GetID();
+
+					if (spawn.Dynamic)
+						dynamicbodies.emplace_back(ids[i]);
+					else
+						staticbodies.emplace_back(ids[i]);
+				}
+
+				// prepare shuffles the arrays, ids keep the spawn order
+
+				if (!staticbodies.empty())
+				{
+					JPH::BodyInterface::AddState state = BodyInterface->AddBodiesPrepare(staticbodies.data(), (int)staticbodies.size());
+					BodyInterface->AddBodiesFinalize(staticbodies.data(), (int)staticbodies.size(), state, JPH::EActivation::DontActivate);
+				}
+
+				if (!dynamicbodies.empty())
+				{
+					JPH::BodyInterface::AddState state = BodyInterface->AddBodiesPrepare(dynamicbodies.data(), (int)dynamicbodies.size());
+					BodyInterface->AddBodiesFinalize(dynamicbodies.data(), (int)dynamicbodies.size(), state, JPH::EActivation::Activate);
+				}
+
+				BodiesAddedSinceOptimize += spawns.size();
+
+				if ((float)BodiesAddedSinceOptimize > BroadPhaseOptimizeRatio * (float)PhysicsSystem->GetNumBodies())
+					OptimizeBroadPhase();
+			}
+
+			// ---------------------------------------------------------------------------
+			// removes and destroys bodies in one batch, invalid ids are skipped,
+			// bodies must not be tracked, call between steps
+
+			void DestroyBodies(const std::vector<JPH::BodyID>& ids)
+			{
+				if (StepInFlight)
+					vml::os::Message::Error("Jolt : ", "Cannot destroy bodies while a step is in flight");
+
+				std::vector<JPH::BodyID> bodies;
+
+				bodies.reserve(ids.size());
+
+				for (size_t i = 0; i < ids.size(); ++i)
+					if (!ids[i].IsInvalid())
+						bodies.emplace_back(ids[i]);
+
+				if (bodies.empty())
+					return;
+
+				BodyInterface->RemoveBodies(bodies.data(), (int)bodies.size());
+				BodyInterface->DestroyBodies(bodies.data(), (int)bodies.size());
+			}
+
+			// ---------------------------------------------------------------------------
+			// tracks a body pose for interpolation, returns the index of the pose,
+			// call once bodies are created and not while a step is in flight
+
+			size_t TrackBody(const JPH::BodyID& id)
+			{
+				if (StepInFlight)
+					vml::os::Message::Error("Jolt : ", "Cannot track bodies while a step is in flight");
+
+				TrackedBodies.emplace_back(id);
+				PreviousPoses.emplace_back(BodyPose());
+				CurrentPoses.emplace_back(BodyPose());
+				InterpolatedPoses.emplace_back(BodyPose());
+
+				size_t index = TrackedBodies.size() - 1;
+
+				JPH::RVec3 position;
+				JPH::Quat  rotation;
+
+				BodyInterface->GetPositionAndRotation(id, position, rotation);
+
+				CurrentPoses[index].Position = ToGlm(JPH::Vec3(position));
+				CurrentPoses[index].Rotation = glm::quat(rotation.GetW(), rotation.GetX(), rotation.GetY(), rotation.GetZ());
+				PreviousPoses[index]		 = CurrentPoses[index];
+				InterpolatedPoses[index]	 = CurrentPoses[index];
+
+				return index;
+			}
+
+			void ClearTrackedBodies()
+			{
+				if (StepInFlight)
+					vml::os::Message::Error("Jolt : ", "Cannot untrack bodies while a step is in flight");
+
+				TrackedBodies.clear();
+				PreviousPoses.clear();
+				CurrentPoses.clear();
+				InterpolatedPoses.clear();
+			}
+
+			// ---------------------------------------------------------------------------
+			// drops accumulated time, call when the simulation restarts
+
+			void ResetStepTime()
+			{
+				if (StepInFlight)
+					vml::os::Message::Error("Jolt : ", "Cannot reset step time while a step is in flight");
+
+				Accumulator = 0.0f;
+				Alpha		= 0.0f;
+			}
+
+			// ---------------------------------------------------------------------------
+			// advances the simulation by frametime seconds in fixed DeltaTime steps,
+			// tracked bodies poses are interpolated between the last two steps,
+			// returns the number of steps run
+
+			int Step(float frametime)
+			{
+				if (StepInFlight)
+					vml::os::Message::Error("Jolt : ", "A step is already in flight");
+
+				int steps = ConsumeSteps(frametime);
+
+				RunSteps(steps);
+
+				InterpolatePoses();
+
+				return steps;
+			}
+
+			// ---------------------------------------------------------------------------
+			// pipelined step, BeginStep runs the fixed steps on the engine thread pool
+			// and returns immediately, EndStep waits for them and interpolates poses,
+			// typical frame is EndStep, copy poses to models, BeginStep, render, so
+			// frame N renders while step N + 1 runs, bodies must not be changed and
+			// queries must not be run between BeginStep and EndStep
+
+			void BeginStep(float frametime)
+			{
+				if (StepInFlight)
+					vml::os::Message::Error("Jolt : ", "A step is already in flight");
+
+				PendingSteps = ConsumeSteps(frametime);
+				StepInFlight = true;
+
+				if (PendingSteps > 0)
+				{
+					int steps = PendingSteps;
+					vml::os::ThreadPool::GetInstance()->Submit([this, steps]() { RunSteps(steps); }, &StepCounter);
+				}
+			}
+
+			int EndStep()
+			{
+				if (!StepInFlight)
+					return 0;
+
+				vml::os::ThreadPool::GetInstance()->Wait(StepCounter);
+
+				StepInFlight = false;
+
+				InterpolatePoses();
+
+				return PendingSteps;
+			}
+
+			// ---------------------------------------------------------------------------
+			// interpolated pose of a tracked body, valid after Step or EndStep
+
+			const BodyPose& GetBodyPose(size_t index) const { return InterpolatedPoses[index]; }
+			size_t			GetTrackedBodiesCount()	  const { return TrackedBodies.size(); }
+			float			GetAlpha()				  const { return Alpha; }
+			bool			IsStepInFlight()		  const { return StepInFlight; }
+
+			// ---------------------------------------------------------------------------
+			// batched queries, hits holds one result per query, queries run in parallel
+			// on the engine thread pool unless parallel is false
+
+			void CastRays(const std::vector<RayQuery>& rays, std::vector<QueryHit>& hits, bool parallel = true)
+			{
+				hits.assign(rays.size(), QueryHit());
+
+				const JPH::NarrowPhaseQuery& query = PhysicsSystem->GetNarrowPhaseQuery();
+
+				RunQueries(rays.size(), parallel, [this, &rays, &hits, &query](QueryContext& context, size_t i)
+				{
+					JPH::RRayCast ray(JPH::RVec3(ToJolt(rays[i].Origin)), ToJolt(rays[i].Direction));
+
+					JPH::RayCastResult result;
+
+					if (!query.CastRay(ray, result))
+						return;
+
+					QueryHit& hit = hits[i];
+
+					hit.HasHit	 = true;
+					hit.Fraction = result.mFraction;
+					hit.Body	 = result.mBodyID;
+					hit.Position = ToGlm(JPH::Vec3(ray.GetPointOnRay(result.mFraction)));
+
+					JPH::BodyLockRead lock(PhysicsSystem->GetBodyLockInterface(), result.mBodyID);
+
+					if (lock.Succeeded())
+						hit.Normal = ToGlm(lock.GetBody().GetWorldSpaceSurfaceNormal(result.mSubShapeID2, ray.GetPointOnRay(result.mFraction)));
+				});
+			}
+
+			// ---------------------------------------------------------------------------
+			// sphere casts use the unit sphere shape, scaled by each query radius
+
+			void CastSpheres(const std::vector<SphereCastQuery>& spheres, std::vector<QueryHit>& hits, bool parallel = true)
+			{
+				hits.assign(spheres.size(), QueryHit());
+
+				const JPH::NarrowPhaseQuery& query = PhysicsSystem->GetNarrowPhaseQuery();
+
+				RunQueries(spheres.size(), parallel, [this, &spheres, &hits, &query](QueryContext& context, size_t i)
+				{
+					JPH::RShapeCast cast = JPH::RShapeCast::sFromWorldTransform(SphereShape, JPH::Vec3::sReplicate(spheres[i].Radius),
+																				 JPH::RMat44::sTranslation(JPH::RVec3(ToJolt(spheres[i].Origin))),
+																				 ToJolt(spheres[i].Direction));
+
+					context.CastCollector.Reset();
+
+					query.CastShape(cast, JPH::ShapeCastSettings(), JPH::RVec3::sZero(), context.CastCollector);
+
+					if (!context.CastCollector.HadHit())
+						return;
+
+					const JPH::ShapeCastResult& result = context.CastCollector.mHit;
+
+					QueryHit& hit = hits[i];
+
+					hit.HasHit	 = true;
+					hit.Fraction = result.mFraction;
+					hit.Body	 = result.mBodyID2;
+					hit.Position = ToGlm(result.mContactPointOn2);
+					hit.Normal	 = ToGlm(-result.mPenetrationAxis.NormalizedOr(JPH::Vec3::sZero()));
+				});
+			}
+
+			// ---------------------------------------------------------------------------
+			// box overlaps use the unit box shape, scaled by each query half extents,
+			// hits of query i are hits[offsets[i]] to hits[offsets[i + 1]] excluded,
+			// as for SingleHitCollector, positions are on the box and normals are
+			// the penetration axes
+
+			void OverlapBoxes(const std::vector<BoxOverlapQuery>& boxes, std::vector<Hit>& hits, std::vector<uint32_t>& offsets, bool parallel = true)
+			{
+				std::vector<uint32_t> contexts(boxes.size());
+				std::vector<uint32_t> starts(boxes.size());
+
+				offsets.assign(boxes.size() + 1, 0);
+
+				const JPH::NarrowPhaseQuery& query = PhysicsSystem->GetNarrowPhaseQuery();
+
+				RunQueries(boxes.size(), parallel, [this, &boxes, &offsets, &contexts, &starts, &query](QueryContext& context, size_t i)
+				{
+					const BoxOverlapQuery& box = boxes[i];
+
+					JPH::RMat44 transform = JPH::RMat44::sRotationTranslation(JPH::Quat(box.Rotation.x, box.Rotation.y, box.Rotation.z, box.Rotation.w),
+																			  JPH::RVec3(ToJolt(box.Center)));
+
+					context.OverlapCollector.Reset();
+
+					query.CollideShape(BoxShape, ToJolt(box.HalfExtents), transform, JPH::CollideShapeSettings(), JPH::RVec3::sZero(), context.OverlapCollector);
+
+					contexts[i]	   = (uint32_t)context.Index;
+					starts[i]	   = (uint32_t)context.Hits.size();
+					offsets[i + 1] = (uint32_t)context.OverlapCollector.mHits.size();
+
+					for (const JPH::CollideShapeResult& result : context.OverlapCollector.mHits)
+					{
+						Hit hit;
+						hit.HasHit		= true;
+						hit.penetration = result.mPenetrationDepth;
+						hit.Position	= ToGlm(result.mContactPointOn1);
+						hit.Normal		= ToGlm(result.mPenetrationAxis.NormalizedOr(JPH::Vec3::sZero()));
+						context.Hits.push_back(hit);
+					}
+				});
+
+				// gather hits in query order
+
+				for (size_t i = 0; i < boxes.size(); ++i)
+					offsets[i + 1] += offsets[i];
+
+				hits.resize(offsets.back());
+
+				for (size_t i = 0; i < boxes.size(); ++i)
+				{
+					const std::vector<Hit>& source = QueryContexts[contexts[i]]->Hits;
+
+					std::copy(source.begin() + starts[i], source.begin() + starts[i] + (offsets[i + 1] - offsets[i]), hits.begin() + offsets[i]);
+				}
+			}
+
+			// ---------------------------------------------------------------------------
+			// measures queries per second against a level collision mesh, queries
+			// start inside the mesh bounding box, each kind is run one by one and
+			// batched, results are written to the log, the collision mesh body is
+			// created if needed
+
+			void BenchmarkQueries(vml::meshes::Mesh3d* collisionmesh, int queries = 10000, unsigned int seed = 1234)
+			{
+				if (!collisionmesh)
+					vml::os::Message::Error("Jolt : ", "Collision mesh is null");
+
+				if (queries < 1)
+					vml::os::Message::Error("Jolt : ", "Benchmark queries must be greater than zero");
+
+				if (collisionMapId.IsInvalid())
+					CreateConcaveMesh(collisionmesh);
+
+				glm::vec3 bmin = collisionmesh->GetBoundingBox().GetMin();
+				glm::vec3 bmax = collisionmesh->GetBoundingBox().GetMax();
+				float	  size = glm::length(bmax - bmin);
+
+				std::mt19937						  generator(seed);
+				std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+				auto randompoint = [&]() { return bmin + (bmax - bmin) * glm::vec3(unit(generator), unit(generator), unit(generator)); };
+				auto randomdir	 = [&]() { glm::vec3 d(unit(generator) - 0.5f, unit(generator) - 0.5f, unit(generator) - 0.5f); return glm::length(d) > 0.0f ? glm::normalize(d) : glm::vec3(0, -1, 0); };
+
+				std::vector<RayQuery>		 rays(queries);
+				std::vector<SphereCastQuery> spheres(queries);
+				std::vector<BoxOverlapQuery> boxes(queries);
+
+				for (int i = 0; i < queries; ++i)
+				{
+					rays[i].Origin	  = randompoint();
+					rays[i].Direction = randomdir() * size * 0.25f;
+
+					spheres[i].Origin	 = randompoint();
+					spheres[i].Direction = randomdir() * size * 0.25f;
+					spheres[i].Radius	 = size * 0.005f;
+
+					boxes[i].Center		 = randompoint();
+					boxes[i].HalfExtents = glm::vec3(size * 0.01f);
+					boxes[i].Rotation	 = glm::quat(randomdir() * 3.14159265f);
+				}
+
+				vml::os::Timer timer;
+
+				auto rate = [&](float time) { return time > 0.0f ? double(queries) / double(time) : 0.0; };
+
+				auto samehits = [](const std::vector<QueryHit>& a, const std::vector<QueryHit>& b)
+				{
+					for (size_t i = 0; i < a.size(); ++i)
+						if (a[i].HasHit != b[i].HasHit || a[i].Fraction != b[i].Fraction)
+							return false;
+					return true;
+				};
+
+				std::vector<QueryHit> serialhits, parallelhits;
+				std::vector<Hit>	  serialoverlaps, paralleloverlaps;
+				std::vector<uint32_t> serialoffsets, paralleloffsets;
+
+				// rays
+
+				timer.Init();
+				CastRays(rays, serialhits, false);
+				float serialtime = timer.GetElapsedTime();
+
+				timer.Init();
+				CastRays(rays, parallelhits, true);
+				float paralleltime = timer.GetElapsedTime();
+
+				size_t hitscount = std::count_if(serialhits.begin(), serialhits.end(), [](const QueryHit& hit) { return hit.HasHit; });
+
+				vml::utils::Logger::GetInstance()->Info("Jolt : Benchmark : Rays    : " + std::to_string(rate(serialtime)) + " q/s serial , " + std::to_string(rate(paralleltime)) + " q/s batched , " +
+														 std::to_string(hitscount) + " hits , Match : " + (samehits(serialhits, parallelhits) ? "yes" : "no"));
+
+				// sphere casts
+
+				timer.Init();
+				CastSpheres(spheres, serialhits, false);
+				serialtime = timer.GetElapsedTime();
+
+				timer.Init();
+				CastSpheres(spheres, parallelhits, true);
+				paralleltime = timer.GetElapsedTime();
+
+				hitscount = std::count_if(serialhits.begin(), serialhits.end(), [](const QueryHit& hit) { return hit.HasHit; });
+
+				vml::utils::Logger::GetInstance()->Info("Jolt : Benchmark : Spheres : " + std::to_string(rate(serialtime)) + " q/s serial , " + std::to_string(rate(paralleltime)) + " q/s batched , " +
+														 std::to_string(hitscount) + " hits , Match : " + (samehits(serialhits, parallelhits) ? "yes" : "no"));
+
+				// box overlaps
+
+				timer.Init();
+				OverlapBoxes(boxes, serialoverlaps, serialoffsets, false);
+				serialtime = timer.GetElapsedTime();
+
+				timer.Init();
+				OverlapBoxes(boxes, paralleloverlaps, paralleloffsets, true);
+				paralleltime = timer.GetElapsedTime();
+
+				vml::utils::Logger::GetInstance()->Info("Jolt : Benchmark : Boxes   : " + std::to_string(rate(serialtime)) + " q/s serial , " + std::to_string(rate(paralleltime)) + " q/s batched , " +
+														 std::to_string(serialoverlaps.size()) + " hits , Match : " + (serialoffsets == paralleloffsets ? "yes" : "no"));
+
+				vml::utils::Logger::GetInstance()->Info("Jolt : Benchmark : Queries : " + std::to_string(queries) + " , Triangles : " + std::to_string(collisionmesh->GetSurfaceIndices().size() / 3) +
+														 " , Threads : " + std::to_string(vml::os::ThreadPool::GetInstance()->GetWorkersCount() + 1));
 			}
 
 			// ---------------------------------------------------------------------------
 
 			void Close()
 			{
+				EndStep();
+
 				BodyInterface->RemoveBody(collisionMapId);
 				BodyInterface->DestroyBody(collisionMapId);
 
+				ScaledShapes.clear();
+
 				vml::os::SafeDelete(gDebugRenderer);
 				vml::os::SafeDelete(TempAllocator);
 				vml::os::SafeDelete(JobSystem);
@@ -1008,6 +2050,18 @@ namespace JPH
 				MaxMem = 10u * 1024u * 1024u;
 				NumBodyMutexes = 0u;
 				DeltaTime = 1.0f / 60.0f;
+				CollisionSteps = 1;
+				MaxStepsPerFrame = 4;
+				BroadPhaseOptimizeRatio = 0.5f;
+				BodiesAddedSinceOptimize = 0;
+				Accumulator = 0.0f;
+				Alpha = 0.0f;
+				PendingSteps = 0;
+				StepInFlight = false;
+				StepCounter = 0;
+				MeshBuildQuality = JPH::MeshShapeSettings::EBuildQuality::FavorRuntimePerformance;
+				MeshBuildTime = 0.0f;
+				MeshLoadTime = 0.0f;
 			}
 
 			~JoltPhysics()
@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////////
+//	This source file is part of v71's engine
+//
+//	Copyright (c) 2011-2050 v71
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+////////////////////////////////////////////////////////////////////////////////////
+// archive packer, packs every file under a directory into a single archive
+// which can be mounted over that directory, see vml::os::Archive
+//
+// usage : packer <directory> <archive> [-c]
+//
+//	-c : compress entries which shrink by at least an eighth
+//
+// legacy .3df meshes can't be read from archives, convert them first
+// with Mesh3d::Convert
+
+#pragma warning(disable:6386)
+#pragma warning(disable:26451)
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <vml4.0/os/common.h>
+
+#include <windows.h>
+#include <vml4.0/os/mappedfile.h>
+
+#include <vml4.0/utils/hash.h>
+#include <vml4.0/os/archive.h>
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		printf("usage : packer <directory> <archive> [-c]\n");
+		return 1;
+	}
+
+	std::string root		= argv[1];
+	std::string archivename = argv[2];
+	bool		compress	= argc > 3 && strcmp(argv[3], "-c") == 0;
+
+	if (!std::filesystem::is_directory(root))
+	{
+		printf("packer : '%s' is not a directory\n", root.c_str());
+		return 1;
+	}
+
+	// collect files, sorted so that archives are reproducible
+
+	std::vector<std::string> filenames;
+
+	std::filesystem::path archivepath = std::filesystem::absolute(archivename);
+
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(root))
+	{
+		if (!entry.is_regular_file() || std::filesystem::absolute(entry.path()) == archivepath)
+			continue;
+
+		std::string filename = entry.path().string();
+
+		// warn about legacy meshes
+
+		if (entry.path().extension() == ".3df")
+		{
+			char magic[4] = {};
+
+			std::ifstream file(filename.c_str(), std::ios::binary);
+
+			file.read(magic, 4);
+
+			if (memcmp(magic, "V3DF", 4) != 0)
+				printf("packer : warning : '%s' is a legacy mesh file, convert it first\n", filename.c_str());
+		}
+
+		filenames.push_back(filename);
+	}
+
+	std::sort(filenames.begin(), filenames.end());
+
+	// pack
+
+	std::string error;
+
+	if (!vml::os::Archive::Pack(archivename, root, filenames, compress, error))
+	{
+		printf("packer : %s\n", error.c_str());
+		return 1;
+	}
+
+	// report
+
+	vml::os::Archive archive;
+
+	if (!archive.Open(archivename, root))
+	{
+		printf("packer : cannot open '%s'\n", archivename.c_str());
+		return 1;
+	}
+
+	uint64_t size	   = 0;
+	uint64_t packed	   = 0;
+	uint32_t compressed = 0;
+
+	for (uint32_t i = 0; i < archive.GetEntriesCount(); ++i)
+	{
+		const vml::os::Archive::Entry* entry = archive.GetEntry(i);
+
+		size   += entry->Size;
+		packed += entry->PackedSize;
+
+		if (entry->Flags & vml::os::Archive::ENTRY_COMPRESSED)
+			compressed++;
+	}
+
+	printf("packer : %s : %u files, %u compressed, %llu bytes packed into %llu bytes\n", archivename.c_str(), archive.GetEntriesCount(), compressed, (unsigned long long)size, (unsigned long long)packed);
+
+	return 0;
+}
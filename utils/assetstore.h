@@ -58,8 +58,8 @@ namespace vml
 				// ----------------------------------------------------------------
 				// protected data
 
-				std::string ResourceFileName;
-				int			Instances;
+				std::string		 ResourceFileName;
+				std::atomic<int> Instances;				// references count, see SharedResourceStore
 
 			public:
 
@@ -83,6 +83,30 @@ namespace vml
 				SharedResource(SharedResource&& other) = delete;
 				SharedResource& operator=(SharedResource&& other) = delete;
 
+				// --------------------------------------------------------------------------------
+				// tag for deferred constructors, a resource built with the tag only
+				// reads and decodes its data, which is safe on a loading thread, 
+				// gpu objects are created later by Finalize on the thread owning 
+				// the opengl context, see SharedResourceStore::LoadAsync
+
+				struct DeferredLoad {};
+
+				// --------------------------------------------------------------------------------
+				// completes a deferred construction
+
+				virtual void Finalize()
+				{
+				}
+
+				// --------------------------------------------------------------------------------
+				// gets bytes held by this resource, both in system and gpu memory,
+				// used by the store memory budget
+
+				virtual size_t GetMemorySize() const
+				{
+					return 0;
+				}
+
 				// --------------------------------------------------------------------------------
 				// get resource filename
 
@@ -109,7 +133,7 @@ namespace vml
 					text += std::format("File directory     : {}\n", vml::strings::SplitPath::GetDirectory(ResourceFileName).c_str());
 					text += std::format("File extension     : {}\n", vml::strings::SplitPath::GetExtension(ResourceFileName).c_str());
 					text += std::format("File path          : {}\n", vml::strings::SplitPath::GetDrive(ResourceFileName).c_str());
-					text += std::format("Instances : {}\n", Instances);
+					text += std::format("Instances : {}\n", Instances.load());
 					return text;
 				}
 
@@ -151,18 +175,312 @@ namespace vml
 				// --------------------------------------------------------------------------------
 				// private data
 
+				// --------------------------------------------------------------------------------
+				// resource being loaded asynchronously, requests for the same
+				// filename share the same entry, Item and Decoded are written by
+				// the loading thread and guarded by DecodedMutex, Waiters and 
+				// Instances are guarded by PendingMutex
+
+				struct PendingResource
+				{
+					std::string									   FileName;		// resource filename
+					std::vector<std::function<void(SharedResource*)>> Waiters;		// fulfils requests once the resource is finalized
+					SharedResource*								   Item;			// decoded resource
+					int											   Instances;		// requests count
+					bool										   Decoded;			// resource is ready to be finalized
+				};
+
+				// --------------------------------------------------------------------------------
+				// the cache is split in shards, each guarded by its own lock, so
+				// that threads looking up different resources rarely contend, 
+				// lookups take a shared lock and only bump the atomic references
+				// count, inserting and erasing take the exclusive lock
+
+				static constexpr size_t CACHE_SHARDS = 16;
+
+				// --------------------------------------------------------------------------------
+				// unreferenced resources are kept in the cache and linked in the
+				// lru list while the store is within its memory budget, Unused and 
+				// LruPosition are guarded by LruMutex
+
+				struct CacheEntry
+				{
+					SharedResource*					 Item;			// cached resource
+					size_t							 Bytes;			// resource memory size when last sampled
+					bool							 Unused;		// resource is unreferenced and linked in the lru list
+					std::list<std::string>::iterator LruPosition;	// position in the lru list
+				};
+
+				struct CacheShard
+				{
+					std::shared_mutex							Mutex;
+					std::unordered_map<std::string, CacheEntry> Items;
+				};
+
 				std::string										 Name;
 				uint32_t										 PreferencesFlags;
-				std::unordered_map<std::string, SharedResource*> Cache{};
+				mutable CacheShard								 Shards[CACHE_SHARDS];
+				std::list<std::string>							 Lru{};					// unreferenced resources, most recently released first
+				mutable std::mutex								 LruMutex;
+				std::atomic<size_t>								 MemoryBudget;			// bytes, 0 releases resources as soon as they are unreferenced
+				std::atomic<size_t>								 TotalBytes;			// bytes held by cached resources
+				std::atomic<size_t>								 UnusedBytes;			// bytes held by unreferenced resources
+				std::atomic<size_t>								 Hits;
+				std::atomic<size_t>								 Misses;
+				std::atomic<size_t>								 Evictions;
+				std::unordered_map<std::string, std::shared_ptr<PendingResource>> Pending{};
+				mutable std::mutex								 PendingMutex;
+				std::deque<std::shared_ptr<PendingResource>>	 DecodedQueue{};		// resources ready for finalizing, in completion order
+				std::mutex										 DecodedMutex;
+				vml::os::ThreadPool*							 Pool;					// engine thread pool, set on first asynchronous load
+				std::atomic<int>								 InFlight;				// resources being decoded
+
+				// --------------------------------------------------------------------------------
+				// gets cache shard for a resource filename
+
+				CacheShard& GetShard(const std::string& filename) const
+				{
+					return Shards[std::hash<std::string>{}(filename) & (CACHE_SHARDS - 1)];
+				}
+
+				// --------------------------------------------------------------------------------
+				// inserts a new resource in a shard, exclusive lock must be held
+
+				void InsertEntry(CacheShard& shard, const std::string& filename, SharedResource* item)
+				{
+					CacheEntry entry;
+
+					entry.Item	 = item;
+					entry.Bytes	 = item->GetMemorySize();
+					entry.Unused = false;
+
+					shard.Items.insert(std::pair<std::string, CacheEntry>(filename, entry));
+
+					TotalBytes += entry.Bytes;
+				}
+
+				// --------------------------------------------------------------------------------
+				// adds references to a cached resource, an unreferenced resource
+				// is unlinked from the lru list, shard lock must be held, either
+				// shared or exclusive, returns the new references count
+
+				int AcquireEntry(CacheEntry& entry, int count)
+				{
+					int instances = entry.Item->Instances.fetch_add(count) + count;
+
+					if (instances == count)
+					{
+						std::lock_guard<std::mutex> lock(LruMutex);
+
+						if (entry.Unused)
+						{
+							Lru.erase(entry.LruPosition);
+							entry.Unused = false;
+							UnusedBytes -= entry.Bytes;
+						}
+					}
+
+					Hits++;
+
+					return instances;
+				}
+
+				// --------------------------------------------------------------------------------
+				// evicts least recently released resources until the store fits
+				// its memory budget, or all of them if required
+
+				void Evict(bool all)
+				{
+					while (true)
+					{
+						std::string filename;
+
+						{
+							std::lock_guard<std::mutex> lock(LruMutex);
+
+							if (Lru.empty() || (!all && TotalBytes <= MemoryBudget))
+								break;
+
+							filename = Lru.back();
+						}
+
+						CacheShard& shard = GetShard(filename);
+
+						SharedResource* item = nullptr;
+
+						{
+							std::unique_lock<std::shared_mutex> lock(shard.Mutex);
+
+							auto it = shard.Items.find(filename);
+
+							if (it != shard.Items.end() && it->second.Item->Instances == 0)
+							{
+								std::lock_guard<std::mutex> lrulock(LruMutex);
+
+								if (it->second.Unused)
+								{
+									Lru.erase(it->second.LruPosition);
+									UnusedBytes -= it->second.Bytes;
+									TotalBytes  -= it->second.Bytes;
+									item = it->second.Item;
+									shard.Items.erase(it);
+								}
+							}
+						}
+
+						// resource was acquired again meanwhile, it is unlinked by the 
+						// acquiring thread, so yield and retry
+
+						if (!item)
+						{
+							std::this_thread::yield();
+							continue;
+						}
+
+						Evictions++;
+
+						if (IsVerbose()) {
+							vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Evicting " + filename);
+						}
+
+						delete item;
+					}
+				}
+
+				// --------------------------------------------------------------------------------
+				// gets asynchronous load for a resource filename, if any
+
+				std::shared_ptr<PendingResource> FindPending(const std::string& filename) const
+				{
+					std::lock_guard<std::mutex> lock(PendingMutex);
+
+					auto it = Pending.find(filename);
+
+					if (it != Pending.end())
+						return it->second;
+
+					return nullptr;
+				}
+
+				// --------------------------------------------------------------------------------
+				// queues a decoded resource for finalizing
+
+				void PushDecoded(const std::shared_ptr<PendingResource>& pending)
+				{
+					std::lock_guard<std::mutex> lock(DecodedMutex);
+					pending->Decoded = true;
+					DecodedQueue.push_back(pending);
+				}
+
+				// --------------------------------------------------------------------------------
+				// creates gpu objects for a decoded resource, moves it into 
+				// the cache and fulfils its requests, if the same resource was
+				// loaded synchronously meanwhile, requests are moved to that one
+
+				void FinalizePending(std::shared_ptr<PendingResource> pending)
+				{
+					SharedResource* item = pending->Item;
+
+					item->Finalize();
+
+					{
+						std::lock_guard<std::mutex> pendinglock(PendingMutex);
+
+						CacheShard& shard = GetShard(pending->FileName);
+
+						std::unique_lock<std::shared_mutex> lock(shard.Mutex);
+
+						auto it = shard.Items.find(pending->FileName);
+
+						if (it != shard.Items.end())
+						{
+							delete item;
+							item = it->second.Item;
+							AcquireEntry(it->second, pending->Instances);
+						}
+						else
+						{
+							InsertEntry(shard, pending->FileName, item);
+							item->Instances += pending->Instances;
+						}
+
+						Pending.erase(pending->FileName);
+					}
+
+					if (IsVerbose()) {
+						vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Adding " + pending->FileName + " , instances : " + std::to_string(item->GetInstancesCount()) + " * Loaded Asynchronously *");
+					}
+
+					for (auto& waiter : pending->Waiters)
+						waiter(item);
+				}
+
+				// --------------------------------------------------------------------------------
+				// waits for a pending resource and finalizes it out of order,
+				// used when a resource is requested synchronously while loading,
+				// if another thread is finalizing it, waits for it to be cached
+
+				void CompletePending(std::shared_ptr<PendingResource> pending)
+				{
+					while (true)
+					{
+						bool decoded;
+						bool claimed = false;
+
+						{
+							std::lock_guard<std::mutex> lock(DecodedMutex);
+
+							decoded = pending->Decoded;
+
+							if (decoded)
+							{
+								auto it = std::find(DecodedQueue.begin(), DecodedQueue.end(), pending);
+								
+								if (it != DecodedQueue.end())
+								{
+									DecodedQueue.erase(it);
+									claimed = true;
+								}
+							}
+						}
+
+						if (claimed)
+							break;
+
+						// finalized by another thread
+
+						if (decoded && FindPending(pending->FileName) != pending)
+							return;
+
+						// help loading threads instead of spinning
+
+						if (!Pool->RunPendingTask())
+							std::this_thread::yield();
+					}
+
+					FinalizePending(pending);
+				}
 
 				// --------------------------------------------------------------------------------
 				// delete all cache content
 
 				void ReleaseAll()
 				{
+					// wait for loading threads, decoded resources which
+					// were never finalized are released as they are
+
+					if (Pool)
+						Pool->Wait(InFlight);
+
+					for (auto& pending : DecodedQueue)
+						delete pending->Item;
+
+					DecodedQueue.clear();
+					Pending.clear();
+
 					if (IsVerbose())
 					{
-						if (Cache.size() == 0) {
+						if (GetResourcesCount() == 0) {
 							vml::utils::Logger::GetInstance()->Info("Store : "+ Name + " : No more resources for this store");
 						}
 						else {
@@ -172,18 +490,26 @@ namespace vml
 
 					// force release of all elements in the cache
 
-					for (auto it = Cache.begin(); it != Cache.end(); ++it)
+					for (CacheShard& shard : Shards)
 					{
-						SharedResource* item = it->second;
+						for (auto it = shard.Items.begin(); it != shard.Items.end(); ++it)
+						{
+							SharedResource* item = it->second.Item;
 
-						if (IsVerbose()) {
-							vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Relasing " + item->GetResourceFileName() + " , instances : " + std::to_string(item->GetInstancesCount()));
+							if (IsVerbose()) {
+								vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Relasing " + item->GetResourceFileName() + " , instances : " + std::to_string(item->GetInstancesCount()));
+							}
+
+							delete item;
 						}
 
-						delete it->second;
+						shard.Items.clear();
 					}
 
-					Cache.clear();
+					Lru.clear();
+
+					TotalBytes	= 0;
+					UnusedBytes = 0;
 
 				}
 
@@ -204,7 +530,9 @@ namespace vml
 				SharedResourceStore& operator = (const SharedResourceStore& SharedResourcestore) = delete;
 
 				// --------------------------------------------------------------------------------
-				// adds new element to the cache
+				// adds new element to the cache, safe to call from any thread,
+				// resources owning gpu objects must be created on the thread
+				// owning the opengl context though
 
 				template < class T>
 				T* Load(const std::string& fullfilename, const std::initializer_list<uint32_t> &il)
@@ -212,111 +540,534 @@ namespace vml
 					if (fullfilename.empty())
 						vml::os::Message::Error("Store : Null filename");
 
-					// checks if resource is already loaded 
+					// if resource is being loaded asynchronously, finish it now
 
-					auto it = Cache.find(fullfilename);
+					std::shared_ptr<PendingResource> pending = FindPending(fullfilename);
 
-					// if not allocate new resource
+					if (pending)
+						CompletePending(pending);
 
-					if (it == Cache.end())
-					{
-						// allocate new resource
+					CacheShard& shard = GetShard(fullfilename);
+
+					// if resource is already present, icrease reference count and return its pointer
 
-						T* item = new T(fullfilename,il);
+					{
+						std::shared_lock<std::shared_mutex> lock(shard.Mutex);
 
-						// insert in cahce
+						auto it = shard.Items.find(fullfilename);
 
-						Cache.insert(std::pair<std::string, T*>(fullfilename, item));
+						if (it != shard.Items.end())
+						{
+							int instances = AcquireEntry(it->second, 1);
 
-						// increase instance counter
+							// log message out
 
-						item->Instances++;
+							if (IsVerbose()) {
+								vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Adding " + fullfilename + " , instances : " + std::to_string(instances) + " * Already Loaded *");
+							}
 
-						// log message out
+							// return pointer to asset
 
-						if (IsVerbose()) {
-							vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Adding " + fullfilename + " , instances : " + std::to_string(item->GetInstancesCount()));
+							return static_cast<T*>(it->second.Item);
 						}
+					}
 
-						// return newly creeated item
+					// if not allocate new resource, check again since
+					// another thread might have added it meanwhile
 
-						return item;
+					std::unique_lock<std::shared_mutex> lock(shard.Mutex);
+
+					auto it = shard.Items.find(fullfilename);
+
+					if (it != shard.Items.end())
+					{
+						AcquireEntry(it->second, 1);
+
+						return static_cast<T*>(it->second.Item);
 					}
 
-					// if resource is already present, icrease reference count and return its pointer
+					// allocate new resource
 
-					it->second->Instances++;
+					T* item = new T(fullfilename,il);
+
+					Misses++;
+
+					// insert in cahce
+
+					InsertEntry(shard, fullfilename, item);
+
+					// increase instance counter
+
+					item->Instances++;
 
 					// log message out
 
 					if (IsVerbose()) {
-						vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Adding " + fullfilename + " , instances : " + std::to_string(it->second->GetInstancesCount()) + " * Already Loaded *");
+						vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Adding " + fullfilename + " , instances : " + std::to_string(item->GetInstancesCount()));
 					}
 
-					// return pointer to asset
+					// return newly creeated item
 
-					return static_cast<T*>(it->second);
+					return item;
 				}
 
 				// --------------------------------------------------------------------------------
-				// remove element from database
+				// remove element from database, safe to call from any thread
 
 				bool UnLoad(const std::string& filename)
 				{
 					if (filename.empty())
 						vml::os::Message::Error("Store : Null filename when unloading");
 
-					// checks if resource is loaded 
+					// if resource is being loaded asynchronously, finish it now
+
+					std::shared_ptr<PendingResource> pending = FindPending(filename);
+
+					if (pending)
+						CompletePending(pending);
+
+					CacheShard& shard = GetShard(filename);
+
+					// checks if resource is loaded and reduce instances
+
+					int instances;
+
+					{
+						std::shared_lock<std::shared_mutex> lock(shard.Mutex);
+
+						auto it = shard.Items.find(filename);
+
+						if (it == shard.Items.end())
+						{
+							if (IsVerbose()) {
+								vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Couldn't find : " + filename);
+							}
+
+							return false;
+						}
+
+						instances = --it->second.Item->Instances;
+					}
+
+					if (IsVerbose()) {
+						vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Unload " + filename + " , instances : " + std::to_string(instances));
+					}
+
+					if (instances != 0)
+						return false;
 
-					auto it = Cache.find(filename);
-					
-					// if not , erase resource if its
-					// reference values reaches zero
+					// if instances reaches zero, then erase it, or keep it warm in
+					// the lru list if the store has a memory budget, unless another
+					// thread loaded it again before we got the exclusive lock
+
+					SharedResource* item = nullptr;
 
-					if (it != Cache.end())
 					{
-						// cache resource
+						std::unique_lock<std::shared_mutex> lock(shard.Mutex);
+
+						auto it = shard.Items.find(filename);
+
+						if (it == shard.Items.end() || it->second.Item->Instances != 0)
+							return false;
 
-						SharedResource* item = it->second;
+						CacheEntry& entry = it->second;
 
+						if (MemoryBudget == 0)
+						{
+							item = entry.Item;
+
+							TotalBytes -= entry.Bytes;
+
+							// remvoe resource from cache
+
+							shard.Items.erase(it);
+						}
+						else
+						{
+							// sample size again, data might have been released
+
+							size_t bytes = entry.Item->GetMemorySize();
+
+							TotalBytes += bytes;
+							TotalBytes -= entry.Bytes;
+
+							entry.Bytes = bytes;
+
+							std::lock_guard<std::mutex> lrulock(LruMutex);
+
+							if (!entry.Unused)
+							{
+								Lru.push_front(filename);
+								entry.LruPosition = Lru.begin();
+								entry.Unused	  = true;
+								UnusedBytes		 += bytes;
+							}
+						}
+					}
+
+					if (!item)
+					{
 						if (IsVerbose()) {
-							vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Unload " + filename + " , instances : " + std::to_string(item->GetInstancesCount()));
+							vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Unload : No more references for : " + filename + " * Kept In Cache *");
 						}
 
-						// reduce instances
+						Evict(false);
 
-						item->Instances--;
+						return true;
+					}
+
+					if (IsVerbose()) {
+						vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Unload : No more references for : " + filename + " , instances : " + std::to_string(item->GetInstancesCount()));
+					}
+
+					// call resource destrctor
+
+					delete item;
+
+					return true;
+				}
+
+				// --------------------------------------------------------------------------------
+				// adds new element to the cache asynchronously, file reading and 
+				// decoding run on the loading threads for resources providing a
+				// deferred constructor ( see SharedResource::DeferredLoad ), other 
+				// resources are loaded synchronously, requests for a resource 
+				// already loading share it, the future is ready once the resource
+				// has been finalized by Update
+
+				template < class T>
+				std::shared_future<T*> LoadAsync(const std::string& fullfilename, const std::initializer_list<uint32_t>& il)
+				{
+					if (fullfilename.empty())
+						vml::os::Message::Error("Store : Null filename");
+
+					auto promise = std::make_shared<std::promise<T*>>();
+
+					std::shared_future<T*> future = promise->get_future().share();
 
-						// if instances reaches zero, then erase it
+					// resource can't be split, load it now
 
-						if (item->Instances == 0)
+					if constexpr (!std::is_constructible_v<T, const std::string&, const std::vector<uint32_t>&, SharedResource::DeferredLoad>)
+					{
+						promise->set_value(Load<T>(fullfilename, il));
+
+						return future;
+					}
+					else
+					{
+						// pending map is locked first, see FinalizePending
+
+						std::lock_guard<std::mutex> pendinglock(PendingMutex);
+
+						// if resource is already loaded, icrease reference count and return its pointer
+
+						{
+							CacheShard& shard = GetShard(fullfilename);
+
+							std::shared_lock<std::shared_mutex> lock(shard.Mutex);
+
+							auto it = shard.Items.find(fullfilename);
+
+							if (it != shard.Items.end())
+							{
+								int instances = AcquireEntry(it->second, 1);
+
+								if (IsVerbose()) {
+									vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Adding " + fullfilename + " , instances : " + std::to_string(instances) + " * Already Loaded *");
+								}
+
+								promise->set_value(static_cast<T*>(it->second.Item));
+
+								return future;
+							}
+						}
+
+						// if resource is loading, share the request
+
+						std::shared_ptr<PendingResource> pending;
+
+						auto pit = Pending.find(fullfilename);
+
+						if (pit != Pending.end())
 						{
+							pending = pit->second;
 
 							if (IsVerbose()) {
-								vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Unload : No more references for : " + filename + " , instances : " + std::to_string(item->GetInstancesCount()));
+								vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Adding " + fullfilename + " * Already Loading *");
 							}
+						}
+						else
+						{
+							pending = std::make_shared<PendingResource>();
 
-							// call resource destrctor
+							pending->FileName  = fullfilename;
+							pending->Item	   = nullptr;
+							pending->Instances = 0;
+							pending->Decoded   = false;
 
-							delete (it->second);
+							Misses++;
 
-							// remvoe resource from cache
+							Pending.insert(std::pair<std::string, std::shared_ptr<PendingResource>>(fullfilename, pending));
+
+							// parameters must outlive the initializer list
+
+							std::vector<uint32_t> parms(il);
+
+							// decode on the engine thread pool
 
-							Cache.erase(it);
+							if (!Pool)
+								Pool = vml::os::ThreadPool::GetInstance();
 
-							return true;
+							Pool->Submit([this, pending, parms]()
+							{
+								pending->Item = new T(pending->FileName, parms, SharedResource::DeferredLoad());
+								PushDecoded(pending);
+							}, &InFlight);
 						}
-						
+
+						pending->Instances++;
+
+						pending->Waiters.push_back([promise](SharedResource* item) { promise->set_value(static_cast<T*>(item)); });
+
+						return future;
 					}
-					else
+				}
+
+				// --------------------------------------------------------------------------------
+				// finalizes decoded resources on the main thread, at least one
+				// resource is finalized per call, then finalizing stops once the
+				// budget in milliseconds is spent, returns resources finalized
+
+				int Update(float budget)
+				{
+					// budget is measured on integer clock ticks, float timers lose
+					// sub millisecond resolution after long uptimes, huge budgets
+					// are clamped so that the conversion doesn't overflow
+
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+					std::chrono::steady_clock::duration limit = std::chrono::steady_clock::duration::max();
+
+					if (budget < 1.0e9f)
+						limit = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(budget));
+
+					int finalized = 0;
+
+					while (true)
 					{
-						if (IsVerbose())
+						std::shared_ptr<PendingResource> pending;
+
 						{
-							vml::utils::Logger::GetInstance()->Info("Store : " + Name + " : Couldn't find : " + filename);
+							std::lock_guard<std::mutex> lock(DecodedMutex);
+
+							if (DecodedQueue.empty())
+								break;
+
+							pending = DecodedQueue.front();
+							DecodedQueue.pop_front();
 						}
+
+						FinalizePending(pending);
+
+						finalized++;
+
+						if (std::chrono::steady_clock::now() - start >= limit)
+							break;
+					}
+
+					return finalized;
+				}
+
+				// --------------------------------------------------------------------------------
+				// blocks until all asynchronous loads are finalized
+
+				void Flush()
+				{
+					if (Pool)
+						Pool->Wait(InFlight);
+
+					Update(FLT_MAX);
+				}
+
+				// --------------------------------------------------------------------------------
+				// gets number of resources loading asynchronously
+
+				size_t GetPendingCount() const
+				{
+					std::lock_guard<std::mutex> lock(PendingMutex);
+					return Pending.size();
+				}
+
+				// --------------------------------------------------------------------------------
+				// gets number of cached resources
+
+				size_t GetResourcesCount() const
+				{
+					size_t count = 0;
+
+					for (CacheShard& shard : Shards)
+					{
+						std::shared_lock<std::shared_mutex> lock(shard.Mutex);
+						count += shard.Items.size();
 					}
 
-					return false;
+					return count;
+				}
+
+				// --------------------------------------------------------------------------------
+				// store statistics
+
+				struct Statistics
+				{
+					size_t Resources;				// cached resources
+					size_t UnusedResources;			// unreferenced resources kept in cache
+					size_t Bytes;					// bytes held by cached resources
+					size_t UnusedBytes;				// bytes held by unreferenced resources
+					size_t Budget;					// memory budget
+					size_t Hits;					// loads served by the cache
+					size_t Misses;					// loads reading the resource
+					size_t Evictions;				// unreferenced resources released to fit the budget
+				};
+
+				Statistics GetStatistics() const
+				{
+					Statistics stats;
+
+					stats.Resources = GetResourcesCount();
+
+					{
+						std::lock_guard<std::mutex> lock(LruMutex);
+						stats.UnusedResources = Lru.size();
+					}
+
+					stats.Bytes		  = TotalBytes;
+					stats.UnusedBytes = UnusedBytes;
+					stats.Budget	  = MemoryBudget;
+					stats.Hits		  = Hits;
+					stats.Misses	  = Misses;
+					stats.Evictions	  = Evictions;
+
+					return stats;
+				}
+
+				// --------------------------------------------------------------------------------
+				// sets memory budget in bytes, unreferenced resources are kept in 
+				// cache, and evicted in least recently released order once cached
+				// resources exceed the budget, referenced resources are never
+				// evicted, a zero budget releases resources once unreferenced
+
+				void SetMemoryBudget(size_t bytes)
+				{
+					MemoryBudget = bytes;
+
+					Evict(false);
+				}
+
+				size_t GetMemoryBudget() const
+				{
+					return MemoryBudget;
+				}
+
+				// --------------------------------------------------------------------------------
+				// releases all unreferenced resources, for example on level change
+
+				void ReleaseUnused()
+				{
+					Evict(true);
+				}
+
+				// --------------------------------------------------------------------------------
+				// stress test and benchmark, threads load and unload resources 
+				// which stay cached, mixed with resources created and released 
+				// on the fly, references counts are validated afterwards, lookups 
+				// per second are logged for an increasing number of threads
+
+				static void Benchmark(size_t resources = 256, size_t lookups = 1000000, unsigned int seed = 1234)
+				{
+					struct BenchmarkResource : public SharedResource
+					{
+						BenchmarkResource(const std::string& key, const std::initializer_list<uint32_t>& il) : SharedResource(key, il)
+						{
+						}
+					};
+
+					if (resources == 0)
+						return;
+
+					std::vector<std::string> names(resources);
+					std::vector<std::string> transientnames(32);
+
+					for (size_t i = 0; i < resources; ++i)
+						names[i] = "resource_" + std::to_string(i);
+
+					for (size_t i = 0; i < transientnames.size(); ++i)
+						transientnames[i] = "transient_" + std::to_string(i);
+
+					size_t maxthreads = std::max(1u, std::thread::hardware_concurrency());
+
+					vml::utils::Logger::GetInstance()->Info("Store : Benchmark : " + std::to_string(resources) + " resources, " + std::to_string(lookups) + " lookups, " + std::to_string(CACHE_SHARDS) + " shards");
+
+					for (size_t threads = 1; ; threads = std::min(threads * 2, maxthreads))
+					{
+						SharedResourceStore store("Benchmark", vml::utils::PreferencesFlags::QUIET);
+
+						// cached resources hold one reference for the whole run
+
+						for (const std::string& name : names)
+							store.Load<BenchmarkResource>(name, {});
+
+						std::vector<std::thread> pool;
+
+						vml::os::Timer timer;
+
+						timer.Init();
+
+						for (size_t t = 0; t < threads; ++t)
+						{
+							pool.emplace_back([&store, &names, &transientnames, lookups, threads, seed, t]()
+							{
+								std::mt19937 rng(seed + (unsigned int)t);
+								std::uniform_int_distribution<size_t> pick(0, names.size() - 1);
+								
+								size_t count = lookups / threads;
+
+								for (size_t i = 0; i < count; ++i)
+								{
+									const std::string& name = (i & 15) == 15 ? transientnames[pick(rng) % transientnames.size()] : names[pick(rng)];
+
+									store.Load<BenchmarkResource>(name, {});
+									store.UnLoad(name);
+								}
+							});
+						}
+
+						for (std::thread& thread : pool)
+							thread.join();
+
+						float elapsed = timer.GetElapsedTime();
+
+						// every cached resource must be left with its single reference,
+						// every transient resource must have been released
+
+						if (store.GetResourcesCount() != resources)
+							vml::os::Message::Error("Store : Benchmark : ", "Resources count mismatch ", store.GetResourcesCount(), " instead of ", resources);
+
+						for (const std::string& name : names)
+						{
+							CacheShard& shard = store.GetShard(name);
+
+							auto it = shard.Items.find(name);
+
+							if (it == shard.Items.end() || it->second.Item->GetInstancesCount() != 1)
+								vml::os::Message::Error("Store : Benchmark : ", "References count mismatch for ", name);
+						}
+
+						vml::utils::Logger::GetInstance()->Info("Store : Benchmark : " + std::to_string(threads) + " threads : " + std::to_string(elapsed * 1000.0f) + " ms, " + 
+																std::to_string((size_t)((double)(lookups / threads * threads) / elapsed)) + " lookups per second");
+
+						if (threads == maxthreads)
+							break;
+					}
 				}
 
 				// --------------------------------------------------------------------------------
@@ -324,13 +1075,23 @@ namespace vml
 
 				const std::string Dump() const
 				{
+					Statistics stats = GetStatistics();
+
 					std::string text = Name + " : Dumping cache\n";
 
-					for (auto it = Cache.begin(); it != Cache.end(); ++it)
+					text += "Bytes : " + std::to_string(stats.Bytes) + " , unused : " + std::to_string(stats.UnusedBytes) + " , budget : " + std::to_string(stats.Budget) + "\n";
+					text += "Hits : " + std::to_string(stats.Hits) + " , misses : " + std::to_string(stats.Misses) + " , evictions : " + std::to_string(stats.Evictions) + "\n";
+
+					for (CacheShard& shard : Shards)
 					{
-						SharedResource* item = it->second;
+						std::shared_lock<std::shared_mutex> lock(shard.Mutex);
+
+						for (auto it = shard.Items.begin(); it != shard.Items.end(); ++it)
+						{
+							SharedResource* item = it->second.Item;
 
-						text += item->ResourceFileName + " : instances : " + std::to_string(item->Instances) + "\n";
+							text += item->ResourceFileName + " : instances : " + std::to_string(item->Instances.load()) + "\n";
+						}
 					}
 
 					return text;
@@ -378,6 +1139,20 @@ namespace vml
 
 					PreferencesFlags = flags;
 
+					// no resources are loading
+
+					InFlight = 0;
+					Pool	 = nullptr;
+
+					// no memory budget, resources are released as soon as unreferenced
+
+					MemoryBudget = 0;
+					TotalBytes	 = 0;
+					UnusedBytes	 = 0;
+					Hits		 = 0;
+					Misses		 = 0;
+					Evictions	 = 0;
+
 					// validate preferences flags
 
 					if (IsVerbose() && IsQuiet())
@@ -0,0 +1,103 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////////
+//	This source file is part of v71's engine
+//
+//	Copyright (c) 2011-2050 v71
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+namespace vml
+{
+	namespace utils
+	{
+
+		////////////////////////////////////////////////////////////////////////////
+		// non cryptographic hashing, used to key cached data to its source
+		// and to build lookup tables, fnv-1a is used since it's simple
+		// and stable across runs and platforms
+
+		namespace hash
+		{
+			
+			// ---------------------------------------------------------------
+			// fnv-1a constants
+
+			static const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+			static const uint64_t FNV_PRIME		   = 0x100000001b3ULL;
+
+			// ---------------------------------------------------------------
+			// hashes a block of memory, seed can be a previous
+			// result to hash non contiguous blocks
+
+			static uint64_t Fnv1a64(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS)
+			{
+				const unsigned char* bytes = (const unsigned char*)data;
+
+				uint64_t hash = seed;
+
+				for (size_t i = 0; i < size; ++i)
+				{
+					hash ^= bytes[i];
+					hash *= FNV_PRIME;
+				}
+
+				return hash;
+			}
+
+			// ---------------------------------------------------------------
+			// hashes a string
+
+			static uint64_t Fnv1a64(const std::string& string, uint64_t seed = FNV_OFFSET_BASIS)
+			{
+				return Fnv1a64(string.data(), string.size(), seed);
+			}
+
+			// ---------------------------------------------------------------
+			// hashes a vector's content, element count is hashed too, so
+			// empty vectors still change the result
+
+			template<class T>
+			static uint64_t Fnv1a64(const std::vector<T>& vector, uint64_t seed = FNV_OFFSET_BASIS)
+			{
+				uint64_t count = vector.size();
+				uint64_t hash  = Fnv1a64(&count, sizeof(count), seed);
+				if (count > 0)
+					hash = Fnv1a64(vector.data(), vector.size() * sizeof(T), hash);
+				return hash;
+			}
+
+			// ---------------------------------------------------------------
+			// mixes a 64 bit key, used by hash tables to spread keys
+			// which differ only in a few bits (splitmix64 finalizer)
+
+			static uint64_t Mix64(uint64_t key)
+			{
+				key ^= key >> 30;
+				key *= 0xbf58476d1ce4e5b9ULL;
+				key ^= key >> 27;
+				key *= 0x94d049bb133111ebULL;
+				key ^= key >> 31;
+				return key;
+			}
+
+		}
+
+	}
+}